@@ -1179,7 +1179,8 @@ intersecting the assigned part of the object.")
         ;; Update offsets in AuxData tables.
         (labels ((update-offset (data type)
                    (cond
-                     ((and (listp type) (eql :mapping (car type)))
+                     ((and (listp type)
+                           (member (car type) '(:mapping :columnar-mapping)))
                       (nest (alist-hash-table)
                             (mapcar «cons
                                      [{update-offset _ (second type)} #'car]
@@ -1351,6 +1352,11 @@ OPEN-CHAR."
        (let ((close (matching #\< #\> type-string)))
          (cons (cons :mapping (aux-data-type-read (subseq type-string 0 close)))
                (aux-data-type-read (subseq type-string close)))))
+      ("columnar-mapping<"
+       (let ((close (matching #\< #\> type-string)))
+         (cons (cons :columnar-mapping
+                     (aux-data-type-read (subseq type-string 0 close)))
+               (aux-data-type-read (subseq type-string close)))))
       ("set<"
        (let ((close (matching #\< #\> type-string)))
          (cons (cons :set (aux-data-type-read (subseq type-string 0 close)))
@@ -1407,6 +1413,10 @@ OPEN-CHAR."
            (format stream "mapping<~/gtirb:aux-data-type-print/,~/gtirb:aux-data-type-print/>"
                    (second type)
                    (third type)))
+          (:columnar-mapping
+           (format stream "columnar-mapping<~/gtirb:aux-data-type-print/,~/gtirb:aux-data-type-print/>"
+                   (second type)
+                   (third type)))
           (:set (format stream "set<~/gtirb:aux-data-type-print/>" (second type)))
           (:sequence (format stream "sequence<~/gtirb:aux-data-type-print/>" (second type)))
           (:tuple (format stream "tuple<~{~/gtirb:aux-data-type-print/~^,~}>" (cdr type)))
@@ -1497,6 +1507,15 @@ OPEN-CHAR."
            (let* ((key (decode key-t))
                   (value (decode value-t)))
              (setf (gethash key result) value)))))
+      ((list :columnar-mapping key-t value-t)
+       ;; All of the keys, then all of the values in the same order.
+       (let ((result (make-hash-table :test #'equal))
+             (keys (let (keys)
+                     (dotimes (n (decode :uint64-t) (reverse keys))
+                       (declare (ignorable n))
+                       (push (decode key-t) keys)))))
+         (dolist (key keys result)
+           (setf (gethash key result) (decode value-t)))))
       ((list (or :sequence :set) type)
        (let (result)
          (reverse
@@ -1554,6 +1573,17 @@ OPEN-CHAR."
                   (encode key-t key)
                   (encode value-t value))
                 data))
+      ((list :columnar-mapping key-t value-t)
+       ;; Keys are written in ascending order when they are integers (which
+       ;; includes UUIDs); other keys are written in hash table order.
+       (let ((keys (hash-table-keys data)))
+         (when (every #'integerp keys)
+           (setf keys (sort keys #'<)))
+         (encode :uint64-t (length keys))
+         (dolist (key keys)
+           (encode key-t key))
+         (dolist (key keys)
+           (encode value-t (gethash key data)))))
       ((list (or :sequence :set) type)
        (let ((size (length data)))
          (encode :uint64-t size)
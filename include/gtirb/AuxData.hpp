@@ -18,13 +18,21 @@
 #include <gtirb/Addr.hpp>
 #include <gtirb/Node.hpp>
 #include <gtirb/Offset.hpp>
+#include <boost/container/container_fwd.hpp>
 #include <boost/endian/conversion.hpp>
+#include <boost/version.hpp>
+#include <algorithm>
+#include <cstring>
 #include <deque>
 #include <iostream>
 #include <list>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <set>
 #include <string>
+#include <tuple>
 #include <type_traits>
 #include <typeinfo>
 #include <unordered_map>
@@ -32,6 +40,11 @@
 #include <variant>
 #include <vector>
 
+#if BOOST_VERSION >= 108100
+#include <boost/unordered/unordered_flat_map.hpp>
+#include <boost/unordered/unordered_flat_set.hpp>
+#endif
+
 /// \file AuxData.hpp
 /// \ingroup AUXDATA_GROUP
 /// \brief  Types and operations for auxiliary data.
@@ -42,6 +55,7 @@ namespace proto {
 class AuxData;
 } // namespace proto
 class Context;
+template <class Schema> class AuxDataKeyIndex;
 
 /// \defgroup AUXDATA_GROUP AuxData
 /// \brief \ref AuxData objects can be attached to the \ref IR or individual
@@ -53,16 +67,17 @@ class Context;
 ///   - Offset
 ///   - \ref UUID
 ///   - sequential containers
-///   - mapping containers
+///   - mapping and set containers, including \ref ColumnarMap and the
+///     sorted-vector and flat hash containers from Boost
 ///   - std::tuple
 ///
 /// ### Supporting Additional Types
 ///
 /// Support for additional containers can be added by specializing \ref
-/// is_sequence or \ref is_mapping. Once serialized, the data does not
-/// depend on any specific container type, and its contents can be
+/// is_sequence, \ref is_mapping or \ref is_set. Once serialized, the data
+/// does not depend on any specific container type, and its contents can be
 /// deserialized into different containers of the same kind (e.g. \c std::list
-/// to \c std::vector).
+/// to \c std::vector, or \c std::map to \c boost::container::flat_map).
 ///
 /// Support for other types can be added by specializing \ref auxdata_traits to
 /// provide serialization functions. However, \ref AuxData containing these
@@ -98,6 +113,10 @@ class Context;
 /// array. Containers first write out the number of elements (as a uint64_t),
 /// then write each element one after another. Tuples are similar but omit
 /// the size, since it can be inferred from the type.
+///
+/// A \ref ColumnarMap ("columnar-mapping<...>") writes the number of
+/// entries, then all of the keys in ascending order, then all of the values
+/// in the same order.
 
 /// @{
 
@@ -126,6 +145,14 @@ template <class T, class U>
 struct is_mapping<std::map<T, U>> : std::true_type {};
 template <class T, class U>
 struct is_mapping<std::unordered_map<T, U>> : std::true_type {};
+template <class T, class U, class... Args>
+struct is_mapping<boost::container::flat_map<T, U, Args...>>
+    : std::true_type {};
+#if BOOST_VERSION >= 108100
+template <class T, class U, class... Args>
+struct is_mapping<boost::unordered_flat_map<T, U, Args...>>
+    : std::true_type {};
+#endif
 // Explicitly disable multimaps. Because they can contain multiple values for
 // a given key, they can't be used interchangeably with maps.
 template <class T, class U>
@@ -134,6 +161,23 @@ template <class T, class U>
 struct is_mapping<std::unordered_multimap<T, U>> : std::false_type {};
 /// @endcond
 
+/// \class ColumnarMap
+///
+/// \brief A \c std::map which is stored in \ref AuxData with its keys and
+/// values in separate columns.
+///
+/// The serialized form has the type name "columnar-mapping<K,V>". Its keys
+/// are written as a sorted array of fixed-width records, so a lookup in an
+/// \ref AuxDataView of such a table is a binary search over the serialized
+/// keys. Use it in place of \c std::map for large tables whose keys are
+/// integers, Addr, \ref UUID, \ref Offset or tuples of these.
+///
+/// \see AUXDATA_GROUP
+template <class K, class V> class ColumnarMap : public std::map<K, V> {
+public:
+  using std::map<K, V>::map;
+};
+
 /// \struct is_set
 ///
 /// \brief Trait class that identifies whether T is a set container type.
@@ -144,6 +188,12 @@ template <class T> struct is_set : std::false_type {};
 template <class... Args> struct is_set<std::set<Args...>> : std::true_type {};
 template <class... Args>
 struct is_set<std::unordered_set<Args...>> : std::true_type {};
+template <class... Args>
+struct is_set<boost::container::flat_set<Args...>> : std::true_type {};
+#if BOOST_VERSION >= 108100
+template <class... Args>
+struct is_set<boost::unordered_flat_set<Args...>> : std::true_type {};
+#endif
 // Explicitly disable multisets. Because they can contain multiple equivalent
 // values, they can't be used interchangeably with sets.
 template <class... Args>
@@ -168,19 +218,51 @@ struct is_tuple<std::pair<Args...>> : std::true_type {};
 // Utility class for serializing AuxData.
 class ToByteRange {
 public:
-  explicit ToByteRange(std::string& Bytes) : It(std::back_inserter(Bytes)) {}
+  explicit ToByteRange(std::string& Bytes_) : Bytes(Bytes_) {}
+
+  // A canonical range writes the elements of hashed containers in the order
+  // of their serialized bytes rather than in hash order, so that equal
+  // tables give equal bytes.
+  ToByteRange(std::string& Bytes_, bool Canonical_)
+      : Bytes(Bytes_), Canonical(Canonical_) {}
+
+  bool isCanonical() const { return Canonical; }
 
-  void write(std::byte Byte) { *It = static_cast<char>(Byte); }
+  void write(std::byte Byte) { Bytes.push_back(static_cast<char>(Byte)); }
+
+  void write(const void* Data, size_t Size) {
+    Bytes.append(static_cast<const char*>(Data), Size);
+  }
+
+  // Appends Size bytes to the output and returns a pointer to them, so that
+  // callers which know how much they will write can fill them in place.
+  char* extend(size_t Size) {
+    size_t Old = Bytes.size();
+    Bytes.resize(Old + Size);
+    return Bytes.data() + Old;
+  }
+
+  // Ensures there is room for Size more bytes of output, growing the buffer
+  // geometrically so that repeated small reservations stay amortized.
+  void reserve(size_t Size) {
+    size_t Needed = Bytes.size() + Size;
+    if (Needed > Bytes.capacity())
+      Bytes.reserve(std::max(Needed, 2 * Bytes.capacity()));
+  }
 
 private:
-  std::back_insert_iterator<std::string> It;
+  std::string& Bytes;
+  bool Canonical{false};
 };
 
 // Utility class for deserializing AuxData.
 class FromByteRange {
 public:
   explicit FromByteRange(const std::string& Bytes)
-      : Curr(Bytes.begin()), End(Bytes.end()) {}
+      : Curr(Bytes.data()), End(Bytes.data() + Bytes.size()) {}
+
+  FromByteRange(const char* Begin, const char* End_)
+      : Curr(Begin), End(End_) {}
 
   bool read(std::byte& Byte) {
     if (Curr == End)
@@ -191,13 +273,34 @@ public:
     return true;
   }
 
+  bool read(void* Data, size_t Size) {
+    const char* Src = consume(Size);
+    if (!Src)
+      return false;
+    std::memcpy(Data, Src, Size);
+    return true;
+  }
+
+  // Consumes the next Size bytes and returns a pointer to them, or null if
+  // fewer than Size bytes remain.
+  const char* consume(size_t Size) {
+    if (Size > remainingBytesToRead())
+      return nullptr;
+    const char* Result = Curr;
+    Curr += Size;
+    return Result;
+  }
+
   uint64_t remainingBytesToRead() const {
-    return static_cast<uint64_t>(std::distance(Curr, End));
+    return static_cast<uint64_t>(End - Curr);
   }
 
+  // The position of the next byte to be read.
+  const char* position() const { return Curr; }
+
 private:
-  std::string::const_iterator Curr;
-  std::string::const_iterator End;
+  const char* Curr;
+  const char* End;
 };
 
 ///@endcond
@@ -260,22 +363,12 @@ struct default_serialization<
                                                  boost::endian::order::native>(
           ordered);
     }
-    auto srcBytes_begin = reinterpret_cast<const std::byte*>(&ordered);
-    auto srcBytes_end = reinterpret_cast<const std::byte*>(&ordered + 1);
-    std::for_each(srcBytes_begin, srcBytes_end, [&](auto b) { TBR.write(b); });
+    TBR.write(&ordered, sizeof(T));
   }
 
   static bool fromBytes(T& object, FromByteRange& FBR) {
-    auto dest_begin = reinterpret_cast<std::byte*>(&object);
-    auto dest_end = reinterpret_cast<std::byte*>(&object + 1);
-    bool Success = true;
-    std::for_each(dest_begin, dest_end, [&](auto& b) {
-      if (!FBR.read(b))
-        Success = false;
-    });
-    if (!Success) {
+    if (!FBR.read(&object, sizeof(T)))
       return false;
-    }
 
     // Data stored as little-endian.
     if constexpr (!std::is_floating_point<T>::value &&
@@ -289,6 +382,144 @@ struct default_serialization<
   }
 };
 
+// Identifies types whose serialized form is a fixed number of bytes which can
+// be written to or read from a buffer directly, without going through
+// ToByteRange or FromByteRange one object at a time. Sequences of these types
+// are serialized in bulk.
+//
+// Scalars are stored as their object representation, byte-swapped to
+// little-endian where default_serialization would swap them. For these,
+// IsContiguous is true: an array of them has the same layout as its
+// serialized form, up to byte order. Tuples of packed types are stored as
+// their packed elements back to back.
+template <typename T, typename Enable = void>
+struct packed_serialization : std::false_type {};
+
+template <typename T>
+struct packed_serialization<
+    T, typename std::enable_if_t<
+           (std::is_integral_v<T> && !std::is_same_v<T, bool>) ||
+           std::is_floating_point_v<T> || std::is_same_v<T, std::byte> ||
+           std::is_same_v<T, Addr> || std::is_same_v<T, UUID>>>
+    : std::true_type {
+  static constexpr size_t Size = sizeof(T);
+  static constexpr bool IsContiguous = true;
+  static constexpr bool NeedsSwap =
+      is_endian_type<T>::value &&
+      boost::endian::order::native != boost::endian::order::little;
+
+  static void pack(const T& Object, char* Out) {
+    T Ordered = Object;
+    if constexpr (NeedsSwap)
+      boost::endian::endian_reverse_inplace(Ordered);
+    std::memcpy(Out, &Ordered, Size);
+  }
+
+  static void unpack(T& Object, const char* In) {
+    std::memcpy(&Object, In, Size);
+    if constexpr (NeedsSwap)
+      boost::endian::endian_reverse_inplace(Object);
+  }
+
+  static void packAll(const T* Objects, size_t Count, char* Out) {
+    if (Count == 0)
+      return;
+    std::memcpy(Out, Objects, Count * Size);
+    if constexpr (NeedsSwap)
+      swapAll(Out, Count);
+  }
+
+  static void unpackAll(T* Objects, size_t Count, const char* In) {
+    if (Count == 0)
+      return;
+    std::memcpy(Objects, In, Count * Size);
+    if constexpr (NeedsSwap)
+      swapAll(reinterpret_cast<char*>(Objects), Count);
+  }
+
+private:
+  // Reverses each Size-byte element of a buffer in place. The loop has no
+  // dependencies between iterations, so compilers can vectorize it.
+  static void swapAll(char* Data, size_t Count) {
+    for (size_t I = 0; I < Count; ++I) {
+      char* Elt = Data + I * Size;
+      for (size_t J = 0; J < Size / 2; ++J)
+        std::swap(Elt[J], Elt[Size - 1 - J]);
+    }
+  }
+};
+
+template <typename... Ts>
+struct packed_serialization<
+    std::tuple<Ts...>,
+    typename std::enable_if_t<sizeof...(Ts) != 0 &&
+                              (packed_serialization<Ts>::value && ...)>>
+    : std::true_type {
+  static constexpr size_t Size = (packed_serialization<Ts>::Size + ... + 0);
+  static constexpr bool IsContiguous = false;
+
+  static void pack(const std::tuple<Ts...>& Object, char* Out) {
+    std::apply(
+        [&Out](const Ts&... Elts) {
+          ((packed_serialization<Ts>::pack(Elts, Out),
+            Out += packed_serialization<Ts>::Size),
+           ...);
+        },
+        Object);
+  }
+
+  static void unpack(std::tuple<Ts...>& Object, const char* In) {
+    std::apply(
+        [&In](Ts&... Elts) {
+          ((packed_serialization<Ts>::unpack(Elts, In),
+            In += packed_serialization<Ts>::Size),
+           ...);
+        },
+        Object);
+  }
+};
+
+template <typename T, typename U>
+struct packed_serialization<
+    std::pair<T, U>,
+    typename std::enable_if_t<packed_serialization<T>::value &&
+                              packed_serialization<U>::value>>
+    : std::true_type {
+  static constexpr size_t Size =
+      packed_serialization<T>::Size + packed_serialization<U>::Size;
+  static constexpr bool IsContiguous = false;
+
+  static void pack(const std::pair<T, U>& Object, char* Out) {
+    packed_serialization<T>::pack(Object.first, Out);
+    packed_serialization<U>::pack(Object.second,
+                                  Out + packed_serialization<T>::Size);
+  }
+
+  static void unpack(std::pair<T, U>& Object, const char* In) {
+    packed_serialization<T>::unpack(Object.first, In);
+    packed_serialization<U>::unpack(Object.second,
+                                    In + packed_serialization<T>::Size);
+  }
+};
+
+template <> struct packed_serialization<Offset> : std::true_type {
+  static constexpr size_t Size =
+      packed_serialization<UUID>::Size + packed_serialization<uint64_t>::Size;
+  static constexpr bool IsContiguous = false;
+
+  static void pack(const Offset& Object, char* Out) {
+    packed_serialization<UUID>::pack(Object.ElementId, Out);
+    packed_serialization<uint64_t>::pack(
+        Object.Displacement, Out + packed_serialization<UUID>::Size);
+  }
+
+  static void unpack(Offset& Object, const char* In) {
+    packed_serialization<UUID>::unpack(Object.ElementId, In);
+    packed_serialization<uint64_t>::unpack(
+        Object.Displacement, In + packed_serialization<UUID>::Size);
+  }
+};
+
 template <>
 struct auxdata_traits<std::byte> : default_serialization<std::byte> {
   static std::string type_name() { return "byte"; }
@@ -343,8 +574,7 @@ template <> struct auxdata_traits<std::string> {
 
   static void toBytes(const std::string& Object, ToByteRange& TBR) {
     auxdata_traits<uint64_t>::toBytes(Object.size(), TBR);
-    std::for_each(Object.begin(), Object.end(),
-                  [&](auto& elt) { auxdata_traits<char>::toBytes(elt, TBR); });
+    TBR.write(Object.data(), Object.size());
   }
 
   static bool fromBytes(std::string& Object, FromByteRange& FBR) {
@@ -352,17 +582,12 @@ template <> struct auxdata_traits<std::string> {
     if (!auxdata_traits<uint64_t>::fromBytes(Count, FBR))
       return false;
 
-    if (Count > FBR.remainingBytesToRead())
+    const char* Src = FBR.consume(Count);
+    if (!Src)
       return false;
 
-    Object.resize(Count);
-    bool Success = true;
-    std::for_each(Object.begin(), Object.end(), [&](auto& elt) {
-      if (!auxdata_traits<char>::fromBytes(elt, FBR))
-        Success = false;
-    });
-
-    return Success;
+    Object.assign(Src, Count);
+    return true;
   }
 };
 
@@ -388,13 +613,27 @@ struct auxdata_traits<T, typename std::enable_if_t<is_sequence<T>::value>> {
   }
 
   static void toBytes(const T& Object, ToByteRange& TBR) {
+    using Packed = packed_serialization<typename T::value_type>;
     auxdata_traits<uint64_t>::toBytes(Object.size(), TBR);
-    std::for_each(Object.begin(), Object.end(), [&](const auto& Elt) {
-      auxdata_traits<typename T::value_type>::toBytes(Elt, TBR);
-    });
+    if constexpr (Packed::value) {
+      char* Out = TBR.extend(Object.size() * Packed::Size);
+      if constexpr (Packed::IsContiguous && is_contiguous) {
+        Packed::packAll(Object.data(), Object.size(), Out);
+      } else {
+        for (const auto& Elt : Object) {
+          Packed::pack(Elt, Out);
+          Out += Packed::Size;
+        }
+      }
+    } else {
+      std::for_each(Object.begin(), Object.end(), [&](const auto& Elt) {
+        auxdata_traits<typename T::value_type>::toBytes(Elt, TBR);
+      });
+    }
   }
 
   static bool fromBytes(T& Object, FromByteRange& FBR) {
+    using Packed = packed_serialization<typename T::value_type>;
     uint64_t Count;
     if (!auxdata_traits<uint64_t>::fromBytes(Count, FBR))
       return false;
@@ -402,17 +641,138 @@ struct auxdata_traits<T, typename std::enable_if_t<is_sequence<T>::value>> {
     if (Count > FBR.remainingBytesToRead())
       return false;
 
-    Object.resize(Count);
-    bool Success = true;
-    std::for_each(Object.begin(), Object.end(), [&](auto& Elt) {
-      if (!auxdata_traits<typename T::value_type>::fromBytes(Elt, FBR))
-        Success = false;
-    });
-
-    return Success;
+    if constexpr (Packed::value) {
+      if (Count > FBR.remainingBytesToRead() / Packed::Size)
+        return false;
+      const char* In = FBR.consume(Count * Packed::Size);
+      Object.resize(Count);
+      if constexpr (Packed::IsContiguous && is_contiguous) {
+        Packed::unpackAll(Object.data(), Object.size(), In);
+      } else {
+        for (auto& Elt : Object) {
+          Packed::unpack(Elt, In);
+          In += Packed::Size;
+        }
+      }
+      return true;
+    } else {
+      Object.resize(Count);
+      bool Success = true;
+      std::for_each(Object.begin(), Object.end(), [&](auto& Elt) {
+        if (!auxdata_traits<typename T::value_type>::fromBytes(Elt, FBR))
+          Success = false;
+      });
+
+      return Success;
+    }
   }
+
+private:
+  static constexpr bool is_contiguous =
+      std::is_same_v<T, std::vector<typename T::value_type,
+                                    typename T::allocator_type>>;
 };
 
+// Helpers for filling set and mapping containers. Serialized sets and
+// mappings are usually in sorted order, so hinting at the end makes each
+// insertion into an ordered or sorted-vector container constant time, and
+// reserving up front avoids rehashing or regrowing the others.
+template <class T, class = void> struct has_emplace_hint : std::false_type {};
+template <class T>
+struct has_emplace_hint<
+    T, std::void_t<decltype(std::declval<T&>().emplace_hint(
+           std::declval<T&>().end(),
+           std::declval<typename T::value_type>()))>> : std::true_type {};
+
+template <class T, class = void> struct has_reserve : std::false_type {};
+template <class T>
+struct has_reserve<T,
+                   std::void_t<decltype(std::declval<T&>().reserve(size_t()))>>
+    : std::true_type {};
+
+template <class T> void reserveElements(T& Container, uint64_t Count) {
+  if constexpr (has_reserve<T>::value)
+    Container.reserve(Container.size() + Count);
+}
+
+template <class T, class... Args>
+void emplaceElement(T& Container, Args&&... As) {
+  if constexpr (has_emplace_hint<T>::value)
+    Container.emplace_hint(Container.end(), std::forward<Args>(As)...);
+  else
+    Container.emplace(std::forward<Args>(As)...);
+}
+
+// Adds the entries of From to Into: at the end of a sequence, into a set, or
+// into a mapping, replacing the entries of any keys already present.
+template <class T, class FromT> void mergeEntries(T& Into, FromT&& From) {
+  constexpr bool IsMove = std::is_rvalue_reference_v<FromT&&>;
+  if constexpr (is_sequence<T>::value) {
+    if constexpr (IsMove)
+      Into.insert(Into.end(), std::make_move_iterator(From.begin()),
+                  std::make_move_iterator(From.end()));
+    else
+      Into.insert(Into.end(), From.begin(), From.end());
+  } else if constexpr (is_set<T>::value) {
+    reserveElements(Into, From.size());
+    Into.insert(From.begin(), From.end());
+  } else {
+    reserveElements(Into, From.size());
+    for (auto& Elt : From) {
+      if constexpr (IsMove)
+        Into.insert_or_assign(Elt.first, std::move(Elt.second));
+      else
+        Into.insert_or_assign(Elt.first, Elt.second);
+    }
+  }
+}
+
+// Whether the elements of a set or mapping are iterated in hash order.
+template <class T, class = void> struct is_hashed : std::false_type {};
+template <class T>
+struct is_hashed<T, std::void_t<typename T::hasher>> : std::true_type {};
+
+// Whether T is or holds a set or mapping. Their entries are serialized in
+// whatever order the writer iterated them, so equal values of T may have
+// different serialized forms unless they are written to a canonical
+// ToByteRange.
+template <class T, class = void>
+struct has_keyed_elements : std::false_type {};
+template <class T>
+struct has_keyed_elements<T, std::enable_if_t<is_sequence<T>::value>>
+    : has_keyed_elements<typename T::value_type> {};
+template <class T>
+struct has_keyed_elements<
+    T, std::enable_if_t<is_set<T>::value || is_mapping<T>::value>>
+    : std::true_type {};
+template <class K, class V>
+struct has_keyed_elements<ColumnarMap<K, V>> : std::true_type {};
+template <class... Ts>
+struct has_keyed_elements<std::tuple<Ts...>>
+    : std::disjunction<has_keyed_elements<Ts>...> {};
+template <class T, class U>
+struct has_keyed_elements<std::pair<T, U>>
+    : std::disjunction<has_keyed_elements<T>, has_keyed_elements<U>> {};
+template <class... Ts>
+struct has_keyed_elements<std::variant<Ts...>>
+    : std::disjunction<has_keyed_elements<Ts>...> {};
+
+// Writes the elements of a hashed set or mapping in the order of their
+// serialized bytes, which does not depend on the hash function or on the
+// order in which the elements were inserted.
+template <class T, class WriteFn>
+void writeSortedElements(const T& Object, ToByteRange& TBR, WriteFn Write) {
+  std::vector<std::string> Elements;
+  Elements.reserve(Object.size());
+  for (const auto& Elt : Object) {
+    ToByteRange EltTBR(Elements.emplace_back(), true);
+    Write(Elt, EltTBR);
+  }
+  std::sort(Elements.begin(), Elements.end());
+  for (const std::string& Bytes : Elements)
+    TBR.write(Bytes.data(), Bytes.size());
+}
+
 template <class T>
 struct auxdata_traits<T, typename std::enable_if_t<is_set<T>::value>> {
   static std::string type_name() {
@@ -421,8 +781,17 @@ struct auxdata_traits<T, typename std::enable_if_t<is_set<T>::value>> {
 
   static void toBytes(const T& Object, ToByteRange& TBR) {
     auxdata_traits<uint64_t>::toBytes(Object.size(), TBR);
+    auto Write = [](const auto& Elt, ToByteRange& Out) {
+      auxdata_traits<typename T::value_type>::toBytes(Elt, Out);
+    };
+    if constexpr (is_hashed<T>::value) {
+      if (TBR.isCanonical()) {
+        writeSortedElements(Object, TBR, Write);
+        return;
+      }
+    }
     for (const auto& Elt : Object)
-      auxdata_traits<typename T::value_type>::toBytes(Elt, TBR);
+      Write(Elt, TBR);
   }
 
   static bool fromBytes(T& Object, FromByteRange& FBR) {
@@ -433,11 +802,12 @@ struct auxdata_traits<T, typename std::enable_if_t<is_set<T>::value>> {
     if (Count > FBR.remainingBytesToRead())
       return false;
 
+    reserveElements(Object, Count);
     for (uint64_t i = 0; i < Count; i++) {
       typename T::value_type V;
       if (!auxdata_traits<decltype(V)>::fromBytes(V, FBR))
         return false;
-      Object.emplace(std::move(V));
+      emplaceElement(Object, std::move(V));
     }
 
     return true;
@@ -453,10 +823,18 @@ struct auxdata_traits<T, typename std::enable_if_t<is_mapping<T>::value>> {
 
   static void toBytes(const T& Object, ToByteRange& TBR) {
     auxdata_traits<uint64_t>::toBytes(Object.size(), TBR);
-    std::for_each(Object.begin(), Object.end(), [&](const auto& Elt) {
-      auxdata_traits<typename T::key_type>::toBytes(Elt.first, TBR);
-      auxdata_traits<typename T::mapped_type>::toBytes(Elt.second, TBR);
-    });
+    auto Write = [](const auto& Elt, ToByteRange& Out) {
+      auxdata_traits<typename T::key_type>::toBytes(Elt.first, Out);
+      auxdata_traits<typename T::mapped_type>::toBytes(Elt.second, Out);
+    };
+    if constexpr (is_hashed<T>::value) {
+      if (TBR.isCanonical()) {
+        writeSortedElements(Object, TBR, Write);
+        return;
+      }
+    }
+    std::for_each(Object.begin(), Object.end(),
+                  [&](const auto& Elt) { Write(Elt, TBR); });
   }
 
   static bool fromBytes(T& Object, FromByteRange& FBR) {
@@ -467,6 +845,7 @@ struct auxdata_traits<T, typename std::enable_if_t<is_mapping<T>::value>> {
     if (Count > FBR.remainingBytesToRead())
       return false;
 
+    reserveElements(Object, Count);
     for (uint64_t i = 0; i < Count; i++) {
       typename T::key_type K;
       if (!auxdata_traits<decltype(K)>::fromBytes(K, FBR))
@@ -474,7 +853,50 @@ struct auxdata_traits<T, typename std::enable_if_t<is_mapping<T>::value>> {
       typename T::mapped_type V;
       if (!auxdata_traits<decltype(V)>::fromBytes(V, FBR))
         return false;
-      Object.emplace(std::move(K), std::move(V));
+      emplaceElement(Object, std::move(K), std::move(V));
+    }
+    return true;
+  }
+};
+
+template <class K, class V> struct auxdata_traits<ColumnarMap<K, V>> {
+  static_assert(packed_serialization<K>::value,
+                "ColumnarMap keys must have a fixed-width serialization");
+  using KeyPacked = packed_serialization<K>;
+
+  static std::string type_name() {
+    return "columnar-mapping<" + TypeId<K, V>::value() + ">";
+  }
+
+  static void toBytes(const ColumnarMap<K, V>& Object, ToByteRange& TBR) {
+    auxdata_traits<uint64_t>::toBytes(Object.size(), TBR);
+    char* Out = TBR.extend(Object.size() * KeyPacked::Size);
+    for (const auto& Elt : Object) {
+      KeyPacked::pack(Elt.first, Out);
+      Out += KeyPacked::Size;
+    }
+    for (const auto& Elt : Object)
+      auxdata_traits<V>::toBytes(Elt.second, TBR);
+  }
+
+  static bool fromBytes(ColumnarMap<K, V>& Object, FromByteRange& FBR) {
+    uint64_t Count;
+    if (!auxdata_traits<uint64_t>::fromBytes(Count, FBR))
+      return false;
+
+    if (Count > FBR.remainingBytesToRead() / KeyPacked::Size)
+      return false;
+
+    const char* Keys = FBR.consume(Count * KeyPacked::Size);
+    for (uint64_t I = 0; I < Count; ++I, Keys += KeyPacked::Size) {
+      K Key;
+      KeyPacked::unpack(Key, Keys);
+      V Value;
+      if (!auxdata_traits<V>::fromBytes(Value, FBR))
+        return false;
+      // Keys written by this class are sorted, so each insertion is at the
+      // end; the hint makes that constant time.
+      Object.emplace_hint(Object.end(), std::move(Key), std::move(Value));
     }
     return true;
   }
@@ -607,6 +1029,447 @@ template <class T, class... Ts> struct TypeId<T, Ts...> {
     return auxdata_traits<T>::type_name() + "," + TypeId<Ts...>::value();
   }
 };
+
+// The serialized type name of T. Building a name concatenates the names of
+// all the types nested in T, so it is built once and kept.
+template <class T> const std::string& auxDataTypeName() {
+  static const std::string Name = auxdata_traits<T>::type_name();
+  return Name;
+}
+/// @endcond
+
+/// \struct AuxDataCollectionStats
+///
+/// \brief Statistics reported by IR::collectAuxDataGarbage.
+///
+/// \see AUXDATA_GROUP
+struct AuxDataCollectionStats {
+  /// \brief Registered tables whose node references were checked.
+  size_t TablesScanned{0};
+  /// \brief Tables which had references remapped or removed.
+  size_t TablesChanged{0};
+  /// \brief References replaced by the UUID of another node.
+  size_t ReferencesRemapped{0};
+  /// \brief Sequence elements, set elements and mapping entries removed
+  /// because they referred to nodes no longer in the IR.
+  size_t ElementsRemoved{0};
+
+  /// \brief Accumulate the statistics of another collection.
+  AuxDataCollectionStats& operator+=(const AuxDataCollectionStats& Other) {
+    TablesScanned += Other.TablesScanned;
+    TablesChanged += Other.TablesChanged;
+    ReferencesRemapped += Other.ReferencesRemapped;
+    ElementsRemoved += Other.ElementsRemoved;
+    return *this;
+  }
+};
+
+/// \brief Marks a part of a schema's References type that holds no node
+/// references.
+///
+/// A schema lists the node references in its tables with a References type
+/// mirroring its Type. \ref IR::collectAuxDataGarbage treats a \ref UUID or
+/// \ref Offset in a table as a reference to a node exactly where References
+/// holds a UUID or Offset at the same position, and ignores everything in the
+/// place of a NoNodeReferences. Tables of schemas without a References type
+/// are not collected.
+struct NoNodeReferences {};
+
+/// @cond INTERNAL
+// Decides what happens to each node reference found during AuxData garbage
+// collection: references to live nodes are kept, references in Remap are
+// replaced, and anything else is dangling.
+struct AuxDataReferenceResolver {
+  const std::unordered_set<UUID, boost::hash<UUID>>& Live;
+  const std::unordered_map<UUID, UUID, boost::hash<UUID>>& Remap;
+
+  // Returns whether resolving Id would change or reject it.
+  bool affects(const UUID& Id) const {
+    return Remap.count(Id) != 0 || Live.count(Id) == 0;
+  }
+
+  // Remaps Id if requested. Returns false if it refers to a dead node.
+  bool resolve(UUID& Id, AuxDataCollectionStats& Stats) const {
+    if (auto It = Remap.find(Id); It != Remap.end()) {
+      Id = It->second;
+      ++Stats.ReferencesRemapped;
+    }
+    return Live.count(Id) != 0;
+  }
+};
+
+// Finds the node references (UUIDs and Offsets) in values stored in AuxData.
+//
+// ShapeT mirrors the structure of T and marks which of its UUIDs and Offsets
+// refer to nodes: one in T is a reference where ShapeT holds a UUID or Offset
+// at the same position, and everything under NoNodeReferences (or any other
+// type) is left alone. The shape of a table is its schema's References type.
+//
+// affected() returns whether any reference would be remapped or found
+// dangling. update() remaps references, removes container elements and
+// mapping entries holding dangling references, and returns false if the
+// value itself still holds a dangling reference, so that its own container
+// removes it in turn. Types with no references are left alone.
+template <class T, class ShapeT, class Enable = void>
+struct auxdata_reference_traits {
+  static constexpr bool HasReferences = false;
+  static bool affected(const T&, const AuxDataReferenceResolver&) {
+    return false;
+  }
+  static bool update(T&, const AuxDataReferenceResolver&,
+                     AuxDataCollectionStats&) {
+    return true;
+  }
+};
+
+// Whether a shape can mark references. Containers only look into the shape's
+// element types when it can.
+template <class ShapeT>
+constexpr bool is_reference_shape_v =
+    !std::is_same_v<ShapeT, NoNodeReferences>;
+
+// The shape of the node references in the tables of a schema.
+template <class Schema, class Enable = void> struct auxdata_schema_references {
+  using type = NoNodeReferences;
+};
+
+template <class Schema>
+struct auxdata_schema_references<Schema,
+                                 std::void_t<typename Schema::References>> {
+  using type = typename Schema::References;
+};
+
+template <> struct auxdata_reference_traits<UUID, UUID> {
+  static constexpr bool HasReferences = true;
+  static bool affected(const UUID& Id, const AuxDataReferenceResolver& R) {
+    return R.affects(Id);
+  }
+  static bool update(UUID& Id, const AuxDataReferenceResolver& R,
+                     AuxDataCollectionStats& Stats) {
+    return R.resolve(Id, Stats);
+  }
+};
+
+template <> struct auxdata_reference_traits<Offset, Offset> {
+  static constexpr bool HasReferences = true;
+  static bool affected(const Offset& O, const AuxDataReferenceResolver& R) {
+    return R.affects(O.ElementId);
+  }
+  static bool update(Offset& O, const AuxDataReferenceResolver& R,
+                     AuxDataCollectionStats& Stats) {
+    return R.resolve(O.ElementId, Stats);
+  }
+};
+
+template <class... Ts, class... Ss>
+struct auxdata_reference_traits<std::tuple<Ts...>, std::tuple<Ss...>> {
+  static_assert(sizeof...(Ts) == sizeof...(Ss),
+                "reference shape does not match the tuple");
+  static constexpr bool HasReferences =
+      (auxdata_reference_traits<Ts, Ss>::HasReferences || ...);
+  static bool affected(const std::tuple<Ts...>& Object,
+                       const AuxDataReferenceResolver& R) {
+    return std::apply(
+        [&R](const Ts&... Elts) {
+          return (auxdata_reference_traits<Ts, Ss>::affected(Elts, R) || ...);
+        },
+        Object);
+  }
+  static bool update(std::tuple<Ts...>& Object,
+                     const AuxDataReferenceResolver& R,
+                     AuxDataCollectionStats& Stats) {
+    return std::apply(
+        [&](Ts&... Elts) {
+          return (auxdata_reference_traits<Ts, Ss>::update(Elts, R, Stats) &
+                  ...);
+        },
+        Object);
+  }
+};
+
+template <class T, class U, class ST, class SU>
+struct auxdata_reference_traits<std::pair<T, U>, std::pair<ST, SU>> {
+  static constexpr bool HasReferences =
+      auxdata_reference_traits<T, ST>::HasReferences ||
+      auxdata_reference_traits<U, SU>::HasReferences;
+  static bool affected(const std::pair<T, U>& Object,
+                       const AuxDataReferenceResolver& R) {
+    return auxdata_reference_traits<T, ST>::affected(Object.first, R) ||
+           auxdata_reference_traits<U, SU>::affected(Object.second, R);
+  }
+  static bool update(std::pair<T, U>& Object, const AuxDataReferenceResolver& R,
+                     AuxDataCollectionStats& Stats) {
+    return auxdata_reference_traits<T, ST>::update(Object.first, R, Stats) &
+           auxdata_reference_traits<U, SU>::update(Object.second, R, Stats);
+  }
+};
+
+template <class... Ts, class... Ss>
+struct auxdata_reference_traits<std::variant<Ts...>, std::variant<Ss...>> {
+  static_assert(sizeof...(Ts) == sizeof...(Ss),
+                "reference shape does not match the variant");
+  static constexpr bool HasReferences =
+      (auxdata_reference_traits<Ts, Ss>::HasReferences || ...);
+  static bool affected(const std::variant<Ts...>& Object,
+                       const AuxDataReferenceResolver& R) {
+    return affected(Object, R, std::index_sequence_for<Ts...>());
+  }
+  static bool update(std::variant<Ts...>& Object,
+                     const AuxDataReferenceResolver& R,
+                     AuxDataCollectionStats& Stats) {
+    return update(Object, R, Stats, std::index_sequence_for<Ts...>());
+  }
+
+private:
+  // The shape of an alternative is the shape alternative at its index.
+  template <size_t I>
+  using Traits = auxdata_reference_traits<
+      std::variant_alternative_t<I, std::variant<Ts...>>,
+      std::variant_alternative_t<I, std::variant<Ss...>>>;
+
+  template <size_t... Is>
+  static bool affected(const std::variant<Ts...>& Object,
+                       const AuxDataReferenceResolver& R,
+                       std::index_sequence<Is...>) {
+    bool Result = false;
+    ((Object.index() == Is &&
+      (Result = Traits<Is>::affected(std::get<Is>(Object), R), true)) ||
+     ...);
+    return Result;
+  }
+  template <size_t... Is>
+  static bool update(std::variant<Ts...>& Object,
+                     const AuxDataReferenceResolver& R,
+                     AuxDataCollectionStats& Stats,
+                     std::index_sequence<Is...>) {
+    bool Result = true;
+    ((Object.index() == Is &&
+      (Result = Traits<Is>::update(std::get<Is>(Object), R, Stats), true)) ||
+     ...);
+    return Result;
+  }
+};
+
+// Shared by containers: whether any element of a range is affected.
+template <class ElementT, class ShapeT, class RangeT>
+bool anyReferenceAffected(const RangeT& Range,
+                          const AuxDataReferenceResolver& R) {
+  return std::any_of(Range.begin(), Range.end(), [&R](const auto& Elt) {
+    return auxdata_reference_traits<ElementT, ShapeT>::affected(Elt, R);
+  });
+}
+
+template <class T, class ShapeT>
+struct auxdata_reference_traits<
+    T, ShapeT,
+    typename std::enable_if_t<is_sequence<T>::value &&
+                              is_reference_shape_v<ShapeT>>> {
+  using ElementT = typename T::value_type;
+  using ElementShapeT = typename ShapeT::value_type;
+  using ElementTraits = auxdata_reference_traits<ElementT, ElementShapeT>;
+  static constexpr bool HasReferences = ElementTraits::HasReferences;
+  static bool affected(const T& Object, const AuxDataReferenceResolver& R) {
+    return anyReferenceAffected<ElementT, ElementShapeT>(Object, R);
+  }
+  static bool update(T& Object, const AuxDataReferenceResolver& R,
+                     AuxDataCollectionStats& Stats) {
+    // Compact the kept elements towards the front, preserving their order.
+    auto Out = Object.begin();
+    for (auto It = Object.begin(); It != Object.end(); ++It) {
+      if (!ElementTraits::update(*It, R, Stats)) {
+        ++Stats.ElementsRemoved;
+        continue;
+      }
+      if (Out != It)
+        *Out = std::move(*It);
+      ++Out;
+    }
+    Object.erase(Out, Object.end());
+    return true;
+  }
+};
+
+template <class T, class ShapeT>
+struct auxdata_reference_traits<
+    T, ShapeT,
+    typename std::enable_if_t<is_set<T>::value &&
+                              is_reference_shape_v<ShapeT>>> {
+  using ElementT = typename T::value_type;
+  using ElementShapeT = typename ShapeT::value_type;
+  using ElementTraits = auxdata_reference_traits<ElementT, ElementShapeT>;
+  static constexpr bool HasReferences = ElementTraits::HasReferences;
+  static bool affected(const T& Object, const AuxDataReferenceResolver& R) {
+    return anyReferenceAffected<ElementT, ElementShapeT>(Object, R);
+  }
+  static bool update(T& Object, const AuxDataReferenceResolver& R,
+                     AuxDataCollectionStats& Stats) {
+    // Set elements are immutable, so rebuild the set if anything changes.
+    if (!affected(Object, R))
+      return true;
+    T Result;
+    reserveElements(Result, Object.size());
+    for (const ElementT& Elt : Object) {
+      ElementT Copy = Elt;
+      if (ElementTraits::update(Copy, R, Stats))
+        emplaceElement(Result, std::move(Copy));
+      else
+        ++Stats.ElementsRemoved;
+    }
+    Object = std::move(Result);
+    return true;
+  }
+};
+
+template <class T, class ShapeT> struct mapping_reference_traits {
+  using KeyT = typename T::key_type;
+  using ValueT = typename T::mapped_type;
+  using KeyTraits =
+      auxdata_reference_traits<KeyT, typename ShapeT::key_type>;
+  using ValueTraits =
+      auxdata_reference_traits<ValueT, typename ShapeT::mapped_type>;
+  static constexpr bool HasReferences =
+      KeyTraits::HasReferences || ValueTraits::HasReferences;
+  static bool affected(const T& Object, const AuxDataReferenceResolver& R) {
+    return std::any_of(Object.begin(), Object.end(), [&R](const auto& Elt) {
+      return KeyTraits::affected(Elt.first, R) ||
+             ValueTraits::affected(Elt.second, R);
+    });
+  }
+  static bool update(T& Object, const AuxDataReferenceResolver& R,
+                     AuxDataCollectionStats& Stats) {
+    // Keys are immutable, so rebuild the mapping if anything changes.
+    if (!affected(Object, R))
+      return true;
+    T Result;
+    reserveElements(Result, Object.size());
+    for (auto& Elt : Object) {
+      KeyT Key = Elt.first;
+      if (KeyTraits::update(Key, R, Stats) &
+          ValueTraits::update(Elt.second, R, Stats))
+        emplaceElement(Result, std::move(Key), std::move(Elt.second));
+      else
+        ++Stats.ElementsRemoved;
+    }
+    Object = std::move(Result);
+    return true;
+  }
+};
+
+template <class T, class ShapeT>
+struct auxdata_reference_traits<
+    T, ShapeT,
+    typename std::enable_if_t<is_mapping<T>::value &&
+                              is_reference_shape_v<ShapeT>>>
+    : mapping_reference_traits<T, ShapeT> {};
+
+template <class K, class V, class ShapeT>
+struct auxdata_reference_traits<
+    ColumnarMap<K, V>, ShapeT,
+    typename std::enable_if_t<is_reference_shape_v<ShapeT>>>
+    : mapping_reference_traits<ColumnarMap<K, V>, ShapeT> {};
+/// @endcond
+
+/// @cond INTERNAL
+// Passes one element to a visitor. Returns false if the visitor returned
+// false to stop the visit.
+template <class Fn, class... Args> bool visitElement(Fn& F, const Args&... As) {
+  if constexpr (std::is_same_v<std::invoke_result_t<Fn&, const Args&...>,
+                               bool>) {
+    return F(As...);
+  } else {
+    F(As...);
+    return true;
+  }
+}
+
+// Passes the elements of sequences and sets, or the keys and values of
+// mappings, to a visitor one at a time.
+//
+// visitBytes() decodes each element from the serialized form just before
+// passing it, and returns false if the bytes are malformed. visitObject()
+// passes the elements of a table in memory. Both clear Continue if the
+// visitor stops the visit.
+template <class T, class Enable = void> struct auxdata_visit_traits;
+
+template <class T>
+struct auxdata_visit_traits<
+    T, typename std::enable_if_t<is_sequence<T>::value || is_set<T>::value>> {
+  template <class Fn>
+  static bool visitBytes(FromByteRange& FBR, Fn& F, bool& Continue) {
+    uint64_t Count;
+    if (!auxdata_traits<uint64_t>::fromBytes(Count, FBR) ||
+        Count > FBR.remainingBytesToRead())
+      return false;
+    for (uint64_t I = 0; I < Count && Continue; ++I) {
+      typename T::value_type Elt;
+      if (!auxdata_traits<typename T::value_type>::fromBytes(Elt, FBR))
+        return false;
+      Continue = visitElement(F, Elt);
+    }
+    return true;
+  }
+
+  template <class Fn>
+  static void visitObject(const T& Object, Fn& F, bool& Continue) {
+    for (auto It = Object.begin(); It != Object.end() && Continue; ++It)
+      Continue = visitElement(F, *It);
+  }
+};
+
+template <class T>
+struct auxdata_visit_traits<T,
+                            typename std::enable_if_t<is_mapping<T>::value>> {
+  template <class Fn>
+  static bool visitBytes(FromByteRange& FBR, Fn& F, bool& Continue) {
+    uint64_t Count;
+    if (!auxdata_traits<uint64_t>::fromBytes(Count, FBR) ||
+        Count > FBR.remainingBytesToRead())
+      return false;
+    for (uint64_t I = 0; I < Count && Continue; ++I) {
+      typename T::key_type Key;
+      typename T::mapped_type Value;
+      if (!auxdata_traits<typename T::key_type>::fromBytes(Key, FBR) ||
+          !auxdata_traits<typename T::mapped_type>::fromBytes(Value, FBR))
+        return false;
+      Continue = visitElement(F, Key, Value);
+    }
+    return true;
+  }
+
+  template <class Fn>
+  static void visitObject(const T& Object, Fn& F, bool& Continue) {
+    for (auto It = Object.begin(); It != Object.end() && Continue; ++It)
+      Continue = visitElement(F, It->first, It->second);
+  }
+};
+
+template <class K, class V> struct auxdata_visit_traits<ColumnarMap<K, V>> {
+  template <class Fn>
+  static bool visitBytes(FromByteRange& FBR, Fn& F, bool& Continue) {
+    using KeyPacked = packed_serialization<K>;
+    uint64_t Count;
+    if (!auxdata_traits<uint64_t>::fromBytes(Count, FBR) ||
+        Count > FBR.remainingBytesToRead() / KeyPacked::Size)
+      return false;
+    const char* Keys = FBR.consume(Count * KeyPacked::Size);
+    for (uint64_t I = 0; I < Count && Continue; ++I) {
+      K Key;
+      KeyPacked::unpack(Key, Keys + I * KeyPacked::Size);
+      V Value;
+      if (!auxdata_traits<V>::fromBytes(Value, FBR))
+        return false;
+      Continue = visitElement(F, Key, Value);
+    }
+    return true;
+  }
+
+  template <class Fn>
+  static void visitObject(const ColumnarMap<K, V>& Object, Fn& F,
+                          bool& Continue) {
+    for (auto It = Object.begin(); It != Object.end() && Continue; ++It)
+      Continue = visitElement(F, It->first, It->second);
+  }
+};
 /// @endcond
 
 /// @cond INTERNAL
@@ -636,7 +1499,10 @@ public:
   /// This interface is provided primarily as a means for clients to
   /// inspect the raw data of AuxData objects whose types have not
   /// been registered.
-  const SerializedForm& rawData() const { return this->SF; }
+  const SerializedForm& rawData() const {
+    static const SerializedForm Empty;
+    return SF ? *SF : Empty;
+  }
 
   /// !brief The degenerate api type id used for AuxData types that
   /// haven't been registered.
@@ -658,10 +1524,47 @@ protected:
   /// \brief Serialize into a protobuf message.
   ///
   /// \param[out] Message  A protobuf message representing the AuxData.
-  virtual void toProtobuf(MessageType* Message) const {
-    toProtobuf(Message, this->SF);
+  void toProtobuf(MessageType* Message) const {
+    SerializedForm Scratch;
+    toProtobuf(Message, encode(Scratch));
+  }
+
+  /// \brief Whether encode() has to re-encode the table.
+  virtual bool needsEncoding() const { return false; }
+
+  /// \brief Get the serialized form to write for this table.
+  ///
+  /// If the stored serialized form does not describe the table, the table is
+  /// encoded into \p Scratch. This only reads the table, so distinct tables
+  /// can be encoded concurrently.
+  ///
+  /// \param Scratch  Storage for a newly encoded form.
+  /// \return The serialized form to write.
+  virtual const SerializedForm& encode(SerializedForm& Scratch
+                                      [[maybe_unused]]) const {
+    return rawData();
+  }
+
+  /// \brief Get the serialized form of this table as written by a canonical
+  /// save, in which the elements of sets and mappings are written in an
+  /// order that depends only on their values.
+  ///
+  /// Untyped tables cannot be decoded, and are written as they were loaded.
+  ///
+  /// \param Scratch  Storage for a newly encoded form.
+  /// \return The serialized form to write.
+  virtual const SerializedForm& encodeCanonical(SerializedForm& Scratch) const {
+    return encode(Scratch);
   }
 
+  /// \brief Remap or remove the node references held by this table.
+  ///
+  /// Untyped tables cannot be inspected and are left alone.
+  virtual void collectGarbage(const AuxDataReferenceResolver& R
+                              [[maybe_unused]],
+                              AuxDataCollectionStats& Stats
+                              [[maybe_unused]]) {}
+
   // This version of protobuf accepts a SerializedForm object to
   // serialize rather than serializing AuxData's SerializedForm
   // member. This is used by AuxDataImpl to serialize a typed AuxData
@@ -678,6 +1581,10 @@ protected:
   static bool checkAuxDataMessageType(const AuxData::MessageType& Message,
                                       const std::string& ExpectedName);
 
+  /// \brief Share ownership of the serialized form the table was loaded
+  /// from, or get null if it was not loaded.
+  std::shared_ptr<const SerializedForm> sharedRawData() const { return SF; }
+
   // Present for testing purposes only.
   void save(std::ostream& Out) const;
 
@@ -686,9 +1593,12 @@ protected:
   load(std::istream& In, std::unique_ptr<AuxData> (*FPPtr)(const MessageType&));
 
 private:
-  SerializedForm SF;
+  // Set once when the table is loaded and never changed afterwards, so that
+  // views of it may share ownership of its bytes.
+  std::shared_ptr<const SerializedForm> SF;
 
   friend class AuxDataContainer; // Friend to enable fromProtobuf.
+  friend class IR;               // Enables IR::collectAuxDataGarbage.
   // Enables serialization by AuxDataContainer via containerToProtobuf.
   template <typename T> friend typename T::MessageType toProtobuf(const T&);
   friend class SerializationTestHarness; // Testing support.
@@ -698,8 +1608,15 @@ private:
 /// @cond INTERNAL
 template <class Schema> class AuxDataImpl : public AuxData {
 public:
+  /// \brief Whether entries can be appended to the table's serialized form.
+  static constexpr bool IsAppendable =
+      is_sequence<typename Schema::Type>::value ||
+      is_set<typename Schema::Type>::value ||
+      is_mapping<typename Schema::Type>::value;
+
   AuxDataImpl() = default;
-  AuxDataImpl(typename Schema::Type&& Val) : Object(std::move(Val)){};
+  AuxDataImpl(typename Schema::Type&& Val)
+      : Object(std::move(Val)), Decoded(true), Modified(true){};
 
   /// !brief Register/retrieve a type-trait-specific Id number.
   static std::size_t staticGetApiTypeId() {
@@ -711,43 +1628,184 @@ public:
     return staticGetApiTypeId();
   }
 
-  const typename Schema::Type* get() const { return &Object; }
+  /// \brief Get the table, decoding it from its serialized form on first
+  /// access.
+  ///
+  /// \return The table, or \c nullptr if it could not be decoded.
+  const typename Schema::Type* get() const {
+    std::call_once(DecodeOnce, [this]() {
+      if (!Decoded) {
+        FromByteRange FBR(rawData().RawBytes);
+        DecodeFailed =
+            !auxdata_traits<typename Schema::Type>::fromBytes(Object, FBR);
+        if constexpr (IsAppendable)
+          if (!DecodeFailed && Appended)
+            mergeEntries(Object, *Appended);
+        Decoded = true;
+      }
+    });
+    return DecodeFailed ? nullptr : &Object;
+  }
+
+  /// \brief Get the table for modification.
+  ///
+  /// Once this is called, the table is re-encoded when it is serialized
+  /// rather than written back from the bytes it was loaded from.
+  ///
+  /// \return The table, or \c nullptr if it could not be decoded.
+  typename Schema::Type* getMutable() {
+    const typename Schema::Type* Result = get();
+    if (!Result)
+      return nullptr;
+    Modified = true;
+    Appended.reset();
+    LoadedKeys.reset();
+    return &Object;
+  }
+
+  /// \brief Get the serialized form of the table.
+  ///
+  /// If the table has not been changed since it was loaded, this shares
+  /// ownership of the bytes it was loaded from, without copying or decoding
+  /// them. Otherwise the table is encoded into a new buffer. Either way the
+  /// bytes outlive any later change to the table or its removal.
+  std::shared_ptr<const std::string> serializedBytes() const {
+    if (!needsEncoding()) {
+      if (std::shared_ptr<const SerializedForm> Form = sharedRawData())
+        return std::shared_ptr<const std::string>(Form, &Form->RawBytes);
+      return std::make_shared<const std::string>();
+    }
+    SerializedForm Scratch;
+    encode(Scratch);
+    return std::make_shared<std::string>(std::move(Scratch.RawBytes));
+  }
 
 private:
   static std::unique_ptr<AuxData> fromProtobuf(const MessageType& Message) {
     // Check if the serialized type isn't compatible with the type
     // we're trying to deserialize to.
     if (!checkAuxDataMessageType(
-            Message, auxdata_traits<typename Schema::Type>::type_name())) {
+            Message, auxDataTypeName<typename Schema::Type>())) {
       return nullptr;
     }
 
     // Note: Do not access Message's contents here. That would introduce
     // dllexport/dllimport problems on Windows. Call the base class's
-    // fromProtobuf function and then unserialize from its
-    // SerializedForm structure.
+    // fromProtobuf function; the contents are decoded from its
+    // SerializedForm structure when they are first accessed.
     auto TypedAuxData = std::make_unique<AuxDataImpl<Schema>>();
     AuxData::fromProtobuf(*TypedAuxData, Message);
-    FromByteRange FBR(TypedAuxData->rawData().RawBytes);
-    if (!auxdata_traits<typename Schema::Type>::fromBytes(TypedAuxData->Object,
-                                                          FBR))
-      return nullptr;
     return TypedAuxData;
   }
 
-  /// \brief Serialize into a protobuf message.
-  ///
-  /// \param Message     The Message to serialize into.
-  virtual void toProtobuf(MessageType* Message) const override {
-    // Note: Do not edit Message's contents here. That would introduce
-    // dllexport/dllimport problems on Windows. Store to a
-    // SerializedForm, and then call the base class's toProtobuf
-    // function.
-    AuxData::SerializedForm TypedSF;
-    TypedSF.ProtobufType = auxdata_traits<typename Schema::Type>::type_name();
-    ToByteRange TBR(TypedSF.RawBytes);
-    auxdata_traits<typename Schema::Type>::toBytes(this->Object, TBR);
-    AuxData::toProtobuf(Message, TypedSF);
+  // Passes the elements of the table to F, streaming them from the loaded
+  // bytes unless the table was modified. Returns false if the bytes are
+  // malformed.
+  template <class Fn> bool visit(Fn& F) const {
+    using Visit = auxdata_visit_traits<typename Schema::Type>;
+    bool Continue = true;
+    if (Modified) {
+      Visit::visitObject(Object, F, Continue);
+      return true;
+    }
+    FromByteRange FBR(rawData().RawBytes);
+    if (!Visit::visitBytes(FBR, F, Continue))
+      return false;
+    if (Continue && Appended)
+      Visit::visitObject(*Appended, F, Continue);
+    return true;
+  }
+
+  // Appends Entries to a table which has not been modified since it was
+  // loaded, without decoding it. None of the keys of Entries may already be
+  // in the loaded table, so that the entries can be encoded after its bytes.
+  void appendEntries(typename Schema::Type&& Entries) {
+    assert(!Modified && "appending entries to a modified table");
+    if (Decoded)
+      mergeEntries(Object, Entries);
+    if (Appended)
+      mergeEntries(*Appended, std::move(Entries));
+    else
+      Appended = std::move(Entries);
+  }
+
+  bool needsEncoding() const override { return Modified || Appended; }
+
+  void collectGarbage(const AuxDataReferenceResolver& R,
+                      AuxDataCollectionStats& Stats) override {
+    using Refs = auxdata_reference_traits<
+        typename Schema::Type,
+        typename auxdata_schema_references<Schema>::type>;
+    if constexpr (Refs::HasReferences) {
+      // Tables without dangling or remapped references are not decoded for
+      // modification, so they are still written back from their original
+      // bytes.
+      const typename Schema::Type* Table = get();
+      if (!Table)
+        return;
+      ++Stats.TablesScanned;
+      if (!Refs::affected(*Table, R))
+        return;
+      ++Stats.TablesChanged;
+      Refs::update(*getMutable(), R, Stats);
+    }
+  }
+
+  // Note: Do not edit a protobuf Message here. That would introduce
+  // dllexport/dllimport problems on Windows. The base class's toProtobuf
+  // function copies the SerializedForm into the message.
+  const SerializedForm& encode(SerializedForm& Scratch) const override {
+    if (!needsEncoding())
+      return rawData();
+    Scratch.ProtobufType = auxDataTypeName<typename Schema::Type>();
+    ToByteRange TBR(Scratch.RawBytes);
+    if (Modified) {
+      auxdata_traits<typename Schema::Type>::toBytes(this->Object, TBR);
+      return Scratch;
+    }
+
+    if constexpr (IsAppendable) {
+      // Sequences, sets and mappings are a count followed by their entries,
+      // and the appended keys are not in the loaded table, so the appended
+      // entries can follow the loaded bytes under the combined count.
+      std::string Tail;
+      ToByteRange TailTBR(Tail);
+      auxdata_traits<typename Schema::Type>::toBytes(*Appended, TailTBR);
+      FromByteRange Loaded(rawData().RawBytes), New(Tail);
+      uint64_t LoadedCount, NewCount;
+      [[maybe_unused]] bool Read =
+          auxdata_traits<uint64_t>::fromBytes(LoadedCount, Loaded) &&
+          auxdata_traits<uint64_t>::fromBytes(NewCount, New);
+      assert(Read && "appended entries to a malformed table");
+      auxdata_traits<uint64_t>::toBytes(LoadedCount + NewCount, TBR);
+      size_t LoadedSize = Loaded.remainingBytesToRead();
+      size_t NewSize = New.remainingBytesToRead();
+      TBR.reserve(LoadedSize + NewSize);
+      TBR.write(Loaded.consume(LoadedSize), LoadedSize);
+      TBR.write(New.consume(NewSize), NewSize);
+    }
+    return Scratch;
+  }
+
+  // Tables holding sets or mappings are decoded and encoded again, since
+  // the bytes they were loaded from are in the writer's iteration order, as
+  // are tables with appended entries, which are spliced after the loaded
+  // ones rather than merged into them.
+  const SerializedForm&
+  encodeCanonical(SerializedForm& Scratch) const override {
+    using Type = typename Schema::Type;
+    if constexpr (has_keyed_elements<Type>::value || IsAppendable) {
+      if (has_keyed_elements<Type>::value || Appended) {
+        const Type* Table = get();
+        if (!Table)
+          return rawData();
+        Scratch.ProtobufType = auxDataTypeName<Type>();
+        ToByteRange TBR(Scratch.RawBytes, true);
+        auxdata_traits<Type>::toBytes(*Table, TBR);
+        return Scratch;
+      }
+    }
+    return encode(Scratch);
   }
 
   // Present for testing purposes only.
@@ -760,7 +1818,21 @@ private:
         static_cast<AuxDataImpl*>(AuxData::load(In, fromProtobuf).release())};
   }
 
-  typename Schema::Type Object;
+  // Loaded tables are decoded on first access, which may happen
+  // concurrently through const accessors, hence the once_flag. Modified
+  // records whether the serialized bytes no longer describe Object, either
+  // because Object was created in memory or because it was handed out for
+  // modification. Otherwise, the table is the loaded bytes plus the entries
+  // in Appended, which are also in Object once it is decoded.
+  mutable typename Schema::Type Object;
+  mutable std::once_flag DecodeOnce;
+  mutable bool Decoded{false};
+  mutable bool DecodeFailed{false};
+  bool Modified{false};
+  std::optional<typename Schema::Type> Appended;
+  // The keys of the loaded bytes, indexed by AuxDataContainer on the first
+  // append so that later appends do not search the bytes again.
+  std::shared_ptr<const AuxDataKeyIndex<Schema>> LoadedKeys;
 
   friend class AuxDataContainer;         // Friend to enable to/fromProtobuf.
   friend class SerializationTestHarness; // Testing support.
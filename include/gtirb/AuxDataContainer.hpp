@@ -17,10 +17,14 @@
 #define GTIRB_AUXDATACONTAINER_H
 
 #include <gtirb/AuxData.hpp>
+#include <gtirb/AuxDataView.hpp>
 #include <gtirb/Node.hpp>
 #include <boost/iterator/transform_iterator.hpp>
 #include <boost/range/iterator_range.hpp>
+#include <functional>
+#include <optional>
 #include <type_traits>
+#include <vector>
 
 /// \file AuxDataContainer.hpp
 /// \brief Class gtirb::AuxDataContainer.
@@ -62,8 +66,8 @@ public:
 
   /// \brief Register a type to be used with AuxData of the given name.
   template <typename Schema> static void registerAuxDataType() {
-    registerAuxDataTypeInternal(Schema::Name,
-                                std::make_unique<AuxDataTypeImpl<Schema>>());
+    AuxDataTypeImpl<Schema>::Slot = registerAuxDataTypeInternal(
+        Schema::Name, std::make_unique<AuxDataTypeImpl<Schema>>());
   }
 
   /// \brief Add a new \ref AuxData, transferring ownership.
@@ -74,11 +78,52 @@ public:
   ///
   template <typename Schema> void addAuxData(typename Schema::Type&& X) {
     // Make sure this type matches a registered type.
-    assert(checkAuxDataRegistration(
-               Schema::Name, AuxDataImpl<Schema>::staticGetApiTypeId()) &&
+    assert(isAuxDataRegistered<Schema>() &&
            "Attempting to add AuxData with unregistered or incorrect type.");
-    this->AuxDatas[Schema::Name] =
-        std::make_unique<AuxDataImpl<Schema>>(std::move(X));
+    auto& Table = this->AuxDatas[Schema::Name];
+    Table = std::make_unique<AuxDataImpl<Schema>>(std::move(X));
+    setSlot(slotOf<Schema>(), Table.get());
+  }
+
+  /// \brief Add entries to an \ref AuxData table, adding the table if it is
+  ///        not present.
+  ///
+  /// Entries are added at the end of a sequence, or inserted into a set or
+  /// mapping, replacing the entries of any mapping keys already present.
+  ///
+  /// A table which was loaded and has not been modified since is not decoded
+  /// when none of the keys of \p Entries are in it. Instead, the entries are
+  /// kept apart, and saving the table writes them after the bytes it was
+  /// loaded from, so that only the new entries are encoded. Replacing
+  /// existing entries, or calling the non-const getAuxData(), causes the
+  /// whole table to be encoded again when saved.
+  ///
+  /// \param Entries  The entries to add.
+  ///
+  /// \return \c false if the table is present but could not be decoded, in
+  ///         which case it is left unchanged, \c true otherwise.
+  ///
+  /// Note that this function can only be used for AuxData for which a
+  /// type has been registered with registerAuxDataType(), and whose type is
+  /// a sequence, set or mapping.
+  template <typename Schema>
+  bool appendAuxData(typename Schema::Type&& Entries) {
+    static_assert(AuxDataImpl<Schema>::IsAppendable,
+                  "only sequences, sets and mappings can be appended to");
+    auto* ADI = const_cast<AuxDataImpl<Schema>*>(findAuxData<Schema>());
+    if (!ADI) {
+      addAuxData<Schema>(std::move(Entries));
+      return true;
+    }
+    if (!ADI->Modified && loadedAuxDataLacksKeys(*ADI, Entries)) {
+      ADI->appendEntries(std::move(Entries));
+      return true;
+    }
+    typename Schema::Type* Table = ADI->getMutable();
+    if (!Table)
+      return false;
+    mergeEntries(*Table, std::move(Entries));
+    return true;
   }
 
   /// \brief Get a reference to the underlying type stored in the \ref
@@ -90,8 +135,8 @@ public:
   /// Note that this function can only be used for AuxData for which a
   /// type has been registered with registerAuxDataType().
   template <typename Schema> typename Schema::Type* getAuxData() {
-    return const_cast<typename Schema::Type*>(
-        const_cast<const AuxDataContainer*>(this)->getAuxData<Schema>());
+    auto* ADI = const_cast<AuxDataImpl<Schema>*>(findAuxData<Schema>());
+    return ADI ? ADI->getMutable() : nullptr;
   }
 
   /// \brief Get a reference to the underlying type stored in the \ref
@@ -103,42 +148,55 @@ public:
   /// Note that this function can only be used for AuxData for which a
   /// type has been registered with registerAuxDataType().
   template <typename Schema> const typename Schema::Type* getAuxData() const {
-    auto Found = this->AuxDatas.find(Schema::Name);
-
-    if (Found == this->AuxDatas.end())
-      return nullptr;
-
-    AuxData& AD = *(Found->second);
-
-    // Is the type of the AuxData registered?
-    if (AD.getApiTypeId() == AuxData::UNREGISTERED_API_TYPE_ID) {
-      // We can get here for two reasons:
-      //
-      //  1) The type is not registered. We treat this as a developer
-      //  error and assert. getAuxData should only ever be called for
-      //  types that are registered.
-      //
-      //  2) The type is registered, but the attempt to unserialized
-      //  the AuxData using the registered type failed. This is a
-      //  legitimate runtime error situation. An example might be
-      //  loading a GTIRB file that has a previous version of the
-      //  AuxData with a different type. In this situation, we don't
-      //  want to assert, just return nullptr.
-      assert(checkAuxDataRegistration(
-                 Schema::Name, AuxDataImpl<Schema>::staticGetApiTypeId()) &&
-             "Attempting to retrieve AuxData with an unregistered type.");
-      return nullptr;
-    }
+    const AuxDataImpl<Schema>* ADI = findAuxData<Schema>();
+    return ADI ? ADI->get() : nullptr;
+  }
 
-    // Does the type match the type being requested?
-    if (AD.getApiTypeId() != AuxDataImpl<Schema>::staticGetApiTypeId()) {
-      assert(false && "Attempting to retrieve AuxData with incorrect type.");
-      return nullptr;
-    }
+  /// \brief Get a read-only view of the data stored in the \ref AuxData by
+  ///        name, decoded directly from its serialized form.
+  ///
+  /// Unlike getAuxData(), this does not decode the whole table: strings,
+  /// sequences, sets and mappings are decoded element by element as they
+  /// are accessed. See \ref auxdata_view_traits for the view types. The
+  /// view shares ownership of the bytes it reads, so it stays valid after
+  /// the table is modified, replaced or removed.
+  ///
+  /// \return     The view if found and well formed,
+  ///             \c std::nullopt otherwise.
+  ///
+  /// Note that this function can only be used for AuxData for which a
+  /// type has been registered with registerAuxDataType().
+  template <typename Schema>
+  std::optional<AuxDataView<Schema>> getAuxDataView() const {
+    const AuxDataImpl<Schema>* ADI = findAuxData<Schema>();
+    if (!ADI)
+      return std::nullopt;
+    return AuxDataView<Schema>::fromBytes(ADI->serializedBytes());
+  }
 
-    // If we get here, it should be safe to downcast to the typed AuxDataImpl.
-    auto& ADI = static_cast<AuxDataImpl<Schema>&>(AD);
-    return ADI.get();
+  /// \brief Pass the contents of an \ref AuxData table to a function one
+  ///        element at a time, without decoding the whole table.
+  ///
+  /// Elements of sequences and sets are passed as a single argument, and
+  /// entries of mappings as a key and a value, by const reference. Each
+  /// element is decoded from the table's serialized form just before it is
+  /// passed and discarded afterwards, so the memory used does not grow with
+  /// the size of the table. Tables created or modified in memory are visited
+  /// in memory instead.
+  ///
+  /// \param F  The function to call with each element. If it returns a \c
+  ///           bool, returning \c false stops the visit.
+  ///
+  /// \return \c false if the table is not present or is malformed, \c true
+  ///         otherwise, including if \p F stopped the visit. Elements before
+  ///         a malformed one are passed to \p F.
+  ///
+  /// Note that this function can only be used for AuxData for which a
+  /// type has been registered with registerAuxDataType(), and whose type is
+  /// a sequence, set or mapping.
+  template <typename Schema, typename Fn> bool visitAuxData(Fn F) const {
+    const AuxDataImpl<Schema>* ADI = findAuxData<Schema>();
+    return ADI && ADI->visit(F);
   }
 
   /// \brief Remove an \ref AuxData by schema.
@@ -150,9 +208,9 @@ public:
   /// Note that this function can only be used for AuxData for which a
   /// type has been registered with registerAuxDataType().
   template <typename Schema> bool removeAuxData() {
-    assert(checkAuxDataRegistration(
-               Schema::Name, AuxDataImpl<Schema>::staticGetApiTypeId()) &&
+    assert(isAuxDataRegistered<Schema>() &&
            "Attempting to remove AuxData with an unregistered type.");
+    setSlot(slotOf<Schema>(), nullptr);
     return this->AuxDatas.erase(Schema::Name) > 0;
   }
 
@@ -165,6 +223,8 @@ public:
   /// Note that this function can be used for any AuxData regardless
   /// of whether or not it has a registered schema.
   bool removeAuxData(std::string Name) {
+    if (const auto* ADT = lookupAuxDataType(Name))
+      setSlot(ADT->Slot, nullptr);
     return this->AuxDatas.erase(Name) > 0;
   }
 
@@ -252,7 +312,10 @@ public:
   ///
   /// \return void
   ///
-  void clearAuxData() { AuxDatas.clear(); }
+  void clearAuxData() {
+    AuxDatas.clear();
+    Slots.clear();
+  }
 
   /// @}
   /// @cond INTERNAL
@@ -260,13 +323,23 @@ public:
   /// \brief Serialize the aux data into a protobuf message.
   ///
   /// \param[out] Message   Serialize into this message.
+  /// \param Canonical      Whether to write the entries of hashed containers
+  ///                        in a canonical order, as for \ref
+  ///                        IR::saveCanonical.
   ///
   /// \return void
   template <
       class MessageType,
       class = std::enable_if_t<message_has_aux_data_container_v<MessageType>>>
-  void toProtobuf(MessageType* Message) const {
-    containerToProtobuf(this->AuxDatas, Message->mutable_aux_data());
+  void toProtobuf(MessageType* Message, bool Canonical = false) const {
+    std::vector<AuxData::SerializedForm> Scratch;
+    std::vector<const AuxData::SerializedForm*> Forms =
+        encodeAuxData(Scratch, getContext().getThreadCount(), Canonical);
+    auto* Map = Message->mutable_aux_data();
+    Map->clear();
+    auto Form = Forms.begin();
+    for (const auto& [Key, AD] : this->AuxDatas)
+      AD->toProtobuf(&(*Map)[Key], **Form++);
   }
 
   /// \brief Load the aux data from a protobuf message.
@@ -279,12 +352,14 @@ public:
       class = std::enable_if_t<message_has_aux_data_container_v<MessageType>>>
   void fromProtobuf(const MessageType& Message) {
     this->AuxDatas.clear();
+    this->Slots.clear();
     for (const auto& M : Message.aux_data()) {
       std::unique_ptr<AuxData> Val;
       std::string Key = M.first;
 
       // See if the name for this AuxData is registered.
-      if (const auto* ADT = lookupAuxDataType(Key)) {
+      const auto* ADT = lookupAuxDataType(Key);
+      if (ADT) {
         Val = ADT->fromProtobuf(M.second);
       }
 
@@ -295,11 +370,27 @@ public:
         Val = std::make_unique<AuxData>();
         AuxData::fromProtobuf(*Val, M.second);
       }
+      if (ADT)
+        setSlot(ADT->Slot, Val.get());
       this->AuxDatas.insert(std::make_pair(Key, std::move(Val)));
     }
     /// @endcond
   }
 
+  /// @cond INTERNAL
+  /// \brief Encode the tables which need it, in parallel, and return the
+  /// serialized form of each table in key order.
+  ///
+  /// \param[out] Scratch    Storage for the newly encoded forms.
+  /// \param NumThreads      The number of threads to encode with.
+  /// \param Canonical       Whether to use \ref AuxData::encodeCanonical.
+  ///
+  /// \return The serialized forms, which are valid while Scratch is.
+  std::vector<const AuxData::SerializedForm*>
+  encodeAuxData(std::vector<AuxData::SerializedForm>& Scratch,
+                unsigned NumThreads, bool Canonical = false) const;
+  /// @endcond
+
 protected:
   AuxDataContainer(Context& C, Kind knd);
   AuxDataContainer(Context& C, Kind knd, const UUID& U);
@@ -307,11 +398,21 @@ protected:
 private:
   AuxDataSet AuxDatas;
 
+  // The table stored under each registered name, indexed by the slot number
+  // assigned to the name when it was registered, so that typed accessors
+  // need not look tables up by name. Null or missing entries mean there is
+  // no table under that name.
+  std::vector<AuxData*> Slots;
+
   struct AuxDataType {
+    static constexpr size_t NoSlot = static_cast<size_t>(-1);
+
     virtual ~AuxDataType() = default;
     virtual std::unique_ptr<AuxData>
     fromProtobuf(const proto::AuxData& Message) const = 0;
     virtual std::size_t getApiTypeId() const = 0;
+
+    size_t Slot{NoSlot};
   };
 
   template <typename Schema> struct AuxDataTypeImpl : public AuxDataType {
@@ -323,13 +424,126 @@ private:
     std::size_t getApiTypeId() const override {
       return AuxDataImpl<Schema>::staticGetApiTypeId();
     }
+
+    // The slot of Schema::Name, once Schema is registered. This is per
+    // module on platforms where templates' static data is not shared between
+    // shared libraries, so slotOf falls back to a lookup by name.
+    static inline size_t Slot = NoSlot;
   };
 
-  static void registerAuxDataTypeInternal(const char* Name,
-                                          std::unique_ptr<AuxDataType> ADT);
+  template <typename Schema> static size_t slotOf() {
+    if (AuxDataTypeImpl<Schema>::Slot != AuxDataType::NoSlot)
+      return AuxDataTypeImpl<Schema>::Slot;
+    const auto* ADT = lookupAuxDataType(Schema::Name);
+    return ADT ? ADT->Slot : AuxDataType::NoSlot;
+  }
+
+  template <typename Schema> static bool isAuxDataRegistered() {
+    return AuxDataTypeImpl<Schema>::Slot != AuxDataType::NoSlot ||
+           checkAuxDataRegistration(Schema::Name,
+                                    AuxDataImpl<Schema>::staticGetApiTypeId());
+  }
+
+  void setSlot(size_t Slot, AuxData* Table) {
+    if (Slot == AuxDataType::NoSlot)
+      return;
+    if (Slot >= Slots.size())
+      Slots.resize(Slot + 1, nullptr);
+    Slots[Slot] = Table;
+  }
+
+  // Whether a table which has not been modified since it was loaded is well
+  // formed and has none of the keys of Entries, checked against its bytes
+  // unless it has already been decoded. The keys of the bytes are indexed
+  // once, on the first append. Keys which cannot be compared through views
+  // are assumed to be present.
+  template <typename Schema>
+  static bool loadedAuxDataLacksKeys(AuxDataImpl<Schema>& ADI,
+                                     const typename Schema::Type& Entries) {
+    using Type = typename Schema::Type;
+    if (ADI.Decoded) {
+      const Type* Table = ADI.get();
+      if (!Table)
+        return false;
+      if constexpr (is_sequence<Type>::value)
+        return true;
+      else
+        return std::none_of(
+            Entries.begin(), Entries.end(), [Table](const auto& Elt) {
+              if constexpr (is_set<Type>::value)
+                return Table->count(Elt) != 0;
+              else
+                return Table->count(Elt.first) != 0;
+            });
+    }
+
+    // Entries appended earlier are not checked: merging replaces them.
+    if constexpr (AuxDataKeyIndex<Schema>::IsSearchable) {
+      if (!ADI.LoadedKeys) {
+        auto Index = AuxDataKeyIndex<Schema>::fromBytes(ADI.rawData().RawBytes);
+        if (!Index)
+          return false;
+        ADI.LoadedKeys =
+            std::make_shared<const AuxDataKeyIndex<Schema>>(std::move(*Index));
+      }
+      return !ADI.LoadedKeys->containsAnyOf(Entries);
+    }
+    return false;
+  }
+
+  // Returns the typed AuxData stored under Schema::Name, if any.
+  template <typename Schema>
+  const AuxDataImpl<Schema>* findAuxData() const {
+    const AuxData* Found = nullptr;
+    if (size_t Slot = slotOf<Schema>(); Slot != AuxDataType::NoSlot) {
+      if (Slot < Slots.size())
+        Found = Slots[Slot];
+    } else if (auto It = this->AuxDatas.find(Schema::Name);
+               It != this->AuxDatas.end()) {
+      Found = It->second.get();
+    }
+
+    if (!Found)
+      return nullptr;
+
+    const AuxData& AD = *Found;
+
+    // Is the type of the AuxData registered?
+    if (AD.getApiTypeId() == AuxData::UNREGISTERED_API_TYPE_ID) {
+      // We can get here for two reasons:
+      //
+      //  1) The type is not registered. We treat this as a developer
+      //  error and assert. getAuxData should only ever be called for
+      //  types that are registered.
+      //
+      //  2) The type is registered, but the attempt to unserialized
+      //  the AuxData using the registered type failed. This is a
+      //  legitimate runtime error situation. An example might be
+      //  loading a GTIRB file that has a previous version of the
+      //  AuxData with a different type. In this situation, we don't
+      //  want to assert, just return nullptr.
+      assert(checkAuxDataRegistration(
+                 Schema::Name, AuxDataImpl<Schema>::staticGetApiTypeId()) &&
+             "Attempting to retrieve AuxData with an unregistered type.");
+      return nullptr;
+    }
+
+    // Does the type match the type being requested?
+    if (AD.getApiTypeId() != AuxDataImpl<Schema>::staticGetApiTypeId()) {
+      assert(false && "Attempting to retrieve AuxData with incorrect type.");
+      return nullptr;
+    }
+
+    // If we get here, it should be safe to downcast to the typed AuxDataImpl.
+    return static_cast<const AuxDataImpl<Schema>*>(&AD);
+  }
+
+  static size_t registerAuxDataTypeInternal(const char* Name,
+                                            std::unique_ptr<AuxDataType> ADT);
   static bool checkAuxDataRegistration(const char* Name, std::size_t Id);
   static const AuxDataType* lookupAuxDataType(const std::string& Name);
   friend struct AuxDataTypeMap; // Allows AuxDataTypeMap to use AuxDataType
+  friend class IR;              // Enables IR::collectAuxDataGarbage.
 };
 } // namespace gtirb
 #endif // GTIRB_AUXDATACONTAINER_H
@@ -17,6 +17,7 @@
 #define GTIRB_AUXDATASCHEMA_HPP
 
 #include <gtirb/Addr.hpp>
+#include <gtirb/AuxData.hpp>
 #include <gtirb/Context.hpp> // UUID
 #include <gtirb/Offset.hpp>
 #include <cstdint>
@@ -30,54 +31,69 @@
 /// \see AUXDATA_GROUP
 
 namespace gtirb {
+
 namespace schema {
 
 /// \brief Schema class for functionBlocks auxiliary data.
+///
+/// The keys are function UUIDs, which are not nodes.
 struct FunctionBlocks {
   static constexpr const char* Name = "functionBlocks";
   typedef std::map<gtirb::UUID, std::set<gtirb::UUID>> Type;
+  typedef std::map<NoNodeReferences, std::set<gtirb::UUID>> References;
 };
 
 /// \brief Schema class for functionEntries auxiliary data.
+///
+/// The keys are function UUIDs, which are not nodes.
 struct FunctionEntries {
   static constexpr const char* Name = "functionEntries";
   typedef std::map<gtirb::UUID, std::set<gtirb::UUID>> Type;
+  typedef std::map<NoNodeReferences, std::set<gtirb::UUID>> References;
 };
 
 /// \brief Schema class for functionNames auxiliary data.
+///
+/// The keys are function UUIDs, which are not nodes.
 struct FunctionNames {
   static constexpr const char* Name = "functionNames";
   typedef std::map<gtirb::UUID, gtirb::UUID> Type;
+  typedef std::map<NoNodeReferences, gtirb::UUID> References;
 };
 
 /// \brief Schema class for types auxiliary data.
 struct Types {
   static constexpr const char* Name = "types";
   typedef std::map<gtirb::UUID, std::string> Type;
+  typedef Type References;
 };
 
 /// \brief Schema class for alignment auxiliary data.
 struct Alignment {
   static constexpr const char* Name = "alignment";
   typedef std::map<gtirb::UUID, uint64_t> Type;
+  typedef Type References;
 };
 
 /// \brief Schema class for comments auxiliary data.
 struct Comments {
   static constexpr const char* Name = "comments";
   typedef std::map<gtirb::Offset, std::string> Type;
+  typedef Type References;
 };
 
 /// \brief Schema class for symbolForwarding auxiliary data.
 struct SymbolForwarding {
   static constexpr const char* Name = "symbolForwarding";
   typedef std::map<gtirb::UUID, gtirb::UUID> Type;
+  typedef Type References;
 };
 
 /// \brief Schema class for padding auxiliary data.
 struct Padding {
   static constexpr const char* Name = "padding";
   typedef std::map<gtirb::Offset, uint64_t> Type;
+  typedef Type References;
 };
 
 /// \brief Schema class for ELF file's dynamic entry DT_INIT.
@@ -85,6 +101,7 @@ struct Padding {
 struct ElfDynamicInit {
   static constexpr const char* Name = "elfDynamicInit";
   typedef gtirb::UUID Type;
+  typedef Type References;
 };
 
 /// \brief Schema class for ELF file's dynamic entry DT_FINI.
@@ -92,6 +109,7 @@ struct ElfDynamicInit {
 struct ElfDynamicFini {
   static constexpr const char* Name = "elfDynamicFini";
   typedef gtirb::UUID Type;
+  typedef Type References;
 };
 
 /// \brief Schema class for ELF file's dynamic entry DT_SONAME.
@@ -123,6 +141,7 @@ namespace provisional_schema {
 struct Profile {
   static constexpr const char* Name = "profile";
   typedef std::map<gtirb::Offset, uint64_t> Type;
+  typedef Type References;
 };
 
 /// Version identifiers are 16 bit unsigned integers.
@@ -152,6 +171,9 @@ struct ElfSymbolVersions {
   static constexpr const char* Name = "elfSymbolVersions";
   typedef std::tuple<ElfSymVerDefs, ElfSymVerNeeded, ElfSymbolVersionsEntries>
       Type;
+  typedef std::tuple<NoNodeReferences, NoNodeReferences,
+                     ElfSymbolVersionsEntries>
+      References;
 };
 
 } // namespace provisional_schema
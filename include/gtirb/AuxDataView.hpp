@@ -0,0 +1,654 @@
+//===- AuxDataView.hpp ------------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#ifndef GTIRB_AUXDATAVIEW_H
+#define GTIRB_AUXDATAVIEW_H
+
+#include <gtirb/AuxData.hpp>
+#include <boost/iterator/iterator_facade.hpp>
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/// \file AuxDataView.hpp
+/// \ingroup AUXDATA_GROUP
+/// \brief Read-only views which decode \ref AuxData directly from its
+/// serialized form.
+/// \see AUXDATA_GROUP
+
+namespace gtirb {
+class AuxDataContainer;
+
+template <class T> class SequenceView;
+template <class T> class SetView;
+template <class K, class V> class MappingView;
+template <class K, class V> class ColumnarMappingView;
+
+/// \struct auxdata_view_traits
+///
+/// \brief Provides the read-only view type for a type which can be stored in
+/// \ref AuxData, and functions to read such views from serialized bytes.
+///
+/// Fixed-width types (integers, floating point values, Addr, UUID, Offset and
+/// tuples of these) are viewed as their decoded values. Strings are viewed as
+/// \c std::string_view, and sequences, sets and mappings as \ref SequenceView,
+/// \ref SetView and \ref MappingView. A \ref ColumnarMap is viewed as a \ref
+/// ColumnarMappingView. All of these refer directly to the serialized bytes.
+/// Tuples of other types are viewed as tuples of views. Any other type is
+/// decoded in full.
+///
+/// \see AUXDATA_GROUP
+template <class T, class Enable = void> struct auxdata_view_traits {
+  /// \brief The view type for T.
+  using type = T;
+
+  /// \brief Read a view of one serialized T, advancing \p FBR past it.
+  ///
+  /// \return \c false if the bytes do not hold a serialized T.
+  static bool parse(FromByteRange& FBR, type& View) {
+    return auxdata_traits<T>::fromBytes(View, FBR);
+  }
+
+  /// \brief Advance \p FBR past one serialized T.
+  ///
+  /// \return \c false if the bytes do not hold a serialized T.
+  static bool skip(FromByteRange& FBR) {
+    T Ignored;
+    return auxdata_traits<T>::fromBytes(Ignored, FBR);
+  }
+};
+
+/// \brief The view type for T.
+///
+/// \see auxdata_view_traits
+template <class T> using auxdata_view_t = typename auxdata_view_traits<T>::type;
+
+/// @cond INTERNAL
+template <class T>
+struct auxdata_view_traits<
+    T, typename std::enable_if_t<packed_serialization<T>::value>> {
+  using type = T;
+
+  static bool parse(FromByteRange& FBR, type& View) {
+    const char* In = FBR.consume(packed_serialization<T>::Size);
+    if (!In)
+      return false;
+    packed_serialization<T>::unpack(View, In);
+    return true;
+  }
+
+  static bool skip(FromByteRange& FBR) {
+    return FBR.consume(packed_serialization<T>::Size) != nullptr;
+  }
+};
+
+template <> struct auxdata_view_traits<std::string> {
+  using type = std::string_view;
+
+  static bool parse(FromByteRange& FBR, type& View) {
+    uint64_t Count;
+    if (!auxdata_traits<uint64_t>::fromBytes(Count, FBR))
+      return false;
+    const char* Chars = FBR.consume(Count);
+    if (!Chars)
+      return false;
+    View = std::string_view(Chars, Count);
+    return true;
+  }
+
+  static bool skip(FromByteRange& FBR) {
+    type Ignored;
+    return parse(FBR, Ignored);
+  }
+};
+
+template <class T>
+struct auxdata_view_traits<T,
+                           typename std::enable_if_t<is_sequence<T>::value>> {
+  using type = SequenceView<typename T::value_type>;
+  static bool parse(FromByteRange& FBR, type& View) { return View.parse(FBR); }
+  static bool skip(FromByteRange& FBR) { return type::skip(FBR); }
+};
+
+template <class T>
+struct auxdata_view_traits<T, typename std::enable_if_t<is_set<T>::value>> {
+  using type = SetView<typename T::value_type>;
+  static bool parse(FromByteRange& FBR, type& View) { return View.parse(FBR); }
+  static bool skip(FromByteRange& FBR) { return type::skip(FBR); }
+};
+
+template <class T>
+struct auxdata_view_traits<T,
+                           typename std::enable_if_t<is_mapping<T>::value>> {
+  using type = MappingView<typename T::key_type, typename T::mapped_type>;
+  static bool parse(FromByteRange& FBR, type& View) { return View.parse(FBR); }
+  static bool skip(FromByteRange& FBR) { return type::skip(FBR); }
+};
+
+template <class... Ts>
+struct auxdata_view_traits<
+    std::tuple<Ts...>,
+    typename std::enable_if_t<
+        !packed_serialization<std::tuple<Ts...>>::value>> {
+  using type = std::tuple<auxdata_view_t<Ts>...>;
+
+  static bool parse(FromByteRange& FBR, type& View) {
+    return std::apply(
+        [&FBR](auto&... Elts) {
+          return (auxdata_view_traits<Ts>::parse(FBR, Elts) && ...);
+        },
+        View);
+  }
+
+  static bool skip(FromByteRange& FBR) {
+    return (auxdata_view_traits<Ts>::skip(FBR) && ...);
+  }
+};
+
+template <class T, class U>
+struct auxdata_view_traits<
+    std::pair<T, U>,
+    typename std::enable_if_t<!packed_serialization<std::pair<T, U>>::value>> {
+  using type = std::pair<auxdata_view_t<T>, auxdata_view_t<U>>;
+
+  static bool parse(FromByteRange& FBR, type& View) {
+    return auxdata_view_traits<T>::parse(FBR, View.first) &&
+           auxdata_view_traits<U>::parse(FBR, View.second);
+  }
+
+  static bool skip(FromByteRange& FBR) {
+    return auxdata_view_traits<T>::skip(FBR) &&
+           auxdata_view_traits<U>::skip(FBR);
+  }
+};
+
+template <class K, class V>
+struct auxdata_view_traits<ColumnarMap<K, V>> {
+  using type = ColumnarMappingView<K, V>;
+  static bool parse(FromByteRange& FBR, type& View) { return View.parse(FBR); }
+  static bool skip(FromByteRange& FBR) {
+    type Ignored;
+    return Ignored.parse(FBR);
+  }
+};
+
+// Views whose ordering matches the ordering of the values they view, so that
+// sorted sets and mappings can be searched without decoding their elements.
+template <class T>
+struct is_ordered_view
+    : std::integral_constant<bool, packed_serialization<T>::value ||
+                                       std::is_same_v<T, std::string_view>> {};
+
+// Returns whether the N keys returned by Key(0) ... Key(N - 1) are strictly
+// increasing. Always false for keys whose views cannot be ordered.
+template <class GetKey> bool viewIsSorted(size_t N, GetKey Key) {
+  using KeyType = decltype(Key(0));
+  if constexpr (is_ordered_view<KeyType>::value) {
+    for (size_t I = 1; I < N; ++I)
+      if (!(Key(I - 1) < Key(I)))
+        return false;
+    return true;
+  }
+  return false;
+}
+
+// Returns the index of the entry equal to Target among the N keys returned by
+// Key(0) ... Key(N - 1), or N if there is none. Uses binary search if Sorted.
+template <class KeyT, class GetKey>
+size_t viewFind(size_t N, bool Sorted, const KeyT& Target, GetKey Key) {
+  if (Sorted) {
+    size_t Low = 0, High = N;
+    while (Low < High) {
+      size_t Mid = Low + (High - Low) / 2;
+      if (Key(Mid) < Target)
+        Low = Mid + 1;
+      else
+        High = Mid;
+    }
+    return Low < N && Key(Low) == Target ? Low : N;
+  }
+  for (size_t I = 0; I < N; ++I)
+    if (Key(I) == Target)
+      return I;
+  return N;
+}
+
+// Random-access iterator over a view which provides size() and operator[].
+template <class ViewT>
+class view_iterator
+    : public boost::iterator_facade<
+          view_iterator<ViewT>, typename ViewT::value_type,
+          boost::random_access_traversal_tag, typename ViewT::value_type> {
+public:
+  view_iterator() = default;
+  view_iterator(const ViewT* V, size_t I) : View(V), Index(I) {}
+
+private:
+  typename ViewT::value_type dereference() const { return (*View)[Index]; }
+  bool equal(const view_iterator& Other) const { return Index == Other.Index; }
+  void increment() { ++Index; }
+  void decrement() { --Index; }
+  void advance(std::ptrdiff_t N) { Index += N; }
+  std::ptrdiff_t distance_to(const view_iterator& Other) const {
+    return static_cast<std::ptrdiff_t>(Other.Index) -
+           static_cast<std::ptrdiff_t>(Index);
+  }
+
+  const ViewT* View{nullptr};
+  size_t Index{0};
+
+  friend class boost::iterator_core_access;
+};
+/// @endcond
+
+/// \class SequenceView
+///
+/// \brief A read-only view of a serialized sequence which decodes elements as
+/// they are accessed.
+///
+/// Elements of fixed-width types are located by index arithmetic. For other
+/// element types, a table of element offsets is built once, when the view is
+/// created. Elements are returned by value as their \ref auxdata_view_t.
+///
+/// \see AUXDATA_GROUP
+template <class T> class SequenceView {
+public:
+  /// \brief The view type of the elements.
+  using value_type = auxdata_view_t<T>;
+  /// \brief Random-access iterator over the elements.
+  using const_iterator = view_iterator<SequenceView>;
+  /// \brief Iterator over the elements.
+  using iterator = const_iterator;
+
+  /// \brief The number of elements.
+  size_t size() const { return Count; }
+
+  /// \brief Whether there are no elements.
+  bool empty() const { return Count == 0; }
+
+  /// \brief Decode the element at an index.
+  value_type operator[](size_t I) const {
+    assert(I < Count && "SequenceView index out of range");
+    FromByteRange FBR(elementBegin(I), elementBegin(I + 1));
+    value_type Result;
+    [[maybe_unused]] bool Valid = auxdata_view_traits<T>::parse(FBR, Result);
+    assert(Valid && "element was validated when the view was created");
+    return Result;
+  }
+
+  /// \brief An iterator to the first element.
+  const_iterator begin() const { return const_iterator(this, 0); }
+
+  /// \brief An iterator past the last element.
+  const_iterator end() const { return const_iterator(this, Count); }
+
+protected:
+  // Returns the position of the first byte of element I. For I == size(),
+  // returns the position just past the last element.
+  const char* elementBegin(size_t I) const {
+    if constexpr (Packed::value)
+      return Data + I * Packed::Size;
+    else
+      return Offsets[I];
+  }
+
+  // Reads the element count, then locates each element, validating it.
+  bool parse(FromByteRange& FBR) {
+    uint64_t N;
+    return auxdata_traits<uint64_t>::fromBytes(N, FBR) && parseElements(FBR, N);
+  }
+
+  // Locates N elements starting at the current position, validating them.
+  bool parseElements(FromByteRange& FBR, uint64_t N) {
+    if (!fits(FBR, N))
+      return false;
+    Count = N;
+    Offsets.clear();
+    if constexpr (Packed::value) {
+      Data = FBR.consume(N * Packed::Size);
+    } else {
+      Offsets.reserve(N + 1);
+      for (uint64_t I = 0; I < N; ++I) {
+        Offsets.push_back(FBR.position());
+        if (!auxdata_view_traits<T>::skip(FBR))
+          return false;
+      }
+      Offsets.push_back(FBR.position());
+    }
+    return true;
+  }
+
+  static bool skip(FromByteRange& FBR) {
+    uint64_t N;
+    if (!auxdata_traits<uint64_t>::fromBytes(N, FBR) || !fits(FBR, N))
+      return false;
+    if constexpr (Packed::value) {
+      return FBR.consume(N * Packed::Size) != nullptr;
+    } else {
+      for (uint64_t I = 0; I < N; ++I)
+        if (!auxdata_view_traits<T>::skip(FBR))
+          return false;
+      return true;
+    }
+  }
+
+private:
+  using Packed = packed_serialization<T>;
+
+  // Rejects element counts which cannot fit in the remaining bytes.
+  static bool fits(const FromByteRange& FBR, uint64_t N) {
+    if constexpr (Packed::value)
+      return N <= FBR.remainingBytesToRead() / Packed::Size;
+    return N <= FBR.remainingBytesToRead();
+  }
+
+  const char* Data{nullptr};
+  size_t Count{0};
+  std::vector<const char*> Offsets;
+
+  template <class, class> friend struct auxdata_view_traits;
+  template <class, class> friend class ColumnarMappingView;
+};
+
+/// \class SetView
+///
+/// \brief A read-only view of a serialized set.
+///
+/// In addition to the operations of a \ref SequenceView, a set view supports
+/// membership queries. These use binary search when the elements were
+/// serialized in sorted order, as they are for \c std::set, and a linear scan
+/// otherwise.
+///
+/// \see AUXDATA_GROUP
+template <class T> class SetView : public SequenceView<T> {
+public:
+  /// \brief Whether the set contains an element equal to \p Elt.
+  template <class EltT> bool contains(const EltT& Elt) const {
+    return viewFind(this->size(), Sorted, Elt, element()) != this->size();
+  }
+
+private:
+  auto element() const {
+    return [this](size_t I) { return (*this)[I]; };
+  }
+
+  bool parse(FromByteRange& FBR) {
+    if (!SequenceView<T>::parse(FBR))
+      return false;
+    Sorted = viewIsSorted(this->size(), element());
+    return true;
+  }
+
+  bool Sorted{false};
+
+  template <class, class> friend struct auxdata_view_traits;
+};
+
+/// \class MappingView
+///
+/// \brief A read-only view of a serialized mapping.
+///
+/// Entries are viewed as pairs of a key view and a value view. Lookups use
+/// binary search when the keys were serialized in sorted order, as they are
+/// for \c std::map, and a linear scan otherwise.
+///
+/// \see AUXDATA_GROUP
+template <class K, class V>
+class MappingView : public SequenceView<std::pair<K, V>> {
+public:
+  /// \brief The view type of the keys.
+  using key_type = auxdata_view_t<K>;
+  /// \brief The view type of the values.
+  using mapped_type = auxdata_view_t<V>;
+
+  /// \brief Look up the value for a key.
+  ///
+  /// \return The value view, or \c std::nullopt if the key is not present.
+  template <class KeyT>
+  std::optional<mapped_type> lookup(const KeyT& Key) const {
+    size_t I = viewFind(this->size(), Sorted, Key, key());
+    if (I == this->size())
+      return std::nullopt;
+    FromByteRange FBR(this->elementBegin(I), this->elementBegin(I + 1));
+    auxdata_view_traits<K>::skip(FBR);
+    mapped_type Result;
+    auxdata_view_traits<V>::parse(FBR, Result);
+    return Result;
+  }
+
+  /// \brief Whether the mapping has an entry for a key.
+  template <class KeyT> bool contains(const KeyT& Key) const {
+    return viewFind(this->size(), Sorted, Key, key()) != this->size();
+  }
+
+private:
+  auto key() const {
+    return [this](size_t I) {
+      FromByteRange FBR(this->elementBegin(I), this->elementBegin(I + 1));
+      key_type Result;
+      auxdata_view_traits<K>::parse(FBR, Result);
+      return Result;
+    };
+  }
+
+  bool parse(FromByteRange& FBR) {
+    if (!SequenceView<std::pair<K, V>>::parse(FBR))
+      return false;
+    Sorted = viewIsSorted(this->size(), key());
+    return true;
+  }
+
+  bool Sorted{false};
+
+  template <class, class> friend struct auxdata_view_traits;
+};
+
+/// \class ColumnarMappingView
+///
+/// \brief A read-only view of a serialized \ref ColumnarMap.
+///
+/// Keys are read directly from the serialized key column, and lookups are
+/// binary searches over it. Entries are viewed as pairs of a key and a value
+/// view.
+///
+/// \see AUXDATA_GROUP
+template <class K, class V> class ColumnarMappingView {
+public:
+  /// \brief The type of the keys.
+  using key_type = K;
+  /// \brief The view type of the values.
+  using mapped_type = auxdata_view_t<V>;
+  /// \brief The type of the entries.
+  using value_type = std::pair<key_type, mapped_type>;
+  /// \brief Random-access iterator over the entries, in key order.
+  using const_iterator = view_iterator<ColumnarMappingView>;
+  /// \brief Iterator over the entries.
+  using iterator = const_iterator;
+
+  /// \brief The number of entries.
+  size_t size() const { return Keys.size(); }
+
+  /// \brief Whether there are no entries.
+  bool empty() const { return Keys.empty(); }
+
+  /// \brief Decode the entry at an index.
+  value_type operator[](size_t I) const { return {Keys[I], Values[I]}; }
+
+  /// \brief An iterator to the first entry.
+  const_iterator begin() const { return const_iterator(this, 0); }
+
+  /// \brief An iterator past the last entry.
+  const_iterator end() const { return const_iterator(this, size()); }
+
+  /// \brief The column of keys.
+  const SequenceView<K>& keys() const { return Keys; }
+
+  /// \brief The column of values.
+  const SequenceView<V>& values() const { return Values; }
+
+  /// \brief Look up the value for a key.
+  ///
+  /// \return The value view, or \c std::nullopt if the key is not present.
+  std::optional<mapped_type> lookup(const K& Key) const {
+    size_t I = find(Key);
+    if (I == size())
+      return std::nullopt;
+    return Values[I];
+  }
+
+  /// \brief Whether the mapping has an entry for a key.
+  bool contains(const K& Key) const { return find(Key) != size(); }
+
+private:
+  size_t find(const K& Key) const {
+    return viewFind(size(), Sorted, Key, [this](size_t I) { return Keys[I]; });
+  }
+
+  bool parse(FromByteRange& FBR) {
+    if (!Keys.parse(FBR) || !Values.parseElements(FBR, Keys.size()))
+      return false;
+    Sorted = viewIsSorted(size(), [this](size_t I) { return Keys[I]; });
+    return true;
+  }
+
+  SequenceView<K> Keys;
+  SequenceView<V> Values;
+  bool Sorted{false};
+
+  template <class, class> friend struct auxdata_view_traits;
+};
+
+/// \class AuxDataView
+///
+/// \brief A read-only view of the contents of an \ref AuxData table, as
+/// returned by AuxDataContainer::getAuxDataView.
+///
+/// The view shares ownership of the serialized bytes of the table, so it
+/// remains valid after the table is modified, replaced or removed from its
+/// container, and keeps describing the contents the table had when the view
+/// was taken.
+///
+/// \see AUXDATA_GROUP
+template <class Schema> class AuxDataView {
+public:
+  /// \brief The view type of the table's contents.
+  using view_type = auxdata_view_t<typename Schema::Type>;
+
+  /// \brief Access the view of the table's contents.
+  const view_type& operator*() const { return View; }
+
+  /// \brief Access the view of the table's contents.
+  const view_type* operator->() const { return &View; }
+
+private:
+  explicit AuxDataView(std::shared_ptr<const std::string> Bytes_)
+      : Bytes(std::move(Bytes_)) {}
+
+  static std::optional<AuxDataView>
+  fromBytes(std::shared_ptr<const std::string> Bytes) {
+    AuxDataView Result(std::move(Bytes));
+    FromByteRange FBR(*Result.Bytes);
+    if (!auxdata_view_traits<typename Schema::Type>::parse(FBR, Result.View))
+      return std::nullopt;
+    return Result;
+  }
+
+  // Owns the bytes when they had to be encoded for this view; otherwise
+  // refers to the bytes the table was loaded from, without owning them.
+  std::shared_ptr<const std::string> Bytes;
+  view_type View;
+
+  friend class AuxDataContainer; // Enables fromBytes.
+  template <class> friend class AuxDataKeyIndex;
+};
+
+/// @cond INTERNAL
+// The keys of a loaded set or mapping, viewed in the bytes it was loaded from
+// and sorted whatever the order they were serialized in, so that entries can
+// be appended to the table without searching its bytes each time. Only built
+// for tables whose key views are ordered; sequences have no keys, and only
+// their bytes are checked.
+template <class Schema> class AuxDataKeyIndex {
+  using Type = typename Schema::Type;
+
+public:
+  static constexpr bool IsSearchable = [] {
+    if constexpr (is_sequence<Type>::value)
+      return true;
+    else
+      return is_ordered_view<auxdata_view_t<typename Type::key_type>>::value;
+  }();
+
+  // Returns the index of the keys in Bytes, or std::nullopt if they are
+  // malformed. Bytes must outlive the index.
+  static std::optional<AuxDataKeyIndex> fromBytes(const std::string& Bytes) {
+    static_assert(IsSearchable, "keys cannot be compared through views");
+    auto View = AuxDataView<Schema>::fromBytes(
+        std::shared_ptr<const std::string>(std::shared_ptr<const std::string>(),
+                                           &Bytes));
+    if (!View)
+      return std::nullopt;
+    AuxDataKeyIndex Result;
+    if constexpr (!is_sequence<Type>::value) {
+      Result.Keys.reserve((*View)->size());
+      for (const auto& Elt : **View) {
+        if constexpr (is_set<Type>::value)
+          Result.Keys.push_back(Elt);
+        else
+          Result.Keys.push_back(Elt.first);
+      }
+      std::sort(Result.Keys.begin(), Result.Keys.end());
+    }
+    return Result;
+  }
+
+  // Whether any of the keys of Entries are in the index.
+  bool containsAnyOf(const Type& Entries) const {
+    if constexpr (is_sequence<Type>::value) {
+      return false;
+    } else {
+      return std::any_of(Entries.begin(), Entries.end(),
+                         [this](const auto& Elt) {
+                           if constexpr (is_set<Type>::value)
+                             return contains(Elt);
+                           else
+                             return contains(Elt.first);
+                         });
+    }
+  }
+
+private:
+  template <class KeyT> bool contains(const KeyT& Key) const {
+    auto It = std::lower_bound(Keys.begin(), Keys.end(), Key);
+    return It != Keys.end() && *It == Key;
+  }
+
+  struct NoKeys {};
+  using KeyView = typename std::conditional_t<
+      is_sequence<Type>::value, std::common_type<NoKeys>,
+      std::common_type<auxdata_view_t<typename Type::key_type>>>::type;
+  std::vector<KeyView> Keys;
+};
+/// @endcond
+
+} // namespace gtirb
+
+#endif // GTIRB_AUXDATAVIEW_H
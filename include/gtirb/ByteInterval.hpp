@@ -18,6 +18,7 @@
 
 #include <gtirb/DecodeMode.hpp>
 #include <gtirb/Export.hpp>
+#include <gtirb/IntervalIndex.hpp>
 #include <gtirb/Node.hpp>
 #include <gtirb/Observer.hpp>
 #include <gtirb/SymbolicExpression.hpp>
@@ -41,6 +42,7 @@
 #include <cstdint>
 #include <functional>
 #include <map>
+#include <memory>
 #include <optional>
 #include <type_traits>
 #include <variant>
@@ -223,6 +225,12 @@ class GTIRB_EXPORT_API ByteInterval : public Node {
   using BlockIntMap =
       boost::icl::interval_map<uint64_t,
                                std::multiset<const Block*, BlockOffsetLess>>;
+  using BlockIndex = IntervalIndex<uint64_t, const Block*>;
+  // Iterates the blocks on an offset in either the interval map or, while
+  // the IR is frozen, the flat index that replaces it.
+  using BlockOffsetIterator =
+      EitherIterator<BlockIntMap::codomain_type::const_iterator,
+                     BlockIndex::const_iterator>;
   using SymbolicExpressionMap = std::map<uint64_t, SymbolicExpression>;
 
   /// \brief Get the \ref Block that corresponds to a \ref Node.
@@ -342,6 +350,12 @@ public:
   /// \brief Get the \ref Section this byte interval belongs to.
   const Section* getSection() const { return Parent; }
 
+  /// \brief Indicates whether the \ref IR this byte interval belongs to is
+  /// frozen.
+  ///
+  /// \see IR::freeze
+  bool isFrozen() const;
+
   /// \brief Get the fixed address of this interval, if present.
   ///
   /// If this field is present, it may indicate the original address at which
@@ -368,8 +382,8 @@ public:
   ///
   /// Blocks are yielded in offset order, ascending. For more details, see
   /// \ref iteration_order "the documentation on iteration order".
-  using block_subrange = boost::iterator_range<boost::transform_iterator<
-      BlockToNode<Node>, BlockIntMap::codomain_type::iterator>>;
+  using block_subrange = boost::iterator_range<
+      boost::transform_iterator<BlockToNode<Node>, BlockOffsetIterator>>;
   /// \brief Const iterator over \ref Block objects.
   ///
   /// Blocks are yielded in offset order, ascending. For more details, see
@@ -387,8 +401,8 @@ public:
   ///
   /// Blocks are yielded in offset order, ascending. For more details, see
   /// \ref iteration_order "the documentation on iteration order".
-  using const_block_subrange = boost::iterator_range<boost::transform_iterator<
-      BlockToNode<const Node>, BlockIntMap::codomain_type::const_iterator>>;
+  using const_block_subrange = boost::iterator_range<
+      boost::transform_iterator<BlockToNode<const Node>, BlockOffsetIterator>>;
 
   /// \brief Return an iterator to the first \ref Block.
   block_iterator blocks_begin() { return block_iterator(Blocks.begin()); }
@@ -419,10 +433,8 @@ public:
   /// \return A range of \ref Node objects, which are either \ref DataBlock or
   /// \ref CodeBlock objects, that contain the offset \p Off.
   block_subrange findBlocksOnOffset(uint64_t Off) {
-    if (auto It = BlockOffsets.find(Off); It != BlockOffsets.end()) {
-      return block_subrange(It->second.begin(), It->second.end());
-    }
-    return {};
+    auto Found = blocksOnOffset(Off);
+    return block_subrange(Found.begin(), Found.end());
   }
 
   /// \brief Find all the blocks that have a byte at the specified offset.
@@ -432,10 +444,8 @@ public:
   /// \return A range of \ref Node objects, which are either \ref DataBlock or
   /// \ref CodeBlock objects, that contain the offset \p Off.
   const_block_subrange findBlocksOnOffset(uint64_t Off) const {
-    if (auto It = BlockOffsets.find(Off); It != BlockOffsets.end()) {
-      return const_block_subrange(It->second.begin(), It->second.end());
-    }
-    return {};
+    auto Found = blocksOnOffset(Off);
+    return const_block_subrange(Found.begin(), Found.end());
   }
 
   /// \brief Find all the blocks that have bytes that lie within the address
@@ -602,7 +612,7 @@ public:
       BlockToNode<CodeBlock>,
       boost::filter_iterator<
           BlockKindEquals<Node::Kind::CodeBlock>,
-          boost::indirect_iterator<BlockIntMap::codomain_type::iterator>>>>;
+          boost::indirect_iterator<BlockOffsetIterator>>>>;
   /// \brief Const iterator over \ref CodeBlock objects.
   ///
   /// Blocks are yielded in offset order, ascending. For more details, see
@@ -627,8 +637,7 @@ public:
           BlockToNode<const CodeBlock>,
           boost::filter_iterator<
               BlockKindEquals<Node::Kind::CodeBlock>,
-              boost::indirect_iterator<
-                  BlockIntMap::codomain_type::const_iterator>>>>;
+              boost::indirect_iterator<BlockOffsetIterator>>>>;
 
   /// \brief Return an iterator to the first \ref CodeBlock.
   code_block_iterator code_blocks_begin() {
@@ -668,14 +677,12 @@ public:
   ///
   /// \return A range of \ref CodeBlock objects, that contain the offset \p Off.
   code_block_subrange findCodeBlocksOnOffset(uint64_t Off) {
-    if (auto It = BlockOffsets.find(Off); It != BlockOffsets.end()) {
-      auto End = boost::make_indirect_iterator(It->second.end());
-      return code_block_subrange(
-          code_block_subrange::iterator::base_type(
-              boost::make_indirect_iterator(It->second.begin()), End),
-          code_block_subrange::iterator::base_type(End, End));
-    }
-    return {};
+    auto Found = blocksOnOffset(Off);
+    auto End = boost::make_indirect_iterator(Found.end());
+    return code_block_subrange(
+        code_block_subrange::iterator::base_type(
+            boost::make_indirect_iterator(Found.begin()), End),
+        code_block_subrange::iterator::base_type(End, End));
   }
 
   /// \brief Find all the code blocks that have a byte at the specified offset.
@@ -684,14 +691,12 @@ public:
   ///
   /// \return A range of \ref CodeBlock objects, that contain the addres \p Off.
   const_code_block_subrange findCodeBlocksOnOffset(uint64_t Off) const {
-    if (auto It = BlockOffsets.find(Off); It != BlockOffsets.end()) {
-      auto End = boost::make_indirect_iterator(It->second.end());
-      return const_code_block_subrange(
-          const_code_block_subrange::iterator::base_type(
-              boost::make_indirect_iterator(It->second.begin()), End),
-          const_code_block_subrange::iterator::base_type(End, End));
-    }
-    return {};
+    auto Found = blocksOnOffset(Off);
+    auto End = boost::make_indirect_iterator(Found.end());
+    return const_code_block_subrange(
+        const_code_block_subrange::iterator::base_type(
+            boost::make_indirect_iterator(Found.begin()), End),
+        const_code_block_subrange::iterator::base_type(End, End));
   }
 
   /// \brief Find all the code blocks that have bytes that lie within the
@@ -859,7 +864,7 @@ public:
       BlockToNode<DataBlock>,
       boost::filter_iterator<
           BlockKindEquals<Node::Kind::DataBlock>,
-          boost::indirect_iterator<BlockIntMap::codomain_type::iterator>>>>;
+          boost::indirect_iterator<BlockOffsetIterator>>>>;
   /// \brief Const iterator over \ref DataBlock objects.
   ///
   /// Blocks are yielded in offset order, ascending. For more details, see
@@ -884,8 +889,7 @@ public:
           BlockToNode<const DataBlock>,
           boost::filter_iterator<
               BlockKindEquals<Node::Kind::DataBlock>,
-              boost::indirect_iterator<
-                  BlockIntMap::codomain_type::const_iterator>>>>;
+              boost::indirect_iterator<BlockOffsetIterator>>>>;
 
   /// \brief Return an iterator to the first \ref DataBlock.
   data_block_iterator data_blocks_begin() {
@@ -925,14 +929,12 @@ public:
   ///
   /// \return A range of \ref DataBlock objects, that contain the offset \p Off.
   data_block_subrange findDataBlocksOnOffset(uint64_t Off) {
-    if (auto It = BlockOffsets.find(Off); It != BlockOffsets.end()) {
-      auto End = boost::make_indirect_iterator(It->second.end());
-      return data_block_subrange(
-          data_block_subrange::iterator::base_type(
-              boost::make_indirect_iterator(It->second.begin()), End),
-          data_block_subrange::iterator::base_type(End, End));
-    }
-    return {};
+    auto Found = blocksOnOffset(Off);
+    auto End = boost::make_indirect_iterator(Found.end());
+    return data_block_subrange(
+        data_block_subrange::iterator::base_type(
+            boost::make_indirect_iterator(Found.begin()), End),
+        data_block_subrange::iterator::base_type(End, End));
   }
 
   /// \brief Find all the data blocks that have a byte at the specified offset.
@@ -941,14 +943,12 @@ public:
   ///
   /// \return A range of \ref DataBlock objects, that contain the addres \p Off.
   const_data_block_subrange findDataBlocksOnOffset(uint64_t Off) const {
-    if (auto It = BlockOffsets.find(Off); It != BlockOffsets.end()) {
-      auto End = boost::make_indirect_iterator(It->second.end());
-      return const_data_block_subrange(
-          const_data_block_subrange::iterator::base_type(
-              boost::make_indirect_iterator(It->second.begin()), End),
-          const_data_block_subrange::iterator::base_type(End, End));
-    }
-    return {};
+    auto Found = blocksOnOffset(Off);
+    auto End = boost::make_indirect_iterator(Found.end());
+    return const_data_block_subrange(
+        const_data_block_subrange::iterator::base_type(
+            boost::make_indirect_iterator(Found.begin()), End),
+        const_data_block_subrange::iterator::base_type(End, End));
   }
 
   /// \brief Find all the data blocks that have bytes that lie within the
@@ -1448,16 +1448,19 @@ public:
   /// \param  C     The \ref Context to use.
   /// \param  O     The offset to add the new \ref CodeBlock at.
   /// \param  A     The arguments to construct a \ref CodeBlock.
-  /// \return       The newly created \ref CodeBlock.
+  /// \return       The newly created \ref CodeBlock, or null if the IR is
+  ///               frozen, which also fails an assertion in debug builds.
+  ///               Nothing is created in that case.
   template <typename BlockType, typename... Args>
   BlockType* addBlock(Context& C, uint64_t O, Args&&... A) {
+    assert(!isFrozen() && "cannot add a block to a frozen IR");
+    if (isFrozen())
+      return nullptr;
     BlockType* B = BlockType::Create(C, std::forward<Args>(A)...);
-    [[maybe_unused]] ChangeStatus Status = addBlock(O, B);
-    // addBlock(uint64_t, BlockType*) does not currently reject any insertions
+    // addBlock(uint64_t, BlockType*) only rejects insertions into a frozen IR
     // and the result cannot be NoChange because we just inserted a newly
-    // created ByteInterval.
-    assert(Status == ChangeStatus::Accepted &&
-           "unexpected result when inserting ByteInterval");
+    // created block.
+    addBlock(O, B);
     return B;
   }
 
@@ -1533,7 +1536,10 @@ public:
   ///
   /// \param A  Either the new address, or an empty \ref std::optional if you
   ///           wish to remove the address.
-  void setAddress(std::optional<Addr> A);
+  ///
+  /// \return \c Rejected if the IR is frozen, which also fails an assertion
+  /// in debug builds; \c Accepted otherwise.
+  ChangeStatus setAddress(std::optional<Addr> A);
 
   /// \brief Get the size of this interval in bytes.
   ///
@@ -1550,7 +1556,10 @@ public:
   /// than the initialized size.
   ///
   /// \param S  The new size.
-  void setSize(uint64_t S);
+  ///
+  /// \return \c Rejected if the IR is frozen, which also fails an assertion
+  /// in debug builds; \c Accepted otherwise.
+  ChangeStatus setSize(uint64_t S);
 
   /// \brief Get the number of initialized bytes in this interval.
   ///
@@ -2273,9 +2282,12 @@ private:
   /// \param C  The Context in which the deserialized SymbolicExpressions will
   /// be held.
   /// \param Message  The protobuf message from which to deserialize.
+  /// \param Symbols  The symbols of the module, in the order of its protobuf
+  /// message, to which packed symbolic expressions refer.
   /// \return true if the symbolic expression could be loaded from protobuf,
   /// false otherwise.
-  bool symbolicExpressionsFromProtobuf(Context& C, const MessageType& Message);
+  bool symbolicExpressionsFromProtobuf(Context& C, const MessageType& Message,
+                                       const std::vector<Symbol*>& Symbols);
 
   // Present for testing purposes only.
   void save(std::ostream& Out) const;
@@ -2294,12 +2306,42 @@ private:
   template <typename BlockType, typename IterType>
   ChangeStatus removeBlock(BlockType* B);
 
+  // Returns the blocks that hold offset \p Off, in offset order.
+  boost::iterator_range<BlockOffsetIterator>
+  blocksOnOffset(uint64_t Off) const {
+    if (FrozenBlockOffsets) {
+      auto Found = FrozenBlockOffsets->find(Off);
+      return {Found.begin(), Found.end()};
+    }
+    if (auto It = BlockOffsets.find(Off); It != BlockOffsets.end())
+      return {It->second.begin(), It->second.end()};
+    return {};
+  }
+
+  // Replaces the interval map with a flat index. Called by Module::freeze.
+  void freeze();
+
+  // Rebuilds the interval map and drops the flat index. Called by
+  // Module::thaw.
+  void thaw();
+
+  // Returns true if a block starts before \p Off and ends after it.
+  bool hasBlockSpanning(uint64_t Off) const;
+
+  // Moves every block and symbolic expression at or after offset \p From
+  // into \p Dest, placing the one at \p From at offset \p DestOff. Used by
+  // Section::splitByteInterval and Section::mergeByteIntervals; no events
+  // are fired, as the moved blocks keep their addresses.
+  void transferContents(ByteInterval& Dest, uint64_t From, uint64_t DestOff);
+
   Section* Parent{nullptr};
   ByteIntervalObserver* Observer{nullptr};
   std::optional<Addr> Address;
   uint64_t Size{0};
   BlockSet Blocks;
   BlockIntMap BlockOffsets;
+  // Non-null only while the IR is frozen, when BlockOffsets is empty.
+  std::unique_ptr<BlockIndex> FrozenBlockOffsets;
   SymbolicExpressionMap SymbolicExpressions;
   std::vector<uint8_t> Bytes;
 
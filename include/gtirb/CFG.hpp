@@ -18,12 +18,13 @@
 #include <gtirb/Casting.hpp>
 #include <gtirb/Export.hpp>
 #include <boost/graph/adjacency_list.hpp>
-#include <boost/iterator/filter_iterator.hpp>
 #include <boost/iterator/indirect_iterator.hpp>
 #include <boost/iterator/iterator_facade.hpp>
 #include <boost/iterator/transform_iterator.hpp>
 #include <boost/range/iterator_range.hpp>
+#include <unordered_map>
 #include <variant>
+#include <vector>
 
 /// \file CFG.hpp
 /// \ingroup CFG_GROUP
@@ -35,6 +36,7 @@
 namespace gtirb {
 class CfgNode;
 class CodeBlock;
+class ProxyBlock;
 
 /// \defgroup CFG_GROUP Control Flow Graphs (CFGs)
 /// \brief Interprocedural control flow graph, with vertices of type
@@ -74,6 +76,22 @@ GTIRB_EXPORT_API std::ostream& operator<<(std::ostream& OS,
                                           const EdgeLabel& Label);
 /// @cond INTERNAL
 
+// The graph property of a CFG. Besides the vertex for each node, it keeps the
+// graph's code blocks and proxy blocks in separate dense arrays, so that
+// blocks(CFG&) and proxies(CFG&) iterate one kind of node without testing the
+// kind of every vertex. Removal swaps the last node of an array into the
+// vacated position, so each entry records where its node is stored.
+template <typename VertexDescriptor> struct CfgNodeIndex {
+  struct Entry {
+    VertexDescriptor Vertex;
+    size_t Position;
+  };
+
+  std::unordered_map<const CfgNode*, Entry> Vertices;
+  std::vector<CodeBlock*> Blocks;
+  std::vector<ProxyBlock*> Proxies;
+};
+
 // Helper for constructing the CFG type. The graph property needs to refer to
 // the graph's vertex_descriptor type. This is accessible via
 // boost::adjacency_list_traits, but requires keeping the template parameters
@@ -91,8 +109,8 @@ struct CfgBuilder {
       // Edges have labels.
       EdgeLabel,
       // The graph keeps track of vertex descriptors for
-      // each node.
-      std::unordered_map<const CfgNode*, vertex_descriptor>, EdgeListS>;
+      // each node, and of its nodes partitioned by kind.
+      CfgNodeIndex<vertex_descriptor>, EdgeListS>;
 };
 /// @endcond
 
@@ -139,45 +157,6 @@ private:
   CFG::vertex_iterator it;
 };
 
-template <typename ToTy> struct downcast {
-  template <typename FromTy> auto operator()(FromTy& Val) const {
-    return dyn_cast_or_null<ToTy>(Val);
-  }
-};
-
-struct not_null {
-  template <typename T> bool operator()(const T* t) { return t != nullptr; }
-};
-
-template <typename T>
-using cfg_node_downcast_iter =
-    boost::transform_iterator<downcast<std::remove_const_t<T>>,
-                              cfg_node_iter_base>;
-
-template <typename T>
-using cfg_node_downcast_not_null_iter =
-    boost::filter_iterator<not_null, cfg_node_downcast_iter<T>>;
-
-template <typename T>
-class cfg_node_cast_iter
-    : public boost::indirect_iterator<cfg_node_downcast_not_null_iter<T>, T> {
-private:
-  using xform_iterator = cfg_node_downcast_iter<T>;
-  using filter_iterator = cfg_node_downcast_not_null_iter<T>;
-  using parent = boost::indirect_iterator<filter_iterator, T>;
-
-public:
-  cfg_node_cast_iter() : parent() {}
-
-  cfg_node_cast_iter(const CFG& g, CFG::vertex_iterator& first,
-                     CFG::vertex_iterator& last)
-      : parent(filter_iterator(xform_iterator(cfg_node_iter_base(g, first)),
-                               xform_iterator(cfg_node_iter_base(g, last)))) {}
-
-  template <typename OtherT>
-  cfg_node_cast_iter(const cfg_node_cast_iter<OtherT>& other) : parent(other) {}
-};
-
 /// @endcond
 
 /// \ingroup CFG_GROUP
@@ -191,11 +170,27 @@ using const_cfg_iterator =
 
 /// \ingroup CFG_GROUP
 /// \brief Iterator over blocks (\ref Block).
-using block_iterator = cfg_node_cast_iter<CodeBlock>;
+using block_iterator =
+    boost::indirect_iterator<std::vector<CodeBlock*>::const_iterator,
+                             CodeBlock>;
 
 /// \ingroup CFG_GROUP
 /// \brief Constant iterator over blocks (\ref Block).
-using const_block_iterator = cfg_node_cast_iter<const CodeBlock>;
+using const_block_iterator =
+    boost::indirect_iterator<std::vector<CodeBlock*>::const_iterator,
+                             const CodeBlock>;
+
+/// \ingroup CFG_GROUP
+/// \brief Iterator over proxy blocks (\ref ProxyBlock).
+using proxy_iterator =
+    boost::indirect_iterator<std::vector<ProxyBlock*>::const_iterator,
+                             ProxyBlock>;
+
+/// \ingroup CFG_GROUP
+/// \brief Constant iterator over proxy blocks (\ref ProxyBlock).
+using const_proxy_iterator =
+    boost::indirect_iterator<std::vector<ProxyBlock*>::const_iterator,
+                             const ProxyBlock>;
 
 /// \ingroup CFG_GROUP
 /// \brief Add a node to the CFG.
@@ -315,6 +310,25 @@ GTIRB_EXPORT_API boost::iterator_range<block_iterator> blocks(CFG& Cfg);
 GTIRB_EXPORT_API boost::iterator_range<const_block_iterator>
 blocks(const CFG& Cfg);
 
+/// \ingroup CFG_GROUP
+/// \brief Get a range of just the \ref ProxyBlock elements in the specified
+/// graph.
+///
+/// \param Cfg  The graph to be iterated over.
+///
+/// \return A range over the \ref ProxyBlocks in the \p Cfg
+GTIRB_EXPORT_API boost::iterator_range<proxy_iterator> proxies(CFG& Cfg);
+
+/// \ingroup CFG_GROUP
+/// \brief Get a constant range of just the \ref ProxyBlock elements in the
+/// specified graph.
+///
+/// \param Cfg  The graph to be iterated over.
+///
+/// \return A range over the \ref ProxyBlocks in the \p Cfg
+GTIRB_EXPORT_API boost::iterator_range<const_proxy_iterator>
+proxies(const CFG& Cfg);
+
 /// @cond INTERNAL
 // Traits for instantiating cfgEdgeIters as cfgPredecessors.
 struct CfgPredecessorTraits {
@@ -0,0 +1,83 @@
+//===- ChunkStore.hpp -------------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#ifndef GTIRB_CHUNKSTORE_H
+#define GTIRB_CHUNKSTORE_H
+
+#include <gtirb/Export.hpp>
+#include <string>
+#include <string_view>
+#include <utility>
+
+/// \file ChunkStore.hpp
+/// \brief Class gtirb::ChunkStore.
+
+namespace gtirb {
+
+/// \class ChunkStore
+///
+/// \brief A directory of byte chunks, each named by the SHA-1 digest of its
+/// contents.
+///
+/// An IR saved with a chunk store (see \ref IR::save) keeps the contents of
+/// its byte intervals in the store rather than in the file, and refers to
+/// each by its digest. Byte intervals with the same contents, whether in one
+/// IR or in many IRs saved to the same store, are stored once, and storing
+/// contents that are already present writes nothing. Chunks are checked
+/// against their digest whenever they are read.
+///
+/// Chunks are written to a temporary file and renamed into place, so a store
+/// may be shared by several processes saving at once.
+class GTIRB_EXPORT_API ChunkStore {
+public:
+  /// \brief Create a chunk store kept in a directory.
+  ///
+  /// The directory is created when the first chunk is stored, if it does
+  /// not exist.
+  ///
+  /// \param Dir The path of the directory.
+  explicit ChunkStore(std::string Dir) : Directory(std::move(Dir)) {}
+
+  /// \brief Get the path of the directory of the store.
+  const std::string& getDirectory() const { return Directory; }
+
+  /// \brief Store a chunk of bytes, unless it is already present.
+  ///
+  /// A chunk already in the store whose contents no longer match its digest
+  /// is replaced.
+  ///
+  /// \param Bytes  The bytes to store.
+  /// \param Digest Set to the digest naming the chunk.
+  ///
+  /// \return Whether the chunk is present in the store.
+  bool put(std::string_view Bytes, std::string& Digest) const;
+
+  /// \brief Read a chunk of bytes.
+  ///
+  /// \param Digest The digest naming the chunk.
+  /// \param Bytes  Set to the contents of the chunk.
+  ///
+  /// \return Whether the chunk could be read and its contents match \p
+  /// Digest.
+  bool get(const std::string& Digest, std::string& Bytes) const;
+
+private:
+  std::string pathOf(const std::string& Digest) const;
+
+  std::string Directory;
+};
+
+} // namespace gtirb
+
+#endif // GTIRB_CHUNKSTORE_H
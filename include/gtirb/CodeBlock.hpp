@@ -98,33 +98,43 @@ public:
   /// Note that this does not automatically update any \ref ByteInterval's size,
   /// bytes, or symbolic expressions. This simply changes the extents of a block
   /// in its \ref ByteInterval.
-  void setSize(uint64_t S) {
-    if (Observer) {
-      std::swap(Size, S);
-      [[maybe_unused]] ChangeStatus Status =
-          Observer->sizeChange(this, S, Size);
-      assert(Status != ChangeStatus::Rejected &&
-             "recovering from rejected size change is not implemented yet");
-    } else {
+  ///
+  /// \return \c Rejected if the IR is frozen, which also fails an assertion
+  /// in debug builds; \c Accepted otherwise.
+  ChangeStatus setSize(uint64_t S) {
+    if (!Observer) {
       Size = S;
+      return ChangeStatus::Accepted;
     }
+    std::swap(Size, S);
+    ChangeStatus Status = Observer->sizeChange(this, S, Size);
+    // Observers only reject a change before updating their indexes.
+    if (Status == ChangeStatus::Rejected)
+      Size = S;
+    assert(Status != ChangeStatus::Rejected &&
+           "cannot resize a block of a frozen IR");
+    return Status;
   }
 
   /// \brief Set the decode mode of this block.
   ///
   /// This field is used in some ISAs where it is used to
   /// differentiate between sub-ISAs; ARM and Thumb, for example.
-  void setDecodeMode(gtirb::DecodeMode DM) {
-    if (Observer) {
-      std::swap(DecodeMode, DM);
-      [[maybe_unused]] ChangeStatus Status =
-          Observer->decodeModeChange(this, DM, DecodeMode);
-      assert(
-          Status != ChangeStatus::Rejected &&
-          "recovering from rejected decode mode change is not implemented yet");
-    } else {
+  ///
+  /// \return \c Rejected if the IR is frozen, which also fails an assertion
+  /// in debug builds; \c Accepted otherwise.
+  ChangeStatus setDecodeMode(gtirb::DecodeMode DM) {
+    if (!Observer) {
       DecodeMode = DM;
+      return ChangeStatus::Accepted;
     }
+    std::swap(DecodeMode, DM);
+    ChangeStatus Status = Observer->decodeModeChange(this, DM, DecodeMode);
+    if (Status == ChangeStatus::Rejected)
+      DecodeMode = DM;
+    assert(Status != ChangeStatus::Rejected &&
+           "cannot change the decode mode of a block of a frozen IR");
+    return Status;
   }
 
   /// \brief Iterator over bytes in this block.
@@ -23,6 +23,7 @@
 #include <cstdlib>
 #include <functional>
 #include <map>
+#include <vector>
 
 /// \file Context.hpp
 /// \brief Class \ref gtirb::Context and related operators.
@@ -42,6 +43,7 @@ class ByteInterval;
 class CodeBlock;
 class DataBlock;
 class IR;
+class LazySections;
 class Module;
 class ProxyBlock;
 class Section;
@@ -66,6 +68,9 @@ class GTIRB_EXPORT_API Context {
   // will access the UuidMap during their destructors to unregister nodes.
   std::map<UUID, Node*> UuidMap;
 
+  // The number of nodes of each kind created so far, indexed by Node::Kind.
+  std::vector<size_t> NodeCounts;
+
   // Allocate each node type in a separate arena.
   mutable SpecificBumpPtrAllocator<Node> NodeAllocator;
   mutable SpecificBumpPtrAllocator<ByteInterval> ByteIntervalAllocator;
@@ -77,11 +82,27 @@ class GTIRB_EXPORT_API Context {
   mutable SpecificBumpPtrAllocator<Section> SectionAllocator;
   mutable SpecificBumpPtrAllocator<Symbol> SymbolAllocator;
 
+  // Called by findNode for a UUID that no node has, so that nodes of an IR
+  // loaded by IR::loadLazily can be materialized when first looked up.
+  std::function<Node*(const UUID&)> MissingNodeHandler;
+
+  // The number of threads operations on this Context's IRs may use, or zero
+  // for the hardware concurrency.
+  unsigned ThreadCount{1};
+
   /// \copybrief gtirb::Node
   friend class Node;
+  friend class LazySections; // Allow it to set MissingNodeHandler.
 
   void registerNode(const UUID& ID, Node* N) { UuidMap[ID] = N; }
 
+  // Returns the next index for a node of a kind, counting from zero.
+  size_t assignNodeIndex(size_t Kind) {
+    if (Kind >= NodeCounts.size())
+      NodeCounts.resize(Kind + 1, 0);
+    return NodeCounts[Kind]++;
+  }
+
   void unregisterNode(const Node* N);
   const Node* findNode(const UUID& ID) const;
   Node* findNode(const UUID& ID);
@@ -116,6 +137,22 @@ public:
   /// acceptable, such as when shutting a program down.
   void ForgetAllocations();
 
+  /// \brief Set the number of threads that operations on the IRs held in
+  /// this Context may use.
+  ///
+  /// This bounds the threads started by saving and loading IRs, by \ref
+  /// IR::collectAuxDataGarbage and by \ref diff. The default of one runs all
+  /// of them on the calling thread.
+  ///
+  /// \param N The number of threads. Zero selects the hardware concurrency.
+  void setThreadCount(unsigned N) { ThreadCount = N; }
+
+  /// \brief Get the number of threads that operations on the IRs held in
+  /// this Context may use, which is at least one.
+  ///
+  /// \see setThreadCount
+  unsigned getThreadCount() const;
+
   /// \brief Create an object of type \ref T.
   ///
   /// \tparam NodeTy   The type of object for which to allocate memory.
@@ -91,16 +91,22 @@ public:
   /// Note that this does not automatically update any \ref ByteInterval's size,
   /// bytes, or symbolic expressions. This simply changes the extents of a block
   /// in its \ref ByteInterval.
-  void setSize(uint64_t S) {
-    if (Observer) {
-      std::swap(S, Size);
-      [[maybe_unused]] ChangeStatus Status =
-          Observer->sizeChange(this, S, Size);
-      assert(Status != ChangeStatus::Rejected &&
-             "recovering from rejected size change is not implemented yet");
-    } else {
+  ///
+  /// \return \c Rejected if the IR is frozen, which also fails an assertion
+  /// in debug builds; \c Accepted otherwise.
+  ChangeStatus setSize(uint64_t S) {
+    if (!Observer) {
       Size = S;
+      return ChangeStatus::Accepted;
     }
+    std::swap(S, Size);
+    ChangeStatus Status = Observer->sizeChange(this, S, Size);
+    // Observers only reject a change before updating their indexes.
+    if (Status == ChangeStatus::Rejected)
+      Size = S;
+    assert(Status != ChangeStatus::Rejected &&
+           "cannot resize a block of a frozen IR");
+    return Status;
   }
 
   /// \brief Iterator over bytes in this block.
@@ -0,0 +1,100 @@
+//===- Diff.hpp -------------------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#ifndef GTIRB_DIFF_H
+#define GTIRB_DIFF_H
+
+#include <gtirb/Export.hpp>
+#include <gtirb/Context.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// \file Diff.hpp
+/// \brief Function gtirb::diff and struct gtirb::IRChange.
+
+namespace gtirb {
+class IR;
+
+/// \struct IRChange
+///
+/// \brief One difference between two IRs, as found by \ref diff.
+struct GTIRB_EXPORT_API IRChange {
+  /// \brief How an element of the IRs differs.
+  enum class Kind {
+    Added,   ///< The element is only in the second IR.
+    Removed, ///< The element is only in the first IR.
+    Changed, ///< The element is in both IRs, with a different property.
+  };
+
+  /// \brief The kind of element that differs.
+  enum class Element {
+    IR,
+    Module,
+    Section,
+    ByteInterval,
+    CodeBlock,
+    DataBlock,
+    ProxyBlock,
+    Symbol,
+    SymbolicExpr,
+    CfgEdge,
+    AuxData,
+  };
+
+  /// \brief How the element differs.
+  Kind K;
+
+  /// \brief The kind of element that differs.
+  Element E;
+
+  /// \brief The UUID of the node that differs. For a symbolic expression,
+  /// the UUID of its byte interval; for an AuxData table, that of the IR or
+  /// module holding it; for a CFG edge, that of its source.
+  UUID Id;
+
+  /// \brief For a CFG edge, the UUID of its target.
+  UUID Target;
+
+  /// \brief For a symbolic expression, its offset in its byte interval.
+  uint64_t Offset = 0;
+
+  /// \brief For an AuxData table, its name. For a node that has changed,
+  /// the property that differs, such as "address" or "bytes".
+  std::string Name;
+};
+
+/// \brief Find the differences between two IRs.
+///
+/// Nodes are matched by their UUIDs, so that the IRs are usually a saved IR
+/// and the same IR loaded and then modified, and need not be in the same
+/// Context. A node that is in one IR but not the other is reported without
+/// its children. A node that has moved to another parent is reported as
+/// removed and added. AuxData tables are compared by their serialized bytes,
+/// and CFG edges by their ends and labels, so that an edge whose label
+/// changes is reported as removed and added.
+///
+/// Modules and sections are compared in parallel, on as many threads as the
+/// Context of \p Before allows (see \ref Context::setThreadCount).
+///
+/// \param Before The first IR.
+/// \param After  The second IR.
+///
+/// \return The differences, in an order that depends only on the IRs.
+GTIRB_EXPORT_API std::vector<IRChange> diff(const IR& Before,
+                                            const IR& After);
+
+} // namespace gtirb
+
+#endif // GTIRB_DIFF_H
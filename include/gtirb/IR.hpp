@@ -19,6 +19,7 @@
 #include <gtirb/AuxData.hpp>
 #include <gtirb/AuxDataContainer.hpp>
 #include <gtirb/CFG.hpp>
+#include <gtirb/ChunkStore.hpp>
 #include <gtirb/ErrorOr.hpp>
 #include <gtirb/Module.hpp>
 #include <gtirb/Node.hpp>
@@ -28,8 +29,11 @@
 #include <boost/iterator/indirect_iterator.hpp>
 #include <boost/multi_index_container.hpp>
 #include <boost/range/iterator_range.hpp>
+#include <functional>
 #include <map>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 /// \file IR.hpp
@@ -188,8 +192,10 @@ public:
   ///
   /// \return Whether or not the operation succeeded. This operation can
   /// fail if the node to remove is not actually part of this node to begin
-  /// with.
+  /// with, or if this IR is frozen.
   bool removeModule(Module* M) {
+    if (Frozen)
+      return false;
     auto& Index = Modules.get<by_pointer>();
     if (auto Iter = Index.find(M); Iter != Index.end()) {
       MO->removeProxyBlocks(M, M->proxy_blocks());
@@ -204,7 +210,12 @@ public:
   /// \brief Move a \ref Module object to be located in this IR.
   ///
   /// \param S The \ref Module object to add.
+  ///
+  /// \return The added module, or null if this IR or the module's current IR
+  /// is frozen.
   Module* addModule(Module* M) {
+    if (Frozen || (M->getIR() && M->getIR()->isFrozen()))
+      return nullptr;
     if (M->getIR()) {
       M->getIR()->removeModule(M);
     }
@@ -219,12 +230,18 @@ public:
   /// \brief Creates a new \ref Module in this IR.
   ///
   /// \tparam Args  The arguments to construct a \ref Module.
+  ///
+  /// \return the created Module, or null if the IR is frozen, which also
+  /// fails an assertion in debug builds. Nothing is created in that case.
   // FIXME: this API may wind up getting removed because we perhaps want to
   // support creating a Module that is not hooked up to any IR object and then
   // set the parent on the module later. Personally, I think that is a
   // dangerous design choice, but we can argue the merits of both approaches in
   // a code review.
   template <typename... Args> Module* addModule(Context& C, Args... A) {
+    assert(!Frozen && "cannot add a module to a frozen IR");
+    if (Frozen)
+      return nullptr;
     return addModule(Module::Create(C, A...));
   }
 
@@ -253,6 +270,15 @@ public:
   /// @}
   // (end Module-Related Public Types and Functions)
 
+  /// \enum ContainerFormat
+  ///
+  /// \brief Specifies the layout of the binary format written by \ref save.
+  enum class ContainerFormat {
+    Monolithic, ///< A single IR message, readable by every GTIRB reader.
+    Indexed, ///< Module and section messages with a table of contents.
+    Compressed, ///< As Indexed, with each message compressed with zlib.
+  };
+
   /// \brief Serialize to an output stream in binary format.
   ///
   /// \param Out The output stream.
@@ -260,6 +286,79 @@ public:
   /// \return void
   void save(std::ostream& Out) const;
 
+  /// \brief Serialize to an output stream in the given binary format.
+  ///
+  /// The \ref ContainerFormat::Indexed format stores each module and section
+  /// separately and ends with a table of contents, so that \ref loadModules
+  /// and \ref Module::loadSection can load parts of the IR without parsing
+  /// the rest. The \ref ContainerFormat::Compressed format also compresses
+  /// each module and section separately, so that \ref load can decompress
+  /// them in parallel. If GTIRB was built without zlib, as reported by \ref
+  /// isCompressionAvailable, nothing is written in that format and the
+  /// failbit of \p Out is set. \ref load reads all formats.
+  ///
+  /// \param Out    The output stream.
+  /// \param Format The layout to write.
+  ///
+  /// \return void
+  void save(std::ostream& Out, ContainerFormat Format) const;
+
+  /// \brief Whether GTIRB was built with zlib, so that IRs can be saved and
+  /// loaded in the \ref ContainerFormat::Compressed format.
+  static bool isCompressionAvailable();
+
+  /// \brief Serialize to an output stream in the given binary format,
+  /// keeping the contents of byte intervals in a chunk store.
+  ///
+  /// The file refers to the contents of each byte interval by its digest,
+  /// and the contents are written to the store unless already present, so
+  /// that IRs saved to the same store share the byte intervals they have in
+  /// common. Contents that cannot be written to the store are kept in the
+  /// file. Such a file is read with the overload of \ref load that takes
+  /// the store.
+  ///
+  /// Only the indexed formats can refer to a chunk store, since readers of
+  /// the \ref ContainerFormat::Monolithic format expect the contents in the
+  /// file. For that format, nothing is written and the failbit of \p Out is
+  /// set.
+  ///
+  /// \param Out    The output stream.
+  /// \param Format The layout to write, \ref ContainerFormat::Indexed or
+  ///               \ref ContainerFormat::Compressed.
+  /// \param Store  The chunk store to which to write contents.
+  ///
+  /// \return void
+  void save(std::ostream& Out, ContainerFormat Format,
+            const ChunkStore& Store) const;
+
+  /// \brief Serialize to an output stream in a canonical binary format.
+  ///
+  /// The output is in the \ref ContainerFormat::Monolithic format, with the
+  /// nodes of each container listed by UUID, CFG vertices and edges sorted,
+  /// and protobuf maps such as those of AuxData tables written in key order.
+  /// The entries of hashed sets and mappings within AuxData tables, such as
+  /// std::unordered_map, are written in the order of their serialized
+  /// bytes. Equal IRs therefore give identical bytes, whatever order their
+  /// nodes, edges and entries were added in.
+  ///
+  /// Tables whose types are not registered are written as they were loaded,
+  /// so hashed containers in them are in the order of the saving program.
+  ///
+  /// \param Out The output stream.
+  ///
+  /// \return The hash of the bytes written, as given by \ref contentHash.
+  std::string saveCanonical(std::ostream& Out) const;
+
+  /// \brief Compute a hash of the canonical binary format of the IR without
+  /// writing it out.
+  ///
+  /// Equal IRs have equal hashes, so that a hash can stand for the IR in a
+  /// build cache.
+  ///
+  /// \return The SHA-1 digest of the bytes \ref saveCanonical would write,
+  /// as 40 hexadecimal digits.
+  std::string contentHash() const;
+
   /// \brief Serialize to an output stream in JSON format.
   ///
   /// \param Out The output stream.
@@ -280,6 +379,7 @@ public:
     BadUUID,     ///< An object had an incorrectly formatted UUID
     MissingUUID, ///< A UUID did not refer to an object in the loading Context
     NotGTIRB,    ///< Indicates the GTIRB magic number was not found
+    FrozenIR,    ///< Sections cannot be loaded into a frozen IR
   };
 
   /// \brief Deserialize binary format from an input stream.
@@ -290,6 +390,74 @@ public:
   /// \return The deserialized IR object or an error.
   static ErrorOr<IR*> load(Context& C, std::istream& In);
 
+  /// \brief Deserialize binary format from an input stream, reading the
+  /// contents of byte intervals saved in a chunk store from the store.
+  ///
+  /// \param C     The Context in which this IR will be loaded.
+  /// \param In    The input stream.
+  /// \param Store The chunk store from which to read contents.
+  ///
+  /// \return The deserialized IR object or an error.
+  static ErrorOr<IR*> load(Context& C, std::istream& In,
+                           const ChunkStore& Store);
+
+  /// \brief Deserialize only the named modules from binary format.
+  ///
+  /// For a file saved in the \ref ContainerFormat::Indexed or
+  /// \ref ContainerFormat::Compressed format, only the requested modules are
+  /// parsed; the stream must be seekable. Other files
+  /// are loaded in full and the other modules discarded. AuxData of the IR
+  /// is always loaded, and CFG edges are restored between loaded blocks.
+  ///
+  /// \param C            The Context in which this IR will be loaded.
+  /// \param In           The input stream, positioned at the start of the IR.
+  /// \param Names        The names of the modules to load.
+  /// \param LoadSections Whether to load the sections of the modules. If
+  ///                     false, sections can be loaded later with
+  ///                     \ref Module::loadSection.
+  ///
+  /// \return The deserialized IR object or an error.
+  static ErrorOr<IR*> loadModules(Context& C, std::istream& In,
+                                  const std::vector<std::string>& Names,
+                                  bool LoadSections = true);
+
+  /// \brief Deserialize from a file, reading each section only when it is
+  /// first needed.
+  ///
+  /// For a file saved in the \ref ContainerFormat::Indexed or
+  /// \ref ContainerFormat::Compressed format, the file is mapped into memory
+  /// and the modules are loaded without their sections. A section is read
+  /// when it is looked up by name with \ref Module::findSections, or when a
+  /// node that it holds is looked up by UUID in \p C. Until then, its blocks
+  /// and symbolic expressions, the CFG edges and symbol referents involving
+  /// them, and the entry point if it is one of them, are missing from the IR.
+  /// Iterating over a module's sections or anything in them, or looking them
+  /// up by address, reads all of the module's remaining sections first, as
+  /// do saving, diffing, freezing, resolving addresses in or collecting the
+  /// AuxData garbage of the IR, and \ref loadPendingSections. Other files
+  /// are loaded in full. The file must not change while any section of the
+  /// IR is still unread.
+  ///
+  /// Reading a section changes the IR, even when it is read by a lookup
+  /// through a const object. An IR loaded lazily must therefore not be
+  /// shared between threads until \ref loadPendingSections has been called.
+  ///
+  /// \param C    The Context in which this IR will be loaded.
+  /// \param Path The file from which to load the IR.
+  ///
+  /// \return The deserialized IR object or an error.
+  static ErrorOr<IR*> loadLazily(Context& C, const std::string& Path);
+
+  /// \brief Read the sections of an IR loaded by \ref loadLazily that have
+  /// not been read yet.
+  ///
+  /// Does nothing for an IR loaded otherwise. A section that cannot be read
+  /// is left unread, so that the error is reported again by the next call.
+  ///
+  /// \return An ErrorInfo without an error code if every section was read,
+  ///         or the error of the first section that could not be read.
+  ErrorInfo loadPendingSections() const;
+
   /// \brief Deserialize JSON format from an input stream.
   ///
   /// \param C   The Context in which this IR will be loaded.
@@ -1121,6 +1289,39 @@ public:
                 FindCodeBlocksBetween<const Module>(Low, High))),
         const_code_block_range::iterator());
   }
+
+  /// \brief Resolve a batch of addresses to the code blocks that contain them.
+  ///
+  /// This produces the same result as taking the first element of \ref
+  /// findCodeBlocksOn for every address, but indexes the code blocks of the
+  /// IR once and then resolves all the addresses in a single ascending sweep
+  /// over that index. Addresses that are already sorted are not re-sorted.
+  ///
+  /// \param Addrs       The addresses to resolve.
+  /// \param Count       The number of addresses in \p Addrs.
+  /// \param[out] Out    Storage for \p Count results. Out[I] is set to the
+  ///                    lowest-addressed \ref CodeBlock containing Addrs[I], or
+  ///                    nullptr if no block contains it.
+  /// \param NumThreads  The number of threads to resolve with. Zero selects the
+  ///                    hardware concurrency.
+  void resolveAddresses(const Addr* Addrs, size_t Count, const CodeBlock** Out,
+                        unsigned NumThreads = 1) const;
+
+  /// \brief Resolve a batch of addresses to the code blocks that contain them.
+  ///
+  /// \param Addrs       The addresses to resolve.
+  /// \param NumThreads  The number of threads to resolve with. Zero selects the
+  ///                    hardware concurrency.
+  ///
+  /// \return For each address, the lowest-addressed \ref CodeBlock containing
+  /// it, or nullptr if no block contains it.
+  std::vector<const CodeBlock*>
+  resolveAddresses(const std::vector<Addr>& Addrs,
+                   unsigned NumThreads = 1) const {
+    std::vector<const CodeBlock*> Result(Addrs.size());
+    resolveAddresses(Addrs.data(), Addrs.size(), Result.data(), NumThreads);
+    return Result;
+  }
   /// @}
   // (end group of CodeBlock-related types and functions)
 
@@ -1462,6 +1663,68 @@ public:
   /// format.
   void setVersion(uint32_t V) { Version = V; }
 
+  /// \brief Remove references to nodes which are no longer in this IR from
+  /// the AuxData of the IR and its modules.
+  ///
+  /// Each table with a registered schema that lists its node references in
+  /// a References type (see \ref NoNodeReferences) is searched for the \ref
+  /// UUID and \ref Offset values at those positions. Other UUIDs, such as the
+  /// function UUIDs keying the functionBlocks table, are left alone, as are
+  /// tables of schemas without a References type. A reference whose UUID is a
+  /// key of \p Remap is first replaced by the mapped UUID. Sequence and set
+  /// elements and mapping entries which then refer to a node not in this IR
+  /// are removed. Dangling references anywhere else, such as in a table
+  /// holding a single UUID, are left in place. Tables are processed in
+  /// parallel, and tables with nothing to change are not re-encoded when
+  /// saved.
+  ///
+  /// \param Remap  Replacement UUIDs, for example for nodes merged into
+  ///               other nodes.
+  ///
+  /// \return Statistics about the tables and references processed.
+  AuxDataCollectionStats collectAuxDataGarbage(
+      const std::unordered_map<UUID, UUID, boost::hash<UUID>>& Remap = {});
+
+  /// \brief Make this IR a read-only snapshot.
+  ///
+  /// Freezing suits IRs that will only be queried. The interval maps behind
+  /// \ref Module::findSectionsOn and the block queries of each \ref
+  /// ByteInterval are replaced by flat, trimmed arrays of extents, and each
+  /// \ref Section's byte interval index is built and trimmed, so address
+  /// queries return the same results in the same order from less memory.
+  /// Each \ref Module also builds a flat, address-sorted array of its code
+  /// block extents (with a merged copy for IRs holding several modules),
+  /// which \ref resolveAddresses uses instead of re-indexing on each call.
+  /// Byte storage is trimmed to its size. The name and UUID indexes and the
+  /// \ref CFG keep their usual structures; the CFG is a public boost graph
+  /// whose type cannot change.
+  ///
+  /// While the IR is frozen, changes that would invalidate an index are
+  /// refused: adding, removing or moving modules, sections, byte intervals,
+  /// blocks and symbols, and changing their names, addresses, sizes, decode
+  /// modes or referents. Operations returning a \ref ChangeStatus report \c
+  /// Rejected and those returning a node or \c bool report null or \c false.
+  /// Setters and the helpers that create a node in place also fail an
+  /// assertion in debug builds, and the helpers create nothing. AuxData,
+  /// section flags, symbolic expressions and the values of existing bytes are
+  /// not indexed and remain writable. Edges added directly to the \ref CFG
+  /// are not checked.
+  ///
+  /// The sections of an IR loaded by \ref loadLazily are read before it is
+  /// frozen; any that cannot be read are missing from the frozen IR.
+  ///
+  /// Freezing an already frozen IR has no effect.
+  void freeze();
+
+  /// \brief Make a frozen IR mutable again, rebuilding the interval maps
+  /// and discarding the flat indexes.
+  void thaw();
+
+  /// \brief Indicates whether this IR is frozen.
+  ///
+  /// \see freeze
+  bool isFrozen() const { return Frozen; }
+
 private:
   /// @cond INTERNAL
   /// \brief The protobuf message type used for serializing IR.
@@ -1470,9 +1733,10 @@ private:
   /// \brief Serialize into a protobuf message.
   ///
   /// \param[out] Message   Serialize into this message.
+  /// \param WithModules    Whether to serialize the modules as well.
   ///
   /// \return void
-  void toProtobuf(MessageType* Message) const;
+  void toProtobuf(MessageType* Message, bool WithModules = true) const;
 
   /// \brief Construct a IR from a protobuf message.
   ///
@@ -1481,15 +1745,70 @@ private:
   ///
   /// \return The deserialized IR object, or null on failure.
   static ErrorOr<IR*> fromProtobuf(Context& C, const MessageType& Message);
+
+  /// \brief Read the frames of an indexed container in order.
+  ///
+  /// \param In         The input stream, positioned after the header.
+  /// \param Compressed Whether the frames are compressed.
+  /// \param NumThreads The number of threads to parse frames with.
+  /// \param[out] Message Read the IR frame into this message.
+  /// \param AddModule  Called with each module message, with its sections,
+  ///                   once all its frames are read. The message may be
+  ///                   taken from; reading stops if this returns false.
+  ///
+  /// \return true if the frames could be read, false otherwise.
+  static bool
+  readIndexedContainer(std::istream& In, bool Compressed, unsigned NumThreads,
+                       MessageType& Message,
+                       const std::function<bool(proto::Module&)>& AddModule);
+
+  /// \brief Construct the CFG and AuxData of an IR whose modules are built
+  /// from a protobuf message, and check its version.
+  ///
+  /// \param C       The Context in which the IR is held.
+  /// \param I       The IR, to which the modules have been added.
+  /// \param Message The protobuf message of the IR.
+  /// \param Nodes   The table of the nodes to which the CFG refers by index.
+  ///
+  /// \return The IR, or an error.
+  static ErrorOr<IR*> finishFromProtobuf(Context& C, IR* I,
+                                         const MessageType& Message,
+                                         NodeIndexTable& Nodes);
+
+  /// \brief Serialize in canonical binary format, writing to Out if it is not
+  /// null, and return the hash of the bytes.
+  std::string writeCanonical(std::ostream* Out) const;
+
+  /// \brief Serialize to an output stream, keeping the contents of byte
+  /// intervals in Store if it is not null.
+  void saveContainer(std::ostream& Out, ContainerFormat Format,
+                     const ChunkStore* Store) const;
+
+  /// \brief Deserialize from an input stream, reading the contents of byte
+  /// intervals from Store if it is not null.
+  static ErrorOr<IR*> loadContainer(Context& C, std::istream& In,
+                                    const ChunkStore* Store);
+
+  /// \brief Read the IR message from an input stream in any binary format,
+  /// reading the contents of byte intervals from Store if it is not null and
+  /// parsing frames on up to NumThreads threads.
+  ///
+  /// \return An ErrorInfo without an error code if the message was read.
+  static ErrorInfo readContainer(std::istream& In, const ChunkStore* Store,
+                                 unsigned NumThreads, MessageType& Message);
   /// @endcond
 
   ModuleSet Modules;
   uint32_t Version{GTIRB_PROTOBUF_VERSION};
   CFG Cfg;
+  bool Frozen{false};
+  // Code block index spanning all modules, built by freeze().
+  std::shared_ptr<const std::vector<CodeBlockExtent>> FrozenCodeBlocks;
 
   std::unique_ptr<ModuleObserver> MO;
 
   friend class Context; // Allow Context to construct new IRs.
+  friend class IRDelta; // Allow IRDelta to serialize and patch IRs.
 };
 
 /// \brief The error category used to represent load failures.
@@ -0,0 +1,112 @@
+//===- IRDelta.hpp ----------------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#ifndef GTIRB_IRDELTA_H
+#define GTIRB_IRDELTA_H
+
+#include <gtirb/ChunkStore.hpp>
+#include <gtirb/ErrorOr.hpp>
+#include <gtirb/Export.hpp>
+#include <iosfwd>
+#include <memory>
+
+/// \file IRDelta.hpp
+/// \brief Class gtirb::IRDelta.
+
+namespace gtirb {
+namespace proto {
+class IRDelta;
+}
+class Context;
+class IR;
+
+/// \class IRDelta
+///
+/// \brief The changes that turn one IR, the base, into another, the target.
+///
+/// A delta records the nodes added, removed and changed, identified by their
+/// UUIDs, together with the symbolic expressions, AuxData tables and CFG
+/// edges added, removed and changed. A changed node is recorded without its
+/// children, so that changing one block of a byte interval records only that
+/// block, and the contents of byte intervals are recorded as the ranges of
+/// bytes that changed. Saved with \ref save, a delta is usually much smaller
+/// than the target, and can stand in for it when the base is kept.
+///
+/// A delta is applied to the base as saved by \ref IR::save, and records the
+/// UUID of the base IR so that it is not applied to another IR.
+class GTIRB_EXPORT_API IRDelta {
+public:
+  /// \brief Create an empty delta.
+  IRDelta();
+  ~IRDelta();
+  IRDelta(IRDelta&&);
+  IRDelta& operator=(IRDelta&&);
+
+  /// \brief Compute the changes from one IR to another.
+  ///
+  /// The IRs need not be in the same Context. The target is usually an IR
+  /// loaded from the saved base and then modified.
+  ///
+  /// \param Base   The IR from which to compute changes.
+  /// \param Target The IR to which the changes lead.
+  ///
+  /// \return The delta.
+  static IRDelta compute(const IR& Base, const IR& Target);
+
+  /// \brief Whether the delta records no changes.
+  bool empty() const;
+
+  /// \brief Serialize to an output stream in binary format.
+  ///
+  /// \param Out The output stream.
+  ///
+  /// \return void
+  void save(std::ostream& Out) const;
+
+  /// \brief Deserialize binary format from an input stream.
+  ///
+  /// \param In The input stream.
+  ///
+  /// \return The deserialized delta or an error.
+  static ErrorOr<IRDelta> load(std::istream& In);
+
+  /// \brief Load the base IR from an input stream and apply the delta to it.
+  ///
+  /// \param C    The Context in which the target IR will be loaded.
+  /// \param Base The input stream holding the base IR, in any binary format.
+  ///
+  /// \return The target IR or an error.
+  ErrorOr<IR*> apply(Context& C, std::istream& Base) const;
+
+  /// \brief Load the base IR from an input stream, reading the contents of
+  /// its byte intervals from a chunk store, and apply the delta to it.
+  ///
+  /// \param C     The Context in which the target IR will be loaded.
+  /// \param Base  The input stream holding the base IR, in any binary format.
+  /// \param Store The chunk store to which the base was saved.
+  ///
+  /// \return The target IR or an error.
+  ErrorOr<IR*> apply(Context& C, std::istream& Base,
+                     const ChunkStore& Store) const;
+
+private:
+  ErrorOr<IR*> applyTo(Context& C, std::istream& Base,
+                       const ChunkStore* Store) const;
+
+  std::unique_ptr<proto::IRDelta> Message;
+};
+
+} // namespace gtirb
+
+#endif // GTIRB_IRDELTA_H
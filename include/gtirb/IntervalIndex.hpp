@@ -0,0 +1,210 @@
+//===- IntervalIndex.hpp ----------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2021 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#ifndef GTIRB_INTERVAL_INDEX_H
+#define GTIRB_INTERVAL_INDEX_H
+
+#include <algorithm>
+#include <atomic>
+#include <boost/iterator/iterator_facade.hpp>
+#include <boost/range/iterator_range.hpp>
+#include <cstddef>
+#include <iterator>
+#include <mutex>
+#include <variant>
+#include <vector>
+
+namespace gtirb {
+
+/// @cond INTERNAL
+
+/// \class IntervalIndex
+///
+/// \brief A flat index of half-open intervals, answering which of them hold
+/// a point.
+///
+/// Entries are stored in the order they are added, which must be by
+/// non-decreasing low end. Over them is an implicit binary tree holding the
+/// largest high end of each power-of-two run of entries. A query finds the
+/// entries that start at or before the point by binary search, then walks
+/// the tree from one entry that ends after the point to the next, skipping
+/// whole runs that end before it. A query with k results takes O((k + 1) log
+/// n) time, however many long intervals precede the point.
+///
+/// The owner fills the index with \ref ensure on the first query after
+/// \ref invalidate, so a series of changes costs a single rebuild. Concurrent
+/// rebuilds from const queries are serialized by a mutex.
+template <typename KeyT, typename ValueT> class IntervalIndex {
+  struct Entry {
+    KeyT Low;
+    KeyT High;
+    ValueT Value;
+  };
+
+public:
+  /// \brief Iterator over the values of the intervals holding a point, in
+  /// the order they were added.
+  class const_iterator
+      : public boost::iterator_facade<const_iterator, const ValueT,
+                                      boost::forward_traversal_tag> {
+  public:
+    const_iterator() = default;
+
+  private:
+    const_iterator(const IntervalIndex* I, KeyT P, size_t Pos_, size_t End_)
+        : Index(I), Point(P), Pos(Pos_), End(End_) {}
+
+    friend class boost::iterator_core_access;
+    friend class IntervalIndex;
+
+    const ValueT& dereference() const { return Index->Entries[Pos].Value; }
+    bool equal(const const_iterator& Other) const { return Pos == Other.Pos; }
+    void increment() { Pos = Index->next(Pos + 1, End, Point); }
+
+    const IntervalIndex* Index{nullptr};
+    KeyT Point{};
+    size_t Pos{0};
+    size_t End{0};
+  };
+  using const_range = boost::iterator_range<const_iterator>;
+
+  /// \brief Mark the index stale, so that the next \ref ensure rebuilds it.
+  void invalidate() { Valid.store(false, std::memory_order_release); }
+
+  /// \brief Rebuild the index if it is stale.
+  ///
+  /// \param Fill Called with a function taking the low end, high end and
+  ///             value of an interval, to be called for each non-empty
+  ///             interval in order of low end.
+  template <typename FillFn> void ensure(FillFn Fill) {
+    if (Valid.load(std::memory_order_acquire))
+      return;
+    std::lock_guard<std::mutex> Lock(Mutex);
+    if (Valid.load(std::memory_order_relaxed))
+      return;
+    Entries.clear();
+    Fill([this](KeyT Low, KeyT High, ValueT V) {
+      Entries.push_back({Low, High, V});
+    });
+    build();
+    Valid.store(true, std::memory_order_release);
+  }
+
+  /// \brief Find the intervals holding a point. The index must be current.
+  const_range find(KeyT Point) const {
+    size_t End = std::upper_bound(Entries.begin(), Entries.end(), Point,
+                                  [](KeyT P, const Entry& E) {
+                                    return P < E.Low;
+                                  }) -
+                 Entries.begin();
+    return boost::make_iterator_range(
+        const_iterator(this, Point, next(0, End, Point), End),
+        const_iterator(this, Point, End, End));
+  }
+
+  /// \brief Release the capacity not used by the entries.
+  void shrink_to_fit() {
+    Entries.shrink_to_fit();
+    Tree.shrink_to_fit();
+  }
+
+private:
+  // Nodes are numbered from 1 at the root; node N has children 2N and 2N+1,
+  // and the leaves from Leaves on are the entries, padded to a power of two.
+  KeyT maxHigh(size_t N) const {
+    if (N < Leaves)
+      return Tree[N];
+    return N - Leaves < Entries.size() ? Entries[N - Leaves].High : KeyT{};
+  }
+
+  void build() {
+    Leaves = 1;
+    while (Leaves < Entries.size())
+      Leaves *= 2;
+    Tree.assign(Leaves, KeyT{});
+    for (size_t N = Leaves - 1; N > 0; --N)
+      Tree[N] = std::max(maxHigh(2 * N), maxHigh(2 * N + 1));
+  }
+
+  // Returns the first entry from I to End that ends after Point, or End.
+  size_t next(size_t I, size_t End, KeyT Point) const {
+    if (I >= End)
+      return End;
+    // Climb to the first run from I on that holds such an entry, moving to
+    // the next run to the right whenever a run holds none.
+    size_t N = Leaves + I;
+    while (!(Point < maxHigh(N))) {
+      while (N & 1)
+        N >>= 1;
+      if (N == 0)
+        return End;
+      ++N;
+    }
+    // Descend to its leftmost such entry.
+    while (N < Leaves) {
+      N *= 2;
+      if (!(Point < maxHigh(N)))
+        ++N;
+    }
+    return std::min(N - Leaves, End);
+  }
+
+  std::vector<Entry> Entries;
+  std::vector<KeyT> Tree;
+  size_t Leaves{1};
+  std::atomic<bool> Valid{true};
+  std::mutex Mutex;
+};
+
+/// \class EitherIterator
+///
+/// \brief A forward iterator over one of two iterator types with the same
+/// reference type.
+///
+/// Lets a query answer from whichever of two indexes is current without
+/// changing its result type, e.g. the interval maps of a mutable IR and the
+/// \ref IntervalIndex "flat indexes" of a frozen one.
+template <typename It1, typename It2>
+class EitherIterator
+    : public boost::iterator_facade<
+          EitherIterator<It1, It2>,
+          typename std::iterator_traits<It1>::value_type,
+          boost::forward_traversal_tag,
+          typename std::iterator_traits<It1>::reference> {
+  using Reference = typename std::iterator_traits<It1>::reference;
+
+public:
+  EitherIterator() = default;
+  EitherIterator(It1 I) : Impl(std::move(I)) {}
+  EitherIterator(It2 I) : Impl(std::move(I)) {}
+
+private:
+  friend class boost::iterator_core_access;
+
+  Reference dereference() const {
+    return std::visit([](const auto& I) -> Reference { return *I; }, Impl);
+  }
+  bool equal(const EitherIterator& Other) const { return Impl == Other.Impl; }
+  void increment() {
+    std::visit([](auto& I) { ++I; }, Impl);
+  }
+
+  std::variant<It1, It2> Impl;
+};
+
+/// @endcond
+
+} // end namespace gtirb
+
+#endif // GTIRB_INTERVAL_INDEX_H
@@ -19,6 +19,7 @@
 #include <gtirb/AuxDataContainer.hpp>
 #include <gtirb/DataBlock.hpp>
 #include <gtirb/Export.hpp>
+#include <gtirb/IntervalIndex.hpp>
 #include <gtirb/Node.hpp>
 #include <gtirb/Observer.hpp>
 #include <gtirb/Section.hpp>
@@ -39,18 +40,26 @@
 #include <boost/range/iterator_range.hpp>
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <optional>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 /// \file Module.hpp
 /// \brief Class gtirb::Module and related functions and types.
 
 namespace gtirb {
 class ByteInterval;
+class ContainerFrames;
 class IR;
+class LazySections;
 class ModuleObserver;
+class NodeIndexTable;
+struct CodeBlockExtent;
 
 template <class T> class ErrorOr;
+struct ErrorInfo;
 
 /// \enum FileFormat
 ///
@@ -119,7 +128,12 @@ class GTIRB_EXPORT_API Module : public AuxDataContainer {
     return nullptr;
   }
 
-  using ProxyBlockSet = std::unordered_set<ProxyBlock*>;
+  // Proxy blocks are stored densely, with a map from each block to its
+  // position so that lookup and removal take constant time. Removal moves the
+  // last block into the vacated position, so the order is the insertion order
+  // only until the first removal. It is deterministic either way.
+  using ProxyBlockSet = std::vector<ProxyBlock*>;
+  using ProxyBlockPositionMap = std::unordered_map<const ProxyBlock*, size_t>;
 
   using SectionSet = boost::multi_index::multi_index_container<
       Section*, boost::multi_index::indexed_by<
@@ -135,6 +149,12 @@ class GTIRB_EXPORT_API Module : public AuxDataContainer {
                         boost::multi_index::identity<Section*>>>>;
   using SectionIntMap =
       boost::icl::interval_map<Addr, std::set<Section*, AddressLess>>;
+  using SectionIndex = IntervalIndex<Addr, Section*>;
+  // Iterates the sections on an address in either the interval map or, while
+  // the IR is frozen, the flat index that replaces it.
+  using SectionAddrIterator =
+      EitherIterator<SectionIntMap::codomain_type::const_iterator,
+                     SectionIndex::const_iterator>;
 
   using SymbolSet = boost::multi_index::multi_index_container<
       Symbol*,
@@ -181,6 +201,11 @@ public:
   /// \brief Get the \ref IR this module belongs to.
   IR* getIR() { return Parent; }
 
+  /// \brief Indicates whether the \ref IR this module belongs to is frozen.
+  ///
+  /// \see IR::freeze
+  bool isFrozen() const;
+
   /// \brief Set the location of the corresponding binary on disk.
   ///
   /// This is for informational purposes only and will not be used to open
@@ -342,16 +367,18 @@ public:
   /// \param  C     The Context in which this object will be held.
   /// \param  A     The arguments to construct a \ref ProxyBlock.
   ///
-  /// \return the created ProxyBlock.
+  /// \return the created ProxyBlock, or null if the IR is frozen, which also
+  /// fails an assertion in debug builds. Nothing is created in that case.
   template <typename... Args>
   ProxyBlock* addProxyBlock(Context& C, Args&&... A) {
+    assert(!isFrozen() && "cannot add a proxy block to a frozen IR");
+    if (isFrozen())
+      return nullptr;
     ProxyBlock* PB = ProxyBlock::Create(C, std::forward<Args>(A)...);
-    [[maybe_unused]] ChangeStatus status = addProxyBlock(PB);
-    // addProxyBlock(ProxyBlock*) does not currently reject any changes and,
+    // addProxyBlock(ProxyBlock*) only rejects changes to a frozen IR and,
     // because we just created the ProxyBlock to add, it cannot result in
     // NoChange.
-    assert(status == ChangeStatus::Accepted &&
-           "unexpected result when inserting ProxyBlock");
+    addProxyBlock(PB);
     return PB;
   }
 
@@ -541,8 +568,10 @@ public:
   ///
   /// \return Whether or not the operation succeeded. This operation can
   /// fail if the node to remove is not actually part of this node to begin
-  /// with.
+  /// with, or if this module is frozen.
   bool removeSymbol(Symbol* S) {
+    if (isFrozen())
+      return false;
     auto& Index = Symbols.get<by_pointer>();
     if (auto Iter = Index.find(S); Iter != Index.end()) {
       Index.erase(Iter);
@@ -555,7 +584,12 @@ public:
   /// \brief Move a \ref Symbol object to be located in this module.
   ///
   /// \param S The \ref Symbol object to add.
+  ///
+  /// \return The added symbol, or null if this module or the symbol's current
+  /// module is frozen.
   Symbol* addSymbol(Symbol* S) {
+    if (isFrozen() || (S->getModule() && S->getModule()->isFrozen()))
+      return nullptr;
     if (S->getModule()) {
       S->getModule()->removeSymbol(S);
     }
@@ -569,7 +603,13 @@ public:
   /// \tparam Args  The arguments to construct a \ref Symbol.
   /// \param  C     The Context in which this object will be held.
   /// \param  A     The arguments to construct a \ref Symbol.
+  ///
+  /// \return the created Symbol, or null if the IR is frozen, which also fails
+  /// an assertion in debug builds. Nothing is created in that case.
   template <typename... Args> Symbol* addSymbol(Context& C, Args... A) {
+    assert(!isFrozen() && "cannot add a symbol to a frozen IR");
+    if (isFrozen())
+      return nullptr;
     return addSymbol(Symbol::Create(C, A...));
   }
 
@@ -672,7 +712,10 @@ public:
   const std::string& getName() const { return Name; }
 
   /// \brief Set the module name.
-  void setName(const std::string& X);
+  ///
+  /// \return \c Rejected if the IR is frozen, which also fails an assertion
+  /// in debug builds; \c Accepted otherwise.
+  ChangeStatus setName(const std::string& X);
 
   /// \name Section-Related Public Types and Functions
   /// @{
@@ -682,8 +725,8 @@ public:
   /// \brief Range of sections (\ref Section).
   using section_range = boost::iterator_range<section_iterator>;
   /// \brief Sub-range of sections overlapping an address (\ref Section).
-  using section_subrange = boost::iterator_range<
-      boost::indirect_iterator<SectionIntMap::codomain_type::iterator>>;
+  using section_subrange =
+      boost::iterator_range<boost::indirect_iterator<SectionAddrIterator>>;
   /// \brief Iterator over sections (\ref Section).
   ///
   /// Sections are returned in name order. If two Sections have the same name,
@@ -709,8 +752,8 @@ public:
   /// the same address and the same size, their order is not specified.
   using const_section_range = boost::iterator_range<const_section_iterator>;
   /// \brief Sub-range of sections overlapping an address (\ref Section).
-  using const_section_subrange = boost::iterator_range<boost::indirect_iterator<
-      SectionIntMap::codomain_type::const_iterator, const Section&>>;
+  using const_section_subrange = boost::iterator_range<
+      boost::indirect_iterator<SectionAddrIterator, const Section&>>;
   /// \brief Constant iterator over sections (\ref Section).
   ///
   /// Sections are returned in name order. If two Sections have the same name,
@@ -726,15 +769,27 @@ public:
       boost::iterator_range<const_section_name_iterator>;
 
   /// \brief Return an iterator to the first Section.
-  section_iterator sections_begin() { return Sections.begin(); }
+  section_iterator sections_begin() {
+    if (Lazy)
+      materializeSections();
+    return Sections.begin();
+  }
   /// \brief Return a constant iterator to the first Section.
-  const_section_iterator sections_begin() const { return Sections.begin(); }
+  const_section_iterator sections_begin() const {
+    if (Lazy)
+      materializeSections();
+    return Sections.begin();
+  }
   /// \brief Return an iterator to the first Section.
   section_name_iterator sections_by_name_begin() {
+    if (Lazy)
+      materializeSections();
     return Sections.get<by_name>().begin();
   }
   /// \brief Return a constant iterator to the first Section.
   const_section_name_iterator sections_by_name_begin() const {
+    if (Lazy)
+      materializeSections();
     return Sections.get<by_name>().begin();
   }
   /// \brief Return an iterator to the element following the last Section.
@@ -785,14 +840,16 @@ public:
   /// \param  C     The Context in which this object will be held.
   /// \param  A     The arguments to construct a \ref Section.
   ///
-  /// \return the created Section.
+  /// \return the created Section, or null if the IR is frozen, which also fails
+  /// an assertion in debug builds. Nothing is created in that case.
   template <typename... Args> Section* addSection(Context& C, Args&&... A) {
+    assert(!isFrozen() && "cannot add a section to a frozen IR");
+    if (isFrozen())
+      return nullptr;
     Section* S = Section::Create(C, std::forward<Args>(A)...);
-    [[maybe_unused]] ChangeStatus status = addSection(S);
-    // addSection(Section*) does not currently reject any changes and, because
+    // addSection(Section*) only rejects changes to a frozen IR and, because
     // we just created the Section to add, it cannot result in NoChange.
-    assert(status == ChangeStatus::Accepted &&
-           "unexpected result when inserting Section");
+    addSection(S);
     return S;
   }
 
@@ -802,10 +859,8 @@ public:
   ///
   /// \return The range of Sections containing the address.
   section_subrange findSectionsOn(Addr X) {
-    if (auto It = SectionAddrs.find(X); It != SectionAddrs.end()) {
-      return boost::make_iterator_range(It->second.begin(), It->second.end());
-    }
-    return {};
+    auto Found = sectionsOn(X);
+    return section_subrange(Found.begin(), Found.end());
   }
 
   /// \brief Find a Section containing an address.
@@ -814,10 +869,8 @@ public:
   ///
   /// \return The range of Sections containing the address.
   const_section_subrange findSectionsOn(Addr X) const {
-    if (auto It = SectionAddrs.find(X); It != SectionAddrs.end()) {
-      return boost::make_iterator_range(It->second.begin(), It->second.end());
-    }
-    return {};
+    auto Found = sectionsOn(X);
+    return const_section_subrange(Found.begin(), Found.end());
   }
 
   /// \brief Find all the sections that start at an address.
@@ -826,6 +879,8 @@ public:
   ///
   /// \return A range of \ref Section objects that are at the address \p A.
   section_range findSectionsAt(Addr A) {
+    if (Lazy)
+      materializeSections();
     auto Pair = Sections.get<by_address>().equal_range(A);
     return boost::make_iterator_range(section_iterator(Pair.first),
                                       section_iterator(Pair.second));
@@ -838,6 +893,8 @@ public:
   ///
   /// \return A range of \ref Section objects that are between the addresses.
   section_range findSectionsAt(Addr Low, Addr High) {
+    if (Lazy)
+      materializeSections();
     auto& Index = Sections.get<by_address>();
     return boost::make_iterator_range(
         section_iterator(Index.lower_bound(Low)),
@@ -850,6 +907,8 @@ public:
   ///
   /// \return A range of \ref Section objects that are at the address \p A.
   const_section_range findSectionsAt(Addr A) const {
+    if (Lazy)
+      materializeSections();
     auto Pair = Sections.get<by_address>().equal_range(A);
     return boost::make_iterator_range(const_section_iterator(Pair.first),
                                       const_section_iterator(Pair.second));
@@ -862,6 +921,8 @@ public:
   ///
   /// \return A range of \ref Section objects that are between the addresses.
   const_section_range findSectionsAt(Addr Low, Addr High) const {
+    if (Lazy)
+      materializeSections();
     auto& Index = Sections.get<by_address>();
     return boost::make_iterator_range(
         const_section_iterator(Index.lower_bound(Low)),
@@ -870,11 +931,16 @@ public:
 
   /// \brief Find a Section by name.
   ///
+  /// For a module loaded by \ref IR::loadLazily, the sections are read from
+  /// the file first if they have not been read yet.
+  ///
   /// \param X The name to look up.
   ///
   /// \return A range of \ref Section objects with the requested name.
 
   section_name_range findSections(const std::string& X) {
+    if (Lazy)
+      materializeSections(X);
     auto Pair = Sections.get<by_name>().equal_range(X);
     return boost::make_iterator_range(section_name_iterator(Pair.first),
                                       section_name_iterator(Pair.second));
@@ -882,15 +948,40 @@ public:
 
   /// \brief Find a Section by name.
   ///
+  /// For a module loaded by \ref IR::loadLazily, the sections are read from
+  /// the file first if they have not been read yet.
+  ///
   /// \param X The name to look up.
   ///
   /// \return A range of \ref Section objects with the requested name.
   const_section_name_range findSections(const std::string& X) const {
+    if (Lazy)
+      materializeSections(X);
     auto Pair = Sections.get<by_name>().equal_range(X);
     return boost::make_iterator_range(const_section_name_iterator(Pair.first),
                                       const_section_name_iterator(Pair.second));
   }
 
+  /// \brief Load the sections with the given name from a saved IR.
+  ///
+  /// Used with an IR loaded by \ref IR::loadModules without its sections.
+  /// The sections are read from an IR saved in the
+  /// \ref IR::ContainerFormat::Indexed or \ref IR::ContainerFormat::Compressed
+  /// format, and their symbolic
+  /// expressions, the referents of this module's symbols, the entry point
+  /// and the CFG edges of their blocks are restored. If the module already
+  /// has sections with this name, nothing is read. Sections cannot be loaded
+  /// into a frozen IR, which fails with \ref IR::load_error::FrozenIR.
+  ///
+  /// \param C           The Context in which the module was loaded.
+  /// \param In          A seekable input stream, positioned at the start of
+  ///                    the IR.
+  /// \param SectionName The name of the sections to load.
+  ///
+  /// \return The first section with the requested name, or an error.
+  ErrorOr<Section*> loadSection(Context& C, std::istream& In,
+                                const std::string& SectionName);
+
   /// @}
   // (end group of Section-related types and functions)
 
@@ -1423,6 +1514,40 @@ public:
     return const_code_block_range(const_code_block_iterator(Ranges),
                                   const_code_block_iterator());
   }
+
+  /// \brief Resolve a batch of addresses to the code blocks that contain them.
+  ///
+  /// This produces the same result as taking the first element of \ref
+  /// findCodeBlocksOn for every address, but indexes the code blocks of the
+  /// module once and then resolves all the addresses in a single ascending
+  /// sweep over that index. Addresses that are already sorted are not
+  /// re-sorted.
+  ///
+  /// \param Addrs       The addresses to resolve.
+  /// \param Count       The number of addresses in \p Addrs.
+  /// \param[out] Out    Storage for \p Count results. Out[I] is set to the
+  ///                    lowest-addressed \ref CodeBlock containing Addrs[I], or
+  ///                    nullptr if no block contains it.
+  /// \param NumThreads  The number of threads to resolve with. Zero selects the
+  ///                    hardware concurrency.
+  void resolveAddresses(const Addr* Addrs, size_t Count, const CodeBlock** Out,
+                        unsigned NumThreads = 1) const;
+
+  /// \brief Resolve a batch of addresses to the code blocks that contain them.
+  ///
+  /// \param Addrs       The addresses to resolve.
+  /// \param NumThreads  The number of threads to resolve with. Zero selects the
+  ///                    hardware concurrency.
+  ///
+  /// \return For each address, the lowest-addressed \ref CodeBlock containing
+  /// it, or nullptr if no block contains it.
+  std::vector<const CodeBlock*>
+  resolveAddresses(const std::vector<Addr>& Addrs,
+                   unsigned NumThreads = 1) const {
+    std::vector<const CodeBlock*> Result(Addrs.size());
+    resolveAddresses(Addrs.data(), Addrs.size(), Result.data(), NumThreads);
+    return Result;
+  }
   /// @}
   // (end group of CodeBlock-related types and functions)
 
@@ -1756,6 +1881,19 @@ private:
   /// \brief The protobuf message type used for serializing Module.
   using MessageType = proto::Module;
 
+  /// \brief Find the sections holding an address, in address order.
+  boost::iterator_range<SectionAddrIterator> sectionsOn(Addr X) const {
+    if (Lazy)
+      materializeSections();
+    if (FrozenSectionAddrs) {
+      auto Found = FrozenSectionAddrs->find(X);
+      return {Found.begin(), Found.end()};
+    }
+    if (auto It = SectionAddrs.find(X); It != SectionAddrs.end())
+      return {It->second.begin(), It->second.end()};
+    return {};
+  }
+
   /// \brief Remove a Section from SectionAddrs.
   void removeSectionAddrs(Section* S);
 
@@ -1768,17 +1906,21 @@ private:
   /// \brief Serialize into a protobuf message.
   ///
   /// \param[out] Message   Serialize into this message.
+  /// \param WithSections   Whether to serialize the sections as well.
   ///
   /// \return void
-  void toProtobuf(MessageType* Message) const;
+  void toProtobuf(MessageType* Message, bool WithSections = true) const;
 
   /// \brief Construct a Module from a protobuf message.
   ///
   /// \param C   The Context in which the deserialized Module will be held.
   /// \param Message  The protobuf message from which to deserialize.
+  /// \param Nodes  The table of nodes to which the indexed references of the
+  /// message refer, if any.
   ///
   /// \return The deserialized Module object, or null on failure.
-  static ErrorOr<Module*> fromProtobuf(Context& C, const MessageType& Message);
+  static ErrorOr<Module*> fromProtobuf(Context& C, const MessageType& Message,
+                                       NodeIndexTable* Nodes = nullptr);
 
   // Present for testing purposes only.
   void save(std::ostream& Out) const;
@@ -1791,6 +1933,12 @@ private:
     Observer = O;
   }
 
+  /// \brief Build the frozen indexes. Called by IR::freeze.
+  void freeze();
+
+  /// \brief Discard the frozen indexes. Called by IR::thaw.
+  void thaw();
+
   IR* Parent{nullptr};
   ModuleObserver* Observer{nullptr};
   std::string BinaryPath;
@@ -1802,15 +1950,45 @@ private:
   std::string Name;
   CodeBlock* EntryPoint{nullptr};
   ProxyBlockSet ProxyBlocks;
+  ProxyBlockPositionMap ProxyBlockPositions;
   SectionSet Sections;
   SectionIntMap SectionAddrs;
+  // Non-null only while the IR is frozen, when SectionAddrs is empty.
+  std::unique_ptr<SectionIndex> FrozenSectionAddrs;
   SymbolSet Symbols;
 
   std::unique_ptr<SectionObserver> SecObs;
   std::unique_ptr<SymbolObserver> SymObs;
 
-  friend class Context; // Allow Context to construct new Modules.
-  friend class IR;      // Allow IRs to call setIR, Create, etc.
+  // Flat code block index, built while the IR is frozen. The IR shares it
+  // when it contains a single module.
+  std::shared_ptr<const std::vector<CodeBlockExtent>> FrozenCodeBlocks;
+
+  // The sections not yet read from the file the module was loaded from by
+  // IR::loadLazily, if any. Reset once all of them have been read.
+  mutable std::shared_ptr<LazySections> Lazy;
+
+  /// \brief Read the sections with a name from the file the module was
+  /// loaded from, if they have not been read yet.
+  void materializeSections(const std::string& SectionName) const;
+
+  /// \brief Read all the sections not yet read from the file the module was
+  /// loaded from, so that queries and serialization see the whole module.
+  void materializeSections() const;
+
+  /// \brief Read all the sections not yet read from the file the module was
+  /// loaded from, and release the file once none are left.
+  ///
+  /// \return The error of the first section that could not be read, if any.
+  ErrorInfo materializePendingSections() const;
+
+  /// \brief Load the sections with a name from the frames of a container.
+  ErrorOr<Section*> loadSection(Context& C, ContainerFrames& Frames,
+                                const std::string& SectionName);
+
+  friend class Context;      // Allow Context to construct new Modules.
+  friend class IR;           // Allow IRs to call setIR, Create, etc.
+  friend class LazySections; // Allow it to load sections from its frames.
   // Allow serialization from IR via containerToProtobuf.
   template <typename T> friend typename T::MessageType toProtobuf(const T&);
   friend class SerializationTestHarness; // Testing support.
@@ -1872,7 +2050,10 @@ public:
                                         Module::code_block_range Blocks) = 0;
 };
 
-inline void Module::setName(const std::string& X) {
+inline ChangeStatus Module::setName(const std::string& X) {
+  assert(!isFrozen() && "cannot rename a module of a frozen IR");
+  if (isFrozen())
+    return ChangeStatus::Rejected;
   if (Observer) {
     std::string OldName = X;
     std::swap(Name, OldName);
@@ -1885,6 +2066,7 @@ inline void Module::setName(const std::string& X) {
   } else {
     Name = X;
   }
+  return ChangeStatus::Accepted;
 }
 } // namespace gtirb
 
@@ -103,6 +103,13 @@ public:
 
   /// \cond INTERNAL
   Kind getKind() const { return K; }
+
+  /// \brief Get the index of this node among the nodes of its kind created in
+  /// its Context, counting from zero in order of creation.
+  size_t getContextIndex() const { return ContextIndex; }
+
+  /// \brief Get the Context this node is held in.
+  Context& getContext() const { return *Ctx; }
   /// \endcond
 
   /// \cond INTERNAL
@@ -126,6 +133,7 @@ private:
   // the Context object because we want to keep the Node class copyable and
   // Context needs to own a move-only allocator.
   Context* Ctx;
+  size_t ContextIndex;
 
   friend class Context; // Enables Context::Create
 };
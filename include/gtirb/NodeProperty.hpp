@@ -0,0 +1,215 @@
+//===- NodeProperty.hpp -----------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#ifndef GTIRB_NODEPROPERTY_H
+#define GTIRB_NODEPROPERTY_H
+
+#include <gtirb/AuxDataContainer.hpp>
+#include <gtirb/Casting.hpp>
+#include <gtirb/Context.hpp>
+#include <gtirb/Node.hpp>
+#include <map>
+#include <utility>
+#include <vector>
+
+/// \file NodeProperty.hpp
+/// \ingroup AUXDATA_GROUP
+/// \brief Class gtirb::NodeProperty.
+/// \see AUXDATA_GROUP
+
+namespace gtirb {
+
+/// \class NodeProperty
+///
+/// \brief A value for each of a set of nodes, such as the alignment of
+/// blocks, stored in arrays indexed by the nodes' positions in their \ref
+/// Context.
+///
+/// Finding the value of a node takes constant time, without comparing or
+/// hashing its UUID. A property is converted to and from the UUID-keyed
+/// mappings stored in \ref AuxData, such as those of the \ref
+/// gtirb::schema::Alignment "alignment" table, so that it serializes as the
+/// corresponding table does.
+///
+/// All the nodes of a property must belong to the \ref Context given when
+/// the property is constructed. Storage for each kind of node grows with the
+/// number of nodes of that kind created in the Context, so properties of a
+/// few nodes among very many are better kept in a mapping.
+///
+/// \tparam NodeT   The type of the nodes, such as \ref CodeBlock.
+/// \tparam ValueT  The type of the values.
+///
+/// \see AUXDATA_GROUP
+template <class NodeT, class ValueT> class NodeProperty {
+public:
+  /// \brief The type of the nodes.
+  using node_type = NodeT;
+  /// \brief The type of the values.
+  using value_type = ValueT;
+
+  /// \brief Construct a property with no values.
+  ///
+  /// \param C  The Context holding the nodes of this property.
+  explicit NodeProperty(const Context& C) : Ctx(&C) {}
+
+  /// \brief Get the value of a node.
+  ///
+  /// \return The value, or \c nullptr if the node has no value.
+  const ValueT* find(const NodeT& N) const {
+    const auto [Kind, Index] = position(N);
+    if (Kind < Columns.size() && Index < Columns[Kind].Nodes.size() &&
+        Columns[Kind].Nodes[Index])
+      return &Columns[Kind].Values[Index].Value;
+    return nullptr;
+  }
+
+  /// \brief Get the value of a node for modification.
+  ///
+  /// \return The value, or \c nullptr if the node has no value.
+  ValueT* find(const NodeT& N) {
+    return const_cast<ValueT*>(std::as_const(*this).find(N));
+  }
+
+  /// \brief Whether a node has a value.
+  bool contains(const NodeT& N) const { return find(N) != nullptr; }
+
+  /// \brief Set the value of a node, replacing any value it has.
+  void set(const NodeT& N, ValueT V) {
+    const auto [Kind, Index] = position(N);
+    if (Kind >= Columns.size())
+      Columns.resize(Kind + 1);
+    Column& Col = Columns[Kind];
+    if (Index >= Col.Nodes.size()) {
+      Col.Nodes.resize(Index + 1, nullptr);
+      Col.Values.resize(Index + 1);
+    }
+    if (!Col.Nodes[Index]) {
+      Col.Nodes[Index] = &N;
+      ++Count;
+    }
+    Col.Values[Index].Value = std::move(V);
+  }
+
+  /// \brief Remove the value of a node.
+  ///
+  /// \return \c true if the node had a value, \c false otherwise.
+  bool erase(const NodeT& N) {
+    const auto [Kind, Index] = position(N);
+    if (!find(N))
+      return false;
+    Columns[Kind].Nodes[Index] = nullptr;
+    Columns[Kind].Values[Index].Value = ValueT();
+    --Count;
+    return true;
+  }
+
+  /// \brief Remove all values, including unresolved ones.
+  void clear() {
+    Columns.clear();
+    Unresolved.clear();
+    Count = 0;
+  }
+
+  /// \brief The number of nodes with values.
+  size_t size() const { return Count; }
+
+  /// \brief Whether no node has a value.
+  bool empty() const { return Count == 0; }
+
+  /// \brief Values read by insert() for UUIDs which were not those of nodes
+  /// of type \p NodeT in the Context.
+  ///
+  /// These are kept so that converting the property back to a mapping
+  /// preserves them.
+  const std::map<UUID, ValueT>& unresolved() const { return Unresolved; }
+
+  /// \brief Set the values of nodes from a UUID-keyed mapping.
+  ///
+  /// \param Map  A mapping from UUIDs to values, such as an AuxData table.
+  template <class MapT> void insert(const MapT& Map) {
+    for (const auto& [Id, V] : Map) {
+      if (const auto* N = dyn_cast_or_null<NodeT>(Node::getByUUID(*Ctx, Id)))
+        set(*N, V);
+      else
+        Unresolved.insert_or_assign(Id, V);
+    }
+  }
+
+  /// \brief Convert to a UUID-keyed mapping, including the unresolved
+  /// values.
+  ///
+  /// \tparam MapT  The type of the mapping.
+  template <class MapT = std::map<UUID, ValueT>> MapT toMap() const {
+    MapT Result(Unresolved.begin(), Unresolved.end());
+    for (const Column& Col : Columns)
+      for (size_t I = 0; I < Col.Nodes.size(); ++I)
+        if (Col.Nodes[I])
+          Result.insert_or_assign(Col.Nodes[I]->getUUID(),
+                                  Col.Values[I].Value);
+    return Result;
+  }
+
+  /// \brief Set the values of nodes from an \ref AuxData table.
+  ///
+  /// \tparam Schema  The schema of the table, whose type maps UUIDs to
+  ///                 values.
+  /// \param Container  The container of the table.
+  ///
+  /// \return \c false if the table is not present or could not be decoded,
+  /// \c true otherwise.
+  template <class Schema> bool loadAuxData(const AuxDataContainer& Container) {
+    const typename Schema::Type* Table = Container.getAuxData<Schema>();
+    if (!Table)
+      return false;
+    insert(*Table);
+    return true;
+  }
+
+  /// \brief Store the values in an \ref AuxData table, replacing any table
+  /// already present.
+  ///
+  /// \tparam Schema  The schema of the table, whose type maps UUIDs to
+  ///                 values.
+  /// \param Container  The container of the table.
+  template <class Schema> void saveAuxData(AuxDataContainer& Container) const {
+    Container.addAuxData<Schema>(toMap<typename Schema::Type>());
+  }
+
+private:
+  // Values are wrapped so that find() can point into the vector even when
+  // ValueT is bool, for which std::vector is specialized.
+  struct Slot {
+    ValueT Value{};
+  };
+
+  // Nodes[I] is the node of the kind with index I, if it has a value, which
+  // is Values[I].
+  struct Column {
+    std::vector<const NodeT*> Nodes;
+    std::vector<Slot> Values;
+  };
+
+  static std::pair<size_t, size_t> position(const NodeT& N) {
+    return {static_cast<size_t>(N.getKind()), N.getContextIndex()};
+  }
+
+  const Context* Ctx;
+  std::vector<Column> Columns;
+  std::map<UUID, ValueT> Unresolved;
+  size_t Count{0};
+};
+
+} // namespace gtirb
+
+#endif // GTIRB_NODEPROPERTY_H
@@ -19,14 +19,15 @@
 #include <gtirb/ByteInterval.hpp>
 #include <gtirb/CodeBlock.hpp>
 #include <gtirb/DataBlock.hpp>
+#include <gtirb/IntervalIndex.hpp>
 #include <gtirb/Node.hpp>
 #include <gtirb/Observer.hpp>
 #include <gtirb/Utility.hpp>
 #include <gtirb/proto/Section.pb.h>
 #include <algorithm>
-#include <boost/icl/interval_map.hpp>
 #include <boost/iterator/indirect_iterator.hpp>
 #include <boost/iterator/iterator_traits.hpp>
+#include <boost/iterator/transform_iterator.hpp>
 #include <boost/multi_index/hashed_index.hpp>
 #include <boost/multi_index/key_extractors.hpp>
 #include <boost/multi_index/mem_fun.hpp>
@@ -35,6 +36,7 @@
 #include <cstdint>
 #include <functional>
 #include <set>
+#include <vector>
 
 /// \file Section.hpp
 /// \brief Class gtirb::Section.
@@ -84,8 +86,10 @@ class GTIRB_EXPORT_API Section : public Node {
           boost::multi_index::hashed_unique<
               boost::multi_index::tag<by_pointer>,
               boost::multi_index::identity<ByteInterval*>>>>;
-  using ByteIntervalIntMap =
-      boost::icl::interval_map<Addr, std::set<ByteInterval*, AddressLess>>;
+
+  // The flat index used to find the intervals on an address, holding the
+  // intervals with an address and a non-zero size, sorted like ByteIntervals.
+  using ByteIntervalIndex = IntervalIndex<Addr, ByteInterval*>;
 
   class ByteIntervalObserverImpl;
 
@@ -116,6 +120,11 @@ public:
   /// \brief Get the \ref Module this section belongs to.
   const Module* getModule() const { return Parent; }
 
+  /// \brief Indicates whether the \ref IR this section belongs to is frozen.
+  ///
+  /// \see IR::freeze
+  bool isFrozen() const;
+
   /// \brief Get the name of a Section.
   ///
   /// \return The name.
@@ -166,8 +175,12 @@ public:
   /// \brief Range of \ref ByteInterval objects.
   using byte_interval_range = boost::iterator_range<byte_interval_iterator>;
   /// \brief Sub-range of \ref ByteInterval objects overlapping addresses.
+  ///
+  /// This type changed when the interval map behind \ref findByteIntervalsOn
+  /// was replaced by a flat index. Code that names it, rather than using
+  /// \c auto or the range's iterators, must be rebuilt against this header.
   using byte_interval_subrange = boost::iterator_range<
-      boost::indirect_iterator<ByteIntervalIntMap::codomain_type::iterator>>;
+      boost::indirect_iterator<ByteIntervalIndex::const_iterator>>;
   /// \brief Const iterator over \ref ByteInterval objects.
   using const_byte_interval_iterator =
       boost::indirect_iterator<ByteIntervalSet::const_iterator,
@@ -176,9 +189,11 @@ public:
   using const_byte_interval_range =
       boost::iterator_range<const_byte_interval_iterator>;
   /// \brief Const sub-range of \ref ByteInterval objects overlapping addresses.
-  using const_byte_interval_subrange =
-      boost::iterator_range<boost::indirect_iterator<
-          ByteIntervalIntMap::codomain_type::const_iterator>>;
+  ///
+  /// \see byte_interval_subrange
+  using const_byte_interval_subrange = boost::iterator_range<
+      boost::indirect_iterator<ByteIntervalIndex::const_iterator,
+                               const ByteInterval>>;
 
   /// \brief Return an iterator to the first \ref ByteInterval.
   byte_interval_iterator byte_intervals_begin() {
@@ -216,12 +231,7 @@ public:
   /// \return A range of \ref ByteInterval objects that intersect the address \p
   /// A.
   byte_interval_subrange findByteIntervalsOn(Addr A) {
-    if (auto It = ByteIntervalAddrs.find(A); It != ByteIntervalAddrs.end()) {
-      return boost::make_iterator_range(
-          boost::make_indirect_iterator(It->second.begin()),
-          boost::make_indirect_iterator(It->second.end()));
-    }
-    return {};
+    return findByteIntervalsOnImpl<ByteInterval>(A);
   }
 
   /// \brief Find all the intervals that have bytes that lie within the address
@@ -232,12 +242,7 @@ public:
   /// \return A range of \ref ByteInterval objects that intersect the address \p
   /// A.
   const_byte_interval_subrange findByteIntervalsOn(Addr A) const {
-    if (auto It = ByteIntervalAddrs.find(A); It != ByteIntervalAddrs.end()) {
-      return boost::make_iterator_range(
-          boost::make_indirect_iterator(It->second.begin()),
-          boost::make_indirect_iterator(It->second.end()));
-    }
-    return {};
+    return findByteIntervalsOnImpl<const ByteInterval>(A);
   }
 
   /// \brief Find all the intervals that start at an address.
@@ -349,20 +354,63 @@ public:
   /// \tparam Args  The arguments to construct a \ref ByteInterval.
   /// \param  C     The Context in which this object will be held.
   /// \param  A     The arguments to construct a \ref ByteInterval.
+  ///
+  /// \return the created ByteInterval, or null if the IR is frozen, which also
+  /// fails an assertion in debug builds. Nothing is created in that case.
   template <typename... Args>
   ByteInterval* addByteInterval(Context& C, Args&&... A) {
+    assert(!isFrozen() && "cannot add a byte interval to a frozen IR");
+    if (isFrozen())
+      return nullptr;
     ByteInterval* BI = ByteInterval::Create(C, std::forward<Args>(A)...);
-    [[maybe_unused]] ChangeStatus status = addByteInterval(BI);
-    // addByteInterval(ByteInterval*) does not currently reject any insertions
+    // addByteInterval(ByteInterval*) only rejects insertions into a frozen IR
     // and the result cannot be NoChange because we just inserted a newly
     // created ByteInterval.
-    assert(status == ChangeStatus::Accepted &&
-           "unexpected result when inserting ByteInterval");
+    addByteInterval(BI);
     return BI;
   }
 
+  /// \brief Split a \ref ByteInterval in this section in two.
+  ///
+  /// The bytes, blocks and symbolic expressions of \p BI at or after \p Offset
+  /// are moved into a new interval, which is added to this section and begins
+  /// where \p BI now ends. Blocks keep their addresses, so their CFG vertices,
+  /// edges and symbol referents are unaffected. The work done is proportional
+  /// to the amount of content moved, not to the size of \p BI.
+  ///
+  /// \param C       The Context in which the new interval will be held.
+  /// \param BI      The interval to split.
+  /// \param Offset  The offset in \p BI at which to split it.
+  ///
+  /// \return The new interval, or null if the split was rejected. A split is
+  /// rejected if \p BI is not in this section, \p Offset is not strictly
+  /// between 0 and the size of \p BI, a block of \p BI spans \p Offset, or
+  /// the IR is frozen.
+  ByteInterval* splitByteInterval(Context& C, ByteInterval* BI,
+                                  uint64_t Offset);
+
+  /// \brief Merge a \ref ByteInterval into the one it directly follows.
+  ///
+  /// The bytes, blocks and symbolic expressions of \p B are appended to \p A,
+  /// which grows by the size of \p B. \p B is then removed from this section,
+  /// left empty. Blocks keep their addresses, so their CFG vertices, edges and
+  /// symbol referents are unaffected. If \p B has initialized bytes, any
+  /// uninitialized bytes at the end of \p A become initialized to zero.
+  ///
+  /// \param A  The interval to merge into.
+  /// \param B  The interval to merge. If both intervals have addresses, \p B
+  ///           must begin at the address where \p A ends.
+  ///
+  /// \return \c Accepted if the intervals were merged, or \c Rejected if
+  /// either interval is not in this section, they are the same interval, \p B
+  /// does not directly follow \p A, or the IR is frozen.
+  ChangeStatus mergeByteIntervals(ByteInterval* A, ByteInterval* B);
+
   /// \brief Set this section's name.
-  void setName(const std::string& N);
+  ///
+  /// \return \c Rejected if the IR is frozen, which also fails an assertion
+  /// in debug builds; \c Accepted otherwise.
+  ChangeStatus setName(const std::string& N);
 
   /// \brief Iterator over blocks.
   ///
@@ -1053,21 +1101,45 @@ private:
   SectionObserver* Observer{nullptr};
   std::string Name;
   ByteIntervalSet ByteIntervals;
-  ByteIntervalIntMap ByteIntervalAddrs;
+  // End addresses of the intervals with an address and a non-zero size.
+  std::multiset<Addr> ByteIntervalEnds;
+  // Flat index behind findByteIntervalsOn. It is rebuilt on the first query
+  // after a change to the intervals, so a series of changes costs one
+  // rebuild instead of one interval map update each.
+  mutable ByteIntervalIndex ByteIntervalAddrs;
   std::optional<AddrRange> Extent;
   std::set<SectionFlag> Flags;
 
   std::unique_ptr<ByteIntervalObserver> BIO;
 
-  /// \brief Remove a ByteInterval from ByteIntervalAddrs.
+  /// \brief Remove a ByteInterval from the address index.
   void removeByteIntervalAddrs(ByteInterval* BI);
 
-  /// \brief Add a ByteInterval to ByteIntervalAddrs.
+  /// \brief Add a ByteInterval to the address index.
   ///
   /// The caller is responsible for ensuring that the ByteInterval is owned
   /// by this Section.
   void insertByteIntervalAddrs(ByteInterval* BI);
 
+  /// \brief Return the address index, rebuilding it if it is stale.
+  const ByteIntervalIndex& byteIntervalAddrs() const;
+
+  /// \brief Build the address index and trim it to size. Called by
+  /// Module::freeze.
+  void freeze();
+
+  template <typename BIType>
+  boost::iterator_range<
+      boost::indirect_iterator<ByteIntervalIndex::const_iterator, BIType>>
+  findByteIntervalsOnImpl(Addr A) const {
+    ByteIntervalIndex::const_range Found = byteIntervalAddrs().find(A);
+    return boost::make_iterator_range(
+        boost::indirect_iterator<ByteIntervalIndex::const_iterator, BIType>(
+            Found.begin()),
+        boost::indirect_iterator<ByteIntervalIndex::const_iterator, BIType>(
+            Found.end()));
+  }
+
   /// \brief Update the extent after adding/removing a ByteInterval.
   ChangeStatus updateExtent();
 
@@ -1207,7 +1279,10 @@ public:
                                     std::function<void(Section*)> Callback) = 0;
 };
 
-inline void Section::setName(const std::string& X) {
+inline ChangeStatus Section::setName(const std::string& X) {
+  assert(!isFrozen() && "cannot rename a section of a frozen IR");
+  if (isFrozen())
+    return ChangeStatus::Rejected;
   if (Observer) {
     std::string OldName = X;
     std::swap(Name, OldName);
@@ -1220,6 +1295,7 @@ inline void Section::setName(const std::string& X) {
   } else {
     Name = X;
   }
+  return ChangeStatus::Accepted;
 }
 } // namespace gtirb
 
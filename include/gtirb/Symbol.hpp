@@ -308,20 +308,30 @@ public:
   bool hasReferent() const { return std::holds_alternative<Node*>(Payload); }
 
   /// \brief Set the name of a symbol.
-  void setName(const std::string& N);
+  ///
+  /// \return \c Rejected if the IR is frozen, which also fails an assertion
+  /// in debug builds; \c Accepted otherwise.
+  ChangeStatus setName(const std::string& N);
 
   /// \brief Set the referent of a symbol.
   ///
   /// If the referent of a symbol is set to null, then the value of the
   /// symbol's payload will be cleared (that is, \ref hasReference will return
   /// false).
+  ///
+  /// \return \c Rejected if the IR is frozen, which also fails an assertion
+  /// in debug builds; \c Accepted otherwise.
   template <typename NodeTy>
-  std::enable_if_t<is_supported_type<NodeTy>()> setReferent(NodeTy* N) {
-    setReferentFromNode(N);
+  std::enable_if_t<is_supported_type<NodeTy>(), ChangeStatus>
+  setReferent(NodeTy* N) {
+    return setReferentFromNode(N);
   }
 
   /// \brief Set the address of a symbol.
-  void setAddress(Addr A);
+  ///
+  /// \return \c Rejected if the IR is frozen, which also fails an assertion
+  /// in debug builds; \c Accepted otherwise.
+  ChangeStatus setAddress(Addr A);
 
   /// \brief If true, this symbol is pointing to the end of the referent
   /// rather than at the beginning.
@@ -365,7 +375,7 @@ private:
     Observer = O;
   }
 
-  void setReferentFromNode(Node* N);
+  ChangeStatus setReferentFromNode(Node* N);
 
   /// \brief The protobuf message type used for serializing Symbol.
   using MessageType = proto::Symbol;
@@ -440,45 +450,52 @@ public:
                  std::variant<std::monostate, Addr, Node*> NewReferent) = 0;
 };
 
-inline void Symbol::setName(const std::string& N) {
-  if (Observer) {
-    std::string OldName(N);
-    std::swap(Name, OldName);
-    [[maybe_unused]] ChangeStatus Status =
-        Observer->nameChange(this, OldName, Name);
-    assert(Status != ChangeStatus::Rejected &&
-           "recovering from rejected name change is unsupported");
-  } else {
+inline ChangeStatus Symbol::setName(const std::string& N) {
+  if (!Observer) {
     Name = N;
+    return ChangeStatus::Accepted;
   }
+  std::string OldName(N);
+  std::swap(Name, OldName);
+  ChangeStatus Status = Observer->nameChange(this, OldName, Name);
+  // Observers only reject a change before updating their indexes.
+  if (Status == ChangeStatus::Rejected)
+    Name = std::move(OldName);
+  assert(Status != ChangeStatus::Rejected &&
+         "cannot rename a symbol of a frozen IR");
+  return Status;
 }
 
-inline void Symbol::setAddress(Addr A) {
-  if (Observer) {
-    std::variant<std::monostate, Addr, Node*> OldValue = Payload;
-    Payload = A;
-    [[maybe_unused]] ChangeStatus Status =
-        Observer->referentChange(this, OldValue, Payload);
-    assert(Status != ChangeStatus::Rejected &&
-           "recovering from rejected address change is unsupported");
-  } else {
+inline ChangeStatus Symbol::setAddress(Addr A) {
+  if (!Observer) {
     Payload = A;
+    return ChangeStatus::Accepted;
   }
+  std::variant<std::monostate, Addr, Node*> OldValue = Payload;
+  Payload = A;
+  ChangeStatus Status = Observer->referentChange(this, OldValue, Payload);
+  if (Status == ChangeStatus::Rejected)
+    Payload = OldValue;
+  assert(Status != ChangeStatus::Rejected &&
+         "cannot change the address of a symbol of a frozen IR");
+  return Status;
 }
 
-inline void Symbol::setReferentFromNode(Node* N) {
+inline ChangeStatus Symbol::setReferentFromNode(Node* N) {
   std::variant<std::monostate, Addr, Node*> OldValue = Payload;
   if (N) {
     Payload = N;
   } else {
     Payload = std::monostate{};
   }
-  if (Observer) {
-    [[maybe_unused]] ChangeStatus Status =
-        Observer->referentChange(this, OldValue, Payload);
-    assert(Status != ChangeStatus::Rejected &&
-           "recovering from rejected referent change is unsupported");
-  }
+  if (!Observer)
+    return ChangeStatus::Accepted;
+  ChangeStatus Status = Observer->referentChange(this, OldValue, Payload);
+  if (Status == ChangeStatus::Rejected)
+    Payload = OldValue;
+  assert(Status != ChangeStatus::Rejected &&
+         "cannot change the referent of a symbol of a frozen IR");
+  return Status;
 }
 
 } // namespace gtirb
@@ -24,14 +24,19 @@
 #include <gtirb/Addr.hpp>
 #include <gtirb/AuxData.hpp>
 #include <gtirb/AuxDataSchema.hpp>
+#include <gtirb/AuxDataView.hpp>
 #include <gtirb/ByteInterval.hpp>
 #include <gtirb/CFG.hpp>
+#include <gtirb/ChunkStore.hpp>
 #include <gtirb/CodeBlock.hpp>
 #include <gtirb/DataBlock.hpp>
+#include <gtirb/Diff.hpp>
 #include <gtirb/Export.hpp>
 #include <gtirb/IR.hpp>
+#include <gtirb/IRDelta.hpp>
 #include <gtirb/Module.hpp>
 #include <gtirb/Node.hpp>
+#include <gtirb/NodeProperty.hpp>
 #include <gtirb/Section.hpp>
 #include <gtirb/Symbol.hpp>
 #include <gtirb/SymbolicExpression.hpp>
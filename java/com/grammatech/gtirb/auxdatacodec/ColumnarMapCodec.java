@@ -0,0 +1,96 @@
+/*
+ *  Copyright (C) 2020-2021 GrammaTech, Inc.
+ *
+ *  This code is licensed under the MIT license. See the LICENSE file in the
+ *  project root for license terms.
+ *
+ *  This project is sponsored by the Office of Naval Research, One Liberty
+ *  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+ *  N68335-17-C-0700.  The content of the information does not necessarily
+ *  reflect the position or policy of the Government and no official
+ *  endorsement should be inferred.
+ *
+ */
+
+package com.grammatech.gtirb.auxdatacodec;
+
+import java.io.IOException;
+import java.io.InputStream;
+import java.io.OutputStream;
+import java.util.ArrayList;
+import java.util.Comparator;
+import java.util.List;
+import java.util.Map;
+import java.util.function.Supplier;
+
+/**
+ * Codec for columnar-mapping&lt;K,V&gt;: the number of entries, then all of
+ * the keys in ascending order, then all of the values in the same order.
+ */
+public class ColumnarMapCodec<K, V> implements Codec<Map<K, V>> {
+    private Codec<K> kCodec;
+    private Codec<V> vCodec;
+    private Supplier<Map<K, V>> sup;
+    private Comparator<? super K> order;
+
+    /**
+     * Create a codec which writes keys in the iteration order of the map
+     * being encoded, e.g. a TreeMap with a suitable comparator.
+     */
+    public ColumnarMapCodec(Codec<K> kc, Codec<V> vc, Supplier<Map<K, V>> s) {
+        this(kc, vc, s, null);
+    }
+
+    /**
+     * Create a codec which sorts keys with the given comparator before
+     * writing them. The comparator should match the ordering of the keys in
+     * the C++ API, e.g. Long::compareUnsigned for uint64_t keys.
+     */
+    public ColumnarMapCodec(Codec<K> kc, Codec<V> vc, Supplier<Map<K, V>> s,
+                            Comparator<? super K> order) {
+        this.kCodec = kc;
+        this.vCodec = vc;
+        this.sup = s;
+        this.order = order;
+    }
+
+    public String getTypeName() {
+        return "columnar-mapping<" + kCodec.getTypeName() + "," +
+            vCodec.getTypeName() + ">";
+    }
+
+    public Map<K, V> decode(InputStream in) throws IOException {
+        Map<K, V> map = this.sup.get();
+
+        // Size of the map.
+        long len = LongCodec.decodeStatic(in);
+
+        // The key column, then the value column.
+        List<K> keys = new ArrayList<>();
+        for (long i = 0; i < len; i++) {
+            keys.add(this.kCodec.decode(in));
+        }
+        for (K key : keys) {
+            map.put(key, this.vCodec.decode(in));
+        }
+        return map;
+    }
+
+    public void encode(OutputStream out, Map<K, V> map) throws IOException {
+        List<K> keys = new ArrayList<>(map.keySet());
+        if (this.order != null) {
+            keys.sort(this.order);
+        }
+
+        // Size of the map.
+        LongCodec.encodeStatic(out, (long)keys.size());
+
+        // The key column, then the value column.
+        for (K key : keys) {
+            this.kCodec.encode(out, key);
+        }
+        for (K key : keys) {
+            this.vCodec.encode(out, map.get(key));
+        }
+    }
+}
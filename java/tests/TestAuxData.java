@@ -14,6 +14,7 @@ import com.grammatech.gtirb.Symbol;
 import com.grammatech.gtirb.auxdatacodec.BoolCodec;
 import com.grammatech.gtirb.auxdatacodec.ByteCodec;
 import com.grammatech.gtirb.auxdatacodec.Codec;
+import com.grammatech.gtirb.auxdatacodec.ColumnarMapCodec;
 import com.grammatech.gtirb.auxdatacodec.FloatCodec;
 import com.grammatech.gtirb.auxdatacodec.IntegerCodec;
 import com.grammatech.gtirb.auxdatacodec.ListCodec;
@@ -171,6 +172,10 @@ public class TestAuxData {
         Map<UUID, List<Float>> hm = new HashMap<>();
         hm.put(new UUID(2, 4), alf);
 
+        Map<Long, String> cm = new HashMap<>();
+        cm.put(7L, "seven");
+        cm.put(-1L, "max");
+
         Set<String> hs = new HashSet<>();
         hs.add("foo");
         hs.add("bar");
@@ -224,6 +229,12 @@ public class TestAuxData {
                              new ListCodec<>(new FloatCodec(), ArrayList::new),
                              HashMap::new),
                          hm),
+            Arguments.of("columnar-mapping<uint64_t,string>",
+                         new ColumnarMapCodec<>(LongCodec.UINT64,
+                                                new StringCodec(),
+                                                HashMap::new,
+                                                Long::compareUnsigned),
+                         cm),
             Arguments.of("set<string>",
                          new SetCodec<>(new StringCodec(), HashSet::new), hs),
             Arguments.of("tuple<string>",
@@ -187,6 +187,78 @@ class MappingCodec(Codec):
             serialization._encode_tree(out, val, val_type)
 
 
+class ColumnarMappingCodec(Codec):
+    """A Codec for columnar-mapping<K,V> entries. Implemented via ``dict``.
+
+    The keys are written as one column, in ascending order, followed by the
+    values as a second column in the same order.
+    """
+
+    @staticmethod
+    def decode(
+        raw_bytes: BinaryIO,
+        *,
+        serialization: "Serialization",
+        subtypes: Sequence[SubtypeTree],
+        get_by_uuid: Optional[CacheLookupFn] = None,
+    ) -> Mapping[object, object]:
+        try:
+            key_type, val_type = subtypes
+        except (TypeError, ValueError):
+            raise DecodeError(
+                "could not unpack columnar-mapping types: %s" % str(subtypes)
+            )
+        mapping_len = Uint64Codec.decode(raw_bytes)
+        keys = [
+            serialization._decode_tree(raw_bytes, key_type, get_by_uuid)
+            for _ in range(mapping_len)
+        ]
+        mapping = dict()
+        for key in keys:
+            val = serialization._decode_tree(raw_bytes, val_type, get_by_uuid)
+            mapping[key] = val
+        return mapping
+
+    @staticmethod
+    def _sort_key(key: object) -> object:
+        """Map a key to a value which orders the same way as its C++
+        counterpart: nodes order by UUID, and offsets and tuples order
+        element by element.
+        """
+
+        if isinstance(key, Node):
+            return key.uuid
+        if isinstance(key, tuple):
+            return tuple(ColumnarMappingCodec._sort_key(k) for k in key)
+        return key
+
+    @staticmethod
+    def encode(
+        out: BinaryIO,
+        mapping: object,
+        *,
+        serialization: "Serialization",
+        subtypes: Sequence[SubtypeTree],
+    ) -> None:
+        if not isinstance(mapping, Mapping):
+            raise EncodeError("Mapping codec only supports Mappings")
+        try:
+            key_type, val_type = subtypes
+        except (TypeError, ValueError):
+            raise EncodeError(
+                "could not unpack columnar-mapping types: %s" % str(subtypes)
+            )
+        try:
+            keys = sorted(mapping, key=ColumnarMappingCodec._sort_key)
+        except TypeError:
+            raise EncodeError("columnar-mapping keys must be ordered")
+        Uint64Codec.encode(out, len(keys))
+        for key in keys:
+            serialization._encode_tree(out, key, key_type)
+        for key in keys:
+            serialization._encode_tree(out, mapping[key], val_type)
+
+
 class OffsetCodec(Codec):
     """A Codec for :class:`gtirb.Offset` objects,
     containing a UUID and a displacement.
@@ -679,6 +751,7 @@ class Serialization:
         self.codecs: Dict[str, Type[Codec]] = {
             "Addr": Uint64Codec,
             "bool": BoolCodec,
+            "columnar-mapping": ColumnarMappingCodec,
             "Offset": OffsetCodec,
             "int64_t": Int64Codec,
             "int32_t": Int32Codec,
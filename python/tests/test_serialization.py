@@ -211,6 +211,28 @@ class TestSerialization(unittest.TestCase):
         )
         self.assertEqual(mapping_val, mapping)
 
+    def test_columnar_mapping_codec(self):
+        serializer = gtirb.serialization.Serialization()
+        ostream = io.BytesIO()
+        mapping = {3: ["c"], 1: ["a", "aa"], 2: []}
+        serializer.encode(
+            ostream, mapping, "columnar-mapping<uint64_t,sequence<string>>"
+        )
+        raw_bytes = ostream.getvalue()
+
+        # Keys are written first, in ascending order.
+        self.assertEqual(raw_bytes[:8], (3).to_bytes(8, byteorder="little"))
+        keys = [
+            int.from_bytes(raw_bytes[8 + 8 * i : 16 + 8 * i], "little")
+            for i in range(3)
+        ]
+        self.assertEqual(keys, [1, 2, 3])
+
+        result = serializer.decode(
+            raw_bytes, "columnar-mapping<uint64_t,sequence<string>>"
+        )
+        self.assertEqual(result, mapping)
+
     def _check_val(self, typename, val):
         bstream = io.BytesIO()
         gtirb.AuxData.serializer.encode(bstream, val, typename)
@@ -0,0 +1,113 @@
+//===- AddressResolution.cpp ------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#include "AddressResolution.hpp"
+#include <algorithm>
+#include <functional>
+#include <numeric>
+#include <thread>
+
+using namespace gtirb;
+
+namespace {
+// Sweep the addresses at sorted positions [Begin, End) of the sweep order.
+// Order is null when the addresses are already sorted.
+void sweep(const std::vector<CodeBlockExtent>& Extents,
+           const std::vector<Addr>& MaxHigh, const Addr* Addrs,
+           const size_t* Order, size_t Begin, size_t End,
+           const CodeBlock** Out) {
+  if (Begin == End)
+    return;
+
+  auto Index = [Order](size_t I) { return Order ? Order[I] : I; };
+
+  // Cursor is one past the last extent starting at or before the address, and
+  // Earliest is the first extent whose running maximum end exceeds it. Both
+  // only move forward as the addresses ascend.
+  Addr First = Addrs[Index(Begin)];
+  size_t Cursor =
+      std::upper_bound(Extents.begin(), Extents.end(), First,
+                       [](const Addr& A, const CodeBlockExtent& E) {
+                         return A < E.Low;
+                       }) -
+      Extents.begin();
+  size_t Earliest =
+      std::upper_bound(MaxHigh.begin(), MaxHigh.end(), First) - MaxHigh.begin();
+
+  for (size_t I = Begin; I != End; ++I) {
+    size_t Pos = Index(I);
+    Addr A = Addrs[Pos];
+    while (Cursor != Extents.size() && Extents[Cursor].Low <= A)
+      ++Cursor;
+    while (Earliest != MaxHigh.size() && MaxHigh[Earliest] <= A)
+      ++Earliest;
+
+    // Every extent before the cursor starts at or before A, so the earliest
+    // one containing A is the first whose end exceeds A. Since MaxHigh is
+    // nondecreasing, that is the first extent whose running maximum does.
+    Out[Pos] = Earliest < Cursor ? Extents[Earliest].Block : nullptr;
+  }
+}
+} // namespace
+
+void gtirb::resolveCodeBlockAddresses(
+    const std::vector<CodeBlockExtent>& Extents, const Addr* Addrs,
+    size_t Count, const CodeBlock** Out, unsigned NumThreads) {
+  if (Count == 0)
+    return;
+
+  // Running maximum of the extent ends, used to find the earliest extent
+  // that reaches an address.
+  std::vector<Addr> MaxHigh;
+  MaxHigh.reserve(Extents.size());
+  for (const CodeBlockExtent& E : Extents)
+    MaxHigh.push_back(MaxHigh.empty() ? E.High
+                                      : std::max(MaxHigh.back(), E.High));
+
+  // Trace and coverage data are usually sorted or nearly so; only pay for a
+  // permutation when the input is out of order.
+  std::vector<size_t> Order;
+  if (!std::is_sorted(Addrs, Addrs + Count)) {
+    Order.resize(Count);
+    std::iota(Order.begin(), Order.end(), size_t{0});
+    std::stable_sort(Order.begin(), Order.end(), [Addrs](size_t L, size_t R) {
+      return Addrs[L] < Addrs[R];
+    });
+  }
+  const size_t* OrderPtr = Order.empty() ? nullptr : Order.data();
+
+  if (NumThreads == 0)
+    NumThreads = std::max(1u, std::thread::hardware_concurrency());
+  // Not worth spawning threads for small batches.
+  static constexpr size_t MinChunkSize = 1 << 14;
+  size_t NumChunks =
+      std::min<size_t>(NumThreads, (Count + MinChunkSize - 1) / MinChunkSize);
+  if (NumChunks <= 1) {
+    sweep(Extents, MaxHigh, Addrs, OrderPtr, 0, Count, Out);
+    return;
+  }
+
+  // Each chunk writes to a disjoint set of output positions.
+  std::vector<std::thread> Threads;
+  Threads.reserve(NumChunks - 1);
+  size_t ChunkSize = (Count + NumChunks - 1) / NumChunks;
+  for (size_t Begin = ChunkSize; Begin < Count; Begin += ChunkSize) {
+    size_t End = std::min(Begin + ChunkSize, Count);
+    Threads.emplace_back(sweep, std::cref(Extents), std::cref(MaxHigh), Addrs,
+                         OrderPtr, Begin, End, Out);
+  }
+  sweep(Extents, MaxHigh, Addrs, OrderPtr, 0, std::min(ChunkSize, Count), Out);
+  for (std::thread& T : Threads)
+    T.join();
+}
@@ -0,0 +1,71 @@
+//===- AddressResolution.hpp ------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#ifndef GTIRB_ADDRESS_RESOLUTION_HPP
+#define GTIRB_ADDRESS_RESOLUTION_HPP
+
+#include <gtirb/Addr.hpp>
+#include <cstddef>
+#include <vector>
+
+namespace gtirb {
+class CodeBlock;
+
+/// @cond INTERNAL
+/// \brief The address range covered by a \ref CodeBlock.
+struct CodeBlockExtent {
+  Addr Low;
+  Addr High;
+  const CodeBlock* Block;
+};
+
+/// \brief Append the extents of the given code blocks to \p Extents.
+///
+/// Blocks without an address and blocks of size zero are skipped, since no
+/// address can lie on them.
+///
+/// \param Blocks   The code blocks to index.
+/// \param Extents  The vector to append to.
+template <typename RangeT>
+void appendCodeBlockExtents(const RangeT& Blocks,
+                            std::vector<CodeBlockExtent>& Extents) {
+  for (const auto& B : Blocks) {
+    if (auto A = B.getAddress(); A && B.getSize() != 0)
+      Extents.push_back({*A, *A + B.getSize(), &B});
+  }
+}
+
+/// \brief Resolve each address to the first code block containing it.
+///
+/// The addresses are visited in ascending order (they are only sorted if they
+/// are not already) while two cursors sweep \p Extents once: one over the
+/// block starts and one over the running maximum of the block ends. A sweep
+/// therefore costs O(E + N) for E extents and N addresses, plus O(N log N)
+/// when the addresses need sorting, regardless of how the blocks overlap.
+///
+/// \param Extents     Block extents, sorted by low address. Ties are resolved
+///                    in favor of the earlier extent.
+/// \param Addrs       The addresses to resolve.
+/// \param Count       The number of addresses.
+/// \param[out] Out    Storage for \p Count results.
+/// \param NumThreads  The number of threads to sweep with. Zero selects the
+///                    hardware concurrency.
+void resolveCodeBlockAddresses(const std::vector<CodeBlockExtent>& Extents,
+                               const Addr* Addrs, size_t Count,
+                               const CodeBlock** Out, unsigned NumThreads);
+/// @endcond
+
+} // namespace gtirb
+
+#endif // GTIRB_ADDRESS_RESOLUTION_HPP
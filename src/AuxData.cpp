@@ -17,8 +17,10 @@
 
 namespace gtirb {
 void AuxData::fromProtobuf(AuxData& Result, const MessageType& Message) {
-  Result.SF.ProtobufType = Message.type_name();
-  Result.SF.RawBytes = Message.data();
+  auto Form = std::make_shared<SerializedForm>();
+  Form->ProtobufType = Message.type_name();
+  Form->RawBytes = Message.data();
+  Result.SF = std::move(Form);
 }
 
 void AuxData::toProtobuf(MessageType* Message,
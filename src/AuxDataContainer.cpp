@@ -16,10 +16,13 @@
 #include "AuxDataContainer.hpp"
 #include "AuxData.hpp"
 #include "Context.hpp"
+#include "Parallel.hpp"
 #include "Serialization.hpp"
 
+#include <algorithm>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace gtirb {
 
@@ -34,7 +37,7 @@ struct AuxDataTypeMap {
 // this symbol in client applications.
 static AuxDataTypeMap TypeMap;
 
-void AuxDataContainer::registerAuxDataTypeInternal(
+size_t AuxDataContainer::registerAuxDataTypeInternal(
     const char* Name, std::unique_ptr<AuxDataType> ADT) {
   assert(!TypeMap.Locked && "New AuxData types cannot be added at this point.");
 
@@ -43,10 +46,16 @@ void AuxDataContainer::registerAuxDataTypeInternal(
     // register the same AuxData name are using different types.
     assert(it->second->getApiTypeId() == ADT->getApiTypeId() &&
            "Different types registered for the same AuxData name.");
-    return;
+    if (it->second->getApiTypeId() != ADT->getApiTypeId())
+      return AuxDataType::NoSlot;
+    return it->second->Slot;
   }
 
+  // Each registered name gets the next slot.
+  ADT->Slot = TypeMap.Map.size();
+  size_t Slot = ADT->Slot;
   TypeMap.Map.insert(std::make_pair(std::string(Name), std::move(ADT)));
+  return Slot;
 }
 
 bool AuxDataContainer::checkAuxDataRegistration(const char* Name,
@@ -64,6 +73,35 @@ AuxDataContainer::lookupAuxDataType(const std::string& Name) {
   return nullptr;
 }
 
+std::vector<const AuxData::SerializedForm*>
+AuxDataContainer::encodeAuxData(std::vector<AuxData::SerializedForm>& Scratch,
+                                unsigned NumThreads, bool Canonical) const {
+  std::vector<const AuxData*> Tables;
+  Tables.reserve(AuxDatas.size());
+  for (const auto& Entry : AuxDatas)
+    Tables.push_back(Entry.second.get());
+
+  Scratch.resize(Tables.size());
+  std::vector<const AuxData::SerializedForm*> Forms(Tables.size());
+  if (Canonical) {
+    // Any table may hold hashed containers which must be decoded and sorted.
+    parallelForEach(Tables.size(), NumThreads, [&](size_t I) {
+      Forms[I] = &Tables[I]->encodeCanonical(Scratch[I]);
+    });
+    return Forms;
+  }
+
+  // Tables written back from the bytes they were loaded from need no work;
+  // only spread the tables that must be encoded across threads.
+  size_t Pending = std::count_if(Tables.begin(), Tables.end(),
+                                 [](const AuxData* AD) {
+                                   return AD->needsEncoding();
+                                 });
+  parallelForEach(Tables.size(), std::min<size_t>(NumThreads, Pending),
+                  [&](size_t I) { Forms[I] = &Tables[I]->encode(Scratch[I]); });
+  return Forms;
+}
+
 AuxDataContainer::AuxDataContainer(Context& C, Node::Kind knd) : Node(C, knd) {
   // Once this is called, we outlaw registering new AuxData types.
   TypeMap.Locked = true;
@@ -22,7 +22,9 @@
 #include <gtirb/Section.hpp>
 #include <gtirb/Utility.hpp>
 #include <gtirb/proto/ByteInterval.pb.h>
+#include <algorithm>
 #include <iterator>
+#include <limits>
 
 using namespace gtirb;
 
@@ -126,6 +128,17 @@ ErrorOr<ByteInterval*> ByteInterval::fromProtobuf(Context& C,
     return {IR::load_error::BadUUID, ss.str()};
   }
 
+  // Contents kept in a chunk store must have been read into the message by
+  // the loader, which knows the store.
+  if (!Message.contents_digest().empty()) {
+    std::stringstream ss;
+    ss << "ByteInterval";
+    if (A)
+      ss << "@ " << *A;
+    ss << " has its contents in a chunk store";
+    return {IR::load_error::CorruptByteInterval, ss.str()};
+  }
+
   ByteInterval* BI = ByteInterval::Create(
       C, A, Message.contents().begin(), Message.contents().end(),
       Message.size(), Message.contents().size(), Id);
@@ -161,8 +174,14 @@ ErrorOr<ByteInterval*> ByteInterval::fromProtobuf(Context& C,
   return BI;
 }
 
-bool ByteInterval::symbolicExpressionsFromProtobuf(Context& C,
-                                                   const MessageType& Message) {
+bool ByteInterval::symbolicExpressionsFromProtobuf(
+    Context& C, const MessageType& Message,
+    const std::vector<Symbol*>& Symbols) {
+  if (Message.has_packed_symbolic_expressions() &&
+      !gtirb::fromProtobuf(Message.packed_symbolic_expressions(), Symbols,
+                           SymbolicExpressions))
+    return false;
+
   bool Result = true;
   for (const auto& Pair : Message.symbolic_expressions()) {
     SymbolicExpression SymExpr;
@@ -198,10 +217,15 @@ ByteInterval* ByteInterval::load(Context& C, std::istream& In) {
 bool ByteInterval::loadSymbolicExpressions(Context& C, std::istream& In) {
   MessageType Message;
   Message.ParseFromIstream(&In);
-  return ByteInterval::symbolicExpressionsFromProtobuf(C, Message);
+  return ByteInterval::symbolicExpressionsFromProtobuf(C, Message, {});
 }
 
-void ByteInterval::setAddress(std::optional<Addr> A) {
+bool ByteInterval::isFrozen() const { return Parent && Parent->isFrozen(); }
+
+ChangeStatus ByteInterval::setAddress(std::optional<Addr> A) {
+  assert(!isFrozen() && "cannot move a byte interval of a frozen IR");
+  if (isFrozen())
+    return ChangeStatus::Rejected;
   if (Observer) {
     [[maybe_unused]] ChangeStatus Status = Observer->changeExtent(
         this, [&A](ByteInterval* BI) { BI->Address = A; });
@@ -216,9 +240,13 @@ void ByteInterval::setAddress(std::optional<Addr> A) {
   } else {
     Address = A;
   }
+  return ChangeStatus::Accepted;
 }
 
-void ByteInterval::setSize(uint64_t S) {
+ChangeStatus ByteInterval::setSize(uint64_t S) {
+  assert(!isFrozen() && "cannot resize a byte interval of a frozen IR");
+  if (isFrozen())
+    return ChangeStatus::Rejected;
   if (Observer) {
     [[maybe_unused]] ChangeStatus Status =
         Observer->changeExtent(this, [&S](ByteInterval* BI) { BI->Size = S; });
@@ -230,6 +258,7 @@ void ByteInterval::setSize(uint64_t S) {
   if (S < getInitializedSize()) {
     setInitializedSize(S);
   }
+  return ChangeStatus::Accepted;
 }
 
 static inline ChangeStatus removeBlocks(ByteIntervalObserver* Observer,
@@ -246,6 +275,9 @@ static inline ChangeStatus removeBlocks(ByteIntervalObserver* Observer,
 
 template <typename BlockType, typename IterType>
 ChangeStatus ByteInterval::removeBlock(BlockType* B) {
+  if (isFrozen())
+    return ChangeStatus::Rejected;
+
   auto& Index = Blocks.get<by_pointer>();
   if (auto Iter = Index.find(B); Iter != Index.end()) {
     if (Observer) {
@@ -316,6 +348,9 @@ static inline ChangeStatus moveBlocks(ByteIntervalObserver* Observer,
 
 template <typename BlockType, typename IterType>
 ChangeStatus ByteInterval::addBlock(uint64_t Off, BlockType* B) {
+  if (isFrozen() || (B->getByteInterval() && B->getByteInterval()->isFrozen()))
+    return ChangeStatus::Rejected;
+
   // Determine if we're moving or adding a block.
   bool IsMove = false;
   ByteInterval* BI = B->getByteInterval();
@@ -434,8 +469,83 @@ void ByteInterval::updateBlockSortOrder(Node* N) {
   Blocks.get<by_pointer>().modify(Iter, [](auto&) {});
 }
 
+bool ByteInterval::hasBlockSpanning(uint64_t Off) const {
+  auto Found = blocksOnOffset(Off);
+  return std::any_of(Found.begin(), Found.end(),
+                     [Off](const Block* B) { return B->Offset < Off; });
+}
+
+static uint64_t blockSize(const Node* N) {
+  if (auto* B = dyn_cast<CodeBlock>(N))
+    return B->getSize();
+  return cast<DataBlock>(N)->getSize();
+}
+
+void ByteInterval::freeze() {
+  // Blocks are visited in the same order as the interval map's sets hold
+  // them, so queries yield the same blocks in the same order.
+  FrozenBlockOffsets = std::make_unique<BlockIndex>();
+  FrozenBlockOffsets->invalidate();
+  FrozenBlockOffsets->ensure([this](auto Add) {
+    for (const Block& B : Blocks.get<by_offset>())
+      if (uint64_t BlockSize = blockSize(B.Node))
+        Add(B.Offset, B.Offset + BlockSize, &B);
+  });
+  FrozenBlockOffsets->shrink_to_fit();
+  BlockOffsets.clear();
+  Bytes.shrink_to_fit();
+}
+
+void ByteInterval::thaw() {
+  FrozenBlockOffsets.reset();
+  for (const Block& B : Blocks.get<by_offset>())
+    updateIntervalMap(B.Node, std::nullopt, blockSize(B.Node));
+}
+
+void ByteInterval::transferContents(ByteInterval& Dest, uint64_t From,
+                                    uint64_t DestOff) {
+  assert(&Dest != this && "cannot transfer an interval's contents to itself");
+  assert(!hasBlockSpanning(From) && "cannot transfer part of a block");
+
+  // Blocks are visited in offset order and all shift by the same amount, so
+  // each one lands at the end of the destination's offset index.
+  auto& Index = Blocks.get<by_offset>();
+  auto& DestIndex = Dest.Blocks.get<by_offset>();
+  auto Begin = Index.lower_bound(From, OffsetCmp());
+  for (auto It = Begin; It != Index.end(); ++It) {
+    Node* N = It->getNode();
+    uint64_t BlockSize = 0;
+    if (auto* B = dyn_cast<CodeBlock>(N)) {
+      B->setParent(&Dest, Dest.CBO.get());
+      BlockSize = B->getSize();
+    } else {
+      auto* D = cast<DataBlock>(N);
+      D->setParent(&Dest, Dest.DBO.get());
+      BlockSize = D->getSize();
+    }
+    DestIndex.emplace_hint(DestIndex.end(), It->Offset - From + DestOff, N);
+    Dest.updateIntervalMap(N, std::nullopt, BlockSize);
+  }
+
+  // No block crosses From, so everything in the interval map at or past it
+  // belongs to the blocks just moved.
+  BlockOffsets.erase(BlockIntMap::interval_type::right_open(
+      From, std::numeric_limits<uint64_t>::max()));
+  Index.erase(Begin, Index.end());
+
+  for (auto It = SymbolicExpressions.lower_bound(From);
+       It != SymbolicExpressions.end();) {
+    auto Handle = SymbolicExpressions.extract(It++);
+    Handle.key() = Handle.key() - From + DestOff;
+    Dest.SymbolicExpressions.insert(Dest.SymbolicExpressions.end(),
+                                    std::move(Handle));
+  }
+}
+
 ChangeStatus ByteInterval::sizeChange(Node* N, uint64_t OldSize,
                                       uint64_t NewSize) {
+  if (isFrozen())
+    return ChangeStatus::Rejected;
   updateIntervalMap(N, OldSize, NewSize);
   updateBlockSortOrder(N);
   return ChangeStatus::Accepted;
@@ -443,6 +553,8 @@ ChangeStatus ByteInterval::sizeChange(Node* N, uint64_t OldSize,
 
 ChangeStatus ByteInterval::decodeModeChange(CodeBlock* B, DecodeMode,
                                             DecodeMode) {
+  if (isFrozen())
+    return ChangeStatus::Rejected;
   updateBlockSortOrder(B);
   return ChangeStatus::Accepted;
 }
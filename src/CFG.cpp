@@ -13,8 +13,11 @@
 //
 //===----------------------------------------------------------------------===//
 #include "CFG.hpp"
+#include "CFGSerialization.hpp"
+#include "NodeIndex.hpp"
 #include "Serialization.hpp"
 #include <gtirb/CodeBlock.hpp>
+#include <gtirb/ProxyBlock.hpp>
 #include <gtirb/proto/CFG.pb.h>
 #include <map>
 #include <tuple>
@@ -85,23 +88,50 @@ GTIRB_EXPORT_API std::ostream& operator<<(std::ostream& OS,
 }
 
 std::pair<CFG::vertex_descriptor, bool> addVertex(CfgNode* B, CFG& Cfg) {
-  auto& IdTable = Cfg[boost::graph_bundle];
-  if (auto it = IdTable.find(B); it != IdTable.end()) {
-    return std::make_pair(it->second, false);
+  auto& Index = Cfg[boost::graph_bundle];
+  if (auto It = Index.Vertices.find(B); It != Index.Vertices.end()) {
+    return std::make_pair(It->second.Vertex, false);
   }
 
   auto Vertex = add_vertex(Cfg);
   Cfg[Vertex] = B;
-  IdTable[B] = Vertex;
+  size_t Position;
+  if (auto* CB = dyn_cast<CodeBlock>(B)) {
+    Position = Index.Blocks.size();
+    Index.Blocks.push_back(CB);
+  } else {
+    Position = Index.Proxies.size();
+    Index.Proxies.push_back(cast<ProxyBlock>(B));
+  }
+  Index.Vertices.emplace(B, CFG::graph_property_type::Entry{Vertex, Position});
   return std::make_pair(Vertex, true);
 }
 
+// Remove the node at Position from one of the dense per-kind arrays of a
+// CfgNodeIndex by moving the array's last node into its place.
+template <typename NodeType>
+static void removeFromPartition(CFG::graph_property_type& Index,
+                                std::vector<NodeType*>& Partition,
+                                size_t Position) {
+  if (Position + 1 != Partition.size()) {
+    NodeType* Last = Partition.back();
+    Partition[Position] = Last;
+    Index.Vertices.find(Last)->second.Position = Position;
+  }
+  Partition.pop_back();
+}
+
 bool removeVertex(CfgNode* N, CFG& Cfg) {
-  auto& IdTable = Cfg[boost::graph_bundle];
-  if (auto it = IdTable.find(N); it != IdTable.end()) {
-    clear_vertex(it->second, Cfg);
-    remove_vertex(it->second, Cfg);
-    IdTable.erase(it);
+  auto& Index = Cfg[boost::graph_bundle];
+  if (auto It = Index.Vertices.find(N); It != Index.Vertices.end()) {
+    clear_vertex(It->second.Vertex, Cfg);
+    remove_vertex(It->second.Vertex, Cfg);
+    if (isa<CodeBlock>(N)) {
+      removeFromPartition(Index, Index.Blocks, It->second.Position);
+    } else {
+      removeFromPartition(Index, Index.Proxies, It->second.Position);
+    }
+    Index.Vertices.erase(It);
     return true;
   }
   return false;
@@ -109,20 +139,20 @@ bool removeVertex(CfgNode* N, CFG& Cfg) {
 
 std::optional<CFG::vertex_descriptor> getVertex(const CfgNode* N,
                                                 const CFG& Cfg) {
-  auto& IdTable = Cfg[boost::graph_bundle];
-  if (auto it = IdTable.find(N); it != IdTable.end()) {
-    return it->second;
+  auto& Index = Cfg[boost::graph_bundle];
+  if (auto It = Index.Vertices.find(N); It != Index.Vertices.end()) {
+    return It->second.Vertex;
   }
   return std::nullopt;
 }
 
 std::optional<CFG::edge_descriptor> addEdge(const CfgNode* From,
                                             const CfgNode* To, CFG& Cfg) {
-  const auto& IdTable = Cfg[boost::graph_bundle];
+  const auto& IdTable = Cfg[boost::graph_bundle].Vertices;
   if (auto it = IdTable.find(From); it != IdTable.end()) {
-    auto FromVertex = it->second;
+    auto FromVertex = it->second.Vertex;
     if (it = IdTable.find(To); it != IdTable.end()) {
-      auto ToVertex = it->second;
+      auto ToVertex = it->second.Vertex;
       return add_edge(FromVertex, ToVertex, Cfg).first;
     }
   }
@@ -130,11 +160,11 @@ std::optional<CFG::edge_descriptor> addEdge(const CfgNode* From,
 }
 
 bool removeEdge(const CfgNode* From, const CfgNode* To, CFG& Cfg) {
-  const auto& IdTable = Cfg[boost::graph_bundle];
+  const auto& IdTable = Cfg[boost::graph_bundle].Vertices;
   if (auto it = IdTable.find(From); it != IdTable.end()) {
-    auto FromVertex = it->second;
+    auto FromVertex = it->second.Vertex;
     if (it = IdTable.find(To); it != IdTable.end()) {
-      auto ToVertex = it->second;
+      auto ToVertex = it->second.Vertex;
       remove_edge(FromVertex, ToVertex, Cfg);
       return true;
     }
@@ -145,10 +175,10 @@ bool removeEdge(const CfgNode* From, const CfgNode* To, CFG& Cfg) {
 bool removeEdge(const CfgNode* From, const CfgNode* To, const EdgeLabel Label,
                 CFG& Cfg) {
   bool remove_called = true, deleted = false;
-  const auto& IdTable = Cfg[boost::graph_bundle];
+  const auto& IdTable = Cfg[boost::graph_bundle].Vertices;
   boost::graph_traits<CFG>::out_edge_iterator ei, edge_end;
   if (auto it = IdTable.find(From); it != IdTable.end()) {
-    auto FromVertex = it->second;
+    auto FromVertex = it->second.Vertex;
     if (it = IdTable.find(To); it != IdTable.end()) {
       while (remove_called) {
         remove_called = false;
@@ -184,16 +214,27 @@ boost::iterator_range<cfg_iterator> nodes(CFG& Cfg) {
 }
 
 boost::iterator_range<const_block_iterator> blocks(const CFG& Cfg) {
-  auto Vs = vertices(Cfg);
-  return boost::make_iterator_range(
-      const_block_iterator(Cfg, Vs.first, Vs.second),
-      const_block_iterator(Cfg, Vs.second, Vs.second));
+  const auto& Blocks = Cfg[boost::graph_bundle].Blocks;
+  return boost::make_iterator_range(const_block_iterator(Blocks.begin()),
+                                    const_block_iterator(Blocks.end()));
 }
 
 boost::iterator_range<block_iterator> blocks(CFG& Cfg) {
-  auto Vs = vertices(Cfg);
-  return boost::make_iterator_range(block_iterator(Cfg, Vs.first, Vs.second),
-                                    block_iterator(Cfg, Vs.second, Vs.second));
+  const auto& Blocks = Cfg[boost::graph_bundle].Blocks;
+  return boost::make_iterator_range(block_iterator(Blocks.begin()),
+                                    block_iterator(Blocks.end()));
+}
+
+boost::iterator_range<const_proxy_iterator> proxies(const CFG& Cfg) {
+  const auto& Proxies = Cfg[boost::graph_bundle].Proxies;
+  return boost::make_iterator_range(const_proxy_iterator(Proxies.begin()),
+                                    const_proxy_iterator(Proxies.end()));
+}
+
+boost::iterator_range<proxy_iterator> proxies(CFG& Cfg) {
+  const auto& Proxies = Cfg[boost::graph_bundle].Proxies;
+  return boost::make_iterator_range(proxy_iterator(Proxies.begin()),
+                                    proxy_iterator(Proxies.end()));
 }
 
 proto::CFG toProtobuf(const CFG& Cfg) {
@@ -220,7 +261,16 @@ proto::CFG toProtobuf(const CFG& Cfg) {
   return Message;
 }
 
-bool fromProtobuf(Context& C, CFG& Result, const proto::CFG& Message) {
+static void labelFromProtobuf(CFG& Cfg, CFG::edge_descriptor E,
+                              const proto::EdgeLabel& L) {
+  Cfg[E] = std::make_tuple(
+      L.conditional() ? ConditionalEdge::OnTrue : ConditionalEdge::OnFalse,
+      L.direct() ? DirectEdge::IsDirect : DirectEdge::IsIndirect,
+      static_cast<EdgeType>(L.type()));
+}
+
+bool fromProtobuf(Context& C, CFG& Result, const proto::CFG& Message,
+                  NodeIndexTable* Nodes) {
   // Because we're deserializing, we have to assume the data is attacker-
   // controlled and may be malicious. We cannot use cast<> because an attacker
   // could specify the UUID to a node of the incorrect type. Instead, we use
@@ -245,16 +295,37 @@ bool fromProtobuf(Context& C, CFG& Result, const proto::CFG& Message) {
       return false;
     CfgNode* Target = dyn_cast_or_null<CfgNode>(Node::getByUUID(C, Id));
     if (Source && Target) {
-      if (auto E = addEdge(Source, Target, Result); E && M.has_label()) {
-        auto& L = M.label();
-        Result[*E] = std::make_tuple(L.conditional() ? ConditionalEdge::OnTrue
-                                                     : ConditionalEdge::OnFalse,
-                                     L.direct() ? DirectEdge::IsDirect
-                                                : DirectEdge::IsIndirect,
-                                     static_cast<EdgeType>(L.type()));
-      }
+      if (auto E = addEdge(Source, Target, Result); E && M.has_label())
+        labelFromProtobuf(Result, *E, M.label());
     }
   }
+
+  // Indexed vertices are looked up in the node table once each, and the
+  // edges between them by index alone.
+  int Count = Message.edge_sources_size();
+  if (Message.vertex_indexes().empty() && Count == 0)
+    return true;
+  if (!Nodes || Message.edge_targets_size() != Count ||
+      Message.edge_labels_size() != Count)
+    return false;
+  std::vector<std::optional<CFG::vertex_descriptor>> Vertices(Nodes->size());
+  for (uint32_t Index : Message.vertex_indexes()) {
+    auto* N = dyn_cast_or_null<CfgNode>(Nodes->get(Index));
+    if (!N)
+      return false;
+    Vertices[Index] = addVertex(N, Result).first;
+  }
+  for (int I = 0; I < Count; ++I) {
+    uint32_t Source = Message.edge_sources(I);
+    uint32_t Target = Message.edge_targets(I);
+    if (Source >= Vertices.size() || Target >= Vertices.size())
+      return false;
+    if (!Vertices[Source] || !Vertices[Target])
+      continue;
+    auto E = add_edge(*Vertices[Source], *Vertices[Target], Result).first;
+    if (proto::EdgeLabel L; unpackEdgeLabel(Message.edge_labels(I), L))
+      labelFromProtobuf(Result, E, L);
+  }
   return true;
 }
 
@@ -20,6 +20,7 @@
 
 namespace gtirb {
 class Context;
+class NodeIndexTable;
 namespace proto {
 class CFG;
 }
@@ -40,9 +41,12 @@ proto::CFG toProtobuf(const CFG& Cfg);
 /// \param      C        The Context in which the deserialized CFG will be held.
 /// \param      Message  The protobuf message from which to deserialize.
 /// \param[out] Result   The CFG to initialize.
+/// \param      Nodes    The table of nodes to which the vertex and edge
+///                      indexes of the message refer, if any.
 ///
 /// \return true if the \ref CFG could be deserialized, false otherwise.
-bool fromProtobuf(Context& C, CFG& Result, const proto::CFG& Message);
+bool fromProtobuf(Context& C, CFG& Result, const proto::CFG& Message,
+                  NodeIndexTable* Nodes = nullptr);
 /// @endcond
 
 } // namespace gtirb
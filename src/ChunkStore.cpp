@@ -0,0 +1,95 @@
+//===- ChunkStore.cpp -------------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#include "Sha1.hpp"
+#include <gtirb/ChunkStore.hpp>
+#include <boost/uuid/random_generator.hpp>
+#include <boost/uuid/uuid_io.hpp>
+#include <filesystem>
+#include <fstream>
+
+using namespace gtirb;
+
+namespace fs = std::filesystem;
+
+static constexpr size_t DigestSize = 20;
+
+// Chunks are spread over subdirectories named by the first byte of their
+// digest, so that no one directory grows too large.
+std::string ChunkStore::pathOf(const std::string& Digest) const {
+  std::string Name = Sha1::toHex(Digest);
+  return (fs::path(Directory) / Name.substr(0, 2) / Name.substr(2)).string();
+}
+
+bool ChunkStore::put(std::string_view Bytes, std::string& Digest) const {
+  Sha1 Hash;
+  Hash.update(Bytes.data(), Bytes.size());
+  Digest = Hash.digest();
+  fs::path Path = pathOf(Digest);
+
+  // A chunk already present is only trusted if it still hashes to its name;
+  // otherwise it is replaced below.
+  std::error_code EC;
+  if (fs::file_size(Path, EC) == Bytes.size() && !EC) {
+    std::string Existing;
+    if (get(Digest, Existing))
+      return true;
+  }
+
+  fs::create_directories(Path.parent_path(), EC);
+  if (EC)
+    return false;
+  fs::path Temp = Path;
+  Temp += ".tmp-" + to_string(boost::uuids::random_generator()());
+  {
+    std::ofstream Out(Temp, std::ios::binary);
+    Out.write(Bytes.data(), static_cast<std::streamsize>(Bytes.size()));
+    if (!Out.flush()) {
+      Out.close();
+      fs::remove(Temp, EC);
+      return false;
+    }
+  }
+  fs::rename(Temp, Path, EC);
+  if (EC) {
+    fs::remove(Temp, EC);
+    return false;
+  }
+  return true;
+}
+
+bool ChunkStore::get(const std::string& Digest, std::string& Bytes) const {
+  if (Digest.size() != DigestSize)
+    return false;
+  std::string Path = pathOf(Digest);
+
+  std::error_code EC;
+  uintmax_t Size = fs::file_size(Path, EC);
+  if (EC)
+    return false;
+
+  // The chunk is read straight into Bytes, which is the only copy made.
+  Bytes.resize(static_cast<size_t>(Size));
+  if (Size != 0) {
+    std::ifstream In(Path, std::ios::binary);
+    if (!In.read(Bytes.data(), static_cast<std::streamsize>(Size)) ||
+        In.gcount() != static_cast<std::streamsize>(Size))
+      return false;
+  }
+
+  // A chunk damaged or replaced on disk no longer matches its name.
+  Sha1 Hash;
+  Hash.update(Bytes.data(), Bytes.size());
+  return Hash.digest() == Digest;
+}
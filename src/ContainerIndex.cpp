@@ -0,0 +1,298 @@
+//===- ContainerIndex.cpp ---------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#include "ContainerIndex.hpp"
+#include <gtirb/AuxData.hpp>
+#include <gtirb/IR.hpp>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include <google/protobuf/message_lite.h>
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <climits>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <tuple>
+#ifdef GTIRB_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+using namespace gtirb;
+
+static constexpr const char* GTIRB_MAGIC_CHARS = "GTIRB";
+
+// The table of contents is encoded with the AuxData serialization.
+using ContentsType =
+    std::vector<std::tuple<uint8_t, UUID, UUID, std::string, uint64_t,
+                           uint64_t, std::vector<UUID>>>;
+
+static void writeUInt64(std::ostream& Out, uint64_t Value) {
+  std::string Bytes;
+  ToByteRange TBR(Bytes);
+  auxdata_traits<uint64_t>::toBytes(Value, TBR);
+  Out.write(Bytes.data(), Bytes.size());
+}
+
+static bool readUInt64(std::istream& In, uint64_t& Value) {
+  std::string Bytes(sizeof(uint64_t), '\0');
+  if (!In.read(Bytes.data(), Bytes.size()))
+    return false;
+  FromByteRange FBR(Bytes);
+  return auxdata_traits<uint64_t>::fromBytes(Value, FBR);
+}
+
+void gtirb::writeContainerHeader(std::ostream& Out, uint8_t Format) {
+  // Magic signature
+  // Bytes 0-4 contain the ASCII characters: GTIRB.
+  // Byte 5 contains the container format.
+  // Byte 6 is considered reserved for future use and should be 0.
+  // Byte 7 contains the GTIRB protobuf spec version in use.
+  Out << GTIRB_MAGIC_CHARS << Format << static_cast<uint8_t>(0)
+      << static_cast<uint8_t>(GTIRB_PROTOBUF_VERSION);
+}
+
+ErrorOr<uint8_t> gtirb::readContainerHeader(std::istream& In,
+                                            bool ExpectDelta) {
+  constexpr size_t magic_len =
+      std::string::traits_type::length(GTIRB_MAGIC_CHARS);
+  std::array<char, magic_len> magic;
+  In.read(magic.data(), magic_len);
+  if (memcmp(magic.data(), GTIRB_MAGIC_CHARS, magic_len) != 0) {
+    return {IR::load_error::NotGTIRB, "GTIRB magic signature not found"};
+  }
+
+  uint8_t format = 0;
+  In >> format;
+
+  uint8_t res1 = 0;
+  In >> res1;
+
+  uint8_t protobuf_version = 0;
+  In >> protobuf_version;
+  if (protobuf_version != GTIRB_PROTOBUF_VERSION) {
+    std::stringstream ss;
+    ss << "GTIRB protobuf version mismatch. Expected: "
+       << GTIRB_PROTOBUF_VERSION << " Saw: " << protobuf_version;
+    return {IR::load_error::IncorrectVersion, ss.str()};
+  }
+
+  if (ExpectDelta != (format == DeltaContainerFormat)) {
+    return {IR::load_error::CorruptFile,
+            ExpectDelta ? "File does not hold an IR delta"
+                        : "File holds an IR delta rather than an IR"};
+  }
+  if (format != MonolithicContainerFormat &&
+      format != IndexedContainerFormat &&
+      format != CompressedContainerFormat && format != DeltaContainerFormat) {
+    return {IR::load_error::CorruptFile,
+            "Unknown container format " + std::to_string(format)};
+  }
+  if (format == CompressedContainerFormat && !isCompressionAvailable()) {
+    return {IR::load_error::CorruptFile,
+            "GTIRB was built without support for compressed files"};
+  }
+  return format;
+}
+
+bool gtirb::isCompressionAvailable() {
+#ifdef GTIRB_HAVE_ZLIB
+  return true;
+#else
+  return false;
+#endif
+}
+
+std::string gtirb::encodePayload(const google::protobuf::MessageLite& Message,
+                                 bool Compressed) {
+  std::string Bytes = Message.SerializeAsString();
+  if (!Compressed)
+    return Bytes;
+#ifdef GTIRB_HAVE_ZLIB
+  std::string Payload;
+  ToByteRange TBR(Payload);
+  auxdata_traits<uint64_t>::toBytes(Bytes.size(), TBR);
+  size_t HeaderSize = Payload.size();
+  uLongf Size = compressBound(Bytes.size());
+  Payload.resize(HeaderSize + Size);
+  [[maybe_unused]] int Status =
+      compress2(reinterpret_cast<Bytef*>(Payload.data() + HeaderSize), &Size,
+                reinterpret_cast<const Bytef*>(Bytes.data()), Bytes.size(),
+                Z_DEFAULT_COMPRESSION);
+  assert(Status == Z_OK && "failed to compress a frame");
+  Payload.resize(HeaderSize + Size);
+  return Payload;
+#else
+  assert(false && "GTIRB was built without zlib");
+  return Bytes;
+#endif
+}
+
+bool gtirb::decodePayload(std::string& Payload, bool Compressed) {
+  if (!Compressed)
+    return true;
+#ifdef GTIRB_HAVE_ZLIB
+  uint64_t Size;
+  FromByteRange FBR(Payload);
+  if (!auxdata_traits<uint64_t>::fromBytes(Size, FBR))
+    return false;
+  const size_t HeaderSize = sizeof(uint64_t);
+  const size_t CompressedSize = Payload.size() - HeaderSize;
+  // Deflate cannot expand its input more than 1032 times, so a larger size
+  // is corrupt and must not be allocated.
+  if (Size / 1032 > CompressedSize)
+    return false;
+  std::string Bytes(static_cast<size_t>(Size), '\0');
+  uLongf Length = static_cast<uLongf>(Size);
+  if (uncompress(reinterpret_cast<Bytef*>(Bytes.data()), &Length,
+                 reinterpret_cast<const Bytef*>(Payload.data() + HeaderSize),
+                 CompressedSize) != Z_OK ||
+      Length != Size)
+    return false;
+  Payload.swap(Bytes);
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool gtirb::parseMessage(const std::string& Bytes,
+                         google::protobuf::MessageLite& Message) {
+  google::protobuf::io::ArrayInputStream Input(Bytes.data(),
+                                               static_cast<int>(Bytes.size()));
+  google::protobuf::io::CodedInputStream CodedStream(&Input);
+#ifdef PROTOBUF_SET_BYTES_LIMIT
+  CodedStream.SetTotalBytesLimit(INT_MAX, INT_MAX);
+#endif
+  return Message.ParseFromCodedStream(&CodedStream);
+}
+
+void ContainerIndexWriter::writeFrameHeader(ContainerFrameKind Kind,
+                                            uint64_t Size) {
+  Out.put(static_cast<char>(Kind));
+  writeUInt64(Out, Size);
+  Position += 1 + sizeof(uint64_t) + Size;
+}
+
+void ContainerIndexWriter::writeFrame(
+    ContainerFrameKind Kind, const UUID& Id, const UUID& Parent,
+    const std::string& Name, const google::protobuf::MessageLite& Message,
+    std::vector<UUID> Nodes) {
+  if (Compressed) {
+    writeEncodedFrame(Kind, Id, Parent, Name, encodePayload(Message, true),
+                      std::move(Nodes));
+    return;
+  }
+  uint64_t Offset = Position;
+  uint64_t Size = Message.ByteSizeLong();
+  writeFrameHeader(Kind, Size);
+  Message.SerializeToOstream(&Out);
+  Entries.push_back({Kind, Id, Parent, Name, Offset, Size, std::move(Nodes)});
+}
+
+void ContainerIndexWriter::writeEncodedFrame(ContainerFrameKind Kind,
+                                             const UUID& Id, const UUID& Parent,
+                                             const std::string& Name,
+                                             const std::string& Payload,
+                                             std::vector<UUID> Nodes) {
+  uint64_t Offset = Position;
+  writeFrameHeader(Kind, Payload.size());
+  Out.write(Payload.data(), Payload.size());
+  Entries.push_back(
+      {Kind, Id, Parent, Name, Offset, Payload.size(), std::move(Nodes)});
+}
+
+void ContainerIndexWriter::finish() {
+  ContentsType Contents;
+  Contents.reserve(Entries.size());
+  for (const ContainerIndexEntry& E : Entries)
+    Contents.emplace_back(static_cast<uint8_t>(E.Kind), E.Id, E.Parent, E.Name,
+                          E.Offset, E.Size, E.Nodes);
+  std::string Bytes;
+  ToByteRange TBR(Bytes);
+  auxdata_traits<ContentsType>::toBytes(Contents, TBR);
+
+  uint64_t Offset = Position;
+  writeFrameHeader(ContainerFrameKind::Contents, Bytes.size());
+  Out.write(Bytes.data(), Bytes.size());
+  writeUInt64(Out, Offset);
+}
+
+std::optional<ContainerIndexReader>
+ContainerIndexReader::open(std::istream& In, std::streamoff Start,
+                           uint8_t Format) {
+  if (Start < 0 || !In.seekg(-static_cast<std::streamoff>(sizeof(uint64_t)),
+                             std::ios_base::end))
+    return std::nullopt;
+  uint64_t Offset;
+  if (!readUInt64(In, Offset) || !In.seekg(Start + Offset))
+    return std::nullopt;
+
+  ContainerFrameKind Kind;
+  std::string Bytes;
+  if (!readNextFrame(In, Kind, Bytes) || Kind != ContainerFrameKind::Contents)
+    return std::nullopt;
+  ContentsType Contents;
+  FromByteRange FBR(Bytes);
+  if (!auxdata_traits<ContentsType>::fromBytes(Contents, FBR))
+    return std::nullopt;
+
+  ContainerIndexReader Reader(In, Start, Format == CompressedContainerFormat);
+  Reader.Entries.reserve(Contents.size());
+  for (auto& [K, Id, Parent, Name, EntryOffset, Size, Nodes] : Contents) {
+    if (K >= static_cast<uint8_t>(ContainerFrameKind::Contents))
+      return std::nullopt;
+    Reader.Entries.push_back({static_cast<ContainerFrameKind>(K), Id, Parent,
+                              std::move(Name), EntryOffset, Size,
+                              std::move(Nodes)});
+  }
+  return Reader;
+}
+
+bool ContainerIndexReader::readNextFrame(std::istream& In,
+                                         ContainerFrameKind& Kind,
+                                         std::string& Payload) {
+  char K;
+  uint64_t Size;
+  if (!In.get(K) || !readUInt64(In, Size) ||
+      static_cast<uint8_t>(K) >
+          static_cast<uint8_t>(ContainerFrameKind::Contents))
+    return false;
+  Kind = static_cast<ContainerFrameKind>(K);
+  // Read in bounded pieces so that a corrupt size cannot force a huge
+  // allocation up front.
+  Payload.clear();
+  constexpr uint64_t Piece = uint64_t(1) << 20;
+  while (Payload.size() < Size) {
+    size_t Old = Payload.size();
+    size_t Count = static_cast<size_t>(std::min(Piece, Size - Old));
+    Payload.resize(Old + Count);
+    if (!In.read(Payload.data() + Old, Count))
+      return false;
+  }
+  return true;
+}
+
+bool ContainerIndexReader::readFrame(
+    const ContainerIndexEntry& Entry,
+    google::protobuf::MessageLite& Message) const {
+  ContainerFrameKind Kind;
+  std::string Payload;
+  return In->seekg(Start + static_cast<std::streamoff>(Entry.Offset)) &&
+         readNextFrame(*In, Kind, Payload) && Kind == Entry.Kind &&
+         Payload.size() == Entry.Size && decodePayload(Payload, Compressed) &&
+         parseMessage(Payload, Message);
+}
@@ -0,0 +1,176 @@
+//===- ContainerIndex.hpp ---------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#ifndef GTIRB_CONTAINER_INDEX_HPP
+#define GTIRB_CONTAINER_INDEX_HPP
+
+#include <gtirb/Context.hpp>
+#include <gtirb/ErrorOr.hpp>
+#include <cstdint>
+#include <iosfwd>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace google {
+namespace protobuf {
+class MessageLite;
+} // namespace protobuf
+} // namespace google
+
+namespace gtirb {
+
+/// @cond INTERNAL
+// The indexed container format.
+//
+// After the 8-byte header written by IR::save, whose byte 5 is
+// IndexedContainerFormat, an indexed file is a series of frames. Each frame
+// is a kind byte, the size of its payload as a little-endian uint64_t, and
+// the payload. In order, the frames are:
+//
+//  - the IR message, without its modules;
+//  - for each module, the Module message without its sections, followed by
+//    one frame for each of its sections;
+//  - the table of contents, listing the frames above with their UUIDs,
+//    names and offsets, and for each section the UUIDs of the byte intervals
+//    and blocks it holds.
+//
+// The file ends with the offset of the table of contents as a little-endian
+// uint64_t, so that a reader can seek to it and from it to any module or
+// section. Offsets are relative to the start of the header.
+//
+// A compressed container has the same layout, except that the payload of each
+// frame but the table of contents is the size of the message as a
+// little-endian uint64_t followed by the message compressed with zlib. Frames
+// are compressed independently so that they can be decompressed in parallel.
+//
+// A delta container, written by IRDelta::save, holds an IRDelta message
+// rather than an IR.
+constexpr uint8_t MonolithicContainerFormat = 0;
+constexpr uint8_t IndexedContainerFormat = 1;
+constexpr uint8_t CompressedContainerFormat = 2;
+constexpr uint8_t DeltaContainerFormat = 3;
+constexpr uint64_t ContainerHeaderSize = 8;
+
+// Writes the header: the magic signature, the container format, a reserved
+// byte and the protobuf spec version.
+void writeContainerHeader(std::ostream& Out, uint8_t Format);
+
+// Reads and checks the header, returning the container format. A delta
+// container is accepted if and only if ExpectDelta is true.
+ErrorOr<uint8_t> readContainerHeader(std::istream& In,
+                                     bool ExpectDelta = false);
+
+// Whether the library was built with zlib, which compressed containers need.
+bool isCompressionAvailable();
+
+// Serializes a message into the payload of a frame.
+std::string encodePayload(const google::protobuf::MessageLite& Message,
+                          bool Compressed);
+
+// Replaces the payload of a frame with the message it holds, serialized.
+// Returns false if the payload is corrupt.
+bool decodePayload(std::string& Payload, bool Compressed);
+
+enum class ContainerFrameKind : uint8_t { IR, Module, Section, Contents };
+
+struct ContainerIndexEntry {
+  ContainerFrameKind Kind;
+  // The UUID of the IR, module or section, and that of its parent IR or
+  // module.
+  UUID Id;
+  UUID Parent;
+  std::string Name;
+  // The offset of the frame and the size of its payload.
+  uint64_t Offset;
+  uint64_t Size;
+  // For a section, the UUIDs of its byte intervals and their blocks, so that
+  // a reader can find the frame holding a node without reading every frame.
+  std::vector<UUID> Nodes;
+};
+
+// Writes the frames of an indexed container to a stream positioned after the
+// header, recording them for the table of contents. Offsets are counted as
+// the frames are written rather than queried from the stream, so the output
+// need not be seekable.
+class ContainerIndexWriter {
+public:
+  ContainerIndexWriter(std::ostream& Out_, uint64_t HeaderSize,
+                       bool Compressed_)
+      : Out(Out_), Position(HeaderSize), Compressed(Compressed_) {}
+
+  bool isCompressed() const { return Compressed; }
+
+  void writeFrame(ContainerFrameKind Kind, const UUID& Id, const UUID& Parent,
+                  const std::string& Name,
+                  const google::protobuf::MessageLite& Message,
+                  std::vector<UUID> Nodes = {});
+
+  // Writes a frame whose payload was made by encodePayload.
+  void writeEncodedFrame(ContainerFrameKind Kind, const UUID& Id,
+                         const UUID& Parent, const std::string& Name,
+                         const std::string& Payload,
+                         std::vector<UUID> Nodes = {});
+
+  // Writes the table of contents and the trailing offset.
+  void finish();
+
+private:
+  void writeFrameHeader(ContainerFrameKind Kind, uint64_t Size);
+
+  std::ostream& Out;
+  uint64_t Position;
+  bool Compressed;
+  std::vector<ContainerIndexEntry> Entries;
+};
+
+// Reads the frames of an indexed container.
+class ContainerIndexReader {
+public:
+  // Reads the table of contents of the container in the given format whose
+  // header is at Start. Returns std::nullopt if the stream cannot seek or the
+  // table is corrupt.
+  static std::optional<ContainerIndexReader>
+  open(std::istream& In, std::streamoff Start, uint8_t Format);
+
+  // Reads the next frame from a stream positioned at the start of a frame.
+  // Returns false at the end of the stream or if the frame is corrupt.
+  static bool readNextFrame(std::istream& In, ContainerFrameKind& Kind,
+                            std::string& Payload);
+
+  // Parses the payload of an entry's frame into Message.
+  bool readFrame(const ContainerIndexEntry& Entry,
+                 google::protobuf::MessageLite& Message) const;
+
+  const std::vector<ContainerIndexEntry>& entries() const { return Entries; }
+
+private:
+  ContainerIndexReader(std::istream& In_, std::streamoff Start_,
+                       bool Compressed_)
+      : In(&In_), Start(Start_), Compressed(Compressed_) {}
+
+  std::istream* In;
+  std::streamoff Start;
+  bool Compressed;
+  std::vector<ContainerIndexEntry> Entries;
+};
+
+// Parses a serialized message of any size.
+bool parseMessage(const std::string& Bytes,
+                  google::protobuf::MessageLite& Message);
+/// @endcond
+
+} // namespace gtirb
+
+#endif // GTIRB_CONTAINER_INDEX_HPP
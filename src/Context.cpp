@@ -22,6 +22,8 @@
 #include <gtirb/ProxyBlock.hpp>
 #include <gtirb/Section.hpp>
 #include <gtirb/Symbol.hpp>
+#include <algorithm>
+#include <thread>
 
 using namespace gtirb;
 
@@ -45,14 +47,21 @@ void Context::ForgetAllocations() {
   SymbolAllocator.ForgetAllocations();
 }
 
+unsigned Context::getThreadCount() const {
+  return ThreadCount != 0 ? ThreadCount
+                          : std::max(1u, std::thread::hardware_concurrency());
+}
+
 const Node* Context::findNode(const UUID& ID) const {
-  auto Iter = UuidMap.find(ID);
-  return Iter != UuidMap.end() ? Iter->second : nullptr;
+  if (auto Iter = UuidMap.find(ID); Iter != UuidMap.end())
+    return Iter->second;
+  return MissingNodeHandler ? MissingNodeHandler(ID) : nullptr;
 }
 
 Node* Context::findNode(const UUID& ID) {
-  auto Iter = UuidMap.find(ID);
-  return Iter != UuidMap.end() ? Iter->second : nullptr;
+  if (auto Iter = UuidMap.find(ID); Iter != UuidMap.end())
+    return Iter->second;
+  return MissingNodeHandler ? MissingNodeHandler(ID) : nullptr;
 }
 
 template <> void* Context::Allocate<Node>() const {
@@ -0,0 +1,343 @@
+//===- Diff.cpp -------------------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#include "Parallel.hpp"
+#include <gtirb/ByteInterval.hpp>
+#include <gtirb/CodeBlock.hpp>
+#include <gtirb/DataBlock.hpp>
+#include <gtirb/Diff.hpp>
+#include <gtirb/IR.hpp>
+#include <gtirb/Module.hpp>
+#include <gtirb/ProxyBlock.hpp>
+#include <gtirb/Section.hpp>
+#include <gtirb/Symbol.hpp>
+#include <gtirb/SymbolicExpression.hpp>
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <tuple>
+#include <vector>
+
+using namespace gtirb;
+
+using Kind = IRChange::Kind;
+using Element = IRChange::Element;
+using ChangeList = std::vector<IRChange>;
+
+static void report(ChangeList& Changes, Kind K, Element E, const UUID& Id,
+                   std::string Name = std::string()) {
+  IRChange Change{K, E, Id, UUID(), 0, std::move(Name)};
+  Changes.push_back(std::move(Change));
+}
+
+// Reports a property of a node that differs between the IRs.
+template <typename T>
+static void compare(ChangeList& Changes, Element E, const UUID& Id,
+                    const char* Property, const T& Before, const T& After) {
+  if (!(Before == After))
+    report(Changes, Kind::Changed, E, Id, Property);
+}
+
+template <typename NodeT> static std::optional<UUID> uuidOf(const NodeT* N) {
+  if (!N)
+    return std::nullopt;
+  return N->getUUID();
+}
+
+// Matches the nodes of two ranges by UUID. Nodes only in one range are
+// reported as added or removed, and Matched is called on each pair of nodes
+// with the same UUID. Nodes are visited in UUID order, since some ranges,
+// such as the symbols of a module, are ordered by address in memory.
+template <typename RangeT, typename Fn>
+static void matchNodes(ChangeList& Changes, Element E, const RangeT& Before,
+                       const RangeT& After, Fn Matched) {
+  using NodeT = std::remove_reference_t<decltype(*Before.begin())>;
+  auto SortedNodes = [](const RangeT& Range) {
+    std::vector<NodeT*> Nodes;
+    for (NodeT& N : Range)
+      Nodes.push_back(&N);
+    std::sort(Nodes.begin(), Nodes.end(), [](const NodeT* A, const NodeT* B) {
+      return A->getUUID() < B->getUUID();
+    });
+    return Nodes;
+  };
+  std::vector<NodeT*> BeforeNodes = SortedNodes(Before);
+  std::vector<NodeT*> AfterNodes = SortedNodes(After);
+
+  auto I = BeforeNodes.begin(), J = AfterNodes.begin();
+  while (I != BeforeNodes.end() || J != AfterNodes.end()) {
+    if (J == AfterNodes.end() ||
+        (I != BeforeNodes.end() && (*I)->getUUID() < (*J)->getUUID())) {
+      report(Changes, Kind::Removed, E, (*I++)->getUUID());
+    } else if (I == BeforeNodes.end() || (*J)->getUUID() < (*I)->getUUID()) {
+      report(Changes, Kind::Added, E, (*J++)->getUUID());
+    } else {
+      Matched(**I++, **J++);
+    }
+  }
+}
+
+static bool sameSymbol(const Symbol* A, const Symbol* B) {
+  return uuidOf(A) == uuidOf(B);
+}
+
+// Symbolic expressions refer to symbols, which are compared by UUID.
+static bool sameExpression(const SymbolicExpression& A,
+                           const SymbolicExpression& B) {
+  if (A.index() != B.index())
+    return false;
+  if (const auto* X = std::get_if<SymAddrConst>(&A)) {
+    const auto& Y = std::get<SymAddrConst>(B);
+    return X->Offset == Y.Offset && sameSymbol(X->Sym, Y.Sym) &&
+           X->Attributes == Y.Attributes;
+  }
+  const auto& X = std::get<SymAddrAddr>(A);
+  const auto& Y = std::get<SymAddrAddr>(B);
+  return X.Scale == Y.Scale && X.Offset == Y.Offset &&
+         sameSymbol(X.Sym1, Y.Sym1) && sameSymbol(X.Sym2, Y.Sym2) &&
+         X.Attributes == Y.Attributes;
+}
+
+static void diffAuxData(ChangeList& Changes, const AuxDataContainer& Before,
+                        const AuxDataContainer& After, unsigned NumThreads) {
+  std::vector<AuxData::SerializedForm> BeforeScratch, AfterScratch;
+  auto BeforeForms = Before.encodeAuxData(BeforeScratch, NumThreads);
+  auto AfterForms = After.encodeAuxData(AfterScratch, NumThreads);
+
+  // Both containers list their tables in key order.
+  auto BeforeIt = Before.aux_data_begin();
+  auto AfterIt = After.aux_data_begin();
+  size_t I = 0, J = 0;
+  while (I < BeforeForms.size() || J < AfterForms.size()) {
+    int Order = I == BeforeForms.size()  ? 1
+                : J == AfterForms.size() ? -1
+                                         : BeforeIt->Key.compare(AfterIt->Key);
+    if (Order < 0) {
+      report(Changes, Kind::Removed, Element::AuxData, Before.getUUID(),
+             BeforeIt->Key);
+      ++BeforeIt, ++I;
+    } else if (Order > 0) {
+      report(Changes, Kind::Added, Element::AuxData, Before.getUUID(),
+             AfterIt->Key);
+      ++AfterIt, ++J;
+    } else {
+      if (BeforeForms[I]->ProtobufType != AfterForms[J]->ProtobufType ||
+          BeforeForms[I]->RawBytes != AfterForms[J]->RawBytes)
+        report(Changes, Kind::Changed, Element::AuxData, Before.getUUID(),
+               BeforeIt->Key);
+      ++BeforeIt, ++I;
+      ++AfterIt, ++J;
+    }
+  }
+}
+
+static void diffByteInterval(ChangeList& Changes, const ByteInterval& Before,
+                             const ByteInterval& After) {
+  const UUID& Id = Before.getUUID();
+  compare(Changes, Element::ByteInterval, Id, "address", Before.getAddress(),
+          After.getAddress());
+  compare(Changes, Element::ByteInterval, Id, "size", Before.getSize(),
+          After.getSize());
+  uint64_t Initialized = Before.getInitializedSize();
+  if (Initialized != After.getInitializedSize() ||
+      (Initialized != 0 &&
+       std::memcmp(Before.rawBytes<uint8_t>(), After.rawBytes<uint8_t>(),
+                   Initialized) != 0))
+    report(Changes, Kind::Changed, Element::ByteInterval, Id, "bytes");
+
+  matchNodes(Changes, Element::CodeBlock, Before.code_blocks(),
+             After.code_blocks(), [&](const CodeBlock& A, const CodeBlock& B) {
+               const UUID& BlockId = A.getUUID();
+               compare(Changes, Element::CodeBlock, BlockId, "offset",
+                       A.getOffset(), B.getOffset());
+               compare(Changes, Element::CodeBlock, BlockId, "size",
+                       A.getSize(), B.getSize());
+               compare(Changes, Element::CodeBlock, BlockId, "decode mode",
+                       A.getDecodeMode(), B.getDecodeMode());
+             });
+  matchNodes(Changes, Element::DataBlock, Before.data_blocks(),
+             After.data_blocks(), [&](const DataBlock& A, const DataBlock& B) {
+               const UUID& BlockId = A.getUUID();
+               compare(Changes, Element::DataBlock, BlockId, "offset",
+                       A.getOffset(), B.getOffset());
+               compare(Changes, Element::DataBlock, BlockId, "size",
+                       A.getSize(), B.getSize());
+             });
+
+  // Symbolic expressions are listed in offset order.
+  auto BeforeSEs = Before.symbolic_expressions();
+  auto AfterSEs = After.symbolic_expressions();
+  auto I = BeforeSEs.begin(), J = AfterSEs.begin();
+  auto ReportSE = [&](Kind K, uint64_t Offset) {
+    IRChange Change{K, Element::SymbolicExpr, Id, UUID(), Offset, ""};
+    Changes.push_back(std::move(Change));
+  };
+  while (I != BeforeSEs.end() || J != AfterSEs.end()) {
+    if (J == AfterSEs.end() ||
+        (I != BeforeSEs.end() && I->getOffset() < J->getOffset())) {
+      ReportSE(Kind::Removed, I->getOffset());
+      ++I;
+    } else if (I == BeforeSEs.end() || J->getOffset() < I->getOffset()) {
+      ReportSE(Kind::Added, J->getOffset());
+      ++J;
+    } else {
+      if (!sameExpression(I->getSymbolicExpression(),
+                          J->getSymbolicExpression()))
+        ReportSE(Kind::Changed, I->getOffset());
+      ++I;
+      ++J;
+    }
+  }
+}
+
+static void diffSection(ChangeList& Changes, const Section& Before,
+                        const Section& After) {
+  const UUID& Id = Before.getUUID();
+  compare(Changes, Element::Section, Id, "name", Before.getName(),
+          After.getName());
+  if (!std::equal(Before.flags().begin(), Before.flags().end(),
+                  After.flags().begin(), After.flags().end()))
+    report(Changes, Kind::Changed, Element::Section, Id, "flags");
+  matchNodes(Changes, Element::ByteInterval, Before.byte_intervals(),
+             After.byte_intervals(),
+             [&](const ByteInterval& A, const ByteInterval& B) {
+               diffByteInterval(Changes, A, B);
+             });
+}
+
+// Compares the properties of two modules, their symbols, proxy blocks and
+// AuxData, and which sections they hold. Matched sections are added to
+// Sections to be compared separately. Modules are compared in parallel, so
+// their AuxData is encoded on the calling thread.
+static void
+diffModule(ChangeList& Changes, const Module& Before, const Module& After,
+           std::vector<std::pair<const Section*, const Section*>>& Sections) {
+  const UUID& Id = Before.getUUID();
+  compare(Changes, Element::Module, Id, "name", Before.getName(),
+          After.getName());
+  compare(Changes, Element::Module, Id, "binary path", Before.getBinaryPath(),
+          After.getBinaryPath());
+  compare(Changes, Element::Module, Id, "preferred address",
+          Before.getPreferredAddr(), After.getPreferredAddr());
+  compare(Changes, Element::Module, Id, "rebase delta",
+          Before.getRebaseDelta(), After.getRebaseDelta());
+  compare(Changes, Element::Module, Id, "file format", Before.getFileFormat(),
+          After.getFileFormat());
+  compare(Changes, Element::Module, Id, "ISA", Before.getISA(),
+          After.getISA());
+  compare(Changes, Element::Module, Id, "byte order", Before.getByteOrder(),
+          After.getByteOrder());
+  compare(Changes, Element::Module, Id, "entry point",
+          uuidOf(Before.getEntryPoint()), uuidOf(After.getEntryPoint()));
+
+  matchNodes(Changes, Element::Symbol, Before.symbols(), After.symbols(),
+             [&](const Symbol& A, const Symbol& B) {
+               const UUID& SymbolId = A.getUUID();
+               compare(Changes, Element::Symbol, SymbolId, "name",
+                       A.getName(), B.getName());
+               compare(Changes, Element::Symbol, SymbolId, "at end",
+                       A.getAtEnd(), B.getAtEnd());
+               if (A.hasReferent() || B.hasReferent())
+                 compare(Changes, Element::Symbol, SymbolId, "referent",
+                         uuidOf(A.getReferent<Node>()),
+                         uuidOf(B.getReferent<Node>()));
+               else
+                 compare(Changes, Element::Symbol, SymbolId, "value",
+                         A.getAddress(), B.getAddress());
+             });
+  matchNodes(Changes, Element::ProxyBlock, Before.proxy_blocks(),
+             After.proxy_blocks(), [](const ProxyBlock&, const ProxyBlock&) {});
+  diffAuxData(Changes, Before, After, 1);
+  matchNodes(Changes, Element::Section, Before.sections(), After.sections(),
+             [&](const Section& A, const Section& B) {
+               Sections.emplace_back(&A, &B);
+             });
+}
+
+// CFG edges are compared as multisets of their ends and labels.
+static void diffCFG(ChangeList& Changes, const CFG& Before, const CFG& After) {
+  using EdgeKey = std::tuple<UUID, UUID, EdgeLabel>;
+  auto Keys = [](const CFG& Cfg) {
+    std::vector<EdgeKey> Result;
+    for (const auto& E : boost::make_iterator_range(edges(Cfg)))
+      Result.emplace_back(Cfg[source(E, Cfg)]->getUUID(),
+                          Cfg[target(E, Cfg)]->getUUID(), Cfg[E]);
+    std::sort(Result.begin(), Result.end());
+    return Result;
+  };
+  std::vector<EdgeKey> BeforeKeys = Keys(Before), AfterKeys = Keys(After);
+
+  auto ReportEdge = [&Changes](Kind K, const EdgeKey& Key) {
+    IRChange Change{K, Element::CfgEdge, std::get<0>(Key), std::get<1>(Key),
+                    0, ""};
+    Changes.push_back(std::move(Change));
+  };
+  auto I = BeforeKeys.begin(), J = AfterKeys.begin();
+  while (I != BeforeKeys.end() || J != AfterKeys.end()) {
+    if (J == AfterKeys.end() || (I != BeforeKeys.end() && *I < *J))
+      ReportEdge(Kind::Removed, *I++);
+    else if (I == BeforeKeys.end() || *J < *I)
+      ReportEdge(Kind::Added, *J++);
+    else
+      ++I, ++J;
+  }
+}
+
+std::vector<IRChange> gtirb::diff(const IR& Before, const IR& After) {
+  Before.loadPendingSections();
+  After.loadPendingSections();
+  ChangeList Changes;
+  const UUID& Id = Before.getUUID();
+  compare(Changes, Element::IR, Id, "UUID", Before.getUUID(),
+          After.getUUID());
+  compare(Changes, Element::IR, Id, "version", Before.getVersion(),
+          After.getVersion());
+  unsigned Threads = Before.getContext().getThreadCount();
+  diffAuxData(Changes, Before, After, Threads);
+
+  std::vector<std::pair<const Module*, const Module*>> Modules;
+  matchNodes(Changes, Element::Module, Before.modules(), After.modules(),
+             [&](const Module& A, const Module& B) {
+               Modules.emplace_back(&A, &B);
+             });
+
+  // The modules are compared in parallel, then all of their sections, and
+  // each task's changes are appended in order.
+  std::vector<ChangeList> ModuleChanges(Modules.size());
+  std::vector<std::vector<std::pair<const Section*, const Section*>>>
+      ModuleSections(Modules.size());
+  parallelForEach(Modules.size(), Threads, [&](size_t I) {
+    diffModule(ModuleChanges[I], *Modules[I].first, *Modules[I].second,
+               ModuleSections[I]);
+  });
+
+  std::vector<std::pair<const Section*, const Section*>> Sections;
+  for (const auto& S : ModuleSections)
+    Sections.insert(Sections.end(), S.begin(), S.end());
+  std::vector<ChangeList> SectionChanges(Sections.size());
+  parallelForEach(Sections.size(), Threads, [&](size_t I) {
+    diffSection(SectionChanges[I], *Sections[I].first, *Sections[I].second);
+  });
+
+  size_t NextSection = 0;
+  for (size_t I = 0; I < Modules.size(); ++I) {
+    Changes.insert(Changes.end(), ModuleChanges[I].begin(),
+                   ModuleChanges[I].end());
+    for (size_t J = 0; J < ModuleSections[I].size(); ++J, ++NextSection)
+      Changes.insert(Changes.end(), SectionChanges[NextSection].begin(),
+                     SectionChanges[NextSection].end());
+  }
+  diffCFG(Changes, Before.getCFG(), After.getCFG());
+  return Changes;
+}
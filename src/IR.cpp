@@ -12,25 +12,39 @@
 //  endorsement should be inferred.
 //
 //===----------------------------------------------------------------------===//
+#include "AddressResolution.hpp"
 #include "CFGSerialization.hpp"
+#include "ContainerIndex.hpp"
+#include "JsonStream.hpp"
+#include "LazySections.hpp"
+#include "NodeIndex.hpp"
+#include "Parallel.hpp"
 #include "Serialization.hpp"
+#include "Sha1.hpp"
+#include "SymbolicExpressionSerialization.hpp"
+#include <gtirb/CodeBlock.hpp>
 #include <gtirb/DataBlock.hpp>
 #include <gtirb/IR.hpp>
 #include <gtirb/Module.hpp>
+#include <gtirb/ProxyBlock.hpp>
 #include <gtirb/Section.hpp>
 #include <gtirb/Symbol.hpp>
 #include <gtirb/SymbolicExpression.hpp>
 #include <gtirb/proto/IR.pb.h>
 #include <google/protobuf/io/coded_stream.h>
 #include <google/protobuf/io/zero_copy_stream_impl.h>
-#include <google/protobuf/util/json_util.h>
+#include <algorithm>
+#include <functional>
 #include <iostream>
 #include <memory>
+#include <optional>
+#include <sstream>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
 
 using namespace gtirb;
 
-static constexpr const char* GTIRB_MAGIC_CHARS = "GTIRB";
-
 class IR::ModuleObserverImpl : public ModuleObserver {
 public:
   explicit ModuleObserverImpl(IR* I_) : I(I_) {}
@@ -140,6 +154,8 @@ public:
       return "Could not locate UUID";
     case IR::load_error::NotGTIRB:
       return "File does not contain GTIRB";
+    case IR::load_error::FrozenIR:
+      return "Cannot load into a frozen IR";
     }
     assert(false && "Expected to handle all error codes");
     return "";
@@ -151,10 +167,12 @@ const std::error_category& gtirb::loadErrorCategory() {
   return Cat;
 }
 
-void IR::toProtobuf(MessageType* Message) const {
+void IR::toProtobuf(MessageType* Message, bool WithModules) const {
+  loadPendingSections();
   nodeUUIDToBytes(this, *Message->mutable_uuid());
   *Message->mutable_cfg() = gtirb::toProtobuf(this->Cfg);
-  containerToProtobuf(this->Modules, Message->mutable_modules());
+  if (WithModules)
+    containerToProtobuf(this->Modules, Message->mutable_modules());
   AuxDataContainer::toProtobuf(Message);
   Message->set_version(Version);
 }
@@ -165,9 +183,10 @@ ErrorOr<IR*> IR::fromProtobuf(Context& C, const MessageType& Message) {
     return {load_error::CorruptFile, "Cannot load IR"};
 
   auto* I = IR::Create(C, Id);
+  NodeIndexTable Nodes(C, Message.node_uuids());
   int i = 0;
   for (const auto& Elt : Message.modules()) {
-    auto M = Module::fromProtobuf(C, Elt);
+    auto M = Module::fromProtobuf(C, Elt, &Nodes);
     if (!M) {
       ErrorInfo Err{load_error::CorruptModule, "#" + std::to_string(i)};
       Err.Msg += "\n" + M.getError().message();
@@ -176,7 +195,13 @@ ErrorOr<IR*> IR::fromProtobuf(Context& C, const MessageType& Message) {
     I->addModule(*M);
     ++i;
   }
-  if (!gtirb::fromProtobuf(C, I->Cfg, Message.cfg()))
+  return finishFromProtobuf(C, I, Message, Nodes);
+}
+
+ErrorOr<IR*> IR::finishFromProtobuf(Context& C, IR* I,
+                                    const MessageType& Message,
+                                    NodeIndexTable& Nodes) {
+  if (!gtirb::fromProtobuf(C, I->Cfg, Message.cfg(), &Nodes))
     return load_error::CorruptCFG;
   static_cast<AuxDataContainer*>(I)->fromProtobuf(Message);
   I->Version = Message.version();
@@ -189,76 +214,765 @@ ErrorOr<IR*> IR::fromProtobuf(Context& C, const MessageType& Message) {
   return I;
 }
 
+void IR::resolveAddresses(const Addr* Addrs, size_t Count,
+                          const CodeBlock** Out, unsigned NumThreads) const {
+  loadPendingSections();
+  if (FrozenCodeBlocks) {
+    resolveCodeBlockAddresses(*FrozenCodeBlocks, Addrs, Count, Out,
+                              NumThreads);
+    return;
+  }
+  std::vector<CodeBlockExtent> Extents;
+  appendCodeBlockExtents(code_blocks(), Extents);
+  resolveCodeBlockAddresses(Extents, Addrs, Count, Out, NumThreads);
+}
+
+AuxDataCollectionStats IR::collectAuxDataGarbage(
+    const std::unordered_map<UUID, UUID, boost::hash<UUID>>& Remap) {
+  // References to sections that have not been read yet are not dangling.
+  loadPendingSections();
+  std::unordered_set<UUID, boost::hash<UUID>> Live;
+  Live.insert(getUUID());
+  for (const Module& M : modules()) {
+    Live.insert(M.getUUID());
+    for (const Section& S : M.sections())
+      Live.insert(S.getUUID());
+    for (const ByteInterval& BI : M.byte_intervals()) {
+      Live.insert(BI.getUUID());
+      for (const Node& B : BI.blocks())
+        Live.insert(B.getUUID());
+    }
+    for (const Symbol& Sym : M.symbols())
+      Live.insert(Sym.getUUID());
+    for (const ProxyBlock& P : M.proxy_blocks())
+      Live.insert(P.getUUID());
+  }
+
+  std::vector<AuxData*> Tables;
+  auto AddTables = [&Tables](AuxDataContainer& C) {
+    for (auto& Entry : C.AuxDatas)
+      Tables.push_back(Entry.second.get());
+  };
+  AddTables(*this);
+  for (Module& M : modules())
+    AddTables(M);
+
+  // Tables are independent of each other, so each is scanned and rewritten
+  // on its own thread with its own statistics, which are summed afterwards.
+  AuxDataReferenceResolver Resolver{Live, Remap};
+  std::vector<AuxDataCollectionStats> PerTable(Tables.size());
+  parallelForEach(Tables.size(), getContext().getThreadCount(), [&](size_t I) {
+    Tables[I]->collectGarbage(Resolver, PerTable[I]);
+  });
+
+  AuxDataCollectionStats Stats;
+  for (const AuxDataCollectionStats& TableStats : PerTable)
+    Stats += TableStats;
+  return Stats;
+}
+
+void IR::freeze() {
+  if (Frozen)
+    return;
+  // Sections cannot be added to a frozen IR, so they are all read first.
+  loadPendingSections();
+
+  for (Module& M : modules())
+    M.freeze();
+  if (Modules.size() == 1) {
+    FrozenCodeBlocks = (*Modules.begin())->FrozenCodeBlocks;
+  } else {
+    auto Extents = std::make_shared<std::vector<CodeBlockExtent>>();
+    appendCodeBlockExtents(code_blocks(), *Extents);
+    Extents->shrink_to_fit();
+    FrozenCodeBlocks = std::move(Extents);
+  }
+  Frozen = true;
+}
+
+void IR::thaw() {
+  if (!Frozen)
+    return;
+
+  Frozen = false;
+  FrozenCodeBlocks.reset();
+  for (Module& M : modules())
+    M.thaw();
+}
+
 void IR::save(std::ostream& Out) const {
-  // Magic signature
-  // Magic signature
-  // Bytes 0-4 contain the ASCII characters: GTIRB.
-  // Bytes 5-6 are considered reserved for future use and should be 0.
-  // Byte 7 contains the GTIRB protobuf spec version in use.
-  Out << GTIRB_MAGIC_CHARS << static_cast<uint8_t>(0) << static_cast<uint8_t>(0)
-      << static_cast<uint8_t>(GTIRB_PROTOBUF_VERSION);
-
-  // Protobuf
+  save(Out, ContainerFormat::Monolithic);
+}
+
+void IR::save(std::ostream& Out, ContainerFormat Format) const {
+  saveContainer(Out, Format, nullptr);
+}
+
+bool IR::isCompressionAvailable() { return gtirb::isCompressionAvailable(); }
+
+void IR::save(std::ostream& Out, ContainerFormat Format,
+              const ChunkStore& Store) const {
+  saveContainer(Out, Format, &Store);
+}
+
+// Moves the contents of the byte intervals of a section into a chunk store,
+// leaving their digests in their place. Contents that cannot be stored are
+// left in the message.
+static void storeContents(proto::Section& Message, const ChunkStore& Store) {
+  for (proto::ByteInterval& BI : *Message.mutable_byte_intervals()) {
+    if (BI.contents().empty())
+      continue;
+    if (Store.put(BI.contents(), *BI.mutable_contents_digest()))
+      BI.clear_contents();
+    else
+      BI.clear_contents_digest();
+  }
+}
+
+// Reads the contents of the byte intervals of a section that were saved in
+// a chunk store back into the message.
+static bool loadContents(proto::Section& Message, const ChunkStore& Store) {
+  for (proto::ByteInterval& BI : *Message.mutable_byte_intervals()) {
+    if (BI.contents_digest().empty())
+      continue;
+    if (!Store.get(BI.contents_digest(), *BI.mutable_contents()))
+      return false;
+    BI.clear_contents_digest();
+  }
+  return true;
+}
+
+// Indexes the symbols of a module message by their UUID bytes, for packing
+// the symbolic expressions of its sections.
+static std::unordered_map<std::string, uint32_t>
+symbolIndexes(const proto::Module& Message) {
+  std::unordered_map<std::string, uint32_t> Indexes;
+  for (int I = 0; I < Message.symbols_size(); ++I)
+    Indexes.emplace(Message.symbols(I).uuid(), I);
+  return Indexes;
+}
+
+void IR::saveContainer(std::ostream& Out, ContainerFormat Format,
+                       const ChunkStore* Store) const {
+  // Other readers of monolithic files would find their byte intervals empty
+  // if the contents were in a store.
+  if (Format == ContainerFormat::Monolithic && Store) {
+    Out.setstate(std::ios::failbit);
+    return;
+  }
+  if (Format == ContainerFormat::Monolithic) {
+    writeContainerHeader(Out, MonolithicContainerFormat);
+    MessageType Message;
+    this->toProtobuf(&Message);
+    Message.SerializeToOstream(&Out);
+    return;
+  }
+
+  // The table of contents maps the nodes of each section to its frame.
+  auto SectionNodes = [](const Section& S) {
+    std::vector<UUID> Nodes;
+    for (const ByteInterval& BI : S.byte_intervals()) {
+      Nodes.push_back(BI.getUUID());
+      for (const Node& B : BI.blocks())
+        Nodes.push_back(B.getUUID());
+    }
+    return Nodes;
+  };
+  auto SectionMessage = [Store](const Section& S, const auto& Indexes) {
+    proto::Section Message = gtirb::toProtobuf(S);
+    for (proto::ByteInterval& BI : *Message.mutable_byte_intervals())
+      packSymbolicExpressions(BI, Indexes);
+    if (Store)
+      storeContents(Message, *Store);
+    return Message;
+  };
+
+  bool Compressed = Format == ContainerFormat::Compressed;
+  if (Compressed && !isCompressionAvailable()) {
+    Out.setstate(std::ios::failbit);
+    return;
+  }
+  writeContainerHeader(Out, Compressed ? CompressedContainerFormat
+                                       : IndexedContainerFormat);
+  ContainerIndexWriter Writer(Out, ContainerHeaderSize, Compressed);
+
+  // The IR frame holds everything but the modules, and the table of the nodes
+  // to which the CFG and the modules refer by index.
   MessageType Message;
-  this->toProtobuf(&Message);
-  Message.SerializeToOstream(&Out);
+  this->toProtobuf(&Message, false);
+  std::vector<proto::Module> ModuleMessages(Modules.size());
+  NodeIndexer Indexer(*Message.mutable_node_uuids());
+  Indexer.indexReferences(*Message.mutable_cfg());
+  auto ModuleMessageIt = ModuleMessages.begin();
+  for (const Module& M : modules()) {
+    M.toProtobuf(&*ModuleMessageIt, false);
+    Indexer.indexReferences(*ModuleMessageIt++);
+  }
+  Writer.writeFrame(ContainerFrameKind::IR, getUUID(), UUID(), "", Message);
+
+  ModuleMessageIt = ModuleMessages.begin();
+  for (const Module& M : modules()) {
+    const proto::Module& ModuleMessage = *ModuleMessageIt++;
+    Writer.writeFrame(ContainerFrameKind::Module, M.getUUID(), getUUID(),
+                      M.getName(), ModuleMessage);
+    const auto Indexes = symbolIndexes(ModuleMessage);
+
+    // Each section gets a frame of its own after that of its module, and is
+    // serialized only when it is written.
+    if (!Compressed) {
+      for (const Section& S : M.sections())
+        Writer.writeFrame(ContainerFrameKind::Section, S.getUUID(),
+                          M.getUUID(), S.getName(),
+                          SectionMessage(S, Indexes), SectionNodes(S));
+      continue;
+    }
+
+    // The sections of a module are compressed in parallel.
+    std::vector<const Section*> Sections;
+    for (const Section& S : M.sections())
+      Sections.push_back(&S);
+    std::vector<std::string> Payloads(Sections.size());
+    parallelForEach(Sections.size(), getContext().getThreadCount(),
+                    [&](size_t I) {
+                      Payloads[I] = encodePayload(
+                          SectionMessage(*Sections[I], Indexes), true);
+                    });
+    for (size_t I = 0; I < Sections.size(); ++I)
+      Writer.writeEncodedFrame(ContainerFrameKind::Section,
+                               Sections[I]->getUUID(), M.getUUID(),
+                               Sections[I]->getName(), Payloads[I],
+                               SectionNodes(*Sections[I]));
+  }
+  Writer.finish();
 }
 
-ErrorOr<IR*> IR::load(Context& C, std::istream& In) {
-  constexpr size_t magic_len =
-      std::string::traits_type::length(GTIRB_MAGIC_CHARS);
-  std::array<char, magic_len> magic;
-  In.read(magic.data(), magic_len);
-  if (memcmp(magic.data(), GTIRB_MAGIC_CHARS, magic_len) != 0) {
-    return {load_error::NotGTIRB, "GTIRB magic signature not found"};
+std::string IR::saveCanonical(std::ostream& Out) const {
+  return writeCanonical(&Out);
+}
+
+std::string IR::contentHash() const { return writeCanonical(nullptr); }
+
+static const std::string& blockUUID(const proto::Block& B) {
+  return B.has_code() ? B.code().uuid() : B.data().uuid();
+}
+
+// Sorts the repeated fields of an IR message whose order has no meaning, so
+// that equal IRs give equal messages. Nodes are sorted by UUID, since nodes
+// that the containers of an IR order alike may be listed in any order.
+static void canonicalizeMessage(proto::IR& Message) {
+  auto SortByUUID = [](auto& Field) {
+    std::sort(Field.pointer_begin(), Field.pointer_end(),
+              [](const auto* A, const auto* B) {
+                return A->uuid() < B->uuid();
+              });
+  };
+  SortByUUID(*Message.mutable_modules());
+  for (proto::Module& M : *Message.mutable_modules()) {
+    SortByUUID(*M.mutable_proxies());
+    SortByUUID(*M.mutable_symbols());
+    SortByUUID(*M.mutable_sections());
+    for (proto::Section& S : *M.mutable_sections()) {
+      SortByUUID(*S.mutable_byte_intervals());
+      for (proto::ByteInterval& BI : *S.mutable_byte_intervals())
+        std::sort(BI.mutable_blocks()->pointer_begin(),
+                  BI.mutable_blocks()->pointer_end(),
+                  [](const proto::Block* A, const proto::Block* B) {
+                    return blockUUID(*A) < blockUUID(*B);
+                  });
+    }
   }
 
-  uint8_t res0;
-  In >> res0;
+  proto::CFG& Cfg = *Message.mutable_cfg();
+  std::sort(Cfg.mutable_vertices()->begin(), Cfg.mutable_vertices()->end());
+  std::sort(Cfg.mutable_edges()->pointer_begin(),
+            Cfg.mutable_edges()->pointer_end(),
+            [](const proto::Edge* A, const proto::Edge* B) {
+              if (A->source_uuid() != B->source_uuid())
+                return A->source_uuid() < B->source_uuid();
+              if (A->target_uuid() != B->target_uuid())
+                return A->target_uuid() < B->target_uuid();
+              auto Label = [](const proto::Edge* E) {
+                return std::make_tuple(E->has_label(), E->label().conditional(),
+                                       E->label().direct(), E->label().type());
+              };
+              return Label(A) < Label(B);
+            });
+}
 
-  uint8_t res1;
-  In >> res1;
+namespace {
+// Writes serialized bytes to a stream, if there is one, while hashing them.
+class HashingOutputStream : public google::protobuf::io::CopyingOutputStream {
+public:
+  HashingOutputStream(std::ostream* O, Sha1& H) : Out(O), Hash(H) {}
 
-  uint8_t protobuf_version;
-  In >> protobuf_version;
-  if (protobuf_version != GTIRB_PROTOBUF_VERSION) {
-    std::stringstream ss;
-    ss << "GTIRB protobuf version mismatch. Expected: "
-       << GTIRB_PROTOBUF_VERSION << " Saw: " << protobuf_version;
-    return {load_error::IncorrectVersion, ss.str()};
+  bool Write(const void* Buffer, int Size) override {
+    Hash.update(Buffer, static_cast<size_t>(Size));
+    return !Out || Out->write(static_cast<const char*>(Buffer), Size);
   }
 
+private:
+  std::ostream* Out;
+  Sha1& Hash;
+};
+} // namespace
+
+std::string IR::writeCanonical(std::ostream* Out) const {
+  MessageType Message;
+  this->toProtobuf(&Message);
+  // Write AuxData tables again with the entries of hashed containers sorted.
+  // The module messages are still in the order of modules() here.
+  AuxDataContainer::toProtobuf(&Message, true);
+  auto ModuleMessage = Message.mutable_modules()->begin();
+  for (const Module& M : modules())
+    M.AuxDataContainer::toProtobuf(&*ModuleMessage++, true);
+  canonicalizeMessage(Message);
+
+  std::ostringstream Header;
+  writeContainerHeader(Header, MonolithicContainerFormat);
+  Sha1 Hash;
+  HashingOutputStream Stream(Out, Hash);
+  {
+    google::protobuf::io::CopyingOutputStreamAdaptor Adaptor(&Stream);
+    google::protobuf::io::CodedOutputStream CodedStream(&Adaptor);
+    CodedStream.SetSerializationDeterministic(true);
+    CodedStream.WriteString(Header.str());
+    Message.SerializeToCodedStream(&CodedStream);
+  }
+  return Sha1::toHex(Hash.digest());
+}
+
+static bool readMonolithicContainer(std::istream& In, proto::IR& Message) {
   google::protobuf::io::IstreamInputStream InputStream(&In);
   google::protobuf::io::CodedInputStream CodedStream(&InputStream);
 #ifdef PROTOBUF_SET_BYTES_LIMIT
   CodedStream.SetTotalBytesLimit(INT_MAX, INT_MAX);
 #endif
+  return Message.ParseFromCodedStream(&CodedStream);
+}
+
+// Reads the frames of an indexed container in order, so that the stream need
+// not be seekable. Module and section frames are read in batches of bounded
+// size, so that only a batch of payloads is held at once, and each batch is
+// decoded and parsed in parallel. Each module is handed to AddModule with its
+// sections as soon as the frame of the next module is parsed, so that only
+// one module's messages are held at once beyond the batch.
+bool IR::readIndexedContainer(
+    std::istream& In, bool Compressed, unsigned NumThreads,
+    MessageType& Message,
+    const std::function<bool(proto::Module&)>& AddModule) {
+  struct PendingFrame {
+    ContainerFrameKind Kind;
+    std::string Payload;
+    proto::Module ModuleMessage;
+    proto::Section SectionMessage;
+  };
+  constexpr size_t BatchBytes = size_t(64) << 20;
+  std::vector<PendingFrame> Batch;
+  size_t PendingBytes = 0;
+  proto::Module CurrentModule;
+  bool HaveModule = false;
+
+  auto Flush = [&]() {
+    std::vector<char> Parsed(Batch.size());
+    parallelForEach(Batch.size(), NumThreads, [&](size_t I) {
+      PendingFrame& F = Batch[I];
+      google::protobuf::MessageLite& Target =
+          F.Kind == ContainerFrameKind::Module
+              ? static_cast<google::protobuf::MessageLite&>(F.ModuleMessage)
+              : F.SectionMessage;
+      Parsed[I] = decodePayload(F.Payload, Compressed) &&
+                  parseMessage(F.Payload, Target);
+      std::string().swap(F.Payload);
+    });
+    // Sections belong to the module read most recently before them.
+    for (size_t I = 0; I < Batch.size(); ++I) {
+      if (!Parsed[I])
+        return false;
+      if (Batch[I].Kind == ContainerFrameKind::Module) {
+        if (HaveModule && !AddModule(CurrentModule))
+          return false;
+        CurrentModule.Clear();
+        CurrentModule.Swap(&Batch[I].ModuleMessage);
+        HaveModule = true;
+      } else {
+        if (!HaveModule)
+          return false;
+        CurrentModule.add_sections()->Swap(&Batch[I].SectionMessage);
+      }
+      Batch[I] = PendingFrame();
+    }
+    Batch.clear();
+    PendingBytes = 0;
+    return true;
+  };
+
+  bool HaveIR = false;
+  ContainerFrameKind Kind;
+  std::string Payload;
+  while (ContainerIndexReader::readNextFrame(In, Kind, Payload)) {
+    switch (Kind) {
+    case ContainerFrameKind::IR:
+      // The IR frame comes first; parsing it resets the message.
+      if (HaveIR || !decodePayload(Payload, Compressed) ||
+          !parseMessage(Payload, Message))
+        return false;
+      HaveIR = true;
+      break;
+    case ContainerFrameKind::Module:
+    case ContainerFrameKind::Section:
+      if (!HaveIR)
+        return false;
+      PendingBytes += Payload.size();
+      Batch.push_back({Kind, std::move(Payload), {}, {}});
+      Payload = std::string();
+      if (PendingBytes >= BatchBytes && !Flush())
+        return false;
+      break;
+    case ContainerFrameKind::Contents:
+      return HaveIR && Flush() && (!HaveModule || AddModule(CurrentModule));
+    }
+  }
+  return false;
+}
 
+// Keeps the elements of a repeated field for which Keep returns true.
+template <typename FieldT, typename Pred>
+static void keepIf(FieldT& Field, Pred Keep) {
+  int Kept = 0;
+  for (int I = 0; I < Field.size(); ++I)
+    if (Keep(Field.Get(I)))
+      Field.SwapElements(I, Kept++);
+  Field.DeleteSubrange(Kept, Field.size() - Kept);
+}
+
+// Drops the modules of an IR message that are not wanted, and their sections
+// if they are not to be loaded. The CFG is pruned to the remaining blocks, as
+// a CFG message may only name vertices that exist.
+static void pruneIRMessage(proto::IR& Message,
+                           const std::unordered_set<std::string>& Wanted,
+                           bool LoadSections) {
+  keepIf(*Message.mutable_modules(), [&](const proto::Module& M) {
+    return Wanted.count(M.name()) != 0;
+  });
+
+  std::unordered_set<std::string> Vertices;
+  for (proto::Module& M : *Message.mutable_modules()) {
+    if (!LoadSections) {
+      M.clear_sections();
+      M.clear_entry_point();
+    }
+    for (const proto::ProxyBlock& PB : M.proxies())
+      Vertices.insert(PB.uuid());
+    for (const proto::Section& S : M.sections())
+      for (const proto::ByteInterval& BI : S.byte_intervals())
+        for (const proto::Block& B : BI.blocks())
+          if (B.has_code())
+            Vertices.insert(B.code().uuid());
+  }
+
+  proto::CFG& Cfg = *Message.mutable_cfg();
+  keepIf(*Cfg.mutable_vertices(),
+         [&](const std::string& V) { return Vertices.count(V) != 0; });
+  keepIf(*Cfg.mutable_edges(), [&](const proto::Edge& E) {
+    return Vertices.count(E.source_uuid()) && Vertices.count(E.target_uuid());
+  });
+}
+
+ErrorOr<IR*> IR::load(Context& C, std::istream& In) {
+  return loadContainer(C, In, nullptr);
+}
+
+ErrorOr<IR*> IR::load(Context& C, std::istream& In, const ChunkStore& Store) {
+  return loadContainer(C, In, &Store);
+}
+
+static ErrorInfo missingContentsError(const ChunkStore& Store) {
+  return {IR::load_error::CorruptFile,
+          "Byte interval contents missing from chunk store " +
+              Store.getDirectory()};
+}
+
+ErrorOr<IR*> IR::loadContainer(Context& C, std::istream& In,
+                               const ChunkStore* Store) {
+  ErrorOr<uint8_t> Format = readContainerHeader(In);
+  if (!Format)
+    return Format.getError();
+  if (*Format == MonolithicContainerFormat) {
+    MessageType Message;
+    if (!readMonolithicContainer(In, Message))
+      return {load_error::CorruptFile, "Protobuf unable to be parsed"};
+    if (Store)
+      for (proto::Module& M : *Message.mutable_modules())
+        for (proto::Section& S : *M.mutable_sections())
+          if (!loadContents(S, *Store))
+            return missingContentsError(*Store);
+    return IR::fromProtobuf(C, Message);
+  }
+
+  // Each module is built as soon as its frames are read, and its messages
+  // dropped, so that the messages of the whole IR are never held at once.
+  // The IR frame is read first, and holds the table of the nodes to which
+  // the modules and the CFG refer by index.
   MessageType Message;
-  if (!Message.ParseFromCodedStream(&CodedStream)) {
+  IR* I = nullptr;
+  std::optional<NodeIndexTable> Nodes;
+  ErrorInfo Err;
+  int ModuleCount = 0;
+  auto CreateIR = [&]() {
+    UUID Id;
+    if (!I && uuidFromBytes(Message.uuid(), Id)) {
+      I = IR::Create(C, Id);
+      Nodes.emplace(C, Message.node_uuids());
+    }
+    return I != nullptr;
+  };
+  auto AddModule = [&](proto::Module& ModuleMessage) {
+    if (!CreateIR()) {
+      Err = {load_error::CorruptFile, "Cannot load IR"};
+      return false;
+    }
+    if (Store)
+      for (proto::Section& S : *ModuleMessage.mutable_sections())
+        if (!loadContents(S, *Store)) {
+          Err = missingContentsError(*Store);
+          return false;
+        }
+    auto M = Module::fromProtobuf(C, ModuleMessage, &*Nodes);
+    if (!M) {
+      Err = {load_error::CorruptModule, "#" + std::to_string(ModuleCount)};
+      Err.Msg += "\n" + M.getError().message();
+      return false;
+    }
+    I->addModule(*M);
+    ++ModuleCount;
+    ModuleMessage.Clear();
+    return true;
+  };
+  if (!readIndexedContainer(In, *Format == CompressedContainerFormat,
+                            C.getThreadCount(), Message, AddModule)) {
+    if (Err.ErrorCode)
+      return Err;
+    return {load_error::CorruptFile, "Container frames unable to be parsed"};
+  }
+  if (!CreateIR())
+    return {load_error::CorruptFile, "Cannot load IR"};
+  return finishFromProtobuf(C, I, Message, *Nodes);
+}
+
+ErrorInfo IR::readContainer(std::istream& In, const ChunkStore* Store,
+                            unsigned NumThreads, MessageType& Message) {
+  ErrorOr<uint8_t> Format = readContainerHeader(In);
+  if (!Format)
+    return Format.getError();
+
+  if (*Format != MonolithicContainerFormat) {
+    auto AddModule = [&Message](proto::Module& ModuleMessage) {
+      Message.add_modules()->Swap(&ModuleMessage);
+      return true;
+    };
+    if (!readIndexedContainer(In, *Format == CompressedContainerFormat,
+                              NumThreads, Message, AddModule))
+      return {load_error::CorruptFile, "Container frames unable to be parsed"};
+  } else if (!readMonolithicContainer(In, Message)) {
     return {load_error::CorruptFile, "Protobuf unable to be parsed"};
   }
 
+  if (Store)
+    for (proto::Module& M : *Message.mutable_modules())
+      for (proto::Section& S : *M.mutable_sections())
+        if (!loadContents(S, *Store))
+          return missingContentsError(*Store);
+  return ErrorInfo();
+}
+
+ErrorOr<IR*> IR::loadModules(Context& C, std::istream& In,
+                             const std::vector<std::string>& Names,
+                             bool LoadSections) {
+  std::streamoff Start = In.tellg();
+  ErrorOr<uint8_t> Format = readContainerHeader(In);
+  if (!Format)
+    return Format.getError();
+
+  std::unordered_set<std::string> Wanted(Names.begin(), Names.end());
+  MessageType Message;
+  if (*Format == MonolithicContainerFormat) {
+    if (!readMonolithicContainer(In, Message))
+      return {load_error::CorruptFile, "Protobuf unable to be parsed"};
+  } else {
+    std::optional<ContainerIndexReader> Reader =
+        ContainerIndexReader::open(In, Start, *Format);
+    if (!Reader)
+      return {load_error::CorruptFile,
+              "Container table of contents unable to be read"};
+
+    // Sections follow the frame of their module, so a section is wanted if
+    // the last module read is its parent.
+    UUID LastModule;
+    bool HaveModule = false;
+    for (const ContainerIndexEntry& E : Reader->entries()) {
+      bool Read = true;
+      switch (E.Kind) {
+      case ContainerFrameKind::IR:
+        Read = Reader->readFrame(E, Message);
+        break;
+      case ContainerFrameKind::Module:
+        HaveModule = Wanted.count(E.Name) != 0;
+        if (HaveModule) {
+          Read = Reader->readFrame(E, *Message.add_modules());
+          LastModule = E.Id;
+        }
+        break;
+      case ContainerFrameKind::Section:
+        if (LoadSections && HaveModule && E.Parent == LastModule)
+          Read = Reader->readFrame(
+              E, *Message.mutable_modules(Message.modules_size() - 1)
+                      ->add_sections());
+        break;
+      case ContainerFrameKind::Contents:
+        break;
+      }
+      if (!Read)
+        return {load_error::CorruptFile, "Container frame unable to be read"};
+    }
+  }
+
+  // References to nodes that are not loaded must be dropped by UUID.
+  if (!unindexReferences(Message))
+    return {load_error::CorruptFile, "Node references unable to be resolved"};
+  pruneIRMessage(Message, Wanted, LoadSections);
   return IR::fromProtobuf(C, Message);
 }
 
+ErrorOr<IR*> IR::loadLazily(Context& C, const std::string& Path) {
+  std::shared_ptr<LazySections> Lazy = LazySections::open(C, Path);
+  if (!Lazy)
+    return {load_error::CorruptFile, "File unable to be mapped: " + Path};
+  std::istream& In = Lazy->stream();
+  ErrorOr<uint8_t> Format = readContainerHeader(In);
+  if (!Format)
+    return Format.getError();
+  In.seekg(0);
+  if (*Format == MonolithicContainerFormat)
+    return load(C, In);
+
+  // The table of contents and the frames the sections are read against are
+  // read once and kept.
+  ErrorOr<ContainerFrames> Frames = ContainerFrames::open(In);
+  if (!Frames)
+    return Frames.getError();
+  std::vector<std::string> Names;
+  for (const ContainerIndexEntry& E : Frames->entries())
+    if (E.Kind == ContainerFrameKind::Module)
+      Names.push_back(E.Name);
+  In.seekg(0);
+  ErrorOr<IR*> Result = loadModules(C, In, Names, false);
+  if (!Result)
+    return Result;
+
+  for (const ContainerIndexEntry& E : Frames->entries()) {
+    if (E.Kind != ContainerFrameKind::Section)
+      continue;
+    if (auto* M = dyn_cast_or_null<Module>(Node::getByUUID(C, E.Parent))) {
+      Lazy->addPending(M, E);
+      M->Lazy = Lazy;
+    }
+  }
+  Lazy->setFrames(std::move(*Frames));
+  Lazy->install();
+  return Result;
+}
+
+ErrorInfo IR::loadPendingSections() const {
+  ErrorInfo Result;
+  for (const Module& M : modules()) {
+    ErrorInfo Error = M.materializePendingSections();
+    if (Error.ErrorCode && !Result.ErrorCode)
+      Result = std::move(Error);
+  }
+  return Result;
+}
+
 void IR::saveJSON(std::ostream& Out) const {
+  // The IR is written a module and a section at a time, so that its whole
+  // message is never held in memory. The text is the same as that of
+  // MessageToJsonString on the whole message.
   MessageType Message;
-  this->toProtobuf(&Message);
-  std::string S;
-  auto status = google::protobuf::util::MessageToJsonString(Message, &S);
-  assert(status.ok());
-  Out << S;
+  this->toProtobuf(&Message, false);
+  JsonWriter Writer(Out);
+  Writer.beginObject();
+  Writer.writeFields(Message, 0, MessageType::kModulesFieldNumber);
+  if (!Modules.empty()) {
+    Writer.key("modules");
+    Writer.beginArray();
+    for (const Module& M : modules()) {
+      proto::Module ModuleMessage;
+      M.toProtobuf(&ModuleMessage, false);
+      Writer.beginObject();
+      Writer.writeFields(ModuleMessage, 0,
+                         proto::Module::kSectionsFieldNumber);
+      if (!M.sections().empty()) {
+        Writer.key("sections");
+        Writer.beginArray();
+        for (const Section& S : M.sections())
+          Writer.writeMessage(gtirb::toProtobuf(S));
+        Writer.endArray();
+      }
+      Writer.writeFields(ModuleMessage,
+                         proto::Module::kSectionsFieldNumber + 1);
+      Writer.endObject();
+    }
+    Writer.endArray();
+  }
+  Writer.writeFields(Message, MessageType::kModulesFieldNumber + 1);
+  Writer.endObject();
 }
 
 ErrorOr<IR*> IR::loadJSON(Context& C, std::istream& In) {
+  // Modules are parsed and built one at a time as they are read, so that
+  // neither the text nor the whole message is held in memory.
   MessageType Message;
-  std::string S;
-  auto status = google::protobuf::util::JsonStringToMessage(
-      std::string(std::istreambuf_iterator<char>(In), {}), &Message);
-  if (!status.ok()) {
-    return {load_error::CorruptFile, status.ToString()};
-  } else {
-    return IR::fromProtobuf(C, Message);
+  std::vector<Module*> Loaded;
+  JsonReader Reader(In);
+  if (Reader.beginObject()) {
+    std::string Key;
+    while (Reader.nextKey(Key)) {
+      if (Key != "modules") {
+        if (!Reader.readField(Message, Key))
+          break;
+        continue;
+      }
+      if (!Reader.beginArray())
+        break;
+      while (Reader.nextElement()) {
+        proto::Module ModuleMessage;
+        if (!Reader.readMessage(ModuleMessage))
+          break;
+        auto M = Module::fromProtobuf(C, ModuleMessage);
+        if (!M) {
+          ErrorInfo Err{load_error::CorruptModule,
+                        "#" + std::to_string(Loaded.size())};
+          Err.Msg += "\n" + M.getError().message();
+          return Err;
+        }
+        Loaded.push_back(*M);
+      }
+      if (Reader.failed())
+        break;
+    }
   }
+  if (Reader.failed() || !Reader.atEnd())
+    return {load_error::CorruptFile,
+            Reader.failed() ? Reader.error() : "Trailing text after IR"};
+
+  // The CFG refers to blocks in the modules, so it is loaded after them.
+  proto::CFG Cfg;
+  Cfg.Swap(Message.mutable_cfg());
+  auto I = IR::fromProtobuf(C, Message);
+  if (!I)
+    return I;
+  for (Module* M : Loaded)
+    (*I)->addModule(M);
+  if (!gtirb::fromProtobuf(C, (*I)->Cfg, Cfg))
+    return load_error::CorruptCFG;
+  return I;
 }
@@ -0,0 +1,489 @@
+//===- IRDelta.cpp ----------------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#include "ContainerIndex.hpp"
+#include "NodeIndex.hpp"
+#include "SymbolicExpressionSerialization.hpp"
+#include <gtirb/IR.hpp>
+#include <gtirb/IRDelta.hpp>
+#include <gtirb/proto/IRDelta.pb.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl.h>
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace gtirb;
+
+namespace {
+// The parts of an IR message that a delta records changes to, each keyed by
+// its identity rather than nested in its parent. Nodes are held without their
+// children, and name their parent instead. Byte intervals are also held
+// without their contents, which are compared byte by byte.
+struct FlatIR {
+  proto::IR Header;
+  std::vector<std::string> Order;
+  std::unordered_map<std::string, proto::DeltaNode> Nodes;
+  std::unordered_map<std::string, std::string> Contents;
+  std::map<std::pair<std::string, uint64_t>, proto::SymbolicExpression>
+      SymbolicExpressions;
+  std::map<std::pair<std::string, std::string>, proto::AuxData> AuxData;
+  google::protobuf::RepeatedPtrField<proto::Edge> Edges;
+};
+} // namespace
+
+static const std::string& nodeUUID(const proto::DeltaNode& Node) {
+  switch (Node.value_case()) {
+  case proto::DeltaNode::kModule:
+    return Node.module().uuid();
+  case proto::DeltaNode::kSection:
+    return Node.section().uuid();
+  case proto::DeltaNode::kByteInterval:
+    return Node.byte_interval().uuid();
+  case proto::DeltaNode::kBlock:
+    return Node.block().has_code() ? Node.block().code().uuid()
+                                   : Node.block().data().uuid();
+  case proto::DeltaNode::kSymbol:
+    return Node.symbol().uuid();
+  case proto::DeltaNode::kProxy:
+    return Node.proxy().uuid();
+  case proto::DeltaNode::VALUE_NOT_SET:
+    break;
+  }
+  static const std::string None;
+  return None;
+}
+
+static proto::DeltaNode* addNode(FlatIR& Flat, const std::string& Id,
+                                 const std::string& Parent) {
+  auto [It, Inserted] = Flat.Nodes.try_emplace(Id);
+  if (Inserted)
+    Flat.Order.push_back(Id);
+  It->second.set_parent_uuid(Parent);
+  return &It->second;
+}
+
+// Takes an IR message apart into Flat, leaving the message empty.
+static void flatten(proto::IR& Message, FlatIR& Flat) {
+  for (auto& [Name, Table] : *Message.mutable_aux_data())
+    Flat.AuxData[{std::string(), Name}].Swap(&Table);
+
+  for (proto::Module& M : *Message.mutable_modules()) {
+    const std::string ModuleId = M.uuid();
+    proto::DeltaNode* ModuleNode = addNode(Flat, ModuleId, std::string());
+    for (auto& [Name, Table] : *M.mutable_aux_data())
+      Flat.AuxData[{ModuleId, Name}].Swap(&Table);
+    for (proto::Symbol& S : *M.mutable_symbols())
+      addNode(Flat, S.uuid(), ModuleId)->mutable_symbol()->Swap(&S);
+    for (proto::ProxyBlock& P : *M.mutable_proxies())
+      addNode(Flat, P.uuid(), ModuleId)->mutable_proxy()->Swap(&P);
+
+    for (proto::Section& S : *M.mutable_sections()) {
+      const std::string SectionId = S.uuid();
+      proto::DeltaNode* SectionNode = addNode(Flat, SectionId, ModuleId);
+      for (proto::ByteInterval& BI : *S.mutable_byte_intervals()) {
+        const std::string IntervalId = BI.uuid();
+        proto::DeltaNode* IntervalNode = addNode(Flat, IntervalId, SectionId);
+        for (auto& [Offset, SE] : *BI.mutable_symbolic_expressions())
+          Flat.SymbolicExpressions[{IntervalId, Offset}].Swap(&SE);
+        for (proto::Block& B : *BI.mutable_blocks()) {
+          proto::DeltaNode Node;
+          Node.mutable_block()->Swap(&B);
+          addNode(Flat, nodeUUID(Node), IntervalId)
+              ->mutable_block()
+              ->Swap(Node.mutable_block());
+        }
+        BI.clear_symbolic_expressions();
+        BI.clear_blocks();
+        Flat.Contents[IntervalId].swap(*BI.mutable_contents());
+        BI.clear_contents();
+        IntervalNode->mutable_byte_interval()->Swap(&BI);
+      }
+      S.clear_byte_intervals();
+      SectionNode->mutable_section()->Swap(&S);
+    }
+
+    M.clear_aux_data();
+    M.clear_symbols();
+    M.clear_proxies();
+    M.clear_sections();
+    ModuleNode->mutable_module()->Swap(&M);
+  }
+
+  Flat.Edges.Swap(Message.mutable_cfg()->mutable_edges());
+  Message.clear_modules();
+  Message.clear_aux_data();
+  Message.clear_cfg();
+  Flat.Header.Swap(&Message);
+}
+
+// Puts an IR message back together from Flat, leaving Flat empty. Nodes whose
+// parent is missing or cannot hold them are dropped, as are their children,
+// and CFG edges between blocks that are missing.
+static void assemble(FlatIR& Flat, proto::IR& Message) {
+  Message.Swap(&Flat.Header);
+
+  std::unordered_map<std::string, std::vector<proto::DeltaNode*>> Children;
+  std::unordered_set<std::string> Seen;
+  for (const std::string& Id : Flat.Order)
+    if (auto It = Flat.Nodes.find(Id);
+        It != Flat.Nodes.end() && Seen.insert(Id).second)
+      Children[It->second.parent_uuid()].push_back(&It->second);
+  auto ChildrenOf = [&Children](const std::string& Id)
+      -> const std::vector<proto::DeltaNode*>& {
+    static const std::vector<proto::DeltaNode*> None;
+    auto It = Children.find(Id);
+    return It == Children.end() ? None : It->second;
+  };
+
+  std::unordered_map<std::string, proto::Module*> Modules;
+  std::unordered_map<std::string, proto::ByteInterval*> Intervals;
+  std::unordered_set<std::string> Vertices;
+  proto::CFG& Cfg = *Message.mutable_cfg();
+  auto AddVertex = [&](const std::string& Id) {
+    if (Vertices.insert(Id).second)
+      Cfg.add_vertices(Id);
+  };
+
+  for (proto::DeltaNode* ModuleNode : ChildrenOf(std::string())) {
+    if (!ModuleNode->has_module())
+      continue;
+    proto::Module* M = Message.add_modules();
+    M->Swap(ModuleNode->mutable_module());
+    Modules[M->uuid()] = M;
+    for (proto::DeltaNode* Node : ChildrenOf(M->uuid())) {
+      if (Node->has_symbol()) {
+        M->add_symbols()->Swap(Node->mutable_symbol());
+      } else if (Node->has_proxy()) {
+        AddVertex(Node->proxy().uuid());
+        M->add_proxies()->Swap(Node->mutable_proxy());
+      } else if (Node->has_section()) {
+        proto::Section* S = M->add_sections();
+        S->Swap(Node->mutable_section());
+        for (proto::DeltaNode* IntervalNode : ChildrenOf(S->uuid())) {
+          if (!IntervalNode->has_byte_interval())
+            continue;
+          proto::ByteInterval* BI = S->add_byte_intervals();
+          BI->Swap(IntervalNode->mutable_byte_interval());
+          Intervals[BI->uuid()] = BI;
+          if (auto It = Flat.Contents.find(BI->uuid());
+              It != Flat.Contents.end())
+            BI->mutable_contents()->swap(It->second);
+          for (proto::DeltaNode* BlockNode : ChildrenOf(BI->uuid())) {
+            if (!BlockNode->has_block())
+              continue;
+            if (BlockNode->block().has_code())
+              AddVertex(BlockNode->block().code().uuid());
+            BI->add_blocks()->Swap(BlockNode->mutable_block());
+          }
+        }
+      }
+    }
+  }
+
+  for (auto& [Key, SE] : Flat.SymbolicExpressions)
+    if (auto It = Intervals.find(Key.first); It != Intervals.end())
+      (*It->second->mutable_symbolic_expressions())[Key.second].Swap(&SE);
+  for (auto& [Key, Table] : Flat.AuxData) {
+    if (Key.first.empty()) {
+      (*Message.mutable_aux_data())[Key.second].Swap(&Table);
+    } else if (auto It = Modules.find(Key.first); It != Modules.end()) {
+      (*It->second->mutable_aux_data())[Key.second].Swap(&Table);
+    }
+  }
+  for (proto::Edge& E : Flat.Edges)
+    if (Vertices.count(E.source_uuid()) && Vertices.count(E.target_uuid()))
+      Cfg.add_edges()->Swap(&E);
+}
+
+// Records the ranges of bytes in which the contents of a byte interval in the
+// target differ from those in the base. Ranges separated by only a few equal
+// bytes are merged, as each range costs a few bytes of its own.
+static void diffContents(const std::string& From, const std::string& To,
+                         proto::DeltaContents& Change) {
+  constexpr size_t MaxGap = 16;
+  Change.set_size(To.size());
+  size_t Common = std::min(From.size(), To.size());
+  proto::DeltaBytes* Last = nullptr;
+  size_t LastEnd = 0;
+  for (size_t I = 0; I < Common;) {
+    if (From[I] == To[I]) {
+      ++I;
+      continue;
+    }
+    size_t End = I + 1;
+    while (End < Common && From[End] != To[End])
+      ++End;
+    if (Last && I - LastEnd <= MaxGap) {
+      Last->mutable_data()->append(To, LastEnd, End - LastEnd);
+    } else {
+      Last = Change.add_ranges();
+      Last->set_offset(I);
+      Last->set_data(To.substr(I, End - I));
+    }
+    LastEnd = End;
+    I = End;
+  }
+  if (To.size() > Common) {
+    if (Last && Common - LastEnd <= MaxGap) {
+      Last->mutable_data()->append(To, LastEnd, std::string::npos);
+    } else {
+      Last = Change.add_ranges();
+      Last->set_offset(Common);
+      Last->set_data(To.substr(Common));
+    }
+  }
+}
+
+// Applies a change recorded by diffContents to the contents in the base.
+static bool patchContents(std::string& Contents,
+                          const proto::DeltaContents& Change) {
+  Contents.resize(Change.size());
+  for (const proto::DeltaBytes& Range : Change.ranges()) {
+    if (Range.offset() > Contents.size() ||
+        Range.data().size() > Contents.size() - Range.offset())
+      return false;
+    Contents.replace(Range.offset(), Range.data().size(), Range.data());
+  }
+  return true;
+}
+
+static bool sameMessage(const google::protobuf::MessageLite& A,
+                        const google::protobuf::MessageLite& B) {
+  return A.ByteSizeLong() == B.ByteSizeLong() &&
+         A.SerializeAsString() == B.SerializeAsString();
+}
+
+IRDelta::IRDelta() : Message(std::make_unique<proto::IRDelta>()) {}
+IRDelta::~IRDelta() = default;
+IRDelta::IRDelta(IRDelta&&) = default;
+IRDelta& IRDelta::operator=(IRDelta&&) = default;
+
+IRDelta IRDelta::compute(const IR& Base, const IR& Target) {
+  FlatIR From, To;
+  {
+    proto::IR Message;
+    Base.toProtobuf(&Message);
+    flatten(Message, From);
+  }
+  {
+    proto::IR Message;
+    Target.toProtobuf(&Message);
+    flatten(Message, To);
+  }
+
+  IRDelta Delta;
+  proto::IRDelta& M = *Delta.Message;
+  M.set_base_uuid(From.Header.uuid());
+  if (!sameMessage(From.Header, To.Header))
+    M.mutable_ir()->Swap(&To.Header);
+
+  // Children of removed nodes are removed with them, and need no record.
+  auto Kept = [&To](const std::string& Id) {
+    return Id.empty() || To.Nodes.count(Id) != 0;
+  };
+
+  for (const std::string& Id : To.Order) {
+    proto::DeltaNode& Node = To.Nodes[Id];
+    auto It = From.Nodes.find(Id);
+    if (It == From.Nodes.end() || !sameMessage(It->second, Node))
+      M.add_nodes()->Swap(&Node);
+  }
+  for (const std::string& Id : From.Order)
+    if (!Kept(Id) && Kept(From.Nodes[Id].parent_uuid()))
+      M.add_removed_nodes(Id);
+
+  for (const std::string& Id : To.Order) {
+    auto ToIt = To.Contents.find(Id);
+    if (ToIt == To.Contents.end())
+      continue;
+    static const std::string None;
+    auto FromIt = From.Contents.find(Id);
+    const std::string& Before =
+        FromIt == From.Contents.end() ? None : FromIt->second;
+    if (Before == ToIt->second)
+      continue;
+    proto::DeltaContents* Change = M.add_contents();
+    Change->set_byte_interval_uuid(Id);
+    diffContents(Before, ToIt->second, *Change);
+  }
+
+  for (auto& [Key, SE] : To.SymbolicExpressions) {
+    auto It = From.SymbolicExpressions.find(Key);
+    if (It != From.SymbolicExpressions.end() && sameMessage(It->second, SE))
+      continue;
+    proto::DeltaSymbolicExpression* Change = M.add_symbolic_expressions();
+    Change->set_byte_interval_uuid(Key.first);
+    Change->set_offset(Key.second);
+    Change->mutable_value()->Swap(&SE);
+  }
+  for (const auto& Entry : From.SymbolicExpressions) {
+    const auto& Key = Entry.first;
+    if (!To.SymbolicExpressions.count(Key) && Kept(Key.first)) {
+      proto::DeltaSymbolicExpression* Change = M.add_symbolic_expressions();
+      Change->set_byte_interval_uuid(Key.first);
+      Change->set_offset(Key.second);
+    }
+  }
+
+  for (auto& [Key, Table] : To.AuxData) {
+    auto It = From.AuxData.find(Key);
+    if (It != From.AuxData.end() && sameMessage(It->second, Table))
+      continue;
+    proto::DeltaAuxData* Change = M.add_aux_data();
+    Change->set_container_uuid(Key.first);
+    Change->set_name(Key.second);
+    Change->mutable_value()->Swap(&Table);
+  }
+  for (const auto& Entry : From.AuxData) {
+    const auto& Key = Entry.first;
+    if (!To.AuxData.count(Key) && Kept(Key.first)) {
+      proto::DeltaAuxData* Change = M.add_aux_data();
+      Change->set_container_uuid(Key.first);
+      Change->set_name(Key.second);
+    }
+  }
+
+  // A CFG may hold several identical edges, so edges are counted.
+  std::unordered_map<std::string, size_t> BaseEdges;
+  for (const proto::Edge& E : From.Edges)
+    ++BaseEdges[E.SerializeAsString()];
+  for (proto::Edge& E : To.Edges) {
+    auto It = BaseEdges.find(E.SerializeAsString());
+    if (It != BaseEdges.end() && It->second != 0)
+      --It->second;
+    else
+      M.add_added_edges()->Swap(&E);
+  }
+  for (const proto::Edge& E : From.Edges) {
+    size_t& Count = BaseEdges[E.SerializeAsString()];
+    if (Count != 0) {
+      --Count;
+      if (Kept(E.source_uuid()) && Kept(E.target_uuid()))
+        *M.add_removed_edges() = E;
+    }
+  }
+  return Delta;
+}
+
+bool IRDelta::empty() const {
+  return !Message->has_ir() && Message->nodes().empty() &&
+         Message->removed_nodes().empty() &&
+         Message->symbolic_expressions().empty() &&
+         Message->aux_data().empty() && Message->added_edges().empty() &&
+         Message->removed_edges().empty() && Message->contents().empty();
+}
+
+void IRDelta::save(std::ostream& Out) const {
+  writeContainerHeader(Out, DeltaContainerFormat);
+  Message->SerializeToOstream(&Out);
+}
+
+ErrorOr<IRDelta> IRDelta::load(std::istream& In) {
+  ErrorOr<uint8_t> Format = readContainerHeader(In, true);
+  if (!Format)
+    return Format.getError();
+
+  IRDelta Delta;
+  google::protobuf::io::IstreamInputStream InputStream(&In);
+  google::protobuf::io::CodedInputStream CodedStream(&InputStream);
+#ifdef PROTOBUF_SET_BYTES_LIMIT
+  CodedStream.SetTotalBytesLimit(INT_MAX, INT_MAX);
+#endif
+  if (!Delta.Message->ParseFromCodedStream(&CodedStream))
+    return {IR::load_error::CorruptFile, "Protobuf unable to be parsed"};
+  return Delta;
+}
+
+ErrorOr<IR*> IRDelta::apply(Context& C, std::istream& Base) const {
+  return applyTo(C, Base, nullptr);
+}
+
+ErrorOr<IR*> IRDelta::apply(Context& C, std::istream& Base,
+                            const ChunkStore& Store) const {
+  return applyTo(C, Base, &Store);
+}
+
+ErrorOr<IR*> IRDelta::applyTo(Context& C, std::istream& Base,
+                              const ChunkStore* Store) const {
+  FlatIR Flat;
+  {
+    proto::IR BaseMessage;
+    ErrorInfo Err =
+        IR::readContainer(Base, Store, C.getThreadCount(), BaseMessage);
+    if (Err.ErrorCode)
+      return Err;
+    if (BaseMessage.uuid() != Message->base_uuid())
+      return {IR::load_error::CorruptFile,
+              "IR delta does not apply to this base IR"};
+    // Changes are keyed by UUID and offset, so references by index and
+    // packed symbolic expressions are expanded first.
+    if (!unindexReferences(BaseMessage))
+      return {IR::load_error::CorruptFile,
+              "Node references unable to be resolved"};
+    for (proto::Module& M : *BaseMessage.mutable_modules())
+      for (proto::Section& S : *M.mutable_sections())
+        for (proto::ByteInterval& BI : *S.mutable_byte_intervals())
+          if (!unpackSymbolicExpressions(BI, M))
+            return {IR::load_error::CorruptFile,
+                    "Packed symbolic expressions unable to be read"};
+    flatten(BaseMessage, Flat);
+  }
+
+  if (Message->has_ir())
+    Flat.Header = Message->ir();
+  for (const std::string& Id : Message->removed_nodes())
+    Flat.Nodes.erase(Id);
+  for (const proto::DeltaNode& Node : Message->nodes())
+    *addNode(Flat, nodeUUID(Node), Node.parent_uuid()) = Node;
+  for (const proto::DeltaContents& Change : Message->contents())
+    if (!patchContents(Flat.Contents[Change.byte_interval_uuid()], Change))
+      return {IR::load_error::CorruptFile,
+              "Byte interval contents unable to be patched"};
+
+  for (const proto::DeltaSymbolicExpression& Change :
+       Message->symbolic_expressions()) {
+    std::pair Key{Change.byte_interval_uuid(), Change.offset()};
+    if (Change.has_value())
+      Flat.SymbolicExpressions[Key] = Change.value();
+    else
+      Flat.SymbolicExpressions.erase(Key);
+  }
+  for (const proto::DeltaAuxData& Change : Message->aux_data()) {
+    std::pair Key{Change.container_uuid(), Change.name()};
+    if (Change.has_value())
+      Flat.AuxData[Key] = Change.value();
+    else
+      Flat.AuxData.erase(Key);
+  }
+
+  std::unordered_map<std::string, size_t> Removed;
+  for (const proto::Edge& E : Message->removed_edges())
+    ++Removed[E.SerializeAsString()];
+  google::protobuf::RepeatedPtrField<proto::Edge> Edges;
+  for (proto::Edge& E : Flat.Edges) {
+    auto It = Removed.find(E.SerializeAsString());
+    if (It != Removed.end() && It->second != 0)
+      --It->second;
+    else
+      Edges.Add()->Swap(&E);
+  }
+  Edges.MergeFrom(Message->added_edges());
+  Flat.Edges.Swap(&Edges);
+
+  proto::IR Target;
+  assemble(Flat, Target);
+  return IR::fromProtobuf(C, Target);
+}
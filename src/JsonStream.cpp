@@ -0,0 +1,827 @@
+//===- JsonStream.cpp -------------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#include "JsonStream.hpp"
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/message.h>
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <sstream>
+
+using namespace gtirb;
+using google::protobuf::Descriptor;
+using google::protobuf::EnumValueDescriptor;
+using google::protobuf::FieldDescriptor;
+using google::protobuf::Message;
+using google::protobuf::Reflection;
+
+static constexpr const char* Base64Chars =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static void writeBase64(std::ostream& Out, const std::string& Bytes) {
+  size_t I = 0;
+  for (; I + 3 <= Bytes.size(); I += 3) {
+    uint32_t V = static_cast<uint8_t>(Bytes[I]) << 16 |
+                 static_cast<uint8_t>(Bytes[I + 1]) << 8 |
+                 static_cast<uint8_t>(Bytes[I + 2]);
+    char Chunk[4] = {Base64Chars[V >> 18], Base64Chars[(V >> 12) & 63],
+                     Base64Chars[(V >> 6) & 63], Base64Chars[V & 63]};
+    Out.write(Chunk, 4);
+  }
+  if (size_t Rest = Bytes.size() - I) {
+    uint32_t V = static_cast<uint8_t>(Bytes[I]) << 16;
+    if (Rest == 2)
+      V |= static_cast<uint8_t>(Bytes[I + 1]) << 8;
+    char Chunk[4] = {Base64Chars[V >> 18], Base64Chars[(V >> 12) & 63],
+                     Rest == 2 ? Base64Chars[(V >> 6) & 63] : '=', '='};
+    Out.write(Chunk, 4);
+  }
+}
+
+// Decodes standard or URL-safe base64 in place, with or without padding.
+static bool decodeBase64(std::string& S) {
+  std::string Bytes;
+  Bytes.reserve(S.size() / 4 * 3 + 3);
+  uint32_t V = 0;
+  int Bits = 0;
+  size_t End = S.size();
+  while (End > 0 && S[End - 1] == '=')
+    --End;
+  for (size_t I = 0; I < End; ++I) {
+    char C = S[I];
+    int D;
+    if (C >= 'A' && C <= 'Z')
+      D = C - 'A';
+    else if (C >= 'a' && C <= 'z')
+      D = C - 'a' + 26;
+    else if (C >= '0' && C <= '9')
+      D = C - '0' + 52;
+    else if (C == '+' || C == '-')
+      D = 62;
+    else if (C == '/' || C == '_')
+      D = 63;
+    else
+      return false;
+    V = (V << 6) | static_cast<uint32_t>(D);
+    Bits += 6;
+    if (Bits >= 8) {
+      Bits -= 8;
+      Bytes.push_back(static_cast<char>((V >> Bits) & 0xff));
+    }
+  }
+  if (Bits >= 6)
+    return false;
+  S.swap(Bytes);
+  return true;
+}
+
+// The code points above U+007F that protobuf escapes in JSON strings: C1
+// controls and invisible formatting characters.
+static bool needsEscape(uint32_t CP) {
+  return CP < 0xa0 || CP == 0xad || (CP >= 0x600 && CP <= 0x603) ||
+         CP == 0x6dd || CP == 0x70f || CP == 0x17b4 || CP == 0x17b5 ||
+         (CP >= 0x200b && CP <= 0x200f) || (CP >= 0x2028 && CP <= 0x202e) ||
+         (CP >= 0x2060 && CP <= 0x2064) || (CP >= 0x206a && CP <= 0x206f) ||
+         CP == 0xfeff || (CP >= 0xfff9 && CP <= 0xfffb) || CP == 0x110bd ||
+         (CP >= 0x1d173 && CP <= 0x1d17a) || CP == 0xe0001 ||
+         (CP >= 0xe0020 && CP <= 0xe007f);
+}
+
+static void writeUnicodeEscape(std::ostream& Out, uint32_t Unit) {
+  static constexpr const char* Hex = "0123456789abcdef";
+  char Chunk[6] = {'\\',
+                   'u',
+                   Hex[(Unit >> 12) & 15],
+                   Hex[(Unit >> 8) & 15],
+                   Hex[(Unit >> 4) & 15],
+                   Hex[Unit & 15]};
+  Out.write(Chunk, 6);
+}
+
+void JsonWriter::beginValue() {
+  if (AfterKey) {
+    AfterKey = false;
+    return;
+  }
+  if (!HaveMember.empty()) {
+    if (HaveMember.back())
+      Out.put(',');
+    HaveMember.back() = true;
+  }
+}
+
+void JsonWriter::beginObject() {
+  beginValue();
+  Out.put('{');
+  HaveMember.push_back(false);
+}
+
+void JsonWriter::endObject() {
+  HaveMember.pop_back();
+  Out.put('}');
+}
+
+void JsonWriter::beginArray() {
+  beginValue();
+  Out.put('[');
+  HaveMember.push_back(false);
+}
+
+void JsonWriter::endArray() {
+  HaveMember.pop_back();
+  Out.put(']');
+}
+
+void JsonWriter::key(const std::string& Name) {
+  if (HaveMember.back())
+    Out.put(',');
+  HaveMember.back() = true;
+  writeString(Name);
+  Out.put(':');
+  AfterKey = true;
+}
+
+void JsonWriter::writeString(const std::string& S) {
+  Out.put('"');
+  size_t I = 0;
+  while (I < S.size()) {
+    auto C = static_cast<uint8_t>(S[I]);
+    if (C < 0x80) {
+      switch (C) {
+      case '"':
+        Out << "\\\"";
+        break;
+      case '\\':
+        Out << "\\\\";
+        break;
+      case '\b':
+        Out << "\\b";
+        break;
+      case '\t':
+        Out << "\\t";
+        break;
+      case '\n':
+        Out << "\\n";
+        break;
+      case '\f':
+        Out << "\\f";
+        break;
+      case '\r':
+        Out << "\\r";
+        break;
+      default:
+        if (C < 0x20 || C == '<' || C == '>' || C == 0x7f)
+          writeUnicodeEscape(Out, C);
+        else
+          Out.put(static_cast<char>(C));
+      }
+      ++I;
+      continue;
+    }
+
+    // Like protobuf, drop bytes that are not valid UTF-8.
+    size_t Length = C >= 0xf8   ? 0
+                    : C >= 0xf0 ? 4
+                    : C >= 0xe0 ? 3
+                    : C >= 0xc0 ? 2
+                                : 0;
+    if (Length == 0) {
+      ++I;
+      continue;
+    }
+    if (I + Length > S.size())
+      break;
+    uint32_t CP = C & (0x7f >> Length);
+    bool Valid = true;
+    for (size_t K = 1; K < Length; ++K) {
+      auto Next = static_cast<uint8_t>(S[I + K]);
+      Valid &= (Next & 0xc0) == 0x80;
+      CP = (CP << 6) | (Next & 0x3f);
+    }
+    if (Valid) {
+      if (!needsEscape(CP)) {
+        Out.write(S.data() + I, Length);
+      } else if (CP < 0x10000) {
+        writeUnicodeEscape(Out, CP);
+      } else {
+        writeUnicodeEscape(Out, 0xd800 + ((CP - 0x10000) >> 10));
+        writeUnicodeEscape(Out, 0xdc00 + ((CP - 0x10000) & 0x3ff));
+      }
+    }
+    I += Length;
+  }
+  Out.put('"');
+}
+
+const std::vector<const FieldDescriptor*>&
+JsonWriter::fieldsByNumber(const Descriptor* D) {
+  auto [It, Inserted] = FieldOrder.try_emplace(D);
+  if (Inserted) {
+    for (int I = 0; I < D->field_count(); ++I)
+      It->second.push_back(D->field(I));
+    std::sort(It->second.begin(), It->second.end(),
+              [](const FieldDescriptor* A, const FieldDescriptor* B) {
+                return A->number() < B->number();
+              });
+  }
+  return It->second;
+}
+
+// Protobuf maps iterate in an unspecified order that varies between
+// instances, so entries are sorted by key, as protobuf's deterministic
+// serialization does, to make the output reproducible.
+static std::vector<const Message*>
+sortedMapEntries(const Message& M, const FieldDescriptor* F, int Size) {
+  const Reflection* R = M.GetReflection();
+  std::vector<const Message*> Entries;
+  Entries.reserve(Size);
+  for (int I = 0; I < Size; ++I)
+    Entries.push_back(&R->GetRepeatedMessage(M, F, I));
+
+  const FieldDescriptor* K = F->message_type()->map_key();
+  auto Less = [K](const Message* A, const Message* B) {
+    const Reflection* ER = A->GetReflection();
+    switch (K->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+      return ER->GetInt32(*A, K) < ER->GetInt32(*B, K);
+    case FieldDescriptor::CPPTYPE_INT64:
+      return ER->GetInt64(*A, K) < ER->GetInt64(*B, K);
+    case FieldDescriptor::CPPTYPE_UINT32:
+      return ER->GetUInt32(*A, K) < ER->GetUInt32(*B, K);
+    case FieldDescriptor::CPPTYPE_UINT64:
+      return ER->GetUInt64(*A, K) < ER->GetUInt64(*B, K);
+    case FieldDescriptor::CPPTYPE_BOOL:
+      return ER->GetBool(*A, K) < ER->GetBool(*B, K);
+    default: {
+      std::string ScratchA, ScratchB;
+      return ER->GetStringReference(*A, K, &ScratchA) <
+             ER->GetStringReference(*B, K, &ScratchB);
+    }
+    }
+  };
+  std::sort(Entries.begin(), Entries.end(), Less);
+  return Entries;
+}
+
+void JsonWriter::writeFields(const Message& M, int Lo, int Hi) {
+  const Reflection* R = M.GetReflection();
+  for (const FieldDescriptor* F : fieldsByNumber(M.GetDescriptor())) {
+    if (F->number() < Lo || F->number() >= Hi)
+      continue;
+    if (!F->is_repeated()) {
+      if (R->HasField(M, F)) {
+        key(F->json_name());
+        writeValue(M, F, -1);
+      }
+      continue;
+    }
+
+    int Size = R->FieldSize(M, F);
+    if (Size == 0)
+      continue;
+    key(F->json_name());
+    if (F->is_map()) {
+      const FieldDescriptor* KeyField = F->message_type()->map_key();
+      const FieldDescriptor* ValueField = F->message_type()->map_value();
+      beginObject();
+      for (const Message* Entry : sortedMapEntries(M, F, Size)) {
+        writeMapKey(*Entry, KeyField);
+        writeValue(*Entry, ValueField, -1);
+      }
+      endObject();
+    } else {
+      beginArray();
+      for (int I = 0; I < Size; ++I)
+        writeValue(M, F, I);
+      endArray();
+    }
+  }
+}
+
+void JsonWriter::writeMessage(const Message& M) {
+  beginObject();
+  writeFields(M);
+  endObject();
+}
+
+void JsonWriter::writeMapKey(const Message& Entry, const FieldDescriptor* F) {
+  const Reflection* R = Entry.GetReflection();
+  switch (F->cpp_type()) {
+  case FieldDescriptor::CPPTYPE_INT32:
+    key(std::to_string(R->GetInt32(Entry, F)));
+    break;
+  case FieldDescriptor::CPPTYPE_INT64:
+    key(std::to_string(R->GetInt64(Entry, F)));
+    break;
+  case FieldDescriptor::CPPTYPE_UINT32:
+    key(std::to_string(R->GetUInt32(Entry, F)));
+    break;
+  case FieldDescriptor::CPPTYPE_UINT64:
+    key(std::to_string(R->GetUInt64(Entry, F)));
+    break;
+  case FieldDescriptor::CPPTYPE_BOOL:
+    key(R->GetBool(Entry, F) ? "true" : "false");
+    break;
+  default:
+    key(R->GetString(Entry, F));
+  }
+}
+
+void JsonWriter::writeValue(const Message& M, const FieldDescriptor* F,
+                            int Index) {
+  const Reflection* R = M.GetReflection();
+  bool Repeated = Index >= 0;
+  if (F->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+    writeMessage(Repeated ? R->GetRepeatedMessage(M, F, Index)
+                          : R->GetMessage(M, F));
+    return;
+  }
+
+  beginValue();
+  switch (F->cpp_type()) {
+  case FieldDescriptor::CPPTYPE_INT32:
+    Out << (Repeated ? R->GetRepeatedInt32(M, F, Index) : R->GetInt32(M, F));
+    break;
+  case FieldDescriptor::CPPTYPE_UINT32:
+    Out << (Repeated ? R->GetRepeatedUInt32(M, F, Index)
+                     : R->GetUInt32(M, F));
+    break;
+  case FieldDescriptor::CPPTYPE_INT64:
+    // 64-bit integers are quoted, as JSON numbers may lose precision.
+    Out << '"'
+        << (Repeated ? R->GetRepeatedInt64(M, F, Index) : R->GetInt64(M, F))
+        << '"';
+    break;
+  case FieldDescriptor::CPPTYPE_UINT64:
+    Out << '"'
+        << (Repeated ? R->GetRepeatedUInt64(M, F, Index) : R->GetUInt64(M, F))
+        << '"';
+    break;
+  case FieldDescriptor::CPPTYPE_DOUBLE:
+  case FieldDescriptor::CPPTYPE_FLOAT: {
+    // GTIRB messages have no floating-point fields; these are written
+    // exactly, though not necessarily in protobuf's shortest form.
+    double V = F->cpp_type() == FieldDescriptor::CPPTYPE_DOUBLE
+                   ? (Repeated ? R->GetRepeatedDouble(M, F, Index)
+                               : R->GetDouble(M, F))
+                   : (Repeated ? R->GetRepeatedFloat(M, F, Index)
+                               : R->GetFloat(M, F));
+    if (std::isnan(V))
+      Out << "\"NaN\"";
+    else if (std::isinf(V))
+      Out << (V > 0 ? "\"Infinity\"" : "\"-Infinity\"");
+    else
+      Out << std::setprecision(17) << V;
+  } break;
+  case FieldDescriptor::CPPTYPE_BOOL:
+    Out << ((Repeated ? R->GetRepeatedBool(M, F, Index) : R->GetBool(M, F))
+                ? "true"
+                : "false");
+    break;
+  case FieldDescriptor::CPPTYPE_ENUM: {
+    int V = Repeated ? R->GetRepeatedEnumValue(M, F, Index)
+                     : R->GetEnumValue(M, F);
+    if (const EnumValueDescriptor* E = F->enum_type()->FindValueByNumber(V)) {
+      Out.put('"');
+      Out << E->name();
+      Out.put('"');
+    } else {
+      Out << V;
+    }
+  } break;
+  case FieldDescriptor::CPPTYPE_STRING: {
+    std::string Scratch;
+    const std::string& S =
+        Repeated ? R->GetRepeatedStringReference(M, F, Index, &Scratch)
+                 : R->GetStringReference(M, F, &Scratch);
+    if (F->type() == FieldDescriptor::TYPE_BYTES) {
+      Out.put('"');
+      writeBase64(Out, S);
+      Out.put('"');
+    } else {
+      writeString(S);
+    }
+  } break;
+  case FieldDescriptor::CPPTYPE_MESSAGE:
+    break;
+  }
+}
+
+int JsonReader::peek() { return In.rdbuf()->sgetc(); }
+
+int JsonReader::get() {
+  int C = In.rdbuf()->sbumpc();
+  if (C != std::char_traits<char>::eof())
+    ++Offset;
+  return C;
+}
+
+void JsonReader::skipWhitespace() {
+  for (int C = peek(); C == ' ' || C == '\t' || C == '\n' || C == '\r';
+       C = peek())
+    get();
+}
+
+bool JsonReader::fail(const std::string& Msg) {
+  if (Error.empty())
+    Error = Msg + " at offset " + std::to_string(Offset);
+  return false;
+}
+
+bool JsonReader::expect(char C) {
+  skipWhitespace();
+  if (get() != static_cast<uint8_t>(C))
+    return fail(std::string("expected '") + C + "'");
+  return true;
+}
+
+bool JsonReader::readToken(std::string& Token) {
+  skipWhitespace();
+  Token.clear();
+  for (int C = peek(); std::isalnum(C) || C == '-' || C == '+' || C == '.';
+       C = peek())
+    Token.push_back(static_cast<char>(get()));
+  return !Token.empty() || fail("expected a value");
+}
+
+bool JsonReader::readNull() {
+  std::string Token;
+  return readToken(Token) && (Token == "null" || fail("expected null"));
+}
+
+static void appendUTF8(std::string& S, uint32_t CP) {
+  if (CP < 0x80) {
+    S.push_back(static_cast<char>(CP));
+  } else if (CP < 0x800) {
+    S.push_back(static_cast<char>(0xc0 | (CP >> 6)));
+    S.push_back(static_cast<char>(0x80 | (CP & 0x3f)));
+  } else if (CP < 0x10000) {
+    S.push_back(static_cast<char>(0xe0 | (CP >> 12)));
+    S.push_back(static_cast<char>(0x80 | ((CP >> 6) & 0x3f)));
+    S.push_back(static_cast<char>(0x80 | (CP & 0x3f)));
+  } else {
+    S.push_back(static_cast<char>(0xf0 | (CP >> 18)));
+    S.push_back(static_cast<char>(0x80 | ((CP >> 12) & 0x3f)));
+    S.push_back(static_cast<char>(0x80 | ((CP >> 6) & 0x3f)));
+    S.push_back(static_cast<char>(0x80 | (CP & 0x3f)));
+  }
+}
+
+bool JsonReader::readString(std::string& S) {
+  if (!expect('"'))
+    return false;
+  S.clear();
+  auto ReadHex = [this](uint32_t& Unit) {
+    Unit = 0;
+    for (int I = 0; I < 4; ++I) {
+      int C = get();
+      int D = C >= '0' && C <= '9'   ? C - '0'
+              : C >= 'a' && C <= 'f' ? C - 'a' + 10
+              : C >= 'A' && C <= 'F' ? C - 'A' + 10
+                                     : -1;
+      if (D < 0)
+        return fail("invalid \\u escape");
+      Unit = Unit << 4 | static_cast<uint32_t>(D);
+    }
+    return true;
+  };
+
+  for (;;) {
+    int C = get();
+    if (C == std::char_traits<char>::eof())
+      return fail("unterminated string");
+    if (C == '"')
+      return true;
+    if (C < 0x20)
+      return fail("control character in string");
+    if (C != '\\') {
+      S.push_back(static_cast<char>(C));
+      continue;
+    }
+    switch (C = get()) {
+    case '"':
+    case '\\':
+    case '/':
+      S.push_back(static_cast<char>(C));
+      break;
+    case 'b':
+      S.push_back('\b');
+      break;
+    case 'f':
+      S.push_back('\f');
+      break;
+    case 'n':
+      S.push_back('\n');
+      break;
+    case 'r':
+      S.push_back('\r');
+      break;
+    case 't':
+      S.push_back('\t');
+      break;
+    case 'u': {
+      uint32_t Unit;
+      if (!ReadHex(Unit))
+        return false;
+      if (Unit >= 0xd800 && Unit < 0xdc00) {
+        uint32_t Low;
+        if (get() != '\\' || get() != 'u' || !ReadHex(Low) || Low < 0xdc00 ||
+            Low >= 0xe000)
+          return fail("invalid surrogate pair");
+        Unit = 0x10000 + ((Unit - 0xd800) << 10) + (Low - 0xdc00);
+      } else if (Unit >= 0xdc00 && Unit < 0xe000) {
+        return fail("invalid surrogate pair");
+      }
+      appendUTF8(S, Unit);
+    } break;
+    default:
+      return fail("invalid escape in string");
+    }
+  }
+}
+
+bool JsonReader::beginObject() {
+  if (!expect('{'))
+    return false;
+  Open.push_back(Nesting::Empty);
+  return true;
+}
+
+bool JsonReader::nextKey(std::string& Key) {
+  skipWhitespace();
+  if (peek() == '}') {
+    get();
+    Open.pop_back();
+    return false;
+  }
+  if (Open.back() == Nesting::NonEmpty && !expect(','))
+    return false;
+  Open.back() = Nesting::NonEmpty;
+  return readString(Key) && expect(':');
+}
+
+bool JsonReader::beginArray() {
+  skipWhitespace();
+  if (peek() == 'n') {
+    if (!readNull())
+      return false;
+    Open.push_back(Nesting::Null);
+    return true;
+  }
+  if (!expect('['))
+    return false;
+  Open.push_back(Nesting::Empty);
+  return true;
+}
+
+bool JsonReader::nextElement() {
+  if (Open.back() == Nesting::Null) {
+    Open.pop_back();
+    return false;
+  }
+  skipWhitespace();
+  if (peek() == ']') {
+    get();
+    Open.pop_back();
+    return false;
+  }
+  if (Open.back() == Nesting::NonEmpty && !expect(','))
+    return false;
+  Open.back() = Nesting::NonEmpty;
+  return true;
+}
+
+bool JsonReader::atEnd() {
+  skipWhitespace();
+  return peek() == std::char_traits<char>::eof();
+}
+
+bool JsonReader::readMessage(Message& M) {
+  if (!beginObject())
+    return false;
+  std::string Key;
+  while (nextKey(Key))
+    if (!readField(M, Key))
+      return false;
+  return !failed();
+}
+
+bool JsonReader::readField(Message& M, const std::string& Name) {
+  const Descriptor* D = M.GetDescriptor();
+  const FieldDescriptor* F = D->FindFieldByName(Name);
+  for (int I = 0; !F && I < D->field_count(); ++I)
+    if (D->field(I)->json_name() == Name)
+      F = D->field(I);
+  if (!F)
+    return fail("unknown field \"" + Name + "\" in " + D->name());
+
+  // A null value leaves the field unset.
+  skipWhitespace();
+  if (peek() == 'n')
+    return readNull();
+
+  if (F->is_map()) {
+    if (!beginObject())
+      return false;
+    std::string Key;
+    while (nextKey(Key))
+      if (!readMapEntry(M, F, Key))
+        return false;
+    return !failed();
+  }
+  if (F->is_repeated()) {
+    if (!beginArray())
+      return false;
+    while (nextElement())
+      if (!readValue(M, F, true))
+        return false;
+    return !failed();
+  }
+  return readValue(M, F, false);
+}
+
+// Parses an integer from its decimal form or, as protobuf allows, from a
+// floating-point form with an integral value.
+template <typename T> static bool parseInteger(const std::string& S, T& V) {
+  const char* End = S.data() + S.size();
+  if (auto [Ptr, Ec] = std::from_chars(S.data(), End, V);
+      Ec == std::errc() && Ptr == End)
+    return true;
+  char* DoubleEnd;
+  double D = std::strtod(S.c_str(), &DoubleEnd);
+  if (S.empty() || DoubleEnd != S.c_str() + S.size() || D != std::floor(D) ||
+      D < static_cast<double>(std::numeric_limits<T>::min()) ||
+      D >= std::ldexp(1.0, std::numeric_limits<T>::digits))
+    return false;
+  V = static_cast<T>(D);
+  return true;
+}
+
+bool JsonReader::readMapEntry(Message& M, const FieldDescriptor* F,
+                              const std::string& Key) {
+  const Reflection* R = M.GetReflection();
+  Message* Entry = R->AddMessage(&M, F);
+  const Reflection* ER = Entry->GetReflection();
+  const FieldDescriptor* KeyField = F->message_type()->map_key();
+  bool Parsed = true;
+  switch (KeyField->cpp_type()) {
+  case FieldDescriptor::CPPTYPE_INT32: {
+    int32_t V;
+    Parsed = parseInteger(Key, V);
+    ER->SetInt32(Entry, KeyField, V);
+  } break;
+  case FieldDescriptor::CPPTYPE_INT64: {
+    int64_t V;
+    Parsed = parseInteger(Key, V);
+    ER->SetInt64(Entry, KeyField, V);
+  } break;
+  case FieldDescriptor::CPPTYPE_UINT32: {
+    uint32_t V;
+    Parsed = parseInteger(Key, V);
+    ER->SetUInt32(Entry, KeyField, V);
+  } break;
+  case FieldDescriptor::CPPTYPE_UINT64: {
+    uint64_t V;
+    Parsed = parseInteger(Key, V);
+    ER->SetUInt64(Entry, KeyField, V);
+  } break;
+  case FieldDescriptor::CPPTYPE_BOOL:
+    Parsed = Key == "true" || Key == "false";
+    ER->SetBool(Entry, KeyField, Key == "true");
+    break;
+  default:
+    ER->SetString(Entry, KeyField, Key);
+  }
+  if (!Parsed)
+    return fail("invalid map key \"" + Key + "\"");
+  return readValue(*Entry, F->message_type()->map_value(), false);
+}
+
+bool JsonReader::readValue(Message& M, const FieldDescriptor* F,
+                           bool Repeated) {
+  const Reflection* R = M.GetReflection();
+  skipWhitespace();
+  std::string Token;
+  auto ReadScalar = [&]() {
+    return peek() == '"' ? readString(Token) : readToken(Token);
+  };
+  auto Invalid = [&]() {
+    return fail("invalid value \"" + Token + "\" for field " + F->name());
+  };
+
+  switch (F->cpp_type()) {
+  case FieldDescriptor::CPPTYPE_MESSAGE:
+    return readMessage(Repeated ? *R->AddMessage(&M, F)
+                                : *R->MutableMessage(&M, F));
+  case FieldDescriptor::CPPTYPE_STRING:
+    if (!readString(Token))
+      return false;
+    if (F->type() == FieldDescriptor::TYPE_BYTES && !decodeBase64(Token))
+      return Invalid();
+    if (Repeated)
+      R->AddString(&M, F, std::move(Token));
+    else
+      R->SetString(&M, F, std::move(Token));
+    return true;
+  case FieldDescriptor::CPPTYPE_BOOL: {
+    if (!readToken(Token))
+      return false;
+    if (Token != "true" && Token != "false")
+      return Invalid();
+    bool V = Token == "true";
+    Repeated ? R->AddBool(&M, F, V) : R->SetBool(&M, F, V);
+    return true;
+  }
+  case FieldDescriptor::CPPTYPE_ENUM: {
+    bool Quoted = peek() == '"';
+    if (!ReadScalar())
+      return false;
+    int V;
+    if (const EnumValueDescriptor* E =
+            Quoted ? F->enum_type()->FindValueByName(Token) : nullptr)
+      V = E->number();
+    else if (!parseInteger(Token, V))
+      return Invalid();
+    Repeated ? R->AddEnumValue(&M, F, V) : R->SetEnumValue(&M, F, V);
+    return true;
+  }
+  case FieldDescriptor::CPPTYPE_INT32: {
+    int32_t V;
+    if (!ReadScalar())
+      return false;
+    if (!parseInteger(Token, V))
+      return Invalid();
+    Repeated ? R->AddInt32(&M, F, V) : R->SetInt32(&M, F, V);
+    return true;
+  }
+  case FieldDescriptor::CPPTYPE_INT64: {
+    int64_t V;
+    if (!ReadScalar())
+      return false;
+    if (!parseInteger(Token, V))
+      return Invalid();
+    Repeated ? R->AddInt64(&M, F, V) : R->SetInt64(&M, F, V);
+    return true;
+  }
+  case FieldDescriptor::CPPTYPE_UINT32: {
+    uint32_t V;
+    if (!ReadScalar())
+      return false;
+    if (!parseInteger(Token, V))
+      return Invalid();
+    Repeated ? R->AddUInt32(&M, F, V) : R->SetUInt32(&M, F, V);
+    return true;
+  }
+  case FieldDescriptor::CPPTYPE_UINT64: {
+    uint64_t V;
+    if (!ReadScalar())
+      return false;
+    if (!parseInteger(Token, V))
+      return Invalid();
+    Repeated ? R->AddUInt64(&M, F, V) : R->SetUInt64(&M, F, V);
+    return true;
+  }
+  case FieldDescriptor::CPPTYPE_DOUBLE:
+  case FieldDescriptor::CPPTYPE_FLOAT: {
+    if (!ReadScalar())
+      return false;
+    double V;
+    if (Token == "NaN") {
+      V = std::numeric_limits<double>::quiet_NaN();
+    } else if (Token == "Infinity" || Token == "-Infinity") {
+      V = Token[0] == '-' ? -std::numeric_limits<double>::infinity()
+                          : std::numeric_limits<double>::infinity();
+    } else {
+      char* End;
+      V = std::strtod(Token.c_str(), &End);
+      if (Token.empty() || End != Token.c_str() + Token.size())
+        return Invalid();
+    }
+    if (F->cpp_type() == FieldDescriptor::CPPTYPE_DOUBLE)
+      Repeated ? R->AddDouble(&M, F, V) : R->SetDouble(&M, F, V);
+    else
+      Repeated ? R->AddFloat(&M, F, static_cast<float>(V))
+               : R->SetFloat(&M, F, static_cast<float>(V));
+    return true;
+  }
+  }
+  return Invalid();
+}
@@ -0,0 +1,140 @@
+//===- JsonStream.hpp -------------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#ifndef GTIRB_JSON_STREAM_HPP
+#define GTIRB_JSON_STREAM_HPP
+
+#include <climits>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace google {
+namespace protobuf {
+class Descriptor;
+class FieldDescriptor;
+class Message;
+} // namespace protobuf
+} // namespace google
+
+namespace gtirb {
+
+/// @cond INTERNAL
+// Writes protobuf messages as JSON, field by field, producing the same text
+// as google::protobuf::util::MessageToJsonString with its default options
+// when serialization is deterministic, which orders map entries by key.
+// Callers can interleave fields they write themselves, so that large repeated
+// fields can be produced one element at a time.
+class JsonWriter {
+public:
+  explicit JsonWriter(std::ostream& Out_) : Out(Out_) {}
+
+  void beginObject();
+  void endObject();
+  void beginArray();
+  void endArray();
+
+  // Writes the key of the next member of the current object.
+  void key(const std::string& Name);
+
+  // Writes the set fields of a message whose numbers are in [Lo, Hi), in
+  // order of field number.
+  void writeFields(const google::protobuf::Message& M, int Lo = 0,
+                   int Hi = INT_MAX);
+
+  // Writes a message as an object.
+  void writeMessage(const google::protobuf::Message& M);
+
+private:
+  void beginValue();
+  void writeString(const std::string& S);
+  void writeValue(const google::protobuf::Message& M,
+                  const google::protobuf::FieldDescriptor* F, int Index);
+  void writeMapKey(const google::protobuf::Message& Entry,
+                   const google::protobuf::FieldDescriptor* F);
+  const std::vector<const google::protobuf::FieldDescriptor*>&
+  fieldsByNumber(const google::protobuf::Descriptor* D);
+
+  std::ostream& Out;
+  std::unordered_map<const google::protobuf::Descriptor*,
+                     std::vector<const google::protobuf::FieldDescriptor*>>
+      FieldOrder;
+  // For each open object or array, whether a member has been written.
+  std::vector<bool> HaveMember;
+  bool AfterKey = false;
+};
+
+// Reads JSON text into protobuf messages, following the rules of
+// google::protobuf::util::JsonStringToMessage with its default options. The
+// text is read from the stream as it is parsed, so callers can process a
+// large array one element at a time.
+class JsonReader {
+public:
+  explicit JsonReader(std::istream& In_) : In(In_) {}
+
+  // Reads the start of an object.
+  bool beginObject();
+
+  // Reads the key of the next member of the current object. Returns false at
+  // the end of the object or on an error.
+  bool nextKey(std::string& Key);
+
+  // Reads the start of an array, or null, which is read as an empty array.
+  bool beginArray();
+
+  // Positions the reader at the next element of the current array. Returns
+  // false at the end of the array or on an error.
+  bool nextElement();
+
+  // Reads the value of the field of M with the given JSON or proto name.
+  bool readField(google::protobuf::Message& M, const std::string& Name);
+
+  // Reads an object into a message.
+  bool readMessage(google::protobuf::Message& M);
+
+  // Whether the rest of the stream holds only whitespace.
+  bool atEnd();
+
+  bool failed() const { return !Error.empty(); }
+  const std::string& error() const { return Error; }
+
+private:
+  int peek();
+  int get();
+  void skipWhitespace();
+  bool expect(char C);
+  bool fail(const std::string& Msg);
+  bool readNull();
+  bool readString(std::string& S);
+  bool readToken(std::string& Token);
+  bool readValue(google::protobuf::Message& M,
+                 const google::protobuf::FieldDescriptor* F, bool Repeated);
+  bool readMapEntry(google::protobuf::Message& M,
+                    const google::protobuf::FieldDescriptor* F,
+                    const std::string& Key);
+
+  std::istream& In;
+  std::string Error;
+  // The state of each open object or array.
+  enum class Nesting : uint8_t { Empty, NonEmpty, Null };
+  std::vector<Nesting> Open;
+  uint64_t Offset = 0;
+};
+/// @endcond
+
+} // namespace gtirb
+
+#endif // GTIRB_JSON_STREAM_HPP
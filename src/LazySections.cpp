@@ -0,0 +1,231 @@
+//===- LazySections.cpp -----------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#include "LazySections.hpp"
+#include "NodeIndex.hpp"
+#include "Serialization.hpp"
+#include <gtirb/IR.hpp>
+#include <gtirb/Module.hpp>
+#include <algorithm>
+
+using namespace gtirb;
+
+namespace bip = boost::interprocess;
+
+ErrorOr<ContainerFrames> ContainerFrames::open(std::istream& In) {
+  std::streamoff Start = In.tellg();
+  ErrorOr<uint8_t> Format = readContainerHeader(In);
+  if (!Format)
+    return Format.getError();
+  if (*Format == MonolithicContainerFormat)
+    return {IR::load_error::CorruptFile,
+            "Sections can only be loaded from an indexed container"};
+  std::optional<ContainerIndexReader> Reader =
+      ContainerIndexReader::open(In, Start, *Format);
+  if (!Reader)
+    return {IR::load_error::CorruptFile,
+            "Container table of contents unable to be read"};
+  return ContainerFrames(std::move(*Reader));
+}
+
+ErrorOr<const proto::IR*> ContainerFrames::irMessage() {
+  if (IRMessage)
+    return &*IRMessage;
+  // The IR frame holds the CFG and the table of nodes to which the modules
+  // refer by index.
+  proto::IR Message;
+  auto Entry = std::find_if(entries().begin(), entries().end(),
+                            [](const ContainerIndexEntry& E) {
+                              return E.Kind == ContainerFrameKind::IR;
+                            });
+  if (Entry != entries().end() && !readFrame(*Entry, Message))
+    return {IR::load_error::CorruptFile, "Cannot reload IR"};
+  if (!unindexReferences(*Message.mutable_cfg(), Message.node_uuids()))
+    return IR::load_error::CorruptCFG;
+  const auto& Edges = Message.cfg().edges();
+  for (int I = 0; I < Edges.size(); ++I) {
+    BlockEdges[Edges[I].source_uuid()].push_back(I);
+    if (Edges[I].target_uuid() != Edges[I].source_uuid())
+      BlockEdges[Edges[I].target_uuid()].push_back(I);
+  }
+  return &IRMessage.emplace(std::move(Message));
+}
+
+ErrorOr<ContainerFrames::ModuleFrame*>
+ContainerFrames::moduleFrame(const UUID& Id) {
+  if (auto It = ModuleFrames.find(Id); It != ModuleFrames.end())
+    return &It->second;
+  auto Entry = std::find_if(entries().begin(), entries().end(),
+                            [&Id](const ContainerIndexEntry& E) {
+                              return E.Kind == ContainerFrameKind::Module &&
+                                     E.Id == Id;
+                            });
+  if (Entry == entries().end())
+    return nullptr;
+  ErrorOr<const proto::IR*> IRFrame = irMessage();
+  if (!IRFrame)
+    return IRFrame.getError();
+  ModuleFrame Frame;
+  if (!readFrame(*Entry, Frame.Message) ||
+      !unindexReferences(Frame.Message, (*IRFrame)->node_uuids()))
+    return {IR::load_error::CorruptModule,
+            "Cannot reload module " + Entry->Name};
+  const auto& Symbols = Frame.Message.symbols();
+  for (int I = 0; I < Symbols.size(); ++I) {
+    UUID Referent;
+    if (Symbols[I].optional_payload_case() ==
+            proto::Symbol::kReferentUuid &&
+        uuidFromBytes(Symbols[I].referent_uuid(), Referent))
+      Frame.Referents[Referent].push_back(I);
+  }
+  return &ModuleFrames.emplace(Id, std::move(Frame)).first->second;
+}
+
+const std::vector<size_t>&
+ContainerFrames::sectionEntries(const UUID& ModuleId,
+                                const std::string& Name) {
+  if (!SectionsIndexed) {
+    for (size_t I = 0; I < entries().size(); ++I) {
+      const ContainerIndexEntry& E = entries()[I];
+      if (E.Kind == ContainerFrameKind::Section)
+        SectionEntries[{E.Parent, E.Name}].push_back(I);
+    }
+    SectionsIndexed = true;
+  }
+  static const std::vector<size_t> None;
+  auto It = SectionEntries.find({ModuleId, Name});
+  return It != SectionEntries.end() ? It->second : None;
+}
+
+ErrorOr<proto::CFG>
+ContainerFrames::edgesOf(const std::unordered_set<std::string>& Blocks) {
+  ErrorOr<const proto::IR*> IRFrame = irMessage();
+  if (!IRFrame)
+    return IRFrame.getError();
+  // An edge between two of the blocks is listed for both.
+  std::vector<int> Indexes;
+  for (const std::string& Id : Blocks)
+    if (auto It = BlockEdges.find(Id); It != BlockEdges.end())
+      Indexes.insert(Indexes.end(), It->second.begin(), It->second.end());
+  std::sort(Indexes.begin(), Indexes.end());
+  Indexes.erase(std::unique(Indexes.begin(), Indexes.end()), Indexes.end());
+  proto::CFG Edges;
+  for (int I : Indexes)
+    *Edges.add_edges() = (*IRFrame)->cfg().edges(I);
+  return Edges;
+}
+
+thread_local bool LazySections::Loading = false;
+
+std::shared_ptr<LazySections> LazySections::open(Context& C,
+                                                 const std::string& Path) {
+  std::shared_ptr<LazySections> Result(new LazySections(C));
+  try {
+    Result->File = bip::file_mapping(Path.c_str(), bip::read_only);
+    Result->Region = bip::mapped_region(Result->File, bip::read_only);
+  } catch (const bip::interprocess_exception&) {
+    return nullptr;
+  }
+  Result->Stream.buffer(Result->data(), Result->size());
+  return Result;
+}
+
+void LazySections::install() {
+  // An earlier lazily loaded IR in the same Context keeps its handler.
+  std::weak_ptr<LazySections> Weak = shared_from_this();
+  C.MissingNodeHandler = [Weak, Previous = std::move(C.MissingNodeHandler)](
+                             const UUID& Id) -> Node* {
+    if (auto Self = Weak.lock())
+      if (Node* N = Self->find(Id))
+        return N;
+    return Previous ? Previous(Id) : nullptr;
+  };
+}
+
+void LazySections::addPending(Module* M, const ContainerIndexEntry& Entry) {
+  size_t Index = Pending.size();
+  Pending.push_back({M, Entry.Name, false});
+  NodeSections.emplace(Entry.Id, Index);
+  for (const UUID& Id : Entry.Nodes)
+    NodeSections.emplace(Id, Index);
+}
+
+Node* LazySections::findExisting(const UUID& Id) const {
+  auto It = C.UuidMap.find(Id);
+  return It != C.UuidMap.end() ? It->second : nullptr;
+}
+
+ErrorInfo LazySections::load(Module* M, const std::string& Name) {
+  // Module::loadSection reads every section of the module with the name. A
+  // section that cannot be read stays pending, so that the error is reported
+  // again by IR::loadPendingSections rather than the section going missing.
+  std::vector<PendingSection*> Wanted;
+  for (PendingSection& P : Pending)
+    if (!P.Read && P.M == M && P.Name == Name)
+      Wanted.push_back(&P);
+  if (Wanted.empty() || !Frames)
+    return {};
+  Loading = true;
+  ErrorOr<Section*> Loaded = M->loadSection(C, *Frames, Name);
+  Loading = false;
+  if (!Loaded)
+    return Loaded.getError();
+  for (PendingSection* P : Wanted)
+    P->Read = true;
+  return {};
+}
+
+void LazySections::materialize(const Module* M, const std::string& Name) {
+  if (Loading)
+    return;
+  std::lock_guard<std::mutex> Lock(Mutex);
+  auto It = std::find_if(Pending.begin(), Pending.end(),
+                         [M, &Name](const PendingSection& P) {
+                           return !P.Read && P.M == M && P.Name == Name;
+                         });
+  if (It != Pending.end())
+    (void)load(It->M, Name);
+}
+
+ErrorInfo LazySections::materializeAll(const Module* M, bool& AllRead) {
+  AllRead = false;
+  if (Loading)
+    return {};
+  std::lock_guard<std::mutex> Lock(Mutex);
+  ErrorInfo Result;
+  AllRead = true;
+  for (PendingSection& P : Pending) {
+    if (P.Read || P.M != M)
+      continue;
+    ErrorInfo Error = load(P.M, P.Name);
+    if (!P.Read)
+      AllRead = false;
+    if (Error.ErrorCode && !Result.ErrorCode)
+      Result = std::move(Error);
+  }
+  return Result;
+}
+
+Node* LazySections::find(const UUID& Id) {
+  if (Loading)
+    return nullptr;
+  std::lock_guard<std::mutex> Lock(Mutex);
+  auto It = NodeSections.find(Id);
+  if (It == NodeSections.end())
+    return nullptr;
+  const PendingSection& P = Pending[It->second];
+  if (!P.Read)
+    (void)load(P.M, P.Name);
+  return findExisting(Id);
+}
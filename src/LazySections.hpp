@@ -0,0 +1,194 @@
+//===- LazySections.hpp -----------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#ifndef GTIRB_LAZY_SECTIONS_HPP
+#define GTIRB_LAZY_SECTIONS_HPP
+
+#include "ContainerIndex.hpp"
+#include <gtirb/Context.hpp>
+#include <gtirb/ErrorOr.hpp>
+#include <gtirb/proto/IR.pb.h>
+#include <boost/functional/hash.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/interprocess/streams/bufferstream.hpp>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace gtirb {
+class Module;
+class Symbol;
+
+/// @cond INTERNAL
+/// \brief The frames of an indexed container from which sections are read.
+///
+/// The IR frame and the frame of each module are parsed the first time they
+/// are needed and kept, so that reading the sections of a module one at a
+/// time does not parse them again.
+class ContainerFrames {
+public:
+  /// \brief Read the header and the table of contents of the container at
+  /// the position of a seekable stream, which must outlive the result.
+  static ErrorOr<ContainerFrames> open(std::istream& In);
+
+  const std::vector<ContainerIndexEntry>& entries() const {
+    return Reader.entries();
+  }
+
+  bool readFrame(const ContainerIndexEntry& Entry,
+                 google::protobuf::MessageLite& Message) const {
+    return Reader.readFrame(Entry, Message);
+  }
+
+  /// \brief The frame of a module, with the indexes into its symbols that
+  /// sections read from the container need.
+  struct ModuleFrame {
+    /// The message of the module, with its references to nodes resolved.
+    proto::Module Message;
+    /// The symbols of the message in order, once \ref SymbolsResolved.
+    std::vector<Symbol*> Symbols;
+    bool SymbolsResolved{false};
+    /// The indexes of the symbols of the message that refer to each node.
+    std::unordered_map<UUID, std::vector<int>, boost::hash<UUID>> Referents;
+  };
+
+  /// \brief Return the frame of the module with a UUID, or null if the
+  /// container has no such module.
+  ErrorOr<ModuleFrame*> moduleFrame(const UUID& Id);
+
+  /// \brief Return the indexes of the entries of the sections of a module
+  /// with a name.
+  const std::vector<size_t>& sectionEntries(const UUID& ModuleId,
+                                            const std::string& Name);
+
+  /// \brief Return the CFG edges from or to any of the given blocks,
+  /// identified by the bytes of their UUIDs.
+  ErrorOr<proto::CFG> edgesOf(const std::unordered_set<std::string>& Blocks);
+
+private:
+  explicit ContainerFrames(ContainerIndexReader Reader_)
+      : Reader(std::move(Reader_)) {}
+
+  // Parses the IR frame, resolving the references of its CFG.
+  ErrorOr<const proto::IR*> irMessage();
+
+  ContainerIndexReader Reader;
+  std::optional<proto::IR> IRMessage;
+  std::map<UUID, ModuleFrame> ModuleFrames;
+  // The indexes of the entries of the sections of each module, by name.
+  std::map<std::pair<UUID, std::string>, std::vector<size_t>> SectionEntries;
+  bool SectionsIndexed{false};
+  // The indexes of the CFG edges from or to each block.
+  std::unordered_map<std::string, std::vector<int>> BlockEdges;
+};
+
+/// \brief The sections of an IR loaded by IR::loadLazily that have not been
+/// materialized yet, and the mapped file from which to read them.
+///
+/// The pending sections and the parsed frames are guarded by a mutex, as the
+/// Context that looks nodes up through them may be shared by IRs used on
+/// other threads. Materializing a section changes its module, which must
+/// not be in use by other threads meanwhile.
+class LazySections : public std::enable_shared_from_this<LazySections> {
+public:
+  /// \brief Map a file into memory.
+  ///
+  /// \return The sections of the file, none of them pending yet, or null if
+  /// the file cannot be mapped.
+  static std::shared_ptr<LazySections> open(Context& C,
+                                            const std::string& Path);
+
+  /// \brief Return the contents of the file.
+  const char* data() const {
+    return static_cast<const char*>(Region.get_address());
+  }
+
+  /// \brief Return the size of the file.
+  size_t size() const { return Region.get_size(); }
+
+  /// \brief Return a stream over the contents of the file.
+  std::istream& stream() { return Stream; }
+
+  /// \brief Keep the frames of the file from which sections are read.
+  void setFrames(ContainerFrames F) { Frames.emplace(std::move(F)); }
+
+  /// \brief Have lookups by UUID in the Context of a node that does not
+  /// exist yet materialize the pending sections.
+  void install();
+
+  /// \brief Record a section of a module that is yet to be materialized,
+  /// and the nodes that it holds.
+  void addPending(Module* M, const ContainerIndexEntry& Entry);
+
+  /// \brief Materialize the pending sections of a module with a given name.
+  ///
+  /// Sections that cannot be read stay pending, and their error is reported
+  /// by a later \ref materializeAll.
+  void materialize(const Module* M, const std::string& Name);
+
+  /// \brief Materialize all the pending sections of a module.
+  ///
+  /// \param M       The module.
+  /// \param AllRead Set to whether none of the module's sections are still
+  ///                pending afterwards.
+  ///
+  /// \return The error of the first section that could not be read, if any.
+  ErrorInfo materializeAll(const Module* M, bool& AllRead);
+
+  /// \brief Materialize the pending section that holds the node with the
+  /// given UUID, if there is one.
+  ///
+  /// \return The node with the UUID, or null if there is none.
+  Node* find(const UUID& Id);
+
+private:
+  explicit LazySections(Context& C_) : C(C_) {}
+
+  // Reads the sections of a module with a name, leaving them pending if
+  // they cannot be read. The mutex must be held.
+  ErrorInfo load(Module* M, const std::string& Name);
+
+  // Looks up a node without materializing anything.
+  Node* findExisting(const UUID& Id) const;
+
+  struct PendingSection {
+    Module* M;
+    std::string Name;
+    bool Read;
+  };
+
+  Context& C;
+  boost::interprocess::file_mapping File;
+  boost::interprocess::mapped_region Region;
+  boost::interprocess::ibufferstream Stream;
+  std::optional<ContainerFrames> Frames;
+  std::mutex Mutex;
+  std::vector<PendingSection> Pending;
+  // The pending section that holds each section, byte interval and block.
+  std::unordered_map<UUID, size_t, boost::hash<UUID>> NodeSections;
+  // Set while any section is read, as reading it looks up nodes that are not
+  // expected to exist.
+  static thread_local bool Loading;
+};
+/// @endcond
+
+} // namespace gtirb
+
+#endif // GTIRB_LAZY_SECTIONS_HPP
@@ -13,13 +13,20 @@
 //
 //===----------------------------------------------------------------------===//
 #include "Module.hpp"
+#include "AddressResolution.hpp"
+#include "CFGSerialization.hpp"
+#include "ContainerIndex.hpp"
+#include "LazySections.hpp"
+#include "NodeIndex.hpp"
 #include "Serialization.hpp"
 #include <gtirb/CFG.hpp>
 #include <gtirb/CodeBlock.hpp>
 #include <gtirb/IR.hpp>
 #include <gtirb/SymbolicExpression.hpp>
+#include <gtirb/proto/IR.pb.h>
 #include <array>
 #include <map>
+#include <unordered_set>
 
 using namespace gtirb;
 
@@ -79,7 +86,8 @@ Module::Module(Context& C, const std::string& N, const UUID& U)
       SecObs(std::make_unique<SectionObserverImpl>(this)),
       SymObs(std::make_unique<SymbolObserverImpl>(this)) {}
 
-void Module::toProtobuf(MessageType* Message) const {
+void Module::toProtobuf(MessageType* Message, bool WithSections) const {
+  materializeSections();
   nodeUUIDToBytes(this, *Message->mutable_uuid());
   Message->set_binary_path(this->BinaryPath);
   Message->set_preferred_addr(static_cast<uint64_t>(this->PreferredAddr));
@@ -89,8 +97,9 @@ void Module::toProtobuf(MessageType* Message) const {
   Message->set_name(this->Name);
   sequenceToProtobuf(ProxyBlocks.begin(), ProxyBlocks.end(),
                      Message->mutable_proxies());
-  sequenceToProtobuf(sections_begin(), sections_end(),
-                     Message->mutable_sections());
+  if (WithSections)
+    sequenceToProtobuf(sections_begin(), sections_end(),
+                       Message->mutable_sections());
   containerToProtobuf(Symbols, Message->mutable_symbols());
   if (EntryPoint) {
     nodeUUIDToBytes(EntryPoint, *Message->mutable_entry_point());
@@ -113,7 +122,8 @@ static void nodeMapFromProtobuf(Context& C, std::map<T, U*>& Values,
   });
 }
 
-ErrorOr<Module*> Module::fromProtobuf(Context& C, const MessageType& Message) {
+ErrorOr<Module*> Module::fromProtobuf(Context& C, const MessageType& Message,
+                                      NodeIndexTable* Nodes) {
   UUID Id;
   if (!uuidFromBytes(Message.uuid(), Id))
     return {IR::load_error::BadUUID, "Cannot load module"};
@@ -143,13 +153,19 @@ ErrorOr<Module*> Module::fromProtobuf(Context& C, const MessageType& Message) {
     }
     M->addSection(*S);
   }
+  std::vector<Symbol*> SymbolTable;
+  SymbolTable.reserve(Message.symbols_size());
   for (const auto& Elt : Message.symbols()) {
     auto S = Symbol::fromProtobuf(C, Elt);
     if (!S) {
       Problem.Msg += "\n" + S.getError().message();
       return Problem;
     }
+    if (Nodes && Elt.optional_payload_case() == proto::Symbol::kReferentIndex)
+      if (Node* N = Nodes->get(Elt.referent_index()))
+        (*S)->Payload = N;
     M->addSymbol(*S);
+    SymbolTable.push_back(*S);
   }
   for (const auto& ProtoS : Message.sections()) {
     for (const auto& ProtoBI : ProtoS.byte_intervals()) {
@@ -164,7 +180,7 @@ ErrorOr<Module*> Module::fromProtobuf(Context& C, const MessageType& Message) {
                        ProtoS.name();
         return Problem;
       }
-      if (!BI->symbolicExpressionsFromProtobuf(C, ProtoBI)) {
+      if (!BI->symbolicExpressionsFromProtobuf(C, ProtoBI, SymbolTable)) {
         std::stringstream msg{
             "Could not deserialize symbolic expression in ByteInterval"};
         if (auto Addr = BI->getAddress())
@@ -186,14 +202,159 @@ ErrorOr<Module*> Module::fromProtobuf(Context& C, const MessageType& Message) {
       Problem.Msg += "\nCould not find entry point";
       return Problem;
     }
+  } else if (uint32_t Entry = Message.entry_point_index()) {
+    M->EntryPoint =
+        Nodes ? dyn_cast_or_null<CodeBlock>(Nodes->get(Entry - 1)) : nullptr;
+    if (!M->EntryPoint) {
+      Problem.Msg += "\nCould not find entry point";
+      return Problem;
+    }
   }
   M->ByteOrder = static_cast<gtirb::ByteOrder>(Message.byte_order());
   static_cast<AuxDataContainer*>(M)->fromProtobuf(Message);
   return M;
 }
 
+ErrorOr<Section*> Module::loadSection(Context& C, std::istream& In,
+                                      const std::string& SectionName) {
+  if (auto Found = findSections(SectionName); !Found.empty())
+    return &Found.front();
+  ErrorOr<ContainerFrames> Frames = ContainerFrames::open(In);
+  if (!Frames)
+    return Frames.getError();
+  return loadSection(C, *Frames, SectionName);
+}
+
+ErrorOr<Section*> Module::loadSection(Context& C, ContainerFrames& Frames,
+                                      const std::string& SectionName) {
+  if (isFrozen())
+    return {IR::load_error::FrozenIR,
+            "Cannot load section " + SectionName + " into a frozen IR"};
+  ErrorInfo Problem{IR::load_error::CorruptSection,
+                    "Cannot load section " + SectionName};
+  // Packed symbolic expressions refer to symbols by their index in the
+  // module message. The symbols are resolved once per container.
+  ErrorOr<ContainerFrames::ModuleFrame*> Frame =
+      Frames.moduleFrame(getUUID());
+  if (!Frame)
+    return Frame.getError();
+  static const std::vector<Symbol*> NoSymbols;
+  if (*Frame && !(*Frame)->SymbolsResolved) {
+    for (const auto& ProtoS : (*Frame)->Message.symbols()) {
+      UUID Id;
+      (*Frame)->Symbols.push_back(
+          uuidFromBytes(ProtoS.uuid(), Id)
+              ? dyn_cast_or_null<Symbol>(getByUUID(C, Id))
+              : nullptr);
+    }
+    (*Frame)->SymbolsResolved = true;
+  }
+  const std::vector<Symbol*>& SymbolTable =
+      *Frame ? (*Frame)->Symbols : NoSymbols;
+
+  Section* First = nullptr;
+  std::unordered_set<std::string> NewBlocks;
+  std::vector<const ContainerIndexEntry*> Loaded;
+  for (size_t I : Frames.sectionEntries(getUUID(), SectionName)) {
+    const ContainerIndexEntry& E = Frames.entries()[I];
+    if (getByUUID(C, E.Id))
+      continue;
+
+    proto::Section Message;
+    if (!Frames.readFrame(E, Message))
+      return Problem;
+    auto S = Section::fromProtobuf(C, Message);
+    if (!S) {
+      Problem.Msg += "\n" + S.getError().message();
+      return Problem;
+    }
+    addSection(*S);
+    for (const auto& ProtoBI : Message.byte_intervals()) {
+      UUID Id;
+      auto* BI = uuidFromBytes(ProtoBI.uuid(), Id)
+                     ? dyn_cast_or_null<ByteInterval>(getByUUID(C, Id))
+                     : nullptr;
+      if (!BI ||
+          !BI->symbolicExpressionsFromProtobuf(C, ProtoBI, SymbolTable)) {
+        Problem.Msg += "\nCould not load byte interval";
+        return Problem;
+      }
+      for (const auto& Block : ProtoBI.blocks())
+        if (Block.has_code())
+          NewBlocks.insert(Block.code().uuid());
+    }
+    Loaded.push_back(&E);
+    if (!First)
+      First = *S;
+  }
+  if (!First)
+    return {IR::load_error::CorruptSection, "No section named " + SectionName};
+
+  // Symbols and the entry point that refer to the new nodes were left
+  // unresolved when the module was loaded. The table of contents lists the
+  // nodes of each section, so only the symbols referring to them are looked
+  // at.
+  if (*Frame) {
+    auto Resolve = [&](const UUID& Id) {
+      auto It = (*Frame)->Referents.find(Id);
+      if (It == (*Frame)->Referents.end())
+        return;
+      Node* N = getByUUID(C, Id);
+      for (int Index : It->second) {
+        Symbol* S = SymbolTable[Index];
+        if (N && S && S->getModule() == this && !S->hasReferent())
+          S->setReferentFromNode(N);
+      }
+    };
+    for (const ContainerIndexEntry* E : Loaded) {
+      Resolve(E->Id);
+      for (const UUID& Id : E->Nodes)
+        Resolve(Id);
+    }
+    UUID Id;
+    if (!EntryPoint && uuidFromBytes((*Frame)->Message.entry_point(), Id))
+      EntryPoint = dyn_cast_or_null<CodeBlock>(getByUUID(C, Id));
+  }
+
+  // Restore the CFG edges of the new blocks. The blocks themselves were
+  // added to the CFG by addSection.
+  if (IR* I = getIR(); I && !NewBlocks.empty()) {
+    ErrorOr<proto::CFG> Edges = Frames.edgesOf(NewBlocks);
+    if (!Edges)
+      return Edges.getError();
+    if (!gtirb::fromProtobuf(C, I->getCFG(), *Edges))
+      return IR::load_error::CorruptCFG;
+  }
+  return First;
+}
+
+void Module::materializeSections(const std::string& SectionName) const {
+  Lazy->materialize(this, SectionName);
+}
+
+void Module::materializeSections() const {
+  (void)materializePendingSections();
+}
+
+ErrorInfo Module::materializePendingSections() const {
+  if (!Lazy)
+    return {};
+  bool AllRead;
+  ErrorInfo Result = Lazy->materializeAll(this, AllRead);
+  if (AllRead)
+    Lazy.reset();
+  return Result;
+}
+
+bool Module::isFrozen() const { return Parent && Parent->isFrozen(); }
+
 ChangeStatus Module::removeProxyBlock(ProxyBlock* B) {
-  if (auto It = ProxyBlocks.find(B); It != ProxyBlocks.end()) {
+  if (isFrozen())
+    return ChangeStatus::Rejected;
+
+  if (auto PosIt = ProxyBlockPositions.find(B);
+      PosIt != ProxyBlockPositions.end()) {
+    auto It = ProxyBlocks.begin() + PosIt->second;
     if (Observer) {
       auto BlockRange = boost::make_iterator_range(It, std::next(It));
       [[maybe_unused]] ChangeStatus status =
@@ -205,7 +366,12 @@ ChangeStatus Module::removeProxyBlock(ProxyBlock* B) {
       assert(status != ChangeStatus::Rejected &&
              "recovering from rejected removal is unimplemented");
     }
-    ProxyBlocks.erase(It);
+    if (std::next(It) != ProxyBlocks.end()) {
+      *It = ProxyBlocks.back();
+      ProxyBlockPositions[*It] = PosIt->second;
+    }
+    ProxyBlocks.pop_back();
+    ProxyBlockPositions.erase(PosIt);
     B->setModule(nullptr);
     return ChangeStatus::Accepted;
   }
@@ -213,6 +379,9 @@ ChangeStatus Module::removeProxyBlock(ProxyBlock* B) {
 }
 
 ChangeStatus Module::addProxyBlock(ProxyBlock* B) {
+  if (isFrozen() || (B->getModule() && B->getModule()->isFrozen()))
+    return ChangeStatus::Rejected;
+
   if (Module* M = B->getModule()) {
     if (M == this)
       return ChangeStatus::NoChange;
@@ -222,7 +391,11 @@ ChangeStatus Module::addProxyBlock(ProxyBlock* B) {
   }
 
   B->setModule(this);
-  auto [It, Inserted] = ProxyBlocks.insert(B);
+  auto [PosIt, Inserted] =
+      ProxyBlockPositions.emplace(B, ProxyBlocks.size());
+  if (Inserted)
+    ProxyBlocks.push_back(B);
+  auto It = ProxyBlocks.begin() + PosIt->second;
   if (Inserted && Observer) {
     auto BlockRange = boost::make_iterator_range(It, std::next(It));
     [[maybe_unused]] ChangeStatus status =
@@ -254,6 +427,9 @@ Module* Module::load(Context& C, std::istream& In) {
 }
 
 ChangeStatus Module::removeSection(Section* S) {
+  if (isFrozen())
+    return ChangeStatus::Rejected;
+
   auto& Index = Sections.get<by_pointer>();
   if (auto Iter = Index.find(S); Iter != Index.end()) {
     if (Observer) {
@@ -278,6 +454,9 @@ ChangeStatus Module::removeSection(Section* S) {
 }
 
 ChangeStatus Module::addSection(Section* S) {
+  if (isFrozen() || S->isFrozen())
+    return ChangeStatus::Rejected;
+
   if (Module* M = S->getModule()) {
     if (M == this)
       return ChangeStatus::NoChange;
@@ -320,6 +499,53 @@ void Module::insertSectionAddrs(Section* S) {
   }
 }
 
+void Module::resolveAddresses(const Addr* Addrs, size_t Count,
+                              const CodeBlock** Out,
+                              unsigned NumThreads) const {
+  if (FrozenCodeBlocks) {
+    resolveCodeBlockAddresses(*FrozenCodeBlocks, Addrs, Count, Out,
+                              NumThreads);
+    return;
+  }
+  std::vector<CodeBlockExtent> Extents;
+  appendCodeBlockExtents(code_blocks(), Extents);
+  resolveCodeBlockAddresses(Extents, Addrs, Count, Out, NumThreads);
+}
+
+void Module::freeze() {
+  // Sections are visited in the same order as the interval map's sets hold
+  // them, so queries yield the same sections in the same order.
+  FrozenSectionAddrs = std::make_unique<SectionIndex>();
+  FrozenSectionAddrs->invalidate();
+  FrozenSectionAddrs->ensure([this](auto Add) {
+    for (Section* S : Sections)
+      if (std::optional<AddrRange> Extent = addressRange(*S);
+          Extent && Extent->size() != 0)
+        Add(Extent->lower(), Extent->upper(), S);
+  });
+  FrozenSectionAddrs->shrink_to_fit();
+  SectionAddrs.clear();
+
+  for (Section& S : sections())
+    S.freeze();
+  for (ByteInterval& BI : byte_intervals())
+    BI.freeze();
+
+  auto Extents = std::make_shared<std::vector<CodeBlockExtent>>();
+  appendCodeBlockExtents(code_blocks(), *Extents);
+  Extents->shrink_to_fit();
+  FrozenCodeBlocks = std::move(Extents);
+}
+
+void Module::thaw() {
+  FrozenCodeBlocks.reset();
+  for (ByteInterval& BI : byte_intervals())
+    BI.thaw();
+  FrozenSectionAddrs.reset();
+  for (Section* S : Sections)
+    insertSectionAddrs(S);
+}
+
 static auto NoOp = [](auto*) {};
 
 ChangeStatus
@@ -458,6 +684,8 @@ ChangeStatus Module::SectionObserverImpl::changeExtent(
 ChangeStatus Module::SymbolObserverImpl::nameChange(Symbol* S,
                                                     const std::string&,
                                                     const std::string&) {
+  if (M->isFrozen())
+    return ChangeStatus::Rejected;
   auto& Index = M->Symbols.get<by_pointer>();
   auto It = Index.find(S);
   assert(It != Index.end() && "symbol observed by non-owner");
@@ -471,6 +699,8 @@ ChangeStatus Module::SymbolObserverImpl::nameChange(Symbol* S,
 ChangeStatus Module::SymbolObserverImpl::referentChange(
     Symbol* S, std::variant<std::monostate, Addr, Node*>,
     std::variant<std::monostate, Addr, Node*>) {
+  if (M->isFrozen())
+    return ChangeStatus::Rejected;
   auto& Index = M->Symbols.get<by_pointer>();
   auto It = Index.find(S);
   assert(It != Index.end() && "symbol observed by non-owner");
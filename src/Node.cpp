@@ -21,7 +21,9 @@ using namespace gtirb;
 // TODO: accessing this object between threads requires synchronization.
 static boost::uuids::random_generator UUIDGenerator;
 
-Node::Node(Context& C, Kind Knd, const UUID& U) : K(Knd), Uuid(U), Ctx(&C) {
+Node::Node(Context& C, Kind Knd, const UUID& U)
+    : K(Knd), Uuid(U), Ctx(&C),
+      ContextIndex(C.assignNodeIndex(static_cast<size_t>(Knd))) {
   Ctx->registerNode(Uuid, this);
 }
 
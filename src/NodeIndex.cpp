@@ -0,0 +1,132 @@
+//===- NodeIndex.cpp --------------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#include "NodeIndex.hpp"
+#include "Serialization.hpp"
+#include <gtirb/Context.hpp>
+#include <gtirb/proto/IR.pb.h>
+
+using namespace gtirb;
+
+uint32_t NodeIndexer::indexOf(const std::string& Id) {
+  auto [It, Inserted] = Indexes.try_emplace(Id, Ids.size());
+  if (Inserted)
+    *Ids.Add() = Id;
+  return It->second;
+}
+
+void NodeIndexer::indexReferences(proto::CFG& Message) {
+  for (const std::string& V : Message.vertices())
+    Message.add_vertex_indexes(indexOf(V));
+  for (const proto::Edge& E : Message.edges()) {
+    Message.add_edge_sources(indexOf(E.source_uuid()));
+    Message.add_edge_targets(indexOf(E.target_uuid()));
+    Message.add_edge_labels(E.has_label() ? packEdgeLabel(E.label()) : 0);
+  }
+  Message.clear_vertices();
+  Message.clear_edges();
+}
+
+void NodeIndexer::indexReferences(proto::Module& Message) {
+  for (proto::Symbol& S : *Message.mutable_symbols())
+    if (S.optional_payload_case() == proto::Symbol::kReferentUuid)
+      S.set_referent_index(indexOf(S.referent_uuid()));
+  if (!Message.entry_point().empty()) {
+    Message.set_entry_point_index(indexOf(Message.entry_point()) + 1);
+    Message.clear_entry_point();
+  }
+}
+
+Node* NodeIndexTable::get(uint64_t Index) {
+  if (Index >= Nodes.size())
+    return nullptr;
+  // Nodes not found are looked up again, as they may be loaded later.
+  if (!Nodes[Index])
+    if (UUID Id; uuidFromBytes(Ids.Get(Index), Id))
+      Nodes[Index] = Node::getByUUID(C, Id);
+  return Nodes[Index];
+}
+
+uint32_t gtirb::packEdgeLabel(const proto::EdgeLabel& Label) {
+  return (static_cast<uint32_t>(Label.type()) << 2 |
+          uint32_t(Label.conditional()) << 1 | uint32_t(Label.direct())) +
+         1;
+}
+
+bool gtirb::unpackEdgeLabel(uint32_t Packed, proto::EdgeLabel& Label) {
+  if (Packed == 0)
+    return false;
+  --Packed;
+  Label.set_type(static_cast<proto::EdgeType>(Packed >> 2));
+  Label.set_conditional(Packed & 2);
+  Label.set_direct(Packed & 1);
+  return true;
+}
+
+bool gtirb::unindexReferences(proto::CFG& Message, const NodeUUIDs& Ids) {
+  int Count = Message.edge_sources_size();
+  if (Message.edge_targets_size() != Count ||
+      Message.edge_labels_size() != Count)
+    return false;
+  for (uint32_t V : Message.vertex_indexes()) {
+    if (V >= static_cast<uint32_t>(Ids.size()))
+      return false;
+    *Message.add_vertices() = Ids.Get(V);
+  }
+  for (int I = 0; I < Count; ++I) {
+    uint32_t Source = Message.edge_sources(I);
+    uint32_t Target = Message.edge_targets(I);
+    if (Source >= static_cast<uint32_t>(Ids.size()) ||
+        Target >= static_cast<uint32_t>(Ids.size()))
+      return false;
+    proto::Edge* E = Message.add_edges();
+    E->set_source_uuid(Ids.Get(Source));
+    E->set_target_uuid(Ids.Get(Target));
+    proto::EdgeLabel Label;
+    if (unpackEdgeLabel(Message.edge_labels(I), Label))
+      E->mutable_label()->Swap(&Label);
+  }
+  Message.clear_vertex_indexes();
+  Message.clear_edge_sources();
+  Message.clear_edge_targets();
+  Message.clear_edge_labels();
+  return true;
+}
+
+bool gtirb::unindexReferences(proto::Module& Message, const NodeUUIDs& Ids) {
+  for (proto::Symbol& S : *Message.mutable_symbols()) {
+    if (S.optional_payload_case() != proto::Symbol::kReferentIndex)
+      continue;
+    if (S.referent_index() >= static_cast<uint32_t>(Ids.size()))
+      return false;
+    S.set_referent_uuid(Ids.Get(S.referent_index()));
+  }
+  if (uint32_t Entry = Message.entry_point_index()) {
+    if (Entry > static_cast<uint32_t>(Ids.size()))
+      return false;
+    Message.set_entry_point(Ids.Get(Entry - 1));
+    Message.clear_entry_point_index();
+  }
+  return true;
+}
+
+bool gtirb::unindexReferences(proto::IR& Message) {
+  if (!unindexReferences(*Message.mutable_cfg(), Message.node_uuids()))
+    return false;
+  for (proto::Module& M : *Message.mutable_modules())
+    if (!unindexReferences(M, Message.node_uuids()))
+      return false;
+  Message.clear_node_uuids();
+  return true;
+}
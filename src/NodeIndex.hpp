@@ -0,0 +1,112 @@
+//===- NodeIndex.hpp --------------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#ifndef GTIRB_NODE_INDEX_HPP
+#define GTIRB_NODE_INDEX_HPP
+
+#include <gtirb/Node.hpp>
+#include <google/protobuf/repeated_field.h>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace gtirb {
+class Context;
+namespace proto {
+class CFG;
+class EdgeLabel;
+class IR;
+class Module;
+} // namespace proto
+
+/// @cond INTERNAL
+using NodeUUIDs = google::protobuf::RepeatedPtrField<std::string>;
+
+/// \brief Rewrites the references to nodes in IR messages as indexes into a
+/// table of node UUIDs, as the indexed container formats store them.
+class NodeIndexer {
+public:
+  /// \param Ids The table to which to add the UUIDs of the nodes referred to,
+  ///            usually the node_uuids of the IR message.
+  explicit NodeIndexer(NodeUUIDs& Ids_) : Ids(Ids_) {}
+
+  /// \brief Return the index of a node's UUID bytes, adding them to the
+  /// table if they are not yet there.
+  uint32_t indexOf(const std::string& Id);
+
+  /// \brief Replace the vertices and edges of a CFG message with indexes.
+  void indexReferences(proto::CFG& Message);
+
+  /// \brief Replace the symbol referents and entry point of a module message
+  /// with indexes.
+  void indexReferences(proto::Module& Message);
+
+private:
+  NodeUUIDs& Ids;
+  std::unordered_map<std::string, uint32_t> Indexes;
+};
+
+/// \brief Resolves indexes into a table of node UUIDs to the nodes they
+/// refer to, looking each node up in its Context at most once.
+class NodeIndexTable {
+public:
+  NodeIndexTable(Context& C_, const NodeUUIDs& Ids_)
+      : C(C_), Ids(Ids_), Nodes(Ids_.size(), nullptr) {}
+
+  /// \brief Return the number of entries in the table.
+  size_t size() const { return Nodes.size(); }
+
+  /// \brief Return the node at an index, or null if the index is out of range
+  /// or no node with its UUID exists yet.
+  Node* get(uint64_t Index);
+
+private:
+  Context& C;
+  const NodeUUIDs& Ids;
+  std::vector<Node*> Nodes;
+};
+
+/// \brief Encode a CFG edge label message as in the edge_labels of an indexed
+/// CFG message.
+uint32_t packEdgeLabel(const proto::EdgeLabel& Label);
+
+/// \brief Decode an edge label from the edge_labels of an indexed CFG
+/// message.
+///
+/// \return false if \p Packed stands for no label, true otherwise.
+bool unpackEdgeLabel(uint32_t Packed, proto::EdgeLabel& Label);
+
+/// \brief Replace the indexes in a CFG message with the UUIDs they refer to.
+///
+/// \return false if an index is out of range or the arrays of edges differ in
+/// length, true otherwise.
+bool unindexReferences(proto::CFG& Message, const NodeUUIDs& Ids);
+
+/// \brief Replace the indexes in a module message with the UUIDs they refer
+/// to.
+///
+/// \return false if an index is out of range, true otherwise.
+bool unindexReferences(proto::Module& Message, const NodeUUIDs& Ids);
+
+/// \brief Replace the indexes in an IR message and its modules with the UUIDs
+/// they refer to, and clear its table of node UUIDs.
+///
+/// \return false if an index is out of range, true otherwise.
+bool unindexReferences(proto::IR& Message);
+/// @endcond
+
+} // namespace gtirb
+
+#endif // GTIRB_NODE_INDEX_HPP
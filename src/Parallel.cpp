@@ -0,0 +1,35 @@
+//===- Parallel.cpp ---------------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#include "Parallel.hpp"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+void gtirb::parallelForEach(size_t Count, size_t NumThreads,
+                            const std::function<void(size_t)>& Fn) {
+  std::atomic<size_t> Next{0};
+  auto Work = [&]() {
+    for (size_t I = Next++; I < Count; I = Next++)
+      Fn(I);
+  };
+  NumThreads = std::min(NumThreads, Count);
+  std::vector<std::thread> Threads;
+  for (size_t T = 1; T < NumThreads; ++T)
+    Threads.emplace_back(Work);
+  Work();
+  for (std::thread& T : Threads)
+    T.join();
+}
@@ -0,0 +1,35 @@
+//===- Parallel.hpp ---------------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#ifndef GTIRB_PARALLEL_HPP
+#define GTIRB_PARALLEL_HPP
+
+#include <cstddef>
+#include <functional>
+
+namespace gtirb {
+
+/// @cond INTERNAL
+/// \brief Call Fn(0) ... Fn(Count - 1) on up to NumThreads threads, handing
+/// out indexes one at a time so that uneven work balances across threads.
+///
+/// The calling thread takes part in the work, so a single thread runs
+/// everything in order on the caller.
+void parallelForEach(size_t Count, size_t NumThreads,
+                     const std::function<void(size_t)>& Fn);
+/// @endcond
+
+} // namespace gtirb
+
+#endif // GTIRB_PARALLEL_HPP
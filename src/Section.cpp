@@ -118,7 +118,12 @@ Section* Section::load(Context& C, std::istream& In) {
   return nullptr;
 }
 
+bool Section::isFrozen() const { return Parent && Parent->isFrozen(); }
+
 ChangeStatus Section::removeByteInterval(ByteInterval* BI) {
+  if (isFrozen())
+    return ChangeStatus::Rejected;
+
   auto& Index = ByteIntervals.get<by_pointer>();
   if (auto Iter = Index.find(BI); Iter != Index.end()) {
     if (Observer) {
@@ -146,6 +151,9 @@ ChangeStatus Section::removeByteInterval(ByteInterval* BI) {
 }
 
 ChangeStatus Section::addByteInterval(ByteInterval* BI) {
+  if (isFrozen() || BI->isFrozen())
+    return ChangeStatus::Rejected;
+
   if (Section* S = BI->getSection()) {
     if (S == this) {
       return ChangeStatus::NoChange;
@@ -174,24 +182,91 @@ ChangeStatus Section::addByteInterval(ByteInterval* BI) {
   return ChangeStatus::Accepted;
 }
 
+ByteInterval* Section::splitByteInterval(Context& C, ByteInterval* BI,
+                                         uint64_t Offset) {
+  if (isFrozen() || BI->getSection() != this || Offset == 0 ||
+      Offset >= BI->getSize() || BI->hasBlockSpanning(Offset))
+    return nullptr;
+
+  std::optional<Addr> TailAddr;
+  if (auto A = BI->getAddress())
+    TailAddr = *A + Offset;
+  uint64_t InitSize = BI->getInitializedSize();
+  uint64_t TailInitSize = InitSize > Offset ? InitSize - Offset : 0;
+  auto BytesBegin = BI->Bytes.begin() + std::min(InitSize, Offset);
+  ByteInterval* Tail =
+      ByteInterval::Create(C, TailAddr, BytesBegin, BI->Bytes.end(),
+                           BI->getSize() - Offset, TailInitSize);
+
+  // Add the tail while it holds no blocks, so that no block events fire. It
+  // overlaps BI until BI is truncated, so the section's extent never shrinks.
+  [[maybe_unused]] ChangeStatus Status = addByteInterval(Tail);
+  assert(Status == ChangeStatus::Accepted &&
+         "unexpected result when inserting ByteInterval");
+  BI->transferContents(*Tail, Offset, 0);
+  BI->setSize(Offset);
+  return Tail;
+}
+
+ChangeStatus Section::mergeByteIntervals(ByteInterval* A, ByteInterval* B) {
+  if (isFrozen() || A == B || A->getSection() != this ||
+      B->getSection() != this)
+    return ChangeStatus::Rejected;
+  if (A->getAddress().has_value() != B->getAddress().has_value() ||
+      (A->getAddress() && *A->getAddress() + A->getSize() != *B->getAddress()))
+    return ChangeStatus::Rejected;
+
+  // Grow A over B before removing B, so that the section's extent never
+  // shrinks.
+  uint64_t OldSize = A->getSize();
+  A->setSize(OldSize + B->getSize());
+  if (B->getInitializedSize() != 0) {
+    A->Bytes.resize(OldSize);
+    A->Bytes.insert(A->Bytes.end(), B->Bytes.begin(), B->Bytes.end());
+  }
+
+  // Empty B before removing it, so that no block events fire.
+  B->transferContents(*A, 0, OldSize);
+  [[maybe_unused]] ChangeStatus Status = removeByteInterval(B);
+  assert(Status == ChangeStatus::Accepted &&
+         "unexpected result when removing ByteInterval");
+  B->setSize(0);
+  return ChangeStatus::Accepted;
+}
+
 void Section::removeByteIntervalAddrs(ByteInterval* BI) {
-  if (std::optional<AddrRange> OldExtent = addressRange(*BI)) {
-    ByteIntervalAddrs.subtract(
-        std::make_pair(ByteIntervalIntMap::interval_type::right_open(
-                           OldExtent->lower(), OldExtent->upper()),
-                       ByteIntervalIntMap::codomain_type({BI})));
+  if (std::optional<AddrRange> OldExtent = addressRange(*BI);
+      OldExtent && OldExtent->size() != 0) {
+    auto It = ByteIntervalEnds.find(OldExtent->upper());
+    assert(It != ByteIntervalEnds.end() && "untracked ByteInterval");
+    ByteIntervalEnds.erase(It);
+    ByteIntervalAddrs.invalidate();
   }
 }
 
 void Section::insertByteIntervalAddrs(ByteInterval* BI) {
-  if (std::optional<AddrRange> NewExtent = addressRange(*BI)) {
-    ByteIntervalAddrs.add(
-        std::make_pair(ByteIntervalIntMap::interval_type::right_open(
-                           NewExtent->lower(), NewExtent->upper()),
-                       ByteIntervalIntMap::codomain_type({BI})));
+  if (std::optional<AddrRange> NewExtent = addressRange(*BI);
+      NewExtent && NewExtent->size() != 0) {
+    ByteIntervalEnds.insert(NewExtent->upper());
+    ByteIntervalAddrs.invalidate();
   }
 }
 
+const Section::ByteIntervalIndex& Section::byteIntervalAddrs() const {
+  ByteIntervalAddrs.ensure([this](auto Add) {
+    for (ByteInterval* BI : ByteIntervals)
+      if (std::optional<AddrRange> Range = addressRange(*BI);
+          Range && Range->size() != 0)
+        Add(Range->lower(), Range->upper(), BI);
+  });
+  return ByteIntervalAddrs;
+}
+
+void Section::freeze() {
+  byteIntervalAddrs();
+  ByteIntervalAddrs.shrink_to_fit();
+}
+
 ChangeStatus Section::updateExtent() {
   std::optional<AddrRange> NewExtent;
   if (!ByteIntervals.empty()) {
@@ -200,12 +275,12 @@ ChangeStatus Section::updateExtent() {
     if (std::optional<Addr> Lower = (*ByteIntervals.begin())->getAddress()) {
       // All the ByteIntervals have an address, so we can calculate the
       // Section's extent. Get the address of the last ByteInterval in case it
-      // has zero size; ByteIntervalAddrs does not track empty ByteIntervals.
+      // has zero size; ByteIntervalEnds does not track empty ByteIntervals.
       Addr Upper = *(*ByteIntervals.rbegin())->getAddress();
-      if (!ByteIntervalAddrs.empty()) {
+      if (!ByteIntervalEnds.empty()) {
         // The last address is the max of the first address in the last
         // interval and the last address in intervals with non-zero size.
-        Upper = std::max(Upper, ByteIntervalAddrs.rbegin()->first.upper());
+        Upper = std::max(Upper, *ByteIntervalEnds.rbegin());
       }
       NewExtent = AddrRange{*Lower, static_cast<uint64_t>(Upper - *Lower)};
     }
@@ -0,0 +1,65 @@
+//===- Sha1.hpp -------------------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#ifndef GTIRB_SHA1_HPP
+#define GTIRB_SHA1_HPP
+
+#include <boost/uuid/detail/sha1.hpp>
+#include <cstddef>
+#include <string>
+
+namespace gtirb {
+
+/// @cond INTERNAL
+// Computes the SHA-1 digest of bytes given in pieces, as used to name the
+// chunks of a ChunkStore and to hash canonical IRs.
+class Sha1 {
+public:
+  void update(const void* Data, size_t Size) {
+    Hash.process_bytes(Data, Size);
+  }
+
+  // Returns the 20-byte digest of the bytes given so far.
+  std::string digest() {
+    boost::uuids::detail::sha1::digest_type Words;
+    Hash.get_digest(Words);
+
+    // Older versions of Boost give the digest as 32-bit words and newer ones
+    // as bytes; either way it is written most significant byte first.
+    std::string Digest;
+    for (auto Word : Words)
+      for (size_t I = sizeof(Word); I-- > 0;)
+        Digest.push_back(static_cast<char>((Word >> (8 * I)) & 0xff));
+    return Digest;
+  }
+
+  // Returns bytes as lowercase hexadecimal digits.
+  static std::string toHex(const std::string& Bytes) {
+    static const char Hex[] = "0123456789abcdef";
+    std::string Result;
+    for (unsigned char Byte : Bytes) {
+      Result.push_back(Hex[Byte >> 4]);
+      Result.push_back(Hex[Byte & 0xf]);
+    }
+    return Result;
+  }
+
+private:
+  boost::uuids::detail::sha1 Hash;
+};
+/// @endcond
+
+} // namespace gtirb
+
+#endif // GTIRB_SHA1_HPP
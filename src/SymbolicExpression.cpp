@@ -14,9 +14,13 @@
 //===----------------------------------------------------------------------===//
 #include "SymbolicExpression.hpp"
 #include "Serialization.hpp"
+#include "SymbolicExpressionSerialization.hpp"
 #include <gtirb/Context.hpp>
 #include <gtirb/Symbol.hpp>
+#include <gtirb/proto/ByteInterval.pb.h>
+#include <gtirb/proto/Module.pb.h>
 #include <gtirb/proto/SymbolicExpression.pb.h>
+#include <algorithm>
 #include <variant>
 
 namespace gtirb {
@@ -104,6 +108,204 @@ bool fromProtobuf(Context& C, SymbolicExpression& Result,
   return false;
 }
 
+namespace {
+// The attributes that have a bit in the packed encoding, in order of bit.
+// Bit I stands for the Ith value of proto::SymAttribute in order of
+// declaration.
+const std::vector<int>& packedAttributes() {
+  static const std::vector<int> Attributes = [] {
+    const auto* Descriptor = proto::SymAttribute_descriptor();
+    std::vector<int> Result;
+    for (int I = 0; I < Descriptor->value_count() && I < 64; ++I)
+      Result.push_back(Descriptor->value(I)->number());
+    return Result;
+  }();
+  return Attributes;
+}
+
+bool attributeMask(const proto::SymbolicExpression& Message, uint64_t& Mask) {
+  const std::vector<int>& Attributes = packedAttributes();
+  Mask = 0;
+  for (int Attr : Message.attribute_flags()) {
+    auto It = std::find(Attributes.begin(), Attributes.end(), Attr);
+    if (It == Attributes.end())
+      return false;
+    Mask |= uint64_t(1) << (It - Attributes.begin());
+  }
+  return true;
+}
+
+template <typename Fn> void forEachAttribute(uint64_t Mask, Fn F) {
+  const std::vector<int>& Attributes = packedAttributes();
+  for (size_t I = 0; I < Attributes.size(); ++I)
+    if (Mask & (uint64_t(1) << I))
+      F(Attributes[I]);
+}
+
+// One packed symbolic expression, with its symbols given as indexes.
+struct PackedExpression {
+  uint64_t At;
+  bool AddrAddr;
+  int64_t Scale;
+  int64_t Offset;
+  uint32_t Sym1;
+  uint32_t Sym2;
+  uint64_t Attributes;
+};
+
+// Calls F on each expression of Message in order of offset. Returns false,
+// without calling F, if the arrays of Message are inconsistent or refer to a
+// symbol at or beyond NumSymbols.
+template <typename Fn>
+bool forEachPacked(const proto::PackedSymbolicExpressions& Message,
+                   size_t NumSymbols, Fn F) {
+  int Count = Message.offset_deltas_size();
+  int AddrAddrCount = static_cast<int>(std::count(
+      Message.addr_addr().begin(), Message.addr_addr().end(), true));
+  if (Message.addr_addr_size() != Count || Message.offsets_size() != Count ||
+      Message.attributes_size() != Count ||
+      Message.scales_size() != AddrAddrCount ||
+      Message.symbols_size() != Count + AddrAddrCount)
+    return false;
+  for (uint32_t Index : Message.symbols())
+    if (Index >= NumSymbols)
+      return false;
+  uint64_t At = 0;
+  for (int I = 0; I < Count; ++I) {
+    uint64_t Delta = Message.offset_deltas(I);
+    if ((I != 0 && Delta == 0) || At + Delta < At)
+      return false;
+    At += Delta;
+  }
+
+  At = 0;
+  int NextScale = 0, NextSymbol = 0;
+  for (int I = 0; I < Count; ++I) {
+    PackedExpression E{};
+    At += Message.offset_deltas(I);
+    E.At = At;
+    E.AddrAddr = Message.addr_addr(I);
+    E.Offset = Message.offsets(I);
+    E.Sym1 = Message.symbols(NextSymbol++);
+    if (E.AddrAddr) {
+      E.Scale = Message.scales(NextScale++);
+      E.Sym2 = Message.symbols(NextSymbol++);
+    }
+    E.Attributes = Message.attributes(I);
+    F(E);
+  }
+  return true;
+}
+} // namespace
+
+bool fromProtobuf(const proto::PackedSymbolicExpressions& Message,
+                  const std::vector<Symbol*>& Symbols,
+                  std::map<uint64_t, SymbolicExpression>& Result) {
+  for (uint32_t Index : Message.symbols())
+    if (Index < Symbols.size() && !Symbols[Index])
+      return false;
+  return forEachPacked(Message, Symbols.size(), [&](const PackedExpression& E) {
+    SymAttributeSet Attributes;
+    forEachAttribute(E.Attributes, [&Attributes](int Attr) {
+      Attributes.insert(Attributes.end(), static_cast<SymAttribute>(Attr));
+    });
+    if (E.AddrAddr)
+      Result.insert_or_assign(Result.end(), E.At,
+                              SymAddrAddr{E.Scale, E.Offset, Symbols[E.Sym1],
+                                          Symbols[E.Sym2],
+                                          std::move(Attributes)});
+    else
+      Result.insert_or_assign(
+          Result.end(), E.At,
+          SymAddrConst{E.Offset, Symbols[E.Sym1], std::move(Attributes)});
+  });
+}
+
+void packSymbolicExpressions(
+    proto::ByteInterval& Message,
+    const std::unordered_map<std::string, uint32_t>& SymbolIndexes) {
+  auto& Expressions = *Message.mutable_symbolic_expressions();
+  std::vector<uint64_t> Offsets;
+  Offsets.reserve(Expressions.size());
+  for (const auto& Pair : Expressions)
+    Offsets.push_back(Pair.first);
+  std::sort(Offsets.begin(), Offsets.end());
+
+  auto IndexOf = [&SymbolIndexes](const std::string& Id, uint32_t& Index) {
+    auto It = SymbolIndexes.find(Id);
+    if (It == SymbolIndexes.end())
+      return false;
+    Index = It->second;
+    return true;
+  };
+
+  proto::PackedSymbolicExpressions Packed;
+  uint64_t Last = 0;
+  for (uint64_t At : Offsets) {
+    auto It = Expressions.find(At);
+    const proto::SymbolicExpression& SE = It->second;
+    uint64_t Mask;
+    uint32_t Sym1, Sym2;
+    if (!attributeMask(SE, Mask))
+      continue;
+    if (SE.has_addr_const()) {
+      if (!IndexOf(SE.addr_const().symbol_uuid(), Sym1))
+        continue;
+      Packed.add_addr_addr(false);
+      Packed.add_offsets(SE.addr_const().offset());
+      Packed.add_symbols(Sym1);
+    } else if (SE.has_addr_addr()) {
+      const proto::SymAddrAddr& Val = SE.addr_addr();
+      if (!IndexOf(Val.symbol1_uuid(), Sym1) ||
+          !IndexOf(Val.symbol2_uuid(), Sym2))
+        continue;
+      Packed.add_addr_addr(true);
+      Packed.add_offsets(Val.offset());
+      Packed.add_scales(Val.scale());
+      Packed.add_symbols(Sym1);
+      Packed.add_symbols(Sym2);
+    } else {
+      continue;
+    }
+    Packed.add_offset_deltas(At - Last);
+    Packed.add_attributes(Mask);
+    Last = At;
+    Expressions.erase(It);
+  }
+
+  if (Packed.offset_deltas_size() != 0)
+    Message.mutable_packed_symbolic_expressions()->Swap(&Packed);
+}
+
+bool unpackSymbolicExpressions(proto::ByteInterval& Message,
+                               const proto::Module& Module) {
+  if (!Message.has_packed_symbolic_expressions())
+    return true;
+  auto& Expressions = *Message.mutable_symbolic_expressions();
+  bool Unpacked = forEachPacked(
+      Message.packed_symbolic_expressions(), Module.symbols_size(),
+      [&](const PackedExpression& E) {
+        proto::SymbolicExpression& SE = Expressions[E.At];
+        SE.Clear();
+        if (E.AddrAddr) {
+          proto::SymAddrAddr& Val = *SE.mutable_addr_addr();
+          Val.set_scale(E.Scale);
+          Val.set_offset(E.Offset);
+          Val.set_symbol1_uuid(Module.symbols(E.Sym1).uuid());
+          Val.set_symbol2_uuid(Module.symbols(E.Sym2).uuid());
+        } else {
+          proto::SymAddrConst& Val = *SE.mutable_addr_const();
+          Val.set_offset(E.Offset);
+          Val.set_symbol_uuid(Module.symbols(E.Sym1).uuid());
+        }
+        forEachAttribute(E.Attributes, [&SE](int Attr) {
+          SE.add_attribute_flags(static_cast<proto::SymAttribute>(Attr));
+        });
+      });
+  Message.clear_packed_symbolic_expressions();
+  return Unpacked;
+}
+
 // This function is defined here w/ GTIRB_EXPORT_API to provide a
 // means for test code to directly invoke serialization routines on a
 // CFG. This is a capability not supported for GTIRB clients, but must
@@ -17,11 +17,18 @@
 #define GTIRB_SYMBOLIC_EXPRESSION_SERIALIZATION_HPP
 
 #include <gtirb/SymbolicExpression.hpp>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace gtirb {
 namespace proto {
+class ByteInterval;
+class Module;
+class PackedSymbolicExpressions;
 class SymbolicExpression;
-}
+} // namespace proto
 class Context;
 
 /// @cond INTERNAL
@@ -44,6 +51,45 @@ bool fromProtobuf(Context& C, SymbolicExpression& Result,
 /// \return A protobuf message representing the SymbolicExpression.
 proto::SymbolicExpression toProtobuf(const SymbolicExpression& Value);
 
+/// \brief Initialize symbolic expressions from their packed encoding.
+///
+/// The expressions are inserted in order of offset, so that filling an empty
+/// map takes linear time.
+///
+/// \param      Message  The packed expressions from which to deserialize.
+/// \param      Symbols  The symbols of the enclosing module, in the order of
+///                      its protobuf message.
+/// \param[out] Result   The map to which to add the expressions.
+///
+/// \return true if the expressions could be deserialized, false otherwise.
+bool fromProtobuf(const proto::PackedSymbolicExpressions& Message,
+                  const std::vector<Symbol*>& Symbols,
+                  std::map<uint64_t, SymbolicExpression>& Result);
+
+/// \brief Move the symbolic expressions of a byte interval message into its
+/// packed encoding.
+///
+/// Expressions whose symbols are not in \p SymbolIndexes, or whose attributes
+/// have no bit in the packed encoding, are left as they are.
+///
+/// \param Message       The byte interval message to rewrite.
+/// \param SymbolIndexes The index of each symbol of the enclosing module in
+///                      its protobuf message, keyed by its UUID bytes.
+void packSymbolicExpressions(
+    proto::ByteInterval& Message,
+    const std::unordered_map<std::string, uint32_t>& SymbolIndexes);
+
+/// \brief Move the packed symbolic expressions of a byte interval message
+/// back into its map of symbolic expressions.
+///
+/// \param Message The byte interval message to rewrite.
+/// \param Module  The enclosing module message, whose symbols the packed
+///                expressions refer to.
+///
+/// \return true if the packed expressions were well formed, false otherwise.
+bool unpackSymbolicExpressions(proto::ByteInterval& Message,
+                               const proto::Module& Module);
+
 /// @endcond
 
 } // namespace gtirb
@@ -16,8 +16,11 @@
 #include <gtirb/AuxData.hpp>
 #include <gtirb/Context.hpp>
 #include <gtirb/proto/AuxData.pb.h>
+#include <boost/container/flat_map.hpp>
+#include <boost/container/flat_set.hpp>
 #include <gtest/gtest.h>
 #include <memory>
+#include <optional>
 #include <sstream>
 
 struct MoveTest;
@@ -814,6 +817,113 @@ TEST(Unit_AuxData, nestedProtobufRoundTrip) {
   EXPECT_EQ(*Result3->get(), N3);
 }
 
+// Serialize a sequence one element at a time, bypassing the bulk path for
+// packed element types.
+template <typename T> static std::string elementwiseBytes(const T& Object) {
+  std::string Bytes;
+  ToByteRange TBR(Bytes);
+  auxdata_traits<uint64_t>::toBytes(Object.size(), TBR);
+  for (const auto& Elt : Object)
+    auxdata_traits<typename T::value_type>::toBytes(Elt, TBR);
+  return Bytes;
+}
+
+template <typename T> static std::string packedBytes(const T& Object) {
+  std::string Bytes;
+  ToByteRange TBR(Bytes);
+  auxdata_traits<T>::toBytes(Object, TBR);
+  return Bytes;
+}
+
+template <typename T> static std::optional<T> unpackBytes(std::string Bytes) {
+  T Result;
+  FromByteRange FBR(Bytes);
+  if (!auxdata_traits<T>::fromBytes(Result, FBR))
+    return std::nullopt;
+  return Result;
+}
+
+TEST(Unit_AuxData, packedSequences) {
+  static_assert(packed_serialization<uint64_t>::value);
+  static_assert(packed_serialization<std::tuple<Addr, int8_t, UUID>>::Size ==
+                8 + 1 + 16);
+  static_assert(!packed_serialization<bool>::value);
+  static_assert(!packed_serialization<std::string>::value);
+  static_assert(!packed_serialization<std::tuple<int, std::string>>::value);
+
+  std::vector<uint64_t> Ints{0, 1, 0x0102030405060708, ~uint64_t(0)};
+  EXPECT_EQ(packedBytes(Ints), elementwiseBytes(Ints));
+  EXPECT_EQ(packedBytes(Ints).substr(24, 8),
+            std::string("\x08\x07\x06\x05\x04\x03\x02\x01", 8));
+  EXPECT_EQ(unpackBytes<std::vector<uint64_t>>(packedBytes(Ints)), Ints);
+
+  std::deque<int16_t> Shorts{-1, 2, -300};
+  EXPECT_EQ(packedBytes(Shorts), elementwiseBytes(Shorts));
+  EXPECT_EQ(unpackBytes<std::deque<int16_t>>(packedBytes(Shorts)), Shorts);
+
+  using Record = std::tuple<Addr, uint32_t, UUID>;
+  UUID Id = Node::Create(Ctx)->getUUID();
+  std::vector<Record> Records{{Addr(0x1000), 7, Id}, {Addr(0x2000), 9, Id}};
+  EXPECT_EQ(packedBytes(Records), elementwiseBytes(Records));
+  EXPECT_EQ(unpackBytes<std::vector<Record>>(packedBytes(Records)), Records);
+
+  using PairList = std::list<std::pair<int8_t, double>>;
+  PairList Pairs{{1, 0.5}, {-2, 3.25}};
+  EXPECT_EQ(packedBytes(Pairs), elementwiseBytes(Pairs));
+  EXPECT_EQ(unpackBytes<PairList>(packedBytes(Pairs)), Pairs);
+
+  // Truncated input is rejected rather than read past the end.
+  std::string Truncated = packedBytes(Ints);
+  Truncated.pop_back();
+  EXPECT_FALSE(unpackBytes<std::vector<uint64_t>>(Truncated));
+}
+
+TEST(Unit_AuxData, columnarMap) {
+  using Map = ColumnarMap<Offset, std::string>;
+  EXPECT_EQ(auxdata_traits<Map>::type_name(),
+            "columnar-mapping<Offset,string>");
+
+  UUID Id = Node::Create(Ctx)->getUUID();
+  Map Comments{{Offset(Id, 8), "b"}, {Offset(Id, 0), "a"}};
+  std::string Bytes = packedBytes(Comments);
+
+  // Count, then the sorted key column, then the values in key order.
+  std::string Expected = elementwiseBytes(std::vector<Offset>{
+      Offset(Id, 0), Offset(Id, 8)});
+  Expected += packedBytes(std::string("a")) + packedBytes(std::string("b"));
+  EXPECT_EQ(Bytes, Expected);
+  EXPECT_EQ(unpackBytes<Map>(Bytes), Comments);
+
+  Bytes.pop_back();
+  EXPECT_FALSE(unpackBytes<Map>(Bytes));
+}
+
+TEST(Unit_AuxData, flatContainers) {
+  using FlatMap =
+      boost::container::flat_map<UUID, boost::container::flat_set<UUID>>;
+  using NodeMap = std::map<UUID, std::set<UUID>>;
+  static_assert(is_mapping<FlatMap>::value);
+  static_assert(is_set<boost::container::flat_set<int>>::value);
+  static_assert(!is_mapping<boost::container::flat_multimap<int, int>>::value);
+  EXPECT_EQ(auxdata_traits<FlatMap>::type_name(),
+            auxdata_traits<NodeMap>::type_name());
+
+  UUID A = Node::Create(Ctx)->getUUID();
+  UUID B = Node::Create(Ctx)->getUUID();
+  NodeMap Nodes{{A, {A, B}}, {B, {}}};
+  FlatMap Flat{{A, {A, B}}, {B, {}}};
+
+  // The wire encoding does not depend on the container.
+  EXPECT_EQ(packedBytes(Flat), packedBytes(Nodes));
+  EXPECT_EQ(unpackBytes<FlatMap>(packedBytes(Nodes)), Flat);
+  EXPECT_EQ(unpackBytes<NodeMap>(packedBytes(Flat)), Nodes);
+  using HashSet = std::unordered_set<int32_t>;
+  HashSet Hashed{3, 1, 2};
+  EXPECT_EQ(unpackBytes<boost::container::flat_set<int32_t>>(
+                packedBytes(Hashed)),
+            boost::container::flat_set<int32_t>({1, 2, 3}));
+}
+
 TEST(Unit_AuxData, wrongTypeAfterProtobufRoundTrip) {
   using STH = gtirb::SerializationTestHarness;
   AuxDataImpl<AnInt32> Original(1234);
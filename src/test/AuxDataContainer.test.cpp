@@ -38,6 +38,10 @@ Context Ctx;
 void registerAuxDataContainerTestAuxDataTypes() {
   AuxDataContainer::registerAuxDataType<RegisteredType>();
   AuxDataContainer::registerAuxDataType<BadDeSerializationType>();
+  AuxDataContainer::registerAuxDataType<ViewMapType>();
+  AuxDataContainer::registerAuxDataType<ViewTupleType>();
+  AuxDataContainer::registerAuxDataType<ViewColumnarType>();
+  AuxDataContainer::registerAuxDataType<ViewUnorderedSetType>();
 }
 
 #ifndef NDEBUG
@@ -146,6 +150,322 @@ TEST(Unit_AuxDataContainer, addAuxDataBadUnserialize) {
   EXPECT_EQ(Raw.RawBytes, ExpectedBytes);
 }
 
+TEST(Unit_AuxDataContainer, getAuxDataView) {
+  using STH = gtirb::SerializationTestHarness;
+  auto* Ir = IR::Create(Ctx);
+  EXPECT_FALSE(Ir->getAuxDataView<ViewMapType>());
+
+  UUID Id = Ir->getUUID();
+  Ir->addAuxData<ViewMapType>({{"a", {1, 2, 3}}, {"c", {}}, {"d", {-4}}});
+  Ir->addAuxData<ViewTupleType>({{Id, {"x", "y"}}});
+
+  std::stringstream ss;
+  STH::save(*Ir, ss);
+  Context ResultCtx;
+  auto* Result = STH::load<IR>(ResultCtx, ss);
+  ASSERT_TRUE(Result);
+
+  auto MapView = Result->getAuxDataView<ViewMapType>();
+  ASSERT_TRUE(MapView);
+  const auto& Map = **MapView;
+  EXPECT_EQ(Map.size(), 3);
+  EXPECT_TRUE(Map.contains("c"));
+  EXPECT_FALSE(Map.contains("b"));
+  EXPECT_FALSE(Map.lookup("e"));
+  auto Values = Map.lookup("a");
+  ASSERT_TRUE(Values);
+  ASSERT_EQ(Values->size(), 3);
+  EXPECT_EQ((*Values)[2], 3);
+  EXPECT_EQ(std::vector<int64_t>(Values->begin(), Values->end()),
+            std::vector<int64_t>({1, 2, 3}));
+  auto [Key, Last] = Map[2];
+  EXPECT_EQ(Key, "d");
+  EXPECT_EQ(Last[0], -4);
+
+  auto TupleView = Result->getAuxDataView<ViewTupleType>();
+  ASSERT_TRUE(TupleView);
+  const auto& Tuples = **TupleView;
+  ASSERT_EQ(Tuples.size(), 1);
+  auto [TupleId, Names] = Tuples[0];
+  EXPECT_EQ(TupleId, Id);
+  EXPECT_TRUE(Names.contains("y"));
+  EXPECT_FALSE(Names.contains("z"));
+
+  // Views reflect changes made through getAuxData.
+  (*Result->getAuxData<ViewMapType>())["b"] = {7};
+  MapView = Result->getAuxDataView<ViewMapType>();
+  ASSERT_TRUE(MapView);
+  EXPECT_EQ((*MapView)->size(), 4);
+  EXPECT_EQ((*(*MapView)->lookup("b"))[0], 7);
+
+  // Views share ownership of the bytes they read, so they outlive the
+  // removal or replacement of their table.
+  EXPECT_TRUE(Result->removeAuxData<ViewTupleType>());
+  EXPECT_TRUE(Names.contains("y"));
+  EXPECT_EQ(std::get<0>(Tuples[0]), Id);
+  Result->addAuxData<ViewMapType>({});
+  EXPECT_EQ((*MapView)->size(), 4);
+  EXPECT_EQ((*(*MapView)->lookup("a"))[1], 2);
+}
+
+TEST(Unit_AuxDataContainer, getColumnarAuxDataView) {
+  using STH = gtirb::SerializationTestHarness;
+  auto* Ir = IR::Create(Ctx);
+  Ir->addAuxData<ViewColumnarType>(
+      {{30, {"c"}}, {10, {"a", "aa"}}, {20, {}}});
+
+  std::stringstream ss;
+  STH::save(*Ir, ss);
+  Context ResultCtx;
+  auto* Result = STH::load<IR>(ResultCtx, ss);
+  ASSERT_TRUE(Result);
+
+  auto View = Result->getAuxDataView<ViewColumnarType>();
+  ASSERT_TRUE(View);
+  const auto& Map = **View;
+  EXPECT_EQ(Map.size(), 3);
+  EXPECT_EQ(std::vector<uint64_t>(Map.keys().begin(), Map.keys().end()),
+            std::vector<uint64_t>({10, 20, 30}));
+  EXPECT_TRUE(Map.contains(20));
+  EXPECT_FALSE(Map.contains(25));
+  auto Strings = Map.lookup(10);
+  ASSERT_TRUE(Strings);
+  ASSERT_EQ(Strings->size(), 2);
+  EXPECT_EQ((*Strings)[1], "aa");
+  auto [Key, Last] = Map[2];
+  EXPECT_EQ(Key, 30);
+  EXPECT_EQ(Last[0], "c");
+}
+
+TEST(Unit_AuxDataContainer, saveManyTables) {
+  using STH = gtirb::SerializationTestHarness;
+  auto* Ir = IR::Create(Ctx);
+  UUID Id = Ir->getUUID();
+  Ir->addAuxData<RegisteredType>(5);
+  Ir->addAuxData<ViewMapType>({{"a", {1}}});
+  Ir->addAuxData<ViewTupleType>({{Id, {"x"}}});
+  Ir->addAuxData<ViewColumnarType>({{1, {"y"}}});
+
+  std::stringstream ss;
+  STH::save(*Ir, ss);
+  Context LoadedCtx;
+  auto* Loaded = STH::load<IR>(LoadedCtx, ss);
+  ASSERT_TRUE(Loaded);
+
+  // Save a mix of tables written back as loaded and tables re-encoded.
+  Loaded->getAuxData<ViewMapType>()->at("a").push_back(2);
+  *Loaded->getAuxData<RegisteredType>() = 6;
+
+  // Encoding is single-threaded unless the Context allows more.
+  EXPECT_EQ(LoadedCtx.getThreadCount(), 1);
+  LoadedCtx.setThreadCount(0);
+  EXPECT_GE(LoadedCtx.getThreadCount(), 1);
+  LoadedCtx.setThreadCount(4);
+  std::stringstream ss2;
+  STH::save(*Loaded, ss2);
+  Context ResultCtx;
+  auto* Result = STH::load<IR>(ResultCtx, ss2);
+  ASSERT_TRUE(Result);
+  EXPECT_EQ(*Result->getAuxData<RegisteredType>(), 6);
+  EXPECT_EQ(Result->getAuxData<ViewMapType>()->at("a"),
+            std::vector<int64_t>({1, 2}));
+  EXPECT_EQ(std::get<0>(Result->getAuxData<ViewTupleType>()->at(0)), Id);
+  EXPECT_EQ(Result->getAuxData<ViewColumnarType>()->at(1),
+            std::vector<std::string>{"y"});
+}
+
+TEST(Unit_AuxDataContainer, unmodifiedAuxDataKeepsBytes) {
+  using STH = gtirb::SerializationTestHarness;
+  auto* Ir = IR::Create(Ctx);
+  Ir->addAuxData<ViewMapType>({{"a", {1}}, {"b", {2, 3}}});
+  std::stringstream ss;
+  STH::save(*Ir, ss);
+  std::string Original = ss.str();
+
+  Context ResultCtx;
+  auto* Result = STH::load<IR>(ResultCtx, ss);
+  ASSERT_TRUE(Result);
+  ASSERT_NE(static_cast<const IR*>(Result)->getAuxData<ViewMapType>(),
+            nullptr);
+  std::stringstream Resaved;
+  STH::save(*Result, Resaved);
+  EXPECT_EQ(Resaved.str(), Original);
+}
+
+TEST(Unit_AuxDataContainer, appendAuxData) {
+  using STH = gtirb::SerializationTestHarness;
+  auto* Ir = IR::Create(Ctx);
+  EXPECT_TRUE(Ir->appendAuxData<ViewMapType>({{"b", {2, 3}}}));
+  EXPECT_TRUE(Ir->appendAuxData<ViewMapType>({{"a", {1}}}));
+  std::stringstream ss;
+  STH::save(*Ir, ss);
+
+  Context ResultCtx;
+  auto* Result = STH::load<IR>(ResultCtx, ss);
+  ASSERT_TRUE(Result);
+  const std::string& Loaded =
+      Result->aux_data_begin()->RawBytes; // Only the one table.
+
+  // New keys are appended without decoding the table.
+  EXPECT_TRUE(Result->appendAuxData<ViewMapType>({{"c", {4}}}));
+  EXPECT_TRUE(Result->appendAuxData<ViewMapType>({{"d", {}}}));
+  auto View = static_cast<const IR*>(Result)->getAuxDataView<ViewMapType>();
+  ASSERT_TRUE(View);
+  const auto& Map = **View;
+  EXPECT_EQ(Map.size(), 4);
+  EXPECT_TRUE(Map.contains("a"));
+  EXPECT_TRUE(Map.contains("d"));
+
+  std::stringstream Resaved;
+  STH::save(*Result, Resaved);
+  Context ReloadedCtx;
+  auto* Reloaded = STH::load<IR>(ReloadedCtx, Resaved);
+  ASSERT_TRUE(Reloaded);
+  const std::string& Spliced = Reloaded->aux_data_begin()->RawBytes;
+  EXPECT_EQ(Spliced.substr(8, Loaded.size() - 8), Loaded.substr(8));
+  using MapType = ViewMapType::Type;
+  EXPECT_EQ(*static_cast<const IR*>(Reloaded)->getAuxData<ViewMapType>(),
+            (MapType{{"a", {1}}, {"b", {2, 3}}, {"c", {4}}, {"d", {}}}));
+
+  // Existing keys are replaced.
+  EXPECT_TRUE(Reloaded->appendAuxData<ViewMapType>({{"a", {5}}, {"e", {6}}}));
+  EXPECT_EQ(*static_cast<const IR*>(Reloaded)->getAuxData<ViewMapType>(),
+            (MapType{{"a", {5}},
+                     {"b", {2, 3}},
+                     {"c", {4}},
+                     {"d", {}},
+                     {"e", {6}}}));
+}
+
+TEST(Unit_AuxDataContainer, appendAuxDataUnordered) {
+  using STH = gtirb::SerializationTestHarness;
+  using SetType = ViewUnorderedSetType::Type;
+  auto* Ir = IR::Create(Ctx);
+  SetType Original;
+  for (uint64_t I = 0; I < 100; ++I)
+    Original.insert(I * 7919 % 1000);
+  Ir->addAuxData<ViewUnorderedSetType>(SetType(Original));
+  std::stringstream ss;
+  STH::save(*Ir, ss);
+
+  Context ResultCtx;
+  auto* Result = STH::load<IR>(ResultCtx, ss);
+  ASSERT_TRUE(Result);
+  const std::string Loaded = Result->aux_data_begin()->RawBytes;
+
+  // Keys are found in the loaded bytes whatever order they were written in.
+  for (uint64_t I = 1000; I < 1010; ++I)
+    EXPECT_TRUE(Result->appendAuxData<ViewUnorderedSetType>({I}));
+  std::stringstream Resaved;
+  STH::save(*Result, Resaved);
+  Context ReloadedCtx;
+  auto* Reloaded = STH::load<IR>(ReloadedCtx, Resaved);
+  ASSERT_TRUE(Reloaded);
+  const std::string& Spliced = Reloaded->aux_data_begin()->RawBytes;
+  EXPECT_EQ(Spliced.substr(8, Loaded.size() - 8), Loaded.substr(8));
+
+  // A key which is already present makes the table be decoded and merged.
+  EXPECT_TRUE(Reloaded->appendAuxData<ViewUnorderedSetType>({0, 2000}));
+  SetType Expected = Original;
+  for (uint64_t I = 1000; I < 1010; ++I)
+    Expected.insert(I);
+  Expected.insert(2000);
+  const IR* CReloaded = Reloaded;
+  EXPECT_EQ(*CReloaded->getAuxData<ViewUnorderedSetType>(), Expected);
+}
+
+TEST(Unit_AuxDataContainer, visitAuxData) {
+  using STH = gtirb::SerializationTestHarness;
+  auto* Ir = IR::Create(Ctx);
+  const IR* CIr = Ir;
+  EXPECT_FALSE(CIr->visitAuxData<ViewMapType>([](const auto&, const auto&) {
+    ADD_FAILURE() << "visited a missing table";
+  }));
+
+  Ir->addAuxData<ViewMapType>({{"a", {1}}, {"b", {2, 3}}, {"c", {}}});
+  Ir->addAuxData<ViewColumnarType>({{7, {"x"}}, {3, {"y", "z"}}});
+  std::stringstream ss;
+  STH::save(*Ir, ss);
+  Context ResultCtx;
+  auto* Result = STH::load<IR>(ResultCtx, ss);
+  ASSERT_TRUE(Result);
+  const IR* CResult = Result;
+
+  // Streamed from the loaded bytes, in serialized order.
+  std::vector<std::string> Keys;
+  int64_t Sum = 0;
+  EXPECT_TRUE(CResult->visitAuxData<ViewMapType>(
+      [&](const std::string& Key, const std::vector<int64_t>& Values) {
+        Keys.push_back(Key);
+        for (int64_t V : Values)
+          Sum += V;
+      }));
+  EXPECT_EQ(Keys, (std::vector<std::string>{"a", "b", "c"}));
+  EXPECT_EQ(Sum, 6);
+
+  // Returning false stops the visit.
+  Keys.clear();
+  EXPECT_TRUE(CResult->visitAuxData<ViewMapType>(
+      [&](const std::string& Key, const auto&) {
+        Keys.push_back(Key);
+        return Key != "b";
+      }));
+  EXPECT_EQ(Keys, (std::vector<std::string>{"a", "b"}));
+
+  std::vector<uint64_t> ColumnarKeys;
+  EXPECT_TRUE(CResult->visitAuxData<ViewColumnarType>(
+      [&](uint64_t Key, const std::vector<std::string>&) {
+        ColumnarKeys.push_back(Key);
+      }));
+  EXPECT_EQ(ColumnarKeys, (std::vector<uint64_t>{3, 7}));
+
+  // Appended entries follow the loaded ones; modified tables are visited in
+  // memory.
+  Result->appendAuxData<ViewMapType>({{"d", {4}}});
+  Keys.clear();
+  EXPECT_TRUE(CResult->visitAuxData<ViewMapType>(
+      [&](const std::string& Key, const auto&) { Keys.push_back(Key); }));
+  EXPECT_EQ(Keys, (std::vector<std::string>{"a", "b", "c", "d"}));
+
+  Result->getAuxData<ViewMapType>()->erase("a");
+  Keys.clear();
+  EXPECT_TRUE(CResult->visitAuxData<ViewMapType>(
+      [&](const std::string& Key, const auto&) { Keys.push_back(Key); }));
+  EXPECT_EQ(Keys, (std::vector<std::string>{"b", "c", "d"}));
+}
+
+TEST(Unit_AuxDataContainer, typedAccessFollowsTables) {
+  auto* Ir = IR::Create(Ctx);
+  const IR* CIr = Ir;
+  Ir->addAuxData<RegisteredType>(1);
+  Ir->addAuxData<ViewMapType>({{"a", {1}}});
+  EXPECT_EQ(*CIr->getAuxData<RegisteredType>(), 1);
+
+  Ir->addAuxData<RegisteredType>(2);
+  EXPECT_EQ(*CIr->getAuxData<RegisteredType>(), 2);
+
+  EXPECT_TRUE(Ir->removeAuxData(RegisteredType::Name));
+  EXPECT_EQ(CIr->getAuxData<RegisteredType>(), nullptr);
+  EXPECT_NE(CIr->getAuxData<ViewMapType>(), nullptr);
+
+  Ir->addAuxData<RegisteredType>(3);
+  EXPECT_TRUE(Ir->removeAuxData<ViewMapType>());
+  EXPECT_EQ(CIr->getAuxData<ViewMapType>(), nullptr);
+  EXPECT_EQ(*CIr->getAuxData<RegisteredType>(), 3);
+
+  std::stringstream ss;
+  gtirb::SerializationTestHarness::save(*Ir, ss);
+  Ir->clearAuxData();
+  EXPECT_EQ(CIr->getAuxData<RegisteredType>(), nullptr);
+
+  Context ResultCtx;
+  auto* Result = gtirb::SerializationTestHarness::load<IR>(ResultCtx, ss);
+  ASSERT_TRUE(Result);
+  EXPECT_EQ(*static_cast<const IR*>(Result)->getAuxData<RegisteredType>(), 3);
+  EXPECT_EQ(static_cast<const IR*>(Result)->getAuxData<ViewMapType>(),
+            nullptr);
+}
+
 // AuxData not present
 TEST(Unit_AuxDataContainer, getAuxDataNotPresent) {
   auto* Ir = IR::Create(Ctx);
@@ -3,6 +3,12 @@
 
 #include <gtirb/AuxData.hpp>
 #include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+#include <unordered_set>
+#include <vector>
 
 // Schema for AuxDataContainer's unit tests
 
@@ -24,6 +30,26 @@ struct DuplicateNameType {
   typedef int32_t Type;
 };
 
+struct ViewMapType {
+  static constexpr const char* Name = "view map type";
+  typedef std::map<std::string, std::vector<int64_t>> Type;
+};
+
+struct ViewTupleType {
+  static constexpr const char* Name = "view tuple type";
+  typedef std::vector<std::tuple<UUID, std::set<std::string>>> Type;
+};
+
+struct ViewColumnarType {
+  static constexpr const char* Name = "view columnar type";
+  typedef ColumnarMap<uint64_t, std::vector<std::string>> Type;
+};
+
+struct ViewUnorderedSetType {
+  static constexpr const char* Name = "view unordered set type";
+  typedef std::unordered_set<uint64_t> Type;
+};
+
 struct BadDeSerializationType {
   static constexpr const char* Name = "bad deserialization type";
   typedef struct {
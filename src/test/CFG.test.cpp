@@ -42,6 +42,15 @@ TEST(Unit_CFG, compilationIteratorTypes) {
     cit = it;
   }
 
+  static_assert(std::is_same_v<proxy_iterator::reference, ProxyBlock&>);
+  static_assert(
+      std::is_same_v<const_proxy_iterator::reference, const ProxyBlock&>);
+  {
+    proxy_iterator it;
+    const_proxy_iterator cit(it);
+    cit = it;
+  }
+
   // Check const-convertibility of [const_]cfg_predecessors_range[::iterator]
   static_assert(
       std::is_same_v<cfg_predecessors_range::iterator::reference::first_type,
@@ -230,6 +239,59 @@ TEST(Unit_CFG, blockIterator) {
   EXPECT_EQ(Cit, ConstRange.end());
 }
 
+TEST(Unit_CFG, proxyIterator) {
+  CFG Cfg;
+  auto* P1 = ProxyBlock::Create(Ctx);
+  auto* P2 = ProxyBlock::Create(Ctx);
+  addVertex(P1, Cfg);
+  addVertex(CodeBlock::Create(Ctx, 1), Cfg);
+  addVertex(P2, Cfg);
+
+  boost::iterator_range<proxy_iterator> ProxyRange = proxies(Cfg);
+  ASSERT_EQ(std::distance(ProxyRange.begin(), ProxyRange.end()), 2);
+  EXPECT_EQ(&*ProxyRange.begin(), P1);
+  EXPECT_EQ(&*std::next(ProxyRange.begin()), P2);
+
+  const CFG& ConstCfg = Cfg;
+  boost::iterator_range<const_proxy_iterator> ConstRange = proxies(ConstCfg);
+  EXPECT_EQ(std::distance(ConstRange.begin(), ConstRange.end()), 2);
+}
+
+TEST(Unit_CFG, removeVertexKeepsPartitions) {
+  CFG Cfg;
+  auto* B1 = CodeBlock::Create(Ctx, 1);
+  auto* B2 = CodeBlock::Create(Ctx, 2);
+  auto* B3 = CodeBlock::Create(Ctx, 3);
+  auto* P1 = ProxyBlock::Create(Ctx);
+  auto* P2 = ProxyBlock::Create(Ctx);
+  for (CfgNode* N : std::vector<CfgNode*>{B1, P1, B2, P2, B3})
+    addVertex(N, Cfg);
+  addEdge(B3, P2, Cfg);
+
+  // Removing from the middle of a partition moves its last node into place.
+  EXPECT_TRUE(removeVertex(B1, Cfg));
+  EXPECT_TRUE(removeVertex(P1, Cfg));
+  auto Blocks = blocks(Cfg);
+  ASSERT_EQ(std::distance(Blocks.begin(), Blocks.end()), 2);
+  EXPECT_EQ(&*Blocks.begin(), B3);
+  EXPECT_EQ(&*std::next(Blocks.begin()), B2);
+  auto Proxies = proxies(Cfg);
+  ASSERT_EQ(std::distance(Proxies.begin(), Proxies.end()), 1);
+  EXPECT_EQ(&*Proxies.begin(), P2);
+
+  // The moved nodes can still be found and removed.
+  EXPECT_EQ(boost::num_edges(Cfg), 1);
+  EXPECT_TRUE(removeVertex(B3, Cfg));
+  EXPECT_TRUE(removeVertex(P2, Cfg));
+  EXPECT_EQ(boost::num_edges(Cfg), 0);
+  Blocks = blocks(Cfg);
+  ASSERT_EQ(std::distance(Blocks.begin(), Blocks.end()), 1);
+  EXPECT_EQ(&*Blocks.begin(), B2);
+  EXPECT_TRUE(proxies(Cfg).empty());
+  EXPECT_FALSE(getVertex(B3, Cfg));
+  EXPECT_TRUE(getVertex(B2, Cfg));
+}
+
 // Helper for validating cfgPredecessors and cfgSuccessors.
 // Uses a multimap to normalize (sort) values, even though the pointer-based
 // ordering may change between processes.
@@ -0,0 +1,170 @@
+//===- Diff.test.cpp --------------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#include <gtirb/AuxData.hpp>
+#include <gtirb/CodeBlock.hpp>
+#include <gtirb/Context.hpp>
+#include <gtirb/DataBlock.hpp>
+#include <gtirb/Diff.hpp>
+#include <gtirb/IR.hpp>
+#include <gtirb/Module.hpp>
+#include <gtirb/ProxyBlock.hpp>
+#include <gtirb/Section.hpp>
+#include <gtirb/Symbol.hpp>
+#include <gtirb/SymbolicExpression.hpp>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <sstream>
+
+namespace gtirb {
+namespace schema {
+// Registered by IR.test.cpp.
+struct TestInt32 {
+  static constexpr const char* Name = "test int32";
+  typedef int32_t Type;
+};
+} // namespace schema
+} // namespace gtirb
+
+using namespace gtirb;
+using namespace gtirb::schema;
+
+static std::string saveDiffTestIR() {
+  Context C;
+  IR* Ir = IR::Create(C);
+  Ir->addAuxData<TestInt32>(1);
+  Module* M = Ir->addModule(C, "m");
+  std::vector<uint8_t> Bytes(64, 0x90);
+  ByteInterval* BI = M->addSection(C, ".text")
+                         ->addByteInterval(C, Addr(0x1000), Bytes.begin(),
+                                           Bytes.end());
+  CodeBlock* B1 = BI->addBlock<CodeBlock>(C, 0, 16);
+  CodeBlock* B2 = BI->addBlock<CodeBlock>(C, 16, 16);
+  Symbol* Sym = M->addSymbol(C, B1, "f");
+  BI->addSymbolicExpression<SymAddrConst>(4, 0, Sym);
+  addEdge(B1, B2, Ir->getCFG());
+  M->addSection(C, ".data")->addByteInterval(C, Addr(0x2000), 32);
+  M->addProxyBlock(C);
+
+  std::ostringstream Out;
+  Ir->save(Out);
+  return Out.str();
+}
+
+static IR* loadDiffTestIR(Context& C, const std::string& Bytes) {
+  std::istringstream In(Bytes);
+  auto Result = IR::load(C, In);
+  EXPECT_TRUE(Result);
+  return Result ? *Result : nullptr;
+}
+
+static bool hasChange(const std::vector<IRChange>& Changes, IRChange::Kind K,
+                      IRChange::Element E, const std::string& Name = "") {
+  return std::any_of(Changes.begin(), Changes.end(), [&](const IRChange& C) {
+    return C.K == K && C.E == E && C.Name == Name;
+  });
+}
+
+TEST(Unit_Diff, identicalIRs) {
+  std::string Saved = saveDiffTestIR();
+  Context C1, C2;
+  EXPECT_TRUE(
+      diff(*loadDiffTestIR(C1, Saved), *loadDiffTestIR(C2, Saved)).empty());
+}
+
+TEST(Unit_Diff, reportsChanges) {
+  std::string Saved = saveDiffTestIR();
+  Context C1, C2;
+  IR* Before = loadDiffTestIR(C1, Saved);
+  IR* After = loadDiffTestIR(C2, Saved);
+
+  Module& M = *After->modules_begin();
+  ByteInterval& BI =
+      *M.findSections(".text").begin()->byte_intervals_begin();
+  CodeBlock* B1 = &*BI.code_blocks_begin();
+  CodeBlock* B2 = &*std::next(BI.code_blocks_begin());
+  Symbol* Sym = &*M.findSymbols("f").begin();
+
+  B1->setSize(12);
+  *std::next(BI.bytes_begin<uint8_t>(), 40) = 0xc3;
+  BI.addSymbolicExpression<SymAddrConst>(4, 8, Sym);
+  BI.addSymbolicExpression<SymAddrConst>(40, 0, Sym);
+  Sym->setName("g");
+  After->addAuxData<TestInt32>(2);
+  M.addAuxData<TestInt32>(3);
+  BI.removeBlock(B2);
+  CodeBlock* B3 = BI.addBlock<CodeBlock>(C2, 32, 8);
+  addEdge(B1, B3, After->getCFG());
+  M.removeSection(&*M.findSections(".data").begin());
+  M.setEntryPoint(B1);
+
+  std::vector<IRChange> Changes = diff(*Before, *After);
+  using Kind = IRChange::Kind;
+  using Element = IRChange::Element;
+  EXPECT_TRUE(hasChange(Changes, Kind::Changed, Element::CodeBlock, "size"));
+  EXPECT_TRUE(
+      hasChange(Changes, Kind::Changed, Element::ByteInterval, "bytes"));
+  EXPECT_TRUE(hasChange(Changes, Kind::Changed, Element::Symbol, "name"));
+  EXPECT_TRUE(
+      hasChange(Changes, Kind::Changed, Element::Module, "entry point"));
+  EXPECT_TRUE(hasChange(Changes, Kind::Removed, Element::CodeBlock));
+  EXPECT_TRUE(hasChange(Changes, Kind::Added, Element::CodeBlock));
+  EXPECT_TRUE(hasChange(Changes, Kind::Removed, Element::Section));
+  EXPECT_TRUE(
+      hasChange(Changes, Kind::Changed, Element::AuxData, "test int32"));
+  EXPECT_TRUE(hasChange(Changes, Kind::Added, Element::AuxData, "test int32"));
+
+  auto SEs = std::count_if(Changes.begin(), Changes.end(), [](const auto& C) {
+    return C.E == Element::SymbolicExpr;
+  });
+  EXPECT_EQ(SEs, 2);
+  EXPECT_TRUE(std::any_of(Changes.begin(), Changes.end(), [&](const auto& C) {
+    return C.E == Element::SymbolicExpr && C.K == Kind::Added &&
+           C.Offset == 40 && C.Id == BI.getUUID();
+  }));
+
+  // The edge to the removed block is gone, and one to the new block added.
+  EXPECT_TRUE(std::any_of(Changes.begin(), Changes.end(), [&](const auto& C) {
+    return C.E == Element::CfgEdge && C.K == Kind::Added &&
+           C.Id == B1->getUUID() && C.Target == B3->getUUID();
+  }));
+  EXPECT_TRUE(hasChange(Changes, Kind::Removed, Element::CfgEdge));
+
+  // The differences are reported in the same order each time.
+  std::vector<IRChange> Again = diff(*Before, *After);
+  ASSERT_EQ(Again.size(), Changes.size());
+  for (size_t I = 0; I < Changes.size(); ++I) {
+    EXPECT_EQ(Again[I].Id, Changes[I].Id);
+    EXPECT_EQ(Again[I].Name, Changes[I].Name);
+  }
+}
+
+TEST(Unit_Diff, nodesInUUIDOrder) {
+  std::string Saved = saveDiffTestIR();
+  Context C1, C2;
+  IR* Before = loadDiffTestIR(C1, Saved);
+  IR* After = loadDiffTestIR(C2, Saved);
+
+  // Symbols are held in memory order, which must not show in the report.
+  Module& M = *After->modules_begin();
+  for (int I = 0; I < 32; ++I)
+    M.addSymbol(C2, Addr(0x1000 + I), "s" + std::to_string(I));
+
+  std::vector<UUID> Added;
+  for (const IRChange& Change : diff(*Before, *After))
+    if (Change.E == IRChange::Element::Symbol)
+      Added.push_back(Change.Id);
+  EXPECT_EQ(Added.size(), 32);
+  EXPECT_TRUE(std::is_sorted(Added.begin(), Added.end()));
+}
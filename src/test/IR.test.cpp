@@ -12,18 +12,34 @@
 //  endorsement should be inferred.
 //
 //===----------------------------------------------------------------------===//
+#include "PrepDeathTest.hpp"
 #include "SerializationTestHarness.hpp"
 #include <gtirb/AuxData.hpp>
+#include <gtirb/AuxDataSchema.hpp>
+#include <gtirb/CodeBlock.hpp>
 #include <gtirb/Context.hpp>
 #include <gtirb/DataBlock.hpp>
 #include <gtirb/IR.hpp>
 #include <gtirb/Module.hpp>
+#include <gtirb/ProxyBlock.hpp>
 #include <gtirb/Section.hpp>
 #include <gtirb/Symbol.hpp>
 #include <gtirb/SymbolicExpression.hpp>
 #include <gtirb/proto/IR.pb.h>
+#include <google/protobuf/dynamic_message.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include <google/protobuf/util/json_util.h>
+#include <google/protobuf/util/message_differencer.h>
+#include <google/protobuf/util/type_resolver_util.h>
+#include <boost/uuid/random_generator.hpp>
+#include <boost/uuid/uuid_io.hpp>
 #include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
 #include <sstream>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace gtirb {
 namespace schema {
@@ -53,6 +69,23 @@ struct TestInt32 {
   typedef int32_t Type;
 };
 
+struct TestBlockSets {
+  static constexpr const char* Name = "test block sets";
+  typedef std::map<UUID, std::set<UUID>> Type;
+  typedef Type References;
+};
+
+struct TestOffsetComments {
+  static constexpr const char* Name = "test offset comments";
+  typedef std::vector<std::tuple<Offset, std::string>> Type;
+  typedef Type References;
+};
+
+struct TestUnorderedSets {
+  static constexpr const char* Name = "test unordered sets";
+  typedef std::unordered_map<std::string, std::unordered_set<uint64_t>> Type;
+};
+
 } // namespace schema
 } // namespace gtirb
 
@@ -65,6 +98,11 @@ void registerIrTestAuxDataTypes() {
   AuxDataContainer::registerAuxDataType<AnAuxDataMap>();
   AuxDataContainer::registerAuxDataType<BarVectorChar>();
   AuxDataContainer::registerAuxDataType<TestInt32>();
+  AuxDataContainer::registerAuxDataType<TestBlockSets>();
+  AuxDataContainer::registerAuxDataType<TestOffsetComments>();
+  AuxDataContainer::registerAuxDataType<TestUnorderedSets>();
+  AuxDataContainer::registerAuxDataType<schema::FunctionBlocks>();
+  AuxDataContainer::registerAuxDataType<schema::FunctionEntries>();
 }
 
 static bool hasPreferredAddr(const Module& M, Addr X) {
@@ -174,6 +212,166 @@ TEST(Unit_IR, findModules) {
   EXPECT_TRUE(Ir->findModules("notfound").empty());
 }
 
+TEST(Unit_IR, resolveAddresses) {
+  auto* Ir = IR::Create(Ctx);
+  auto* M1 = Ir->addModule(Ctx, "M1");
+  auto* BI1 = M1->addSection(Ctx, "S")->addByteInterval(Ctx, Addr(0x10), 16);
+  auto* CB1 = BI1->addBlock<CodeBlock>(Ctx, 0, 8);
+  auto* M2 = Ir->addModule(Ctx, "M2");
+  auto* BI2 = M2->addSection(Ctx, "S")->addByteInterval(Ctx, Addr(0x14), 16);
+  auto* CB2 = BI2->addBlock<CodeBlock>(Ctx, 0, 16);
+
+  // Blocks from all modules are considered; overlaps resolve to the
+  // lowest-addressed block.
+  std::vector<Addr> Addrs{Addr(0x30), Addr(0x17), Addr(0x18), Addr(0x10),
+                          Addr(0x0)};
+  std::vector<const CodeBlock*> Blocks = Ir->resolveAddresses(Addrs);
+  EXPECT_EQ(Blocks,
+            (std::vector<const CodeBlock*>{nullptr, CB1, CB2, CB1, nullptr}));
+
+  std::vector<const CodeBlock*> Out(Addrs.size());
+  Ir->resolveAddresses(Addrs.data(), Addrs.size(), Out.data(), 2);
+  EXPECT_EQ(Out, Blocks);
+}
+
+TEST(Unit_IR, freeze) {
+  auto* Ir = IR::Create(Ctx);
+  auto* M = Ir->addModule(Ctx, "M");
+  auto* S = M->addSection(Ctx, "S");
+  auto* BI = S->addByteInterval(Ctx, Addr(0x10), 16);
+  auto* CB = BI->addBlock<CodeBlock>(Ctx, 0, 8);
+  auto* DB = BI->addBlock<DataBlock>(Ctx, 8, 8);
+  auto* PB = M->addProxyBlock(Ctx);
+  auto* Sym = M->addSymbol(Ctx, CB, "Sym");
+  EXPECT_FALSE(Ir->isFrozen());
+  EXPECT_FALSE(BI->isFrozen());
+
+  Ir->freeze();
+  Ir->freeze();
+  EXPECT_TRUE(Ir->isFrozen());
+  EXPECT_TRUE(M->isFrozen());
+  EXPECT_TRUE(S->isFrozen());
+  EXPECT_TRUE(BI->isFrozen());
+
+  // Structural changes are rejected and leave the IR untouched.
+  auto* OtherS = Section::Create(Ctx, "Other");
+  auto* OtherBI = ByteInterval::Create(Ctx, Addr(0x40), 4);
+  auto* OtherCB = CodeBlock::Create(Ctx, 4);
+  EXPECT_EQ(M->addSection(OtherS), ChangeStatus::Rejected);
+  EXPECT_EQ(M->removeSection(S), ChangeStatus::Rejected);
+  EXPECT_EQ(S->addByteInterval(OtherBI), ChangeStatus::Rejected);
+  EXPECT_EQ(S->removeByteInterval(BI), ChangeStatus::Rejected);
+  EXPECT_EQ(BI->addBlock(0, OtherCB), ChangeStatus::Rejected);
+  EXPECT_EQ(BI->removeBlock(DB), ChangeStatus::Rejected);
+  EXPECT_EQ(OtherBI->addBlock(0, CB), ChangeStatus::Rejected);
+  EXPECT_EQ(M->removeProxyBlock(PB), ChangeStatus::Rejected);
+  EXPECT_EQ(OtherCB->getByteInterval(), nullptr);
+  EXPECT_EQ(CB->getByteInterval(), BI);
+  EXPECT_EQ(std::distance(M->sections_begin(), M->sections_end()), 1);
+  EXPECT_EQ(num_vertices(Ir->getCFG()), 2);
+
+  // Creating nodes in the IR and changing indexed values are refused. Debug
+  // builds fail an assertion; release builds report the refusal.
+#ifndef NDEBUG
+  {
+    [[maybe_unused]] PrepDeathTest PDT;
+    EXPECT_DEATH(Ir->addModule(Ctx, "Other"), "cannot add a module");
+    EXPECT_DEATH(M->addSection(Ctx, "Other"), "cannot add a section");
+    EXPECT_DEATH(S->addByteInterval(Ctx, Addr(0x40), 4),
+                 "cannot add a byte interval");
+    EXPECT_DEATH(BI->addBlock<CodeBlock>(Ctx, 0, 4), "cannot add a block");
+    EXPECT_DEATH(M->addProxyBlock(Ctx), "cannot add a proxy block");
+    EXPECT_DEATH(M->addSymbol(Ctx, "Other"), "cannot add a symbol");
+    EXPECT_DEATH(M->setName("Renamed"), "cannot rename a module");
+    EXPECT_DEATH(S->setName("Renamed"), "cannot rename a section");
+    EXPECT_DEATH(Sym->setName("Renamed"), "cannot rename a symbol");
+    EXPECT_DEATH(Sym->setAddress(Addr(0x20)), "cannot change the address");
+    EXPECT_DEATH(Sym->setReferent(DB), "cannot change the referent");
+    EXPECT_DEATH(BI->setAddress(Addr(0x80)), "cannot move a byte interval");
+    EXPECT_DEATH(BI->setSize(32), "cannot resize a byte interval");
+    EXPECT_DEATH(CB->setSize(4), "cannot resize a block");
+    EXPECT_DEATH(CB->setDecodeMode(DecodeMode::Thumb),
+                 "cannot change the decode mode");
+    EXPECT_DEATH(DB->setSize(2), "cannot resize a block");
+  }
+#else
+  EXPECT_EQ(Ir->addModule(Ctx, "Other"), nullptr);
+  EXPECT_EQ(M->addSection(Ctx, "Other"), nullptr);
+  EXPECT_EQ(S->addByteInterval(Ctx, Addr(0x40), 4), nullptr);
+  EXPECT_EQ(BI->addBlock<CodeBlock>(Ctx, 0, 4), nullptr);
+  EXPECT_EQ(M->addProxyBlock(Ctx), nullptr);
+  EXPECT_EQ(M->addSymbol(Ctx, "Other"), nullptr);
+  EXPECT_EQ(M->setName("Renamed"), ChangeStatus::Rejected);
+  EXPECT_EQ(S->setName("Renamed"), ChangeStatus::Rejected);
+  EXPECT_EQ(Sym->setName("Renamed"), ChangeStatus::Rejected);
+  EXPECT_EQ(Sym->setAddress(Addr(0x20)), ChangeStatus::Rejected);
+  EXPECT_EQ(Sym->setReferent(DB), ChangeStatus::Rejected);
+  EXPECT_EQ(BI->setAddress(Addr(0x80)), ChangeStatus::Rejected);
+  EXPECT_EQ(BI->setSize(32), ChangeStatus::Rejected);
+  EXPECT_EQ(CB->setSize(4), ChangeStatus::Rejected);
+  EXPECT_EQ(CB->setDecodeMode(DecodeMode::Thumb), ChangeStatus::Rejected);
+  EXPECT_EQ(DB->setSize(2), ChangeStatus::Rejected);
+#endif
+  EXPECT_EQ(std::distance(Ir->modules_begin(), Ir->modules_end()), 1);
+  EXPECT_EQ(std::distance(M->sections_begin(), M->sections_end()), 1);
+  EXPECT_EQ(std::distance(M->symbols_begin(), M->symbols_end()), 1);
+  EXPECT_EQ(M->getName(), "M");
+  EXPECT_EQ(S->getName(), "S");
+  EXPECT_EQ(Sym->getName(), "Sym");
+  EXPECT_EQ(Sym->getReferent<CodeBlock>(), CB);
+  EXPECT_EQ(BI->getAddress(), Addr(0x10));
+  EXPECT_EQ(BI->getSize(), 16);
+  EXPECT_EQ(CB->getSize(), 8);
+  EXPECT_EQ(CB->getDecodeMode(), DecodeMode::Default);
+  EXPECT_EQ(DB->getSize(), 8);
+  EXPECT_EQ(std::distance(M->findSymbols("Sym").begin(),
+                          M->findSymbols("Sym").end()),
+            1);
+
+  // Symbolic expressions are not indexed and stay writable.
+  BI->addSymbolicExpression<SymAddrConst>(0, 0, Sym);
+  EXPECT_NE(BI->getSymbolicExpression(0), nullptr);
+  EXPECT_TRUE(BI->removeSymbolicExpression(0));
+
+  // Address queries keep working, answered from the flat frozen indexes.
+  EXPECT_EQ(&*M->findCodeBlocksOn(Addr(0x14)).begin(), CB);
+  EXPECT_EQ(&*M->findDataBlocksOn(Addr(0x18)).begin(), DB);
+  EXPECT_EQ(std::distance(BI->findBlocksOnOffset(8).begin(),
+                          BI->findBlocksOnOffset(8).end()),
+            1);
+  EXPECT_EQ(&*M->findSectionsOn(Addr(0x1f)).begin(), S);
+  EXPECT_TRUE(M->findSectionsOn(Addr(0x20)).empty());
+  EXPECT_TRUE(BI->findBlocksOnOffset(16).empty());
+  std::vector<Addr> Addrs{Addr(0x14), Addr(0x18), Addr(0x0)};
+  EXPECT_EQ(Ir->resolveAddresses(Addrs),
+            (std::vector<const CodeBlock*>{CB, nullptr, nullptr}));
+  EXPECT_EQ(M->resolveAddresses(Addrs), Ir->resolveAddresses(Addrs));
+
+  // After thawing, changes are accepted and the index is rebuilt on demand.
+  Ir->thaw();
+  EXPECT_FALSE(BI->isFrozen());
+  EXPECT_EQ(BI->addBlock(8, OtherCB), ChangeStatus::Accepted);
+  EXPECT_EQ(Ir->resolveAddresses(Addrs),
+            (std::vector<const CodeBlock*>{CB, OtherCB, nullptr}));
+  EXPECT_EQ(std::distance(BI->findBlocksOnOffset(8).begin(),
+                          BI->findBlocksOnOffset(8).end()),
+            2);
+  EXPECT_EQ(&*M->findSectionsOn(Addr(0x1f)).begin(), S);
+
+  // An IR with several modules indexes the blocks of all of them.
+  auto* M2 = Ir->addModule(Ctx, "M2");
+  auto* CB2 = M2->addSection(Ctx, "S")
+                  ->addByteInterval(Ctx, Addr(0x0), 4)
+                  ->addBlock<CodeBlock>(Ctx, 0, 4);
+  Ir->freeze();
+  EXPECT_TRUE(M2->isFrozen());
+  EXPECT_EQ(Ir->resolveAddresses(Addrs),
+            (std::vector<const CodeBlock*>{CB, OtherCB, CB2}));
+  EXPECT_EQ(M2->resolveAddresses(Addrs),
+            (std::vector<const CodeBlock*>{nullptr, nullptr, CB2}));
+  Ir->thaw();
+}
+
 TEST(Unit_IR, getModulesWithPreferredAddr) {
   const Addr PreferredAddr{22678};
   const size_t ModulesWithAddr{3};
@@ -450,3 +648,840 @@ TEST(Unit_IR, CFG) {
                                   &*M2->proxy_blocks_begin()}));
   }
 }
+
+TEST(Unit_IR, collectAuxDataGarbage) {
+  auto* Ir = IR::Create(Ctx);
+  auto* M = Ir->addModule(Ctx, "M");
+  auto* BI = M->addSection(Ctx, ".text")->addByteInterval(Ctx, Addr(0), 16);
+  auto* B1 = BI->addBlock<CodeBlock>(Ctx, 0, 4);
+  auto* B2 = BI->addBlock<CodeBlock>(Ctx, 4, 4);
+  auto* B3 = BI->addBlock<CodeBlock>(Ctx, 8, 4);
+  UUID Merged = B3->getUUID();
+
+  M->addAuxData<TestBlockSets>(
+      {{B1->getUUID(), {B1->getUUID(), B2->getUUID(), Merged}},
+       {B2->getUUID(), {B2->getUUID()}}});
+  M->addAuxData<TestOffsetComments>({{Offset(B1->getUUID(), 0), "one"},
+                                     {Offset(B2->getUUID(), 1), "two"},
+                                     {Offset(Merged, 2), "three"}});
+  M->addAuxData<FooVectorInt64>({1, 2, 3});
+
+  BI->removeBlock(B2);
+  BI->removeBlock(B3);
+  auto Stats = Ir->collectAuxDataGarbage({{Merged, B1->getUUID()}});
+
+  EXPECT_EQ(*M->getAuxData<TestBlockSets>(),
+            (std::map<UUID, std::set<UUID>>{
+                {B1->getUUID(), {B1->getUUID()}}}));
+  EXPECT_EQ(*M->getAuxData<TestOffsetComments>(),
+            (std::vector<std::tuple<Offset, std::string>>{
+                {Offset(B1->getUUID(), 0), "one"},
+                {Offset(B1->getUUID(), 2), "three"}}));
+  EXPECT_EQ(Stats.TablesScanned, 2);
+  EXPECT_EQ(Stats.TablesChanged, 2);
+  EXPECT_EQ(Stats.ReferencesRemapped, 2);
+
+  // A second pass finds nothing left to change.
+  Stats = Ir->collectAuxDataGarbage();
+  EXPECT_EQ(Stats.TablesScanned, 2);
+  EXPECT_EQ(Stats.TablesChanged, 0);
+  EXPECT_EQ(Stats.ElementsRemoved, 0);
+}
+
+TEST(Unit_IR, collectAuxDataGarbageFunctionTables) {
+  auto* Ir = IR::Create(Ctx);
+  auto* M = Ir->addModule(Ctx, "M");
+  auto* BI = M->addSection(Ctx, ".text")->addByteInterval(Ctx, Addr(0), 16);
+  auto* B1 = BI->addBlock<CodeBlock>(Ctx, 0, 4);
+  auto* B2 = BI->addBlock<CodeBlock>(Ctx, 4, 4);
+  UUID F1 = boost::uuids::random_generator()();
+  UUID F2 = boost::uuids::random_generator()();
+
+  // Function UUIDs key the tables but are not nodes, so only the blocks in
+  // the sets are collected.
+  M->addAuxData<schema::FunctionBlocks>(
+      {{F1, {B1->getUUID(), B2->getUUID()}}, {F2, {B2->getUUID()}}});
+  M->addAuxData<schema::FunctionEntries>({{F1, {B1->getUUID()}}});
+  auto Stats = Ir->collectAuxDataGarbage();
+  EXPECT_EQ(Stats.TablesScanned, 2);
+  EXPECT_EQ(Stats.TablesChanged, 0);
+
+  BI->removeBlock(B2);
+  Stats = Ir->collectAuxDataGarbage();
+  EXPECT_EQ(Stats.TablesChanged, 1);
+  EXPECT_EQ(Stats.ElementsRemoved, 2);
+  EXPECT_EQ(*M->getAuxData<schema::FunctionBlocks>(),
+            (std::map<UUID, std::set<UUID>>{{F1, {B1->getUUID()}}, {F2, {}}}));
+  EXPECT_EQ(*M->getAuxData<schema::FunctionEntries>(),
+            (std::map<UUID, std::set<UUID>>{{F1, {B1->getUUID()}}}));
+}
+
+// Saves an IR with two modules, linked by the CFG, in an indexed format.
+static void saveIndexedTestIR(
+    std::ostream& Out,
+    IR::ContainerFormat Format = IR::ContainerFormat::Indexed) {
+  Context C;
+  IR* Ir = IR::Create(C);
+  Ir->addAuxData<TestInt32>(7);
+
+  Module* A = Ir->addModule(C, "a");
+  ByteInterval* Text =
+      A->addSection(C, ".text")->addByteInterval(C, Addr(0x1000), 16);
+  CodeBlock* CBA = Text->addBlock<CodeBlock>(C, 0, 16);
+  ByteInterval* Data =
+      A->addSection(C, ".data")->addByteInterval(C, Addr(0x2000), 4096);
+  Data->addBlock<DataBlock>(C, 0, 8);
+  Symbol* Sym = A->addSymbol(C, CBA, "start");
+  Text->addSymbolicExpression<SymAddrConst>(4, 0, Sym);
+  A->setEntryPoint(CBA);
+  ProxyBlock* PB = A->addProxyBlock(C);
+
+  Module* B = Ir->addModule(C, "b");
+  CodeBlock* CBB = B->addSection(C, ".text")
+                       ->addByteInterval(C, Addr(0x3000), 4)
+                       ->addBlock<CodeBlock>(C, 0, 4);
+
+  addEdge(CBA, PB, Ir->getCFG());
+  addEdge(CBA, CBB, Ir->getCFG());
+  Ir->save(Out, Format);
+}
+
+TEST(Unit_IR, indexedRoundTrip) {
+  std::stringstream ss;
+  saveIndexedTestIR(ss);
+
+  Context C;
+  auto Result = IR::load(C, ss);
+  ASSERT_TRUE(Result);
+  IR* Ir = *Result;
+  ASSERT_NE(Ir->getAuxData<TestInt32>(), nullptr);
+  EXPECT_EQ(*Ir->getAuxData<TestInt32>(), 7);
+  ASSERT_EQ(std::distance(Ir->modules_begin(), Ir->modules_end()), 2);
+
+  Module& A = *Ir->findModules("a").begin();
+  EXPECT_EQ(std::distance(A.sections_begin(), A.sections_end()), 2);
+  ASSERT_NE(A.getEntryPoint(), nullptr);
+  EXPECT_EQ(A.findSymbols("start").begin()->getReferent<CodeBlock>(),
+            A.getEntryPoint());
+  EXPECT_EQ(std::distance(A.symbolic_expressions_begin(),
+                          A.symbolic_expressions_end()),
+            1);
+  EXPECT_EQ(num_vertices(Ir->getCFG()), 3);
+  EXPECT_EQ(num_edges(Ir->getCFG()), 2);
+}
+
+TEST(Unit_IR, indexedSymbolicExpressions) {
+  Context C;
+  IR* Ir = IR::Create(C);
+  Module* M = Ir->addModule(C, "m");
+  ByteInterval* BI =
+      M->addSection(C, ".data")->addByteInterval(C, Addr(0x1000), 64);
+  Symbol* S1 = M->addSymbol(C, Addr(0x1000), "s1");
+  Symbol* S2 = M->addSymbol(C, Addr(0x1010), "s2");
+  BI->addSymbolicExpression<SymAddrConst>(
+      0, -8, S1, SymAttributeSet{SymAttribute::GOT, SymAttribute::PLT});
+  BI->addSymbolicExpression<SymAddrAddr>(
+      8, 4, 2, S2, S1, SymAttributeSet{SymAttribute::HA});
+  BI->addSymbolicExpression<SymAddrConst>(16, 0, S2);
+  // The last attribute has no bit in the packed encoding, so this expression
+  // is written unpacked.
+  BI->addSymbolicExpression<SymAddrConst>(
+      24, 0, S1, SymAttributeSet{SymAttribute::NOTOC});
+
+  for (auto Format :
+       {IR::ContainerFormat::Indexed, IR::ContainerFormat::Compressed}) {
+    if (Format == IR::ContainerFormat::Compressed &&
+        !IR::isCompressionAvailable())
+      continue;
+    std::stringstream ss;
+    Ir->save(ss, Format);
+    Context C2;
+    auto Result = IR::load(C2, ss);
+    ASSERT_TRUE(Result) << Result.getError().message();
+    Module& M2 = *(*Result)->findModules("m").begin();
+    const ByteInterval& BI2 = *M2.byte_intervals_begin();
+    Symbol* S1b = &*M2.findSymbols("s1").begin();
+    Symbol* S2b = &*M2.findSymbols("s2").begin();
+
+    ASSERT_EQ(std::distance(BI2.symbolic_expressions_begin(),
+                            BI2.symbolic_expressions_end()),
+              4);
+    EXPECT_EQ(*BI2.getSymbolicExpression(0),
+              SymbolicExpression(SymAddrConst{
+                  -8, S1b,
+                  SymAttributeSet{SymAttribute::GOT, SymAttribute::PLT}}));
+    EXPECT_EQ(*BI2.getSymbolicExpression(8),
+              SymbolicExpression(SymAddrAddr{
+                  4, 2, S2b, S1b, SymAttributeSet{SymAttribute::HA}}));
+    EXPECT_EQ(*BI2.getSymbolicExpression(16),
+              SymbolicExpression(SymAddrConst{0, S2b}));
+    EXPECT_EQ(*BI2.getSymbolicExpression(24),
+              SymbolicExpression(SymAddrConst{
+                  0, S1b, SymAttributeSet{SymAttribute::NOTOC}}));
+  }
+}
+
+TEST(Unit_IR, indexedNodeReferences) {
+  Context C;
+  IR* Ir = IR::Create(C);
+  Module* M = Ir->addModule(C, "m");
+  ByteInterval* BI =
+      M->addSection(C, ".text")->addByteInterval(C, Addr(0x1000), 1024);
+  std::vector<CodeBlock*> Blocks;
+  for (uint64_t I = 0; I < 64; ++I)
+    Blocks.push_back(BI->addBlock<CodeBlock>(C, I * 16, 16));
+  for (size_t I = 1; I < Blocks.size(); ++I) {
+    auto E = addEdge(Blocks[I - 1], Blocks[I], Ir->getCFG());
+    Ir->getCFG()[*E] = std::make_tuple(
+        ConditionalEdge::OnTrue, DirectEdge::IsDirect, EdgeType::Fallthrough);
+  }
+  addEdge(Blocks.back(), M->addProxyBlock(C), Ir->getCFG());
+  DataBlock* DB = M->addSection(C, ".data")
+                      ->addByteInterval(C, Addr(0x2000), 8)
+                      ->addBlock<DataBlock>(C, 0, 8);
+  M->addSymbol(C, DB, "data");
+  M->setEntryPoint(Blocks.front());
+
+  // Each edge refers to its blocks by index rather than by UUID.
+  std::stringstream Monolithic, Indexed;
+  Ir->save(Monolithic);
+  Ir->save(Indexed, IR::ContainerFormat::Indexed);
+  EXPECT_LT(Indexed.str().size(), Monolithic.str().size());
+
+  Context C2;
+  auto Result = IR::load(C2, Indexed);
+  ASSERT_TRUE(Result);
+  const CFG& Cfg = (*Result)->getCFG();
+  EXPECT_EQ(num_vertices(Cfg), 65);
+  EXPECT_EQ(num_edges(Cfg), 64);
+  size_t Labeled = 0;
+  for (auto E : boost::make_iterator_range(edges(Cfg)))
+    if (Cfg[E] == std::make_tuple(ConditionalEdge::OnTrue,
+                                  DirectEdge::IsDirect, EdgeType::Fallthrough))
+      ++Labeled;
+  EXPECT_EQ(Labeled, 63);
+  Module& M2 = *(*Result)->modules_begin();
+  EXPECT_EQ(M2.getEntryPoint()->getAddress(), Addr(0x1000));
+  EXPECT_EQ(M2.findSymbols("data").begin()->getAddress(), Addr(0x2000));
+}
+
+// A stream buffer that cannot seek, like that of a pipe.
+class NonSeekableBuf : public std::stringbuf {
+public:
+  using std::stringbuf::stringbuf;
+
+protected:
+  pos_type seekoff(off_type, std::ios_base::seekdir,
+                   std::ios_base::openmode) override {
+    return pos_type(off_type(-1));
+  }
+  pos_type seekpos(pos_type, std::ios_base::openmode) override {
+    return pos_type(off_type(-1));
+  }
+};
+
+TEST(Unit_IR, loadIndexedFromNonSeekableStream) {
+  std::stringstream ss;
+  saveIndexedTestIR(ss);
+
+  // Loading everything reads the frames in order, without the table of
+  // contents, so it works on a stream that cannot seek.
+  NonSeekableBuf Buf(ss.str());
+  std::istream In(&Buf);
+  Context C;
+  auto Result = IR::load(C, In);
+  ASSERT_TRUE(Result);
+  EXPECT_EQ(std::distance((*Result)->modules_begin(), (*Result)->modules_end()),
+            2);
+
+  NonSeekableBuf Buf2(ss.str());
+  std::istream In2(&Buf2);
+  auto Partial = IR::loadModules(C, In2, {"a"});
+  EXPECT_EQ(Partial, IR::load_error::CorruptFile);
+}
+
+TEST(Unit_IR, loadModules) {
+  std::stringstream Indexed;
+  saveIndexedTestIR(Indexed);
+
+  for (bool IsIndexed : {true, false}) {
+    std::stringstream ss;
+    if (IsIndexed) {
+      ss << Indexed.str();
+    } else {
+      Context C;
+      auto Full = IR::load(C, Indexed);
+      ASSERT_TRUE(Full);
+      (*Full)->save(ss);
+      Indexed.clear();
+      Indexed.seekg(0);
+    }
+
+    Context C;
+    auto Result = IR::loadModules(C, ss, {"b"});
+    ASSERT_TRUE(Result);
+    IR* Ir = *Result;
+    ASSERT_EQ(std::distance(Ir->modules_begin(), Ir->modules_end()), 1);
+    EXPECT_EQ(Ir->modules_begin()->getName(), "b");
+    EXPECT_EQ(std::distance(Ir->code_blocks_begin(), Ir->code_blocks_end()),
+              1);
+    // The edge from module a is dropped along with its source.
+    EXPECT_EQ(num_vertices(Ir->getCFG()), 1);
+    EXPECT_EQ(num_edges(Ir->getCFG()), 0);
+    ASSERT_NE(Ir->getAuxData<TestInt32>(), nullptr);
+    EXPECT_EQ(*Ir->getAuxData<TestInt32>(), 7);
+  }
+}
+
+TEST(Unit_IR, loadSectionOnDemand) {
+  std::stringstream ss;
+  saveIndexedTestIR(ss);
+
+  Context C;
+  auto Result = IR::loadModules(C, ss, {"a"}, false);
+  ASSERT_TRUE(Result);
+  IR* Ir = *Result;
+  Module& A = *Ir->modules_begin();
+  EXPECT_EQ(A.sections_begin(), A.sections_end());
+  EXPECT_EQ(A.getEntryPoint(), nullptr);
+  EXPECT_FALSE(A.findSymbols("start").begin()->hasReferent());
+  EXPECT_EQ(num_vertices(Ir->getCFG()), 1);
+
+  ss.clear();
+  ss.seekg(0);
+  auto Text = A.loadSection(C, ss, ".text");
+  ASSERT_TRUE(Text);
+  EXPECT_EQ((*Text)->getName(), ".text");
+  EXPECT_EQ(std::distance(A.sections_begin(), A.sections_end()), 1);
+  ASSERT_NE(A.getEntryPoint(), nullptr);
+  EXPECT_EQ(A.findSymbols("start").begin()->getReferent<CodeBlock>(),
+            A.getEntryPoint());
+  EXPECT_EQ(std::distance(A.symbolic_expressions_begin(),
+                          A.symbolic_expressions_end()),
+            1);
+  // Only the edge to the proxy block is restored; module b was not loaded.
+  EXPECT_EQ(num_vertices(Ir->getCFG()), 2);
+  EXPECT_EQ(num_edges(Ir->getCFG()), 1);
+
+  // Loading a section again does not read it.
+  std::stringstream Empty;
+  auto Again = A.loadSection(C, Empty, ".text");
+  ASSERT_TRUE(Again);
+  EXPECT_EQ(*Again, *Text);
+
+  ss.clear();
+  ss.seekg(0);
+  auto Missing = A.loadSection(C, ss, ".bss");
+  EXPECT_FALSE(Missing);
+  EXPECT_EQ(Missing, IR::load_error::CorruptSection);
+
+  // Sections cannot be loaded into a frozen IR.
+  Ir->freeze();
+  ss.clear();
+  ss.seekg(0);
+  auto Frozen = A.loadSection(C, ss, ".data");
+  EXPECT_FALSE(Frozen);
+  EXPECT_EQ(Frozen, IR::load_error::FrozenIR);
+  EXPECT_EQ(std::distance(A.sections_begin(), A.sections_end()), 1);
+}
+
+TEST(Unit_IR, compressedRoundTrip) {
+  std::stringstream Indexed, Compressed;
+  saveIndexedTestIR(Indexed);
+  saveIndexedTestIR(Compressed, IR::ContainerFormat::Compressed);
+  // Without zlib, nothing is written.
+  if (!IR::isCompressionAvailable()) {
+    EXPECT_TRUE(Compressed.fail());
+    EXPECT_TRUE(Compressed.str().empty());
+    return;
+  }
+  EXPECT_EQ(Compressed.str()[5], 2);
+  EXPECT_LT(Compressed.str().size(), Indexed.str().size());
+
+  {
+    Context C;
+    C.setThreadCount(4);
+    auto Result = IR::load(C, Compressed);
+    ASSERT_TRUE(Result);
+    IR* Ir = *Result;
+    ASSERT_EQ(std::distance(Ir->modules_begin(), Ir->modules_end()), 2);
+    Module& A = *Ir->findModules("a").begin();
+    EXPECT_EQ(std::distance(A.sections_begin(), A.sections_end()), 2);
+    EXPECT_EQ(A.findSections(".data").begin()->getSize(), 4096);
+    EXPECT_EQ(num_edges(Ir->getCFG()), 2);
+    ASSERT_NE(Ir->getAuxData<TestInt32>(), nullptr);
+    EXPECT_EQ(*Ir->getAuxData<TestInt32>(), 7);
+  }
+
+  // Random access works the same way on compressed frames.
+  Compressed.clear();
+  Compressed.seekg(0);
+  Context C;
+  auto Result = IR::loadModules(C, Compressed, {"a"}, false);
+  ASSERT_TRUE(Result);
+  Module& A = *(*Result)->modules_begin();
+  Compressed.clear();
+  Compressed.seekg(0);
+  auto Data = A.loadSection(C, Compressed, ".data");
+  ASSERT_TRUE(Data);
+  EXPECT_EQ((*Data)->getSize(), 4096);
+}
+
+TEST(Unit_IR, loadCorruptCompressedFile) {
+  std::stringstream ss;
+  if (!IR::isCompressionAvailable())
+    return;
+  saveIndexedTestIR(ss, IR::ContainerFormat::Compressed);
+  std::string Bytes = ss.str();
+
+  // Damage the first byte of compressed data, after the header, the frame
+  // header and the uncompressed size of the IR frame.
+  Bytes[8 + 9 + 8] ^= 0xff;
+  std::stringstream Corrupt(Bytes);
+  Context C;
+  auto Result = IR::load(C, Corrupt);
+  EXPECT_EQ(Result, IR::load_error::CorruptFile);
+}
+
+TEST(Unit_IR, jsonMatchesBinaryRoundTrip) {
+  std::stringstream Binary;
+  saveIndexedTestIR(Binary, IR::ContainerFormat::Monolithic);
+
+  // Loading the JSON of an IR gives the same IR as loading its binary form,
+  // so both write the same JSON.
+  Context C1;
+  auto FromBinary = IR::load(C1, Binary);
+  ASSERT_TRUE(FromBinary);
+  std::ostringstream Json;
+  (*FromBinary)->saveJSON(Json);
+
+  Context C2;
+  std::istringstream In(Json.str());
+  auto FromJson = IR::loadJSON(C2, In);
+  ASSERT_TRUE(FromJson);
+  std::ostringstream Again;
+  (*FromJson)->saveJSON(Again);
+  EXPECT_EQ(Again.str(), Json.str());
+
+  Module& A = *(*FromJson)->findModules("a").begin();
+  EXPECT_EQ(std::distance(A.sections_begin(), A.sections_end()), 2);
+  EXPECT_EQ(A.findSymbols("start").begin()->getReferent<CodeBlock>(),
+            A.getEntryPoint());
+  EXPECT_EQ(num_edges((*FromJson)->getCFG()), 2);
+}
+
+// Returns the IR message held by a monolithic file, which follows its
+// 8-byte header. The message types are not exported by the library, so the
+// message is a dynamic one built from the registered descriptor.
+static std::unique_ptr<google::protobuf::Message>
+monolithicMessage(const IR& Ir) {
+  static google::protobuf::DynamicMessageFactory Factory;
+  const google::protobuf::Descriptor* Desc =
+      google::protobuf::DescriptorPool::generated_pool()
+          ->FindMessageTypeByName("gtirb.proto.IR");
+  EXPECT_NE(Desc, nullptr);
+  std::unique_ptr<google::protobuf::Message> Message(
+      Factory.GetPrototype(Desc)->New());
+  std::stringstream Monolithic;
+  Ir.save(Monolithic, IR::ContainerFormat::Monolithic);
+  EXPECT_TRUE(Message->ParseFromString(Monolithic.str().substr(8)));
+  return Message;
+}
+
+TEST(Unit_IR, jsonMatchesProtobuf) {
+  namespace util = google::protobuf::util;
+  std::stringstream Binary;
+  saveIndexedTestIR(Binary, IR::ContainerFormat::Monolithic);
+  Context C;
+  auto Loaded = IR::load(C, Binary);
+  ASSERT_TRUE(Loaded);
+  IR* Ir = *Loaded;
+
+  // No map of the test IR has more than one entry, so protobuf's own text
+  // does not depend on map order.
+  std::ostringstream Json;
+  Ir->saveJSON(Json);
+  auto Message = monolithicMessage(*Ir);
+  std::string Expected;
+  ASSERT_TRUE(util::MessageToJsonString(*Message, &Expected).ok());
+  EXPECT_EQ(Json.str(), Expected);
+
+  // With several AuxData tables per container, compare with the conversion
+  // MessageToJsonString makes of the serialized message, but from a
+  // deterministic serialization, which orders map entries by key.
+  Ir->addAuxData<TestVectorInt64>({1, -2});
+  Ir->addAuxData<AnAuxDataMap>({{"x", 1}, {"y", 2}});
+  Module& A = *Ir->findModules("a").begin();
+  A.addAuxData<TestInt32>(3);
+  A.addAuxData<BarVectorChar>({'a', 'b'});
+  A.addAuxData<FooVectorInt64>({4});
+  Json.str("");
+  Ir->saveJSON(Json);
+  Message = monolithicMessage(*Ir);
+  std::string Bytes;
+  {
+    google::protobuf::io::StringOutputStream Stream(&Bytes);
+    google::protobuf::io::CodedOutputStream Coded(&Stream);
+    Coded.SetSerializationDeterministic(true);
+    ASSERT_TRUE(Message->SerializeToCodedStream(&Coded));
+  }
+  std::unique_ptr<util::TypeResolver> Resolver(
+      util::NewTypeResolverForDescriptorPool(
+          "type.googleapis.com",
+          google::protobuf::DescriptorPool::generated_pool()));
+  std::string TypeUrl =
+      "type.googleapis.com/" + Message->GetDescriptor()->full_name();
+  Expected.clear();
+  ASSERT_TRUE(
+      util::BinaryToJsonString(Resolver.get(), TypeUrl, Bytes, &Expected)
+          .ok());
+  EXPECT_EQ(Json.str(), Expected);
+
+  // Protobuf parses the text back into the same message.
+  std::unique_ptr<google::protobuf::Message> Parsed(Message->New());
+  ASSERT_TRUE(util::JsonStringToMessage(Json.str(), Parsed.get()).ok());
+  EXPECT_TRUE(util::MessageDifferencer::Equals(*Parsed, *Message));
+}
+
+TEST(Unit_IR, jsonStringEscapes) {
+  std::string Name = "a\"b\\c\n\x01<>\x7f\xc3\xa9\xe2\x80\xa8\xf0\x9f\x98\x80";
+  std::ostringstream Out;
+  {
+    Context C;
+    IR* Ir = IR::Create(C);
+    Ir->addModule(C, Name);
+    Ir->saveJSON(Out);
+  }
+  // Characters are escaped as protobuf escapes them.
+  EXPECT_NE(Out.str().find(R"("name":"a\"b\\c\n\u0001\u003c\u003e\u007f)"
+                           "\xc3\xa9\\u2028\xf0\x9f\x98\x80\""),
+            std::string::npos);
+
+  Context C;
+  std::istringstream In(Out.str());
+  auto Result = IR::loadJSON(C, In);
+  ASSERT_TRUE(Result);
+  EXPECT_EQ((*Result)->modules_begin()->getName(), Name);
+}
+
+TEST(Unit_IR, loadJSONFormatting) {
+  // Protobuf field names, whitespace, quoted and unquoted numbers and nulls
+  // are all accepted, as they are by protobuf.
+  std::istringstream In(R"( {
+    "uuid": "AAAAAAAAAAAAAAAAAAAAAQ==",
+    "version": )" + std::to_string(GTIRB_PROTOBUF_VERSION) +
+                        R"(,
+    "aux_data": null,
+    "modules": [ { "uuid": "AAAAAAAAAAAAAAAAAAAAAg==", "name": "m",
+                   "preferred_addr": 4096, "rebaseDelta": "-16",
+                   "isa": "X64", "file_format": 2, "sections": [] } ]
+  } )");
+  Context C;
+  auto Result = IR::loadJSON(C, In);
+  ASSERT_TRUE(Result);
+  Module& M = *(*Result)->modules_begin();
+  EXPECT_EQ(M.getName(), "m");
+  EXPECT_EQ(M.getPreferredAddr(), Addr(4096));
+  EXPECT_EQ(M.getRebaseDelta(), -16);
+  EXPECT_EQ(M.getISA(), ISA::X64);
+  EXPECT_EQ(M.getFileFormat(), FileFormat::ELF);
+
+  for (const char* Bad :
+       {R"({"uuid":"AAAAAAAAAAAAAAAAAAAAAQ==","bogus":1})",
+        R"({"uuid":"AAAAAAAAAAAAAAAAAAAAAQ=="} trailing)",
+        R"({"modules":[{"uuid":"AAAAAAAAAAAAAAAAAAAAAw=="},]})",
+        R"({"version":"seven"})", R"({"uuid":"AAA)"}) {
+    std::istringstream BadIn(Bad);
+    Context BadC;
+    EXPECT_EQ(IR::loadJSON(BadC, BadIn), IR::load_error::CorruptFile) << Bad;
+  }
+}
+
+TEST(Unit_IR, chunkStoreRoundTrip) {
+  std::filesystem::path Dir =
+      std::filesystem::temp_directory_path() /
+      ("gtirb-chunks-" + to_string(boost::uuids::random_generator()()));
+  ChunkStore Store(Dir.string());
+
+  // Two byte intervals with the same contents are stored once.
+  std::vector<uint8_t> Bytes(4096);
+  for (size_t I = 0; I < Bytes.size(); ++I)
+    Bytes[I] = static_cast<uint8_t>(I * 7);
+  Context C;
+  IR* Ir = IR::Create(C);
+  Section* S = Ir->addModule(C, "m")->addSection(C, ".text");
+  S->addByteInterval(C, Addr(0x1000), Bytes.begin(), Bytes.end());
+  S->addByteInterval(C, Addr(0x2000), Bytes.begin(), Bytes.end());
+
+  // Monolithic files cannot refer to a store.
+  std::stringstream Monolithic;
+  Ir->save(Monolithic, IR::ContainerFormat::Monolithic, Store);
+  EXPECT_TRUE(Monolithic.fail());
+  EXPECT_TRUE(Monolithic.str().empty());
+
+  for (auto Format :
+       {IR::ContainerFormat::Indexed, IR::ContainerFormat::Compressed}) {
+    if (Format == IR::ContainerFormat::Compressed &&
+        !IR::isCompressionAvailable())
+      continue;
+    std::stringstream ss;
+    Ir->save(ss, Format, Store);
+    EXPECT_LT(ss.str().size(), Bytes.size());
+
+    Context C2;
+    std::stringstream Copy(ss.str());
+    auto Result = IR::load(C2, ss, Store);
+    ASSERT_TRUE(Result);
+    const Section& S2 = *(*Result)->modules_begin()->sections_begin();
+    ASSERT_EQ(std::distance(S2.byte_intervals_begin(),
+                            S2.byte_intervals_end()),
+              2);
+    for (const ByteInterval& BI : S2.byte_intervals())
+      EXPECT_TRUE(std::equal(BI.bytes_begin<uint8_t>(),
+                             BI.bytes_end<uint8_t>(), Bytes.begin(),
+                             Bytes.end()));
+
+    // The contents cannot be loaded without the store.
+    Context C3;
+    EXPECT_FALSE(IR::load(C3, Copy));
+  }
+
+  size_t Chunks = 0;
+  for (const auto& Entry :
+       std::filesystem::recursive_directory_iterator(Dir))
+    Chunks += Entry.is_regular_file();
+  EXPECT_EQ(Chunks, 1);
+
+  // A chunk whose contents changed on disk is reported when loading, and
+  // replaced by the next save.
+  std::stringstream Saved;
+  Ir->save(Saved, IR::ContainerFormat::Indexed, Store);
+  for (const auto& Entry :
+       std::filesystem::recursive_directory_iterator(Dir)) {
+    if (!Entry.is_regular_file())
+      continue;
+    std::ofstream Damage(Entry.path(), std::ios::binary);
+    std::string Zeros(Bytes.size(), '\0');
+    Damage.write(Zeros.data(), static_cast<std::streamsize>(Zeros.size()));
+  }
+  {
+    std::stringstream Copy(Saved.str());
+    Context C5;
+    EXPECT_EQ(IR::load(C5, Copy, Store), IR::load_error::CorruptFile);
+  }
+  std::stringstream Resaved;
+  Ir->save(Resaved, IR::ContainerFormat::Indexed, Store);
+  {
+    std::stringstream Copy(Saved.str());
+    Context C5;
+    auto Repaired = IR::load(C5, Copy, Store);
+    ASSERT_TRUE(Repaired);
+    const ByteInterval& BI =
+        *(*Repaired)->modules_begin()->byte_intervals_begin();
+    EXPECT_TRUE(std::equal(BI.bytes_begin<uint8_t>(), BI.bytes_end<uint8_t>(),
+                           Bytes.begin(), Bytes.end()));
+  }
+
+  // A chunk that has gone missing is reported when loading.
+  std::stringstream ss;
+  Ir->save(ss, IR::ContainerFormat::Indexed, Store);
+  std::filesystem::remove_all(Dir);
+  Context C4;
+  auto Missing = IR::load(C4, ss, Store);
+  ASSERT_FALSE(Missing);
+  EXPECT_EQ(Missing, IR::load_error::CorruptFile);
+}
+
+TEST(Unit_IR, loadLazily) {
+  std::stringstream ss;
+  saveIndexedTestIR(ss);
+  std::filesystem::path Path =
+      std::filesystem::temp_directory_path() /
+      ("gtirb-lazy-" + to_string(boost::uuids::random_generator()()));
+  {
+    std::ofstream Out(Path, std::ios::binary);
+    Out << ss.str();
+  }
+
+  // The UUIDs of nodes are the same in every copy of the IR.
+  Context Full;
+  IR* FullIr = *IR::load(Full, ss);
+  UUID DataId = FullIr->findModules("a")
+                    .begin()
+                    ->findSections(".data")
+                    .begin()
+                    ->data_blocks_begin()
+                    ->getUUID();
+  UUID TextBId = FullIr->findModules("b")
+                     .begin()
+                     ->findSections(".text")
+                     .begin()
+                     ->getUUID();
+
+  Context C;
+  auto Result = IR::loadLazily(C, Path.string());
+  ASSERT_TRUE(Result);
+  IR* Ir = *Result;
+  Module& A = *Ir->findModules("a").begin();
+  EXPECT_EQ(A.getEntryPoint(), nullptr);
+  EXPECT_EQ(num_edges(Ir->getCFG()), 0);
+
+  // Looking a section up by name reads it, and restores what refers to it.
+  EXPECT_EQ(std::distance(A.findSections(".text").begin(),
+                          A.findSections(".text").end()),
+            1);
+  ASSERT_NE(A.getEntryPoint(), nullptr);
+  EXPECT_EQ(A.findSymbols("start").begin()->getReferent<CodeBlock>(),
+            A.getEntryPoint());
+  EXPECT_EQ(num_edges(Ir->getCFG()), 1);
+
+  // Looking a node up by UUID reads only the section that holds it, also
+  // through a const Context.
+  auto* TextB = dyn_cast_or_null<Section>(Node::getByUUID(C, TextBId));
+  ASSERT_NE(TextB, nullptr);
+  EXPECT_EQ(TextB->getModule()->getName(), "b");
+  EXPECT_EQ(num_edges(Ir->getCFG()), 2);
+  const Context& ConstC = C;
+  auto* DB = dyn_cast_or_null<DataBlock>(Node::getByUUID(ConstC, DataId));
+  ASSERT_NE(DB, nullptr);
+  EXPECT_EQ(DB->getAddress(), Addr(0x2000));
+  EXPECT_EQ(std::distance(A.sections_begin(), A.sections_end()), 2);
+  EXPECT_EQ(Node::getByUUID(C, boost::uuids::random_generator()()), nullptr);
+
+  // Looking up by address or iterating over the sections of a module reads
+  // all of its sections, but not those of other modules.
+  Context Queried;
+  auto Query = IR::loadLazily(Queried, Path.string());
+  ASSERT_TRUE(Query);
+  const Module& QueryA = *(*Query)->findModules("a").begin();
+  EXPECT_EQ(std::distance(QueryA.findDataBlocksOn(Addr(0x2004)).begin(),
+                          QueryA.findDataBlocksOn(Addr(0x2004)).end()),
+            1);
+  EXPECT_NE(QueryA.getEntryPoint(), nullptr);
+  EXPECT_EQ(num_edges((*Query)->getCFG()), 1);
+  EXPECT_EQ(std::distance(QueryA.sections_begin(), QueryA.sections_end()), 2);
+
+  // Freezing reads the remaining sections, which cannot be added to a
+  // frozen IR.
+  (*Query)->freeze();
+  EXPECT_EQ(num_edges((*Query)->getCFG()), 2);
+  EXPECT_EQ(std::distance((*Query)->findCodeBlocksOn(Addr(0x3000)).begin(),
+                          (*Query)->findCodeBlocksOn(Addr(0x3000)).end()),
+            1);
+  EXPECT_FALSE((*Query)->loadPendingSections().ErrorCode);
+
+  // Serializing an IR reads the sections that have not been read yet.
+  Context Untouched;
+  auto Unread = IR::loadLazily(Untouched, Path.string());
+  ASSERT_TRUE(Unread);
+  EXPECT_EQ((*Unread)->contentHash(), FullIr->contentHash());
+  Module& UnreadA = *(*Unread)->findModules("a").begin();
+  EXPECT_EQ(std::distance(UnreadA.sections_begin(), UnreadA.sections_end()),
+            2);
+
+  std::filesystem::remove(Path);
+}
+
+TEST(Unit_IR, canonicalSaveIsStable) {
+  std::stringstream Saved;
+  saveIndexedTestIR(Saved, IR::ContainerFormat::Monolithic);
+
+  // Re-adding a CFG edge moves it to the end of the edge list, which changes
+  // the ordinary output but not the canonical output.
+  Context C1, C2;
+  std::stringstream Copy(Saved.str());
+  IR* A = *IR::load(C1, Saved);
+  IR* B = *IR::load(C2, Copy);
+  Module& MA = *A->findModules("a").begin();
+  CodeBlock* Entry = MA.getEntryPoint();
+  ProxyBlock* Proxy = &*MA.proxy_blocks_begin();
+  ASSERT_TRUE(removeEdge(Entry, Proxy, A->getCFG()));
+  addEdge(Entry, Proxy, A->getCFG());
+
+  std::stringstream PlainA, PlainB;
+  A->save(PlainA);
+  B->save(PlainB);
+  EXPECT_NE(PlainA.str(), PlainB.str());
+
+  std::stringstream OutA, OutB;
+  std::string HashA = A->saveCanonical(OutA);
+  std::string HashB = B->saveCanonical(OutB);
+  EXPECT_EQ(OutA.str(), OutB.str());
+  EXPECT_EQ(HashA, HashB);
+  EXPECT_EQ(HashA.size(), 40);
+  EXPECT_EQ(A->contentHash(), HashA);
+
+  // The canonical format loads like any other, and a change to the IR
+  // changes its hash.
+  Context C3;
+  auto Reloaded = IR::load(C3, OutA);
+  ASSERT_TRUE(Reloaded);
+  EXPECT_EQ((*Reloaded)->contentHash(), HashA);
+  B->addAuxData<TestInt32>(8);
+  EXPECT_NE(B->contentHash(), HashA);
+}
+
+TEST(Unit_IR, canonicalSaveSortsHashedContainers) {
+  std::stringstream Saved;
+  saveIndexedTestIR(Saved, IR::ContainerFormat::Monolithic);
+
+  // Equal tables built in different orders and with different bucket counts
+  // iterate differently, but hash alike.
+  TestUnorderedSets::Type Forward, Backward;
+  Backward.reserve(1024);
+  for (uint64_t I = 0; I < 200; ++I) {
+    Forward["set " + std::to_string(I % 7)].insert(I * 977);
+    uint64_t J = 199 - I;
+    auto& Set = Backward["set " + std::to_string(J % 7)];
+    Set.reserve(512);
+    Set.insert(J * 977);
+  }
+  ASSERT_EQ(Forward, Backward);
+
+  Context C1, C2;
+  std::stringstream Copy(Saved.str());
+  IR* A = *IR::load(C1, Saved);
+  IR* B = *IR::load(C2, Copy);
+  A->addAuxData<TestUnorderedSets>(TestUnorderedSets::Type(Forward));
+  A->findModules("a").begin()->addAuxData<TestUnorderedSets>(
+      TestUnorderedSets::Type(Backward));
+  B->addAuxData<TestUnorderedSets>(std::move(Backward));
+  B->findModules("a").begin()->addAuxData<TestUnorderedSets>(
+      std::move(Forward));
+  std::string Hash = A->contentHash();
+  EXPECT_EQ(B->contentHash(), Hash);
+
+  // Tables loaded from bytes in either order are decoded and sorted too.
+  std::stringstream PlainB;
+  B->save(PlainB);
+  Context C3;
+  auto Reloaded = IR::load(C3, PlainB);
+  ASSERT_TRUE(Reloaded);
+  EXPECT_EQ((*Reloaded)->contentHash(), Hash);
+}
+
+TEST(Unit_IR, canonicalSaveMergesAppendedEntries) {
+  std::stringstream Saved;
+  saveIndexedTestIR(Saved, IR::ContainerFormat::Monolithic);
+
+  // A loaded mapping keeps the appended entries apart and writes them after
+  // its own, but hashes like the same mapping built in memory.
+  Context C1;
+  IR* A = *IR::load(C1, Saved);
+  A->addAuxData<AnAuxDataMap>({{"b", 2}, {"d", 4}});
+  std::stringstream WithTable;
+  A->save(WithTable);
+  std::stringstream Copy(WithTable.str());
+
+  Context C2, C3;
+  IR* B = *IR::load(C2, WithTable);
+  IR* Expected = *IR::load(C3, Copy);
+  ASSERT_TRUE(B->appendAuxData<AnAuxDataMap>({{"a", 1}, {"c", 3}}));
+  Expected->addAuxData<AnAuxDataMap>({{"a", 1}, {"b", 2}, {"c", 3}, {"d", 4}});
+
+  std::stringstream PlainB, PlainExpected;
+  B->save(PlainB);
+  Expected->save(PlainExpected);
+  EXPECT_NE(PlainB.str(), PlainExpected.str());
+  EXPECT_EQ(B->contentHash(), Expected->contentHash());
+}
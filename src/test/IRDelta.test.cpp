@@ -0,0 +1,236 @@
+//===- IRDelta.test.cpp -----------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#include <gtirb/AuxData.hpp>
+#include <gtirb/CodeBlock.hpp>
+#include <gtirb/Context.hpp>
+#include <gtirb/DataBlock.hpp>
+#include <gtirb/IR.hpp>
+#include <gtirb/IRDelta.hpp>
+#include <gtirb/Module.hpp>
+#include <gtirb/Section.hpp>
+#include <gtirb/Symbol.hpp>
+#include <gtirb/SymbolicExpression.hpp>
+#include <gtest/gtest.h>
+#include <sstream>
+
+namespace gtirb {
+namespace schema {
+// Registered by IR.test.cpp.
+struct TestInt32 {
+  static constexpr const char* Name = "test int32";
+  typedef int32_t Type;
+};
+} // namespace schema
+} // namespace gtirb
+
+using namespace gtirb;
+using namespace gtirb::schema;
+
+// Saves an IR with a small .text section and a large .data section.
+static std::string saveBaseIR(
+    IR::ContainerFormat Format = IR::ContainerFormat::Monolithic) {
+  Context C;
+  IR* Ir = IR::Create(C);
+  Ir->addAuxData<TestInt32>(1);
+  Module* M = Ir->addModule(C, "m");
+  ByteInterval* Text =
+      M->addSection(C, ".text")->addByteInterval(C, Addr(0x1000), 64);
+  CodeBlock* B1 = Text->addBlock<CodeBlock>(C, 0, 16);
+  CodeBlock* B2 = Text->addBlock<CodeBlock>(C, 16, 16);
+  Symbol* Sym = M->addSymbol(C, B1, "f");
+  Text->addSymbolicExpression<SymAddrConst>(4, 0, Sym);
+  addEdge(B1, B2, Ir->getCFG());
+  std::vector<uint8_t> Bytes(1 << 16, 0x90);
+  ByteInterval* Data = M->addSection(C, ".data")
+                           ->addByteInterval(C, Addr(0x2000), Bytes.begin(),
+                                             Bytes.end());
+  Data->addBlock<DataBlock>(C, 0, Bytes.size());
+
+  std::ostringstream Out;
+  Ir->save(Out, Format);
+  return Out.str();
+}
+
+static IR* loadIR(Context& C, const std::string& Bytes) {
+  std::istringstream In(Bytes);
+  auto Result = IR::load(C, In);
+  EXPECT_TRUE(Result);
+  return Result ? *Result : nullptr;
+}
+
+TEST(Unit_IRDelta, unchangedIsEmpty) {
+  std::string Base = saveBaseIR();
+  Context C1, C2;
+  IRDelta Delta = IRDelta::compute(*loadIR(C1, Base), *loadIR(C2, Base));
+  EXPECT_TRUE(Delta.empty());
+}
+
+TEST(Unit_IRDelta, applyReproducesTarget) {
+  std::string Base = saveBaseIR();
+  Context C;
+  IR* Target = loadIR(C, Base);
+  Module& M = *Target->modules_begin();
+  Section& Text = *M.findSections(".text").begin();
+  ByteInterval& BI = *Text.byte_intervals_begin();
+  CodeBlock* B1 = &*BI.code_blocks_begin();
+  CodeBlock* B2 = &*std::next(BI.code_blocks_begin());
+  Symbol* Sym = &*M.findSymbols("f").begin();
+
+  // Change a block, a symbolic expression, the contents of .text and the
+  // IR's AuxData; remove a block with its edge; add a block, a symbolic
+  // expression, an edge and a section.
+  B1->setSize(12);
+  BI.addSymbolicExpression<SymAddrConst>(4, 8, Sym);
+  BI.addSymbolicExpression<SymAddrConst>(40, 0, Sym);
+  *BI.bytes_begin<uint8_t>() = 0xc3;
+  Target->addAuxData<TestInt32>(2);
+  BI.removeBlock(B2);
+  CodeBlock* B3 = BI.addBlock<CodeBlock>(C, 32, 8);
+  addEdge(B1, B3, Target->getCFG());
+  M.addSection(C, ".bss")->addByteInterval(C, Addr(0x3000), 0x100);
+
+  Context CB;
+  IRDelta Delta = IRDelta::compute(*loadIR(CB, Base), *Target);
+  EXPECT_FALSE(Delta.empty());
+
+  std::stringstream Saved;
+  Delta.save(Saved);
+  EXPECT_LT(Saved.str().size(), Base.size() / 10);
+  auto Loaded = IRDelta::load(Saved);
+  ASSERT_TRUE(Loaded);
+
+  Context CA;
+  std::istringstream BaseIn(Base);
+  auto Applied = Loaded->apply(CA, BaseIn);
+  ASSERT_TRUE(Applied);
+  EXPECT_TRUE(IRDelta::compute(*Target, **Applied).empty());
+
+  const Module& AM = *(*Applied)->modules_begin();
+  EXPECT_EQ(std::distance(AM.sections_begin(), AM.sections_end()), 3);
+  const ByteInterval& ABI =
+      *AM.findSections(".text").begin()->byte_intervals_begin();
+  EXPECT_EQ(*ABI.bytes_begin<uint8_t>(), 0xc3);
+  EXPECT_EQ(std::distance(ABI.code_blocks_begin(), ABI.code_blocks_end()), 2);
+  EXPECT_EQ(std::distance(ABI.symbolic_expressions_begin(),
+                          ABI.symbolic_expressions_end()),
+            2);
+  EXPECT_EQ(*(*Applied)->getAuxData<TestInt32>(), 2);
+  EXPECT_EQ(num_vertices((*Applied)->getCFG()), 2);
+  EXPECT_EQ(num_edges((*Applied)->getCFG()), 1);
+}
+
+TEST(Unit_IRDelta, changedBytesOnly) {
+  std::string Base = saveBaseIR();
+  Context C;
+  IR* Target = loadIR(C, Base);
+  Module& M = *Target->modules_begin();
+  ByteInterval& Data = *M.findSections(".data").begin()->byte_intervals_begin();
+  ByteInterval& Text = *M.findSections(".text").begin()->byte_intervals_begin();
+
+  // Changing a few bytes of the large interval records only those bytes,
+  // and cutting the small one records only its new size.
+  *(Data.bytes_begin<uint8_t>() + 100) = 0xcc;
+  *(Data.bytes_begin<uint8_t>() + 104) = 0xcc;
+  *(Data.bytes_begin<uint8_t>() + 40000) = 0xcc;
+  Text.setInitializedSize(32);
+
+  Context CB;
+  IRDelta Delta = IRDelta::compute(*loadIR(CB, Base), *Target);
+  std::stringstream Saved;
+  Delta.save(Saved);
+  EXPECT_LT(Saved.str().size(), 256);
+
+  Context CA;
+  std::istringstream BaseIn(Base);
+  auto Applied = Delta.apply(CA, BaseIn);
+  ASSERT_TRUE(Applied);
+  EXPECT_TRUE(IRDelta::compute(*Target, **Applied).empty());
+  const Module& AM = *(*Applied)->modules_begin();
+  const ByteInterval& AData =
+      *AM.findSections(".data").begin()->byte_intervals_begin();
+  EXPECT_TRUE(std::equal(AData.bytes_begin<uint8_t>(),
+                         AData.bytes_end<uint8_t>(),
+                         Data.bytes_begin<uint8_t>(),
+                         Data.bytes_end<uint8_t>()));
+  EXPECT_EQ(AM.findSections(".text")
+                .begin()
+                ->byte_intervals_begin()
+                ->getInitializedSize(),
+            32);
+}
+
+TEST(Unit_IRDelta, applyToIndexedBase) {
+  // The symbolic expressions of an indexed base are packed, and removing one
+  // must remove it from there.
+  std::string Base = saveBaseIR(IR::ContainerFormat::Indexed);
+  Context C;
+  IR* Target = loadIR(C, Base);
+  Module& M = *Target->modules_begin();
+  ByteInterval& BI = *M.findSections(".text").begin()->byte_intervals_begin();
+  BI.removeSymbolicExpression(4);
+
+  Context CB;
+  IRDelta Delta = IRDelta::compute(*loadIR(CB, Base), *Target);
+  Context CA;
+  std::istringstream BaseIn(Base);
+  auto Applied = Delta.apply(CA, BaseIn);
+  ASSERT_TRUE(Applied);
+  EXPECT_TRUE(IRDelta::compute(*Target, **Applied).empty());
+  EXPECT_EQ((*Applied)->symbolic_expressions_begin(),
+            (*Applied)->symbolic_expressions_end());
+}
+
+TEST(Unit_IRDelta, removeSection) {
+  std::string Base = saveBaseIR();
+  Context C;
+  IR* Target = loadIR(C, Base);
+  Module& M = *Target->modules_begin();
+  M.removeSymbol(&*M.findSymbols("f").begin());
+  M.removeSection(&*M.findSections(".text").begin());
+
+  Context CB;
+  IRDelta Delta = IRDelta::compute(*loadIR(CB, Base), *Target);
+  Context CA;
+  std::istringstream BaseIn(Base);
+  auto Applied = Delta.apply(CA, BaseIn);
+  ASSERT_TRUE(Applied);
+  EXPECT_TRUE(IRDelta::compute(*Target, **Applied).empty());
+  EXPECT_EQ(num_edges((*Applied)->getCFG()), 0);
+}
+
+TEST(Unit_IRDelta, wrongFiles) {
+  std::string Base = saveBaseIR();
+  Context C1, C2;
+  IR* Target = loadIR(C2, Base);
+  Target->addAuxData<TestInt32>(3);
+  IRDelta Delta = IRDelta::compute(*loadIR(C1, Base), *Target);
+  std::stringstream Saved;
+  Delta.save(Saved);
+
+  // A delta is not an IR, and an IR is not a delta.
+  Context C3;
+  std::istringstream DeltaIn(Saved.str());
+  EXPECT_EQ(IR::load(C3, DeltaIn), IR::load_error::CorruptFile);
+  std::istringstream BaseIn(Base);
+  EXPECT_FALSE(IRDelta::load(BaseIn));
+
+  // A delta applies only to its base.
+  Context C4;
+  IR* Other = IR::Create(C4);
+  std::stringstream OtherIn;
+  Other->save(OtherIn);
+  Context C5;
+  EXPECT_EQ(Delta.apply(C5, OtherIn), IR::load_error::CorruptFile);
+}
@@ -10,6 +10,7 @@
 void registerAuxDataContainerTestAuxDataTypes();
 void registerIrTestAuxDataTypes();
 void registerModuleTestAuxDataTypes();
+void registerNodePropertyTestAuxDataTypes();
 
 static gtirb::Context Ctx;
 
@@ -37,6 +38,7 @@ int main(int argc, char** argv) {
   registerAuxDataContainerTestAuxDataTypes();
   registerIrTestAuxDataTypes();
   registerModuleTestAuxDataTypes();
+  registerNodePropertyTestAuxDataTypes();
 
   // Expect a gtirb filename passed as argv[1]
   std::string GtirbFilename;
@@ -13,6 +13,7 @@
 //
 //===----------------------------------------------------------------------===//
 #include "SerializationTestHarness.hpp"
+#include "TestHelpers.hpp"
 #include <gtirb/AuxData.hpp>
 #include <gtirb/CodeBlock.hpp>
 #include <gtirb/Context.hpp>
@@ -793,6 +794,83 @@ TEST(Unit_Module, findCodeBlocksOn) {
   EXPECT_EQ(&*std::next(ConstBlockRange.begin(), 1), CB11);
 }
 
+TEST(Unit_Module, resolveAddresses) {
+  auto* M = Module::Create(Ctx, "test");
+  auto* S1 = M->addSection(Ctx, "S1");
+  auto* BI1 = S1->addByteInterval(Ctx, Addr(4), 16);
+  auto* CB11 = BI1->addBlock<CodeBlock>(Ctx, 0, 4);
+  BI1->addBlock<DataBlock>(Ctx, 4, 4);
+  auto* CB12 = BI1->addBlock<CodeBlock>(Ctx, 8, 8);
+  auto* S2 = M->addSection(Ctx, "S2");
+  auto* BI2 = S2->addByteInterval(Ctx, Addr(0), 10);
+  auto* CB21 = BI2->addBlock<CodeBlock>(Ctx, 0, 2);
+  auto* CB22 = BI2->addBlock<CodeBlock>(Ctx, 5, 2);
+  BI2->addBlock<CodeBlock>(Ctx, 8, 0);
+  auto* S3 = M->addSection(Ctx, "S3");
+  auto* BI3 = S3->addByteInterval(Ctx, 4);
+  BI3->addBlock<CodeBlock>(Ctx, 0, 4);
+
+  // Every address resolves to the first block reported by findCodeBlocksOn,
+  // whether or not the input is sorted.
+  std::vector<Addr> Sorted;
+  for (uint64_t A = 0; A < 24; ++A)
+    Sorted.push_back(Addr(A));
+  std::vector<Addr> Unsorted(Sorted.rbegin(), Sorted.rend());
+  std::swap(Unsorted[3], Unsorted[17]);
+
+  for (const auto& Addrs : {Sorted, Unsorted}) {
+    std::vector<const CodeBlock*> Blocks = M->resolveAddresses(Addrs);
+    ASSERT_EQ(Blocks.size(), Addrs.size());
+    for (size_t I = 0; I < Addrs.size(); ++I) {
+      auto Range = M->findCodeBlocksOn(Addrs[I]);
+      const CodeBlock* Expected = Range.empty() ? nullptr : &Range.front();
+      EXPECT_EQ(Blocks[I], Expected) << "at address " << Addrs[I];
+    }
+  }
+
+  std::vector<Addr> Addrs{Addr(5), Addr(0), Addr(2), Addr(13), Addr(20)};
+  std::vector<const CodeBlock*> Blocks = M->resolveAddresses(Addrs);
+  EXPECT_EQ(Blocks, (std::vector<const CodeBlock*>{CB11, CB21, nullptr, CB12,
+                                                   nullptr}));
+
+  // Results do not depend on the number of threads.
+  std::vector<Addr> Many;
+  for (uint64_t I = 0; I < 100000; ++I)
+    Many.push_back(Addr((I * 7919) % 32));
+  std::vector<const CodeBlock*> Serial = M->resolveAddresses(Many);
+  EXPECT_EQ(M->resolveAddresses(Many, 4), Serial);
+  EXPECT_EQ(M->resolveAddresses(Many, 0), Serial);
+  std::sort(Many.begin(), Many.end());
+  Serial = M->resolveAddresses(Many);
+  EXPECT_EQ(M->resolveAddresses(Many, 4), Serial);
+  EXPECT_EQ(Serial.front(), CB21);
+  EXPECT_EQ(Serial.back(), nullptr);
+
+  // Addresses overlapped by more than one block resolve to the lowest one.
+  BI1->setAddress(Addr(2));
+  Blocks = M->resolveAddresses(std::vector<Addr>{Addr(5), Addr(6)});
+  EXPECT_EQ(Blocks, (std::vector<const CodeBlock*>{CB11, CB22}));
+
+  // A long block that starts first wins over every block nested inside it,
+  // and addresses past its end fall through to the nested blocks.
+  auto* M2 = Module::Create(Ctx, "long");
+  auto* BI4 = M2->addSection(Ctx, "S")->addByteInterval(Ctx, Addr(0), 1024);
+  auto* Long = BI4->addBlock<CodeBlock>(Ctx, 0, 512);
+  std::vector<Addr> Nested;
+  for (uint64_t Offset = 1; Offset < 1024; Offset += 2) {
+    BI4->addBlock<CodeBlock>(Ctx, Offset, 1);
+    Nested.push_back(Addr(Offset));
+  }
+  Blocks = M2->resolveAddresses(Nested);
+  for (size_t I = 0; I < Nested.size(); ++I) {
+    auto Range = M2->findCodeBlocksOn(Nested[I]);
+    EXPECT_EQ(Blocks[I], &Range.front()) << "at address " << Nested[I];
+    if (Nested[I] < Addr(512)) {
+      EXPECT_EQ(Blocks[I], Long);
+    }
+  }
+}
+
 TEST(Unit_Module, findDataBlocksOn) {
   auto* M = Module::Create(Ctx, "test");
   auto* S1 = M->addSection(Ctx, "S1");
@@ -1615,6 +1693,31 @@ TEST(Unit_Module, removeNodes) {
   EXPECT_EQ(std::distance(M->symbols_begin(), M->symbols_end()), 0);
 }
 
+TEST(Unit_Module, proxyBlockOrder) {
+  auto* M = Module::Create(Ctx, "M");
+  std::vector<ProxyBlock*> Proxies;
+  for (int I = 0; I < 5; ++I)
+    Proxies.push_back(M->addProxyBlock(Ctx));
+
+  // Proxy blocks iterate in insertion order.
+  EXPECT_EQ(pointers(M->proxy_blocks()), Proxies);
+
+  // Removal moves the last proxy block into the vacated position.
+  EXPECT_EQ(M->removeProxyBlock(Proxies[1]), ChangeStatus::Accepted);
+  EXPECT_EQ(M->removeProxyBlock(Proxies[1]), ChangeStatus::NoChange);
+  EXPECT_EQ(pointers(M->proxy_blocks()),
+            std::vector<ProxyBlock*>({Proxies[0], Proxies[4], Proxies[2],
+                                      Proxies[3]}));
+  EXPECT_EQ(M->removeProxyBlock(Proxies[3]), ChangeStatus::Accepted);
+  EXPECT_EQ(M->removeProxyBlock(Proxies[4]), ChangeStatus::Accepted);
+  EXPECT_EQ(pointers(M->proxy_blocks()),
+            std::vector<ProxyBlock*>({Proxies[0], Proxies[2]}));
+  EXPECT_EQ(M->addProxyBlock(Proxies[0]), ChangeStatus::NoChange);
+  EXPECT_EQ(M->addProxyBlock(Proxies[4]), ChangeStatus::Accepted);
+  EXPECT_EQ(pointers(M->proxy_blocks()),
+            std::vector<ProxyBlock*>({Proxies[0], Proxies[2], Proxies[4]}));
+}
+
 TEST(Unit_Module, removeInvalidSection) {
   auto* M1 = Module::Create(Ctx, "M1");
   auto* M2 = Module::Create(Ctx, "M2");
@@ -12,7 +12,10 @@
 //  endorsement should be inferred.
 //
 //===----------------------------------------------------------------------===//
+#include <gtirb/ByteInterval.hpp>
+#include <gtirb/CodeBlock.hpp>
 #include <gtirb/Context.hpp>
+#include <gtirb/DataBlock.hpp>
 #include <gtirb/Node.hpp>
 #include <fstream>
 #include <gtest/gtest.h>
@@ -54,3 +57,15 @@ TEST(Unit_Node, getByUUID) {
   const gtirb::Context& ConstCtx = Ctx;
   EXPECT_EQ(gtirb::Node::getByUUID(ConstCtx, N->getUUID()), N);
 }
+
+TEST(Unit_Node, contextIndexesCountEachKind) {
+  gtirb::Context C;
+  auto* BI = gtirb::ByteInterval::Create(C, gtirb::Addr(0), 16);
+  auto* B0 = BI->addBlock<gtirb::CodeBlock>(C, 0, 4);
+  auto* D0 = BI->addBlock<gtirb::DataBlock>(C, 4, 4);
+  auto* B1 = BI->addBlock<gtirb::CodeBlock>(C, 8, 4);
+  EXPECT_EQ(BI->getContextIndex(), 0);
+  EXPECT_EQ(B0->getContextIndex(), 0);
+  EXPECT_EQ(D0->getContextIndex(), 0);
+  EXPECT_EQ(B1->getContextIndex(), 1);
+}
@@ -0,0 +1,108 @@
+//===- NodeProperty.test.cpp ------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#include <gtirb/AuxDataSchema.hpp>
+#include <gtirb/ByteInterval.hpp>
+#include <gtirb/CodeBlock.hpp>
+#include <gtirb/Context.hpp>
+#include <gtirb/DataBlock.hpp>
+#include <gtirb/Module.hpp>
+#include <gtirb/NodeProperty.hpp>
+#include <gtest/gtest.h>
+
+using namespace gtirb;
+
+static Context Ctx;
+
+void registerNodePropertyTestAuxDataTypes() {
+  AuxDataContainer::registerAuxDataType<schema::Alignment>();
+}
+
+TEST(Unit_NodeProperty, setFindErase) {
+  auto* BI = ByteInterval::Create(Ctx, Addr(0), 16);
+  auto* B0 = BI->addBlock<CodeBlock>(Ctx, 0, 4);
+  auto* B1 = BI->addBlock<CodeBlock>(Ctx, 4, 4);
+  auto* D = BI->addBlock<DataBlock>(Ctx, 8, 4);
+
+  NodeProperty<Node, uint64_t> Alignment(Ctx);
+  EXPECT_TRUE(Alignment.empty());
+  Alignment.set(*B1, 4);
+  Alignment.set(*D, 8);
+  ASSERT_NE(Alignment.find(*B1), nullptr);
+  EXPECT_EQ(*Alignment.find(*B1), 4);
+  EXPECT_EQ(*Alignment.find(*D), 8);
+  EXPECT_EQ(Alignment.find(*B0), nullptr);
+  EXPECT_EQ(Alignment.find(*BI), nullptr);
+  EXPECT_EQ(Alignment.size(), 2);
+
+  *Alignment.find(*B1) = 16;
+  Alignment.set(*D, 2);
+  EXPECT_EQ(*Alignment.find(*B1), 16);
+  EXPECT_EQ(*Alignment.find(*D), 2);
+  EXPECT_EQ(Alignment.size(), 2);
+
+  EXPECT_TRUE(Alignment.erase(*B1));
+  EXPECT_FALSE(Alignment.erase(*B1));
+  EXPECT_FALSE(Alignment.contains(*B1));
+  EXPECT_EQ(Alignment.size(), 1);
+}
+
+TEST(Unit_NodeProperty, boolValues) {
+  auto* BI = ByteInterval::Create(Ctx, Addr(0), 8);
+  auto* B0 = BI->addBlock<CodeBlock>(Ctx, 0, 4);
+  auto* B1 = BI->addBlock<CodeBlock>(Ctx, 4, 4);
+
+  NodeProperty<CodeBlock, bool> IsEntry(Ctx);
+  IsEntry.set(*B0, true);
+  IsEntry.set(*B1, false);
+  ASSERT_NE(IsEntry.find(*B0), nullptr);
+  EXPECT_TRUE(*IsEntry.find(*B0));
+  EXPECT_FALSE(*IsEntry.find(*B1));
+
+  *IsEntry.find(*B1) = true;
+  EXPECT_TRUE(*IsEntry.find(*B1));
+  EXPECT_EQ(IsEntry.toMap(), (std::map<UUID, bool>{{B0->getUUID(), true},
+                                                    {B1->getUUID(), true}}));
+}
+
+TEST(Unit_NodeProperty, auxDataRoundTrip) {
+  auto* M = Module::Create(Ctx, "M");
+  auto* BI = ByteInterval::Create(Ctx, Addr(0), 16);
+  auto* B0 = BI->addBlock<CodeBlock>(Ctx, 0, 4);
+  auto* B1 = BI->addBlock<CodeBlock>(Ctx, 4, 4);
+  auto* D = BI->addBlock<DataBlock>(Ctx, 8, 4);
+  UUID Missing = Node::Create(Ctx)->getUUID();
+
+  M->addAuxData<schema::Alignment>({{B0->getUUID(), 2},
+                                    {B1->getUUID(), 4},
+                                    {D->getUUID(), 8},
+                                    {Missing, 16}});
+
+  NodeProperty<CodeBlock, uint64_t> Alignment(Ctx);
+  ASSERT_TRUE(Alignment.loadAuxData<schema::Alignment>(*M));
+  EXPECT_EQ(Alignment.size(), 2);
+  EXPECT_EQ(*Alignment.find(*B0), 2);
+  EXPECT_EQ(*Alignment.find(*B1), 4);
+  // Values for other kinds of nodes, or for UUIDs of no node, are kept.
+  EXPECT_EQ(Alignment.unresolved(),
+            (std::map<UUID, uint64_t>{{D->getUUID(), 8}, {Missing, 16}}));
+
+  Alignment.set(*B0, 32);
+  Alignment.saveAuxData<schema::Alignment>(*M);
+  EXPECT_EQ(*M->getAuxData<schema::Alignment>(),
+            (std::map<UUID, uint64_t>{{B0->getUUID(), 32},
+                                      {B1->getUUID(), 4},
+                                      {D->getUUID(), 8},
+                                      {Missing, 16}}));
+}
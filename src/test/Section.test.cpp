@@ -15,6 +15,7 @@
 #include "SerializationTestHarness.hpp"
 #include "TestHelpers.hpp"
 #include <gtirb/Context.hpp>
+#include <gtirb/IR.hpp>
 #include <gtirb/Section.hpp>
 #include <gtirb/proto/Section.pb.h>
 #include <gtest/gtest.h>
@@ -209,6 +210,64 @@ TEST(Unit_Section, findByteIntervalsOn) {
   EXPECT_EQ(&*std::next(ConstRange.begin(), 1), BI1);
 }
 
+TEST(Unit_Section, findByteIntervalsOnMatchesLinearScan) {
+  auto* S = Section::Create(Ctx, "test");
+  // Many small disjoint intervals, a long one spanning several of them, and
+  // empty or address-less intervals that must never be found.
+  for (uint64_t I = 0; I < 64; ++I)
+    S->addByteInterval(Ctx, Addr(I * 8), 4 + I % 8);
+  auto* Long = S->addByteInterval(Ctx, Addr(20), 200);
+  S->addByteInterval(Ctx, Addr(100), 0);
+  S->addByteInterval(Ctx, 16);
+
+  auto Check = [S](uint64_t Offset) {
+    Addr A(Offset);
+    std::vector<const ByteInterval*> Expected;
+    for (const ByteInterval& BI : S->byte_intervals())
+      if (BI.getAddress() && *BI.getAddress() <= A &&
+          A < *BI.getAddress() + BI.getSize())
+        Expected.push_back(&BI);
+
+    std::vector<const ByteInterval*> Found;
+    for (const ByteInterval& BI : S->findByteIntervalsOn(A))
+      Found.push_back(&BI);
+    EXPECT_EQ(Found, Expected) << "at address " << A;
+  };
+
+  for (uint64_t Offset = 0; Offset < 540; ++Offset)
+    Check(Offset);
+
+  // The index follows changes made between queries.
+  Long->setSize(8);
+  S->removeByteInterval(&*S->findByteIntervalsOn(Addr(64)).begin());
+  for (uint64_t Offset = 0; Offset < 540; ++Offset)
+    Check(Offset);
+}
+
+TEST(Unit_Section, findByteIntervalsOnAfterLongInterval) {
+  // A long interval that starts first holds every address, so every query
+  // must step over the short intervals before the address that do not.
+  auto* S = Section::Create(Ctx, "test");
+  auto* Long = S->addByteInterval(Ctx, Addr(0), 1 << 20);
+  std::vector<ByteInterval*> Short;
+  for (uint64_t I = 0; I < 10000; ++I)
+    Short.push_back(S->addByteInterval(Ctx, Addr(16 + I * 64), 8));
+
+  for (uint64_t I = 0; I < 10000; I += 97) {
+    Addr A(16 + I * 64 + 4);
+    std::vector<ByteInterval*> Found;
+    for (ByteInterval& BI : S->findByteIntervalsOn(A))
+      Found.push_back(&BI);
+    EXPECT_EQ(Found, (std::vector<ByteInterval*>{Long, Short[I]}));
+
+    Found.clear();
+    for (ByteInterval& BI : S->findByteIntervalsOn(A + 16))
+      Found.push_back(&BI);
+    EXPECT_EQ(Found, std::vector<ByteInterval*>{Long});
+  }
+  EXPECT_TRUE(S->findByteIntervalsOn(Addr(1 << 20)).empty());
+}
+
 TEST(Unit_Section, findByteIntervalsAt) {
   auto* S = Section::Create(Ctx, "test");
   auto* BI1 = S->addByteInterval(Ctx, 16);
@@ -751,3 +810,97 @@ TEST(Unit_Section, testIterationOrder) {
     EXPECT_EQ(pointers(S->blocks()), ExpectedOrder);
   }
 }
+
+TEST(Unit_Section, splitByteInterval) {
+  auto* I = IR::Create(Ctx);
+  auto* M = I->addModule(Ctx, "test");
+  auto* S = M->addSection(Ctx, ".text");
+  std::vector<uint8_t> Bytes{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+  auto* BI = S->addByteInterval(Ctx, Addr(0x1000), Bytes.begin(), Bytes.end(),
+                                16, 12);
+  auto* CB1 = BI->addBlock<CodeBlock>(Ctx, 0, 4);
+  auto* CB2 = BI->addBlock<CodeBlock>(Ctx, 4, 4);
+  auto* CB3 = BI->addBlock<CodeBlock>(Ctx, 8, 4);
+  auto* DB = BI->addBlock<DataBlock>(Ctx, 12, 4);
+  auto* Sym = M->addSymbol(Ctx, CB3, "sym");
+  BI->addSymbolicExpression<SymAddrConst>(2, 0, Sym);
+  BI->addSymbolicExpression<SymAddrConst>(10, 0, Sym);
+  addEdge(CB1, CB3, I->getCFG());
+  addEdge(CB3, CB2, I->getCFG());
+
+  // Splits inside a block or outside the interval are rejected.
+  EXPECT_EQ(S->splitByteInterval(Ctx, BI, 6), nullptr);
+  EXPECT_EQ(S->splitByteInterval(Ctx, BI, 0), nullptr);
+  EXPECT_EQ(S->splitByteInterval(Ctx, BI, 16), nullptr);
+
+  auto* Tail = S->splitByteInterval(Ctx, BI, 8);
+  ASSERT_NE(Tail, nullptr);
+  EXPECT_EQ(Tail->getSection(), S);
+  EXPECT_EQ(boost::distance(S->byte_intervals()), 2);
+  EXPECT_EQ(S->getAddress(), Addr(0x1000));
+  EXPECT_EQ(S->getSize(), 16);
+
+  EXPECT_EQ(BI->getSize(), 8);
+  EXPECT_EQ(BI->getInitializedSize(), 8);
+  EXPECT_EQ(Tail->getAddress(), Addr(0x1008));
+  EXPECT_EQ(Tail->getSize(), 8);
+  EXPECT_EQ(Tail->getInitializedSize(), 4);
+  EXPECT_EQ(std::vector<uint8_t>(Tail->bytes_begin<uint8_t>(),
+                                 Tail->bytes_end<uint8_t>()),
+            std::vector<uint8_t>({8, 9, 10, 11, 0, 0, 0, 0}));
+
+  EXPECT_EQ(pointers(BI->blocks()), std::vector<Node*>({CB1, CB2}));
+  EXPECT_EQ(pointers(Tail->blocks()), std::vector<Node*>({CB3, DB}));
+  EXPECT_EQ(CB3->getByteInterval(), Tail);
+  EXPECT_EQ(CB3->getOffset(), 0);
+  EXPECT_EQ(CB3->getAddress(), Addr(0x1008));
+  EXPECT_EQ(DB->getByteInterval(), Tail);
+  EXPECT_EQ(DB->getAddress(), Addr(0x100C));
+  EXPECT_EQ(boost::distance(Tail->findCodeBlocksOnOffset(2)), 1);
+  EXPECT_EQ(boost::distance(BI->findCodeBlocksOnOffset(6)), 1);
+  EXPECT_TRUE(BI->findBlocksOnOffset(8).empty());
+
+  EXPECT_NE(BI->getSymbolicExpression(2), nullptr);
+  EXPECT_EQ(BI->getSymbolicExpression(10), nullptr);
+  EXPECT_NE(Tail->getSymbolicExpression(2), nullptr);
+
+  EXPECT_EQ(boost::num_vertices(I->getCFG()), 3);
+  EXPECT_EQ(boost::num_edges(I->getCFG()), 2);
+  EXPECT_EQ(boost::distance(M->findSymbols(Addr(0x1008))), 1);
+
+  // Merging the tail back restores the original interval.
+  EXPECT_EQ(S->mergeByteIntervals(Tail, BI), ChangeStatus::Rejected);
+  EXPECT_EQ(S->mergeByteIntervals(BI, BI), ChangeStatus::Rejected);
+  EXPECT_EQ(S->mergeByteIntervals(BI, Tail), ChangeStatus::Accepted);
+  EXPECT_EQ(Tail->getSection(), nullptr);
+  EXPECT_EQ(Tail->getSize(), 0);
+  EXPECT_TRUE(Tail->blocks().empty());
+  EXPECT_EQ(boost::distance(S->byte_intervals()), 1);
+
+  EXPECT_EQ(BI->getSize(), 16);
+  EXPECT_EQ(BI->getInitializedSize(), 12);
+  EXPECT_EQ(std::vector<uint8_t>(BI->bytes_begin<uint8_t>(),
+                                 BI->bytes_begin<uint8_t>() + 12),
+            Bytes);
+  EXPECT_EQ(pointers(BI->blocks()), std::vector<Node*>({CB1, CB2, CB3, DB}));
+  EXPECT_EQ(CB3->getByteInterval(), BI);
+  EXPECT_EQ(CB3->getOffset(), 8);
+  EXPECT_EQ(DB->getAddress(), Addr(0x100C));
+  EXPECT_NE(BI->getSymbolicExpression(10), nullptr);
+  EXPECT_EQ(boost::distance(BI->findCodeBlocksOnOffset(10)), 1);
+  EXPECT_EQ(boost::num_edges(I->getCFG()), 2);
+}
+
+TEST(Unit_Section, mergeByteIntervalsRejectsGaps) {
+  auto* S = Section::Create(Ctx, "test");
+  auto* BI1 = S->addByteInterval(Ctx, Addr(0), 4);
+  auto* BI2 = S->addByteInterval(Ctx, Addr(8), 4);
+  auto* BI3 = S->addByteInterval(Ctx, 4);
+  EXPECT_EQ(S->mergeByteIntervals(BI1, BI2), ChangeStatus::Rejected);
+  EXPECT_EQ(S->mergeByteIntervals(BI1, BI3), ChangeStatus::Rejected);
+
+  BI2->setAddress(Addr(4));
+  EXPECT_EQ(S->mergeByteIntervals(BI1, BI2), ChangeStatus::Accepted);
+  EXPECT_EQ(BI1->getSize(), 8);
+  EXPECT_EQ(boost::distance(S->byte_intervals()), 2);
+}